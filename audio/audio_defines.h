@@ -26,6 +26,10 @@ RETRO_BEGIN_DECLS
 /* So we don't get complete line-noise when fast-forwarding audio. */
 #define AUDIO_CHUNK_SIZE_NONBLOCKING   2048
 
+/* Frames per pass through the pipeline when
+ * 'audio_fused_pipeline' is enabled. */
+#define AUDIO_FUSED_CHUNK_FRAMES       256
+
 #define AUDIO_MAX_RATIO                16
 
 #define AUDIO_MIXER_MAX_STREAMS        16
@@ -19,10 +19,58 @@
 
 #include <queues/fifo_queue.h>
 #include <rthreads/rthreads.h>
+#include <retro_math.h>
 
 #include "audio_thread_wrapper.h"
 #include "../verbosity.h"
 
+#ifdef HAVE_AUDIO_THREAD_RING
+#define AUDIO_RING_LOAD(ptr)       __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#define AUDIO_RING_STORE(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_RELEASE)
+/* Sequentially consistent, used for the 'waiting' handshake
+ * so a wakeup can't be lost between the check and the wait. */
+#define AUDIO_RING_LOAD_SC(ptr)       __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define AUDIO_RING_STORE_SC(ptr, val) __atomic_store_n((ptr), (val), __ATOMIC_SEQ_CST)
+#define AUDIO_RING_CACHE_LINE      64
+/* The ring's consumer and producer read 'alive', 'stopped'
+ * and 'is_paused' without the lock, so they're set atomically. */
+#define AUDIO_THREAD_FLAG_GET(ptr)      AUDIO_RING_LOAD_SC(ptr)
+#define AUDIO_THREAD_FLAG_SET(ptr, val) AUDIO_RING_STORE_SC(ptr, val)
+
+/* Single-producer/single-consumer byte ring.
+ * The main thread is the only writer of 'write_idx', the
+ * audio thread is the only writer of 'read_idx'. Both
+ * indices are free-running and 'size' is a power of two,
+ * so the fill level is simply write_idx - read_idx.
+ * Each index sits on its own cache line to avoid false
+ * sharing between the two threads. */
+typedef struct audio_thread_ring
+{
+   size_t write_idx;
+   /* Set by the producer when it has to wait for space. */
+   unsigned producer_waiting;
+   char pad0[AUDIO_RING_CACHE_LINE - sizeof(size_t) - sizeof(unsigned)];
+
+   size_t read_idx;
+   /* Set by the consumer when the ring ran dry. */
+   unsigned consumer_waiting;
+   char pad1[AUDIO_RING_CACHE_LINE - sizeof(size_t) - sizeof(unsigned)];
+
+   /* Times the ring ran dry while playing, only written by the
+    * consumer. Whether the last drain found data, so an idle ring
+    * only counts once. */
+   unsigned underruns;
+   bool     had_data;
+
+   uint8_t *data;
+   size_t   size;
+   size_t   mask;
+} audio_thread_ring_t;
+#else
+#define AUDIO_THREAD_FLAG_GET(ptr)      (*(ptr))
+#define AUDIO_THREAD_FLAG_SET(ptr, val) (*(ptr) = (val))
+#endif
+
 typedef struct audio_thread
 {
    const audio_driver_t *driver;
@@ -31,6 +79,12 @@ typedef struct audio_thread
    sthread_t *thread;
    slock_t *lock;
    scond_t *cond;
+#ifdef HAVE_AUDIO_THREAD_RING
+   /* Only used in ring mode, signalled when the
+    * producer is waiting for free space. */
+   scond_t *space_cond;
+   audio_thread_ring_t *ring;
+#endif
    const char *device;
    unsigned *new_rate;
 
@@ -47,9 +101,117 @@ typedef struct audio_thread
    bool is_paused;
    bool is_shutdown;
    bool use_float;
+   bool nonblock;
 
 } audio_thread_t;
 
+#ifdef HAVE_AUDIO_THREAD_RING
+static void audio_thread_ring_free(audio_thread_ring_t *ring)
+{
+   if (!ring)
+      return;
+
+   if (ring->data)
+      free(ring->data);
+   free(ring);
+}
+
+static audio_thread_ring_t *audio_thread_ring_new(size_t size)
+{
+   audio_thread_ring_t *ring = (audio_thread_ring_t*)
+      calloc(1, sizeof(*ring));
+
+   if (!ring)
+      return NULL;
+
+   ring->size = next_pow2((uint32_t)size);
+   ring->mask = ring->size - 1;
+   ring->data = (uint8_t*)malloc(ring->size);
+
+   if (!ring->data)
+   {
+      audio_thread_ring_free(ring);
+      return NULL;
+   }
+
+   return ring;
+}
+
+static INLINE size_t audio_thread_ring_fill(audio_thread_ring_t *ring)
+{
+   return AUDIO_RING_LOAD(&ring->write_idx) - AUDIO_RING_LOAD(&ring->read_idx);
+}
+
+/* Wakes up the other side if it is waiting on @cond.
+ * Only takes the lock when somebody actually sleeps. */
+static void audio_thread_ring_wake(audio_thread_t *thr,
+      unsigned *waiting, scond_t *cond)
+{
+   if (!AUDIO_RING_LOAD_SC(waiting))
+      return;
+
+   slock_lock(thr->lock);
+   AUDIO_RING_STORE_SC(waiting, 0);
+   scond_signal(cond);
+   slock_unlock(thr->lock);
+}
+
+/* Consumer side, runs on the audio thread.
+ * Forwards whatever is in the ring to the real driver,
+ * or sleeps until the producer hands over more data. */
+static void audio_thread_ring_drain(audio_thread_t *thr)
+{
+   ssize_t ret;
+   size_t offset, avail;
+   audio_thread_ring_t *ring = thr->ring;
+   size_t read_idx           = ring->read_idx;
+
+   avail                     = AUDIO_RING_LOAD(&ring->write_idx) - read_idx;
+
+   if (!avail)
+   {
+      if (     ring->had_data
+            && !AUDIO_THREAD_FLAG_GET(&thr->is_paused))
+         AUDIO_RING_STORE(&ring->underruns, ring->underruns + 1);
+      ring->had_data = false;
+
+      AUDIO_RING_STORE_SC(&ring->consumer_waiting, 1);
+
+      slock_lock(thr->lock);
+      while (     AUDIO_RING_LOAD_SC(&ring->consumer_waiting)
+            &&    AUDIO_RING_LOAD_SC(&ring->write_idx) == read_idx
+            &&    thr->alive
+            &&   !thr->stopped)
+         scond_wait(thr->cond, thr->lock);
+      AUDIO_RING_STORE_SC(&ring->consumer_waiting, 0);
+      slock_unlock(thr->lock);
+      return;
+   }
+
+   /* Only hand the contiguous part over,
+    * the rest goes out on the next iteration. */
+   offset = read_idx & ring->mask;
+   if (avail > ring->size - offset)
+      avail = ring->size - offset;
+
+   ret = thr->driver->write(thr->driver_data, ring->data + offset, avail);
+
+   if (ret < 0)
+   {
+      slock_lock(thr->lock);
+      AUDIO_THREAD_FLAG_SET(&thr->alive, false);
+      scond_signal(thr->cond);
+      scond_signal(thr->space_cond);
+      slock_unlock(thr->lock);
+      return;
+   }
+
+   ring->had_data = true;
+   AUDIO_RING_STORE_SC(&ring->read_idx, read_idx + ret);
+   audio_thread_ring_wake(thr, &ring->producer_waiting, thr->space_cond);
+}
+#endif
+
 static void audio_thread_loop(void *data)
 {
    audio_thread_t *thr = (audio_thread_t*)data;
@@ -79,6 +241,18 @@ static void audio_thread_loop(void *data)
 
    for (;;)
    {
+#ifdef HAVE_AUDIO_THREAD_RING
+      /* Only take the lock to stop or quit, draining
+       * sleeps on its own when the ring runs dry. */
+      if (     thr->ring
+            &&  AUDIO_THREAD_FLAG_GET(&thr->alive)
+            && !AUDIO_THREAD_FLAG_GET(&thr->stopped))
+      {
+         audio_thread_ring_drain(thr);
+         continue;
+      }
+#endif
+
       slock_lock(thr->lock);
 
       if (!thr->alive)
@@ -103,10 +277,20 @@ static void audio_thread_loop(void *data)
             scond_wait(thr->cond, thr->lock);
          }
          thr->driver->start(thr->driver_data, thr->is_shutdown);
+#ifdef HAVE_AUDIO_THREAD_RING
+         /* Running dry after a restart isn't an underrun */
+         if (thr->ring)
+            thr->ring->had_data = false;
+#endif
       }
 
       slock_unlock(thr->lock);
-      audio_driver_callback();
+#ifdef HAVE_AUDIO_THREAD_RING
+      if (thr->ring)
+         audio_thread_ring_drain(thr);
+      else
+#endif
+         audio_driver_callback();
    }
 
    thr->driver->free(thr->driver_data);
@@ -122,8 +306,12 @@ static void audio_thread_block(audio_thread_t *thr)
 
    slock_lock(thr->lock);
    thr->stopped_ack = false;
-   thr->stopped = true;
+   AUDIO_THREAD_FLAG_SET(&thr->stopped, true);
    scond_signal(thr->cond);
+#ifdef HAVE_AUDIO_THREAD_RING
+   if (thr->space_cond)
+      scond_signal(thr->space_cond);
+#endif
 
    /* Wait until audio driver actually goes to sleep. */
    while (!thr->stopped_ack)
@@ -138,7 +326,7 @@ static void audio_thread_unblock(audio_thread_t *thr)
       return;
 
    slock_lock(thr->lock);
-   thr->stopped = false;
+   AUDIO_THREAD_FLAG_SET(&thr->stopped, false);
    scond_signal(thr->cond);
    slock_unlock(thr->lock);
 }
@@ -153,14 +341,24 @@ static void audio_thread_free(void *data)
    if (thr->thread)
    {
       slock_lock(thr->lock);
-      thr->stopped = false;
-      thr->alive   = false;
+      AUDIO_THREAD_FLAG_SET(&thr->stopped, false);
+      AUDIO_THREAD_FLAG_SET(&thr->alive, false);
       scond_signal(thr->cond);
       slock_unlock(thr->lock);
 
       sthread_join(thr->thread);
    }
 
+#ifdef HAVE_AUDIO_THREAD_RING
+   if (thr->ring)
+   {
+      RARCH_LOG("[Audio]: Threaded ring: %u underruns.\n",
+            thr->ring->underruns);
+      audio_thread_ring_free(thr->ring);
+   }
+   if (thr->space_cond)
+      scond_free(thr->space_cond);
+#endif
    if (thr->lock)
       slock_free(thr->lock);
    if (thr->cond)
@@ -191,7 +389,7 @@ static bool audio_thread_stop(void *data)
       return false;
 
    audio_thread_block(thr);
-   thr->is_paused = true;
+   AUDIO_THREAD_FLAG_SET(&thr->is_paused, true);
 
    audio_driver_disable_callback();
 
@@ -207,7 +405,7 @@ static bool audio_thread_start(void *data, bool is_shutdown)
 
    audio_driver_enable_callback();
 
-   thr->is_paused   = false;
+   AUDIO_THREAD_FLAG_SET(&thr->is_paused, false);
    thr->is_shutdown = is_shutdown;
    audio_thread_unblock(thr);
 
@@ -216,8 +414,9 @@ static bool audio_thread_start(void *data, bool is_shutdown)
 
 static void audio_thread_set_nonblock_state(void *data, bool state)
 {
-   (void)data;
-   (void)state;
+   audio_thread_t *thr = (audio_thread_t*)data;
+   if (thr)
+      thr->nonblock = state;
 }
 
 static bool audio_thread_use_float(void *data)
@@ -241,7 +440,7 @@ static ssize_t audio_thread_write(void *data, const void *buf, size_t size)
    if (ret < 0)
    {
       slock_lock(thr->lock);
-      thr->alive = false;
+      AUDIO_THREAD_FLAG_SET(&thr->alive, false);
       scond_signal(thr->cond);
       slock_unlock(thr->lock);
    }
@@ -249,6 +448,119 @@ static ssize_t audio_thread_write(void *data, const void *buf, size_t size)
    return ret;
 }
 
+#ifdef HAVE_AUDIO_THREAD_RING
+/* Producer side, runs on the main thread.
+ * Never takes a lock unless the ring is full and
+ * we're in blocking mode. */
+static ssize_t audio_thread_ring_write(void *data, const void *buf, size_t size)
+{
+   audio_thread_t *thr       = (audio_thread_t*)data;
+   audio_thread_ring_t *ring = thr ? thr->ring : NULL;
+   const uint8_t *src        = (const uint8_t*)buf;
+   size_t written            = 0;
+
+   if (!ring)
+      return 0;
+
+   while (written < size)
+   {
+      size_t write_idx = ring->write_idx;
+      size_t avail     = ring->size -
+         (write_idx - AUDIO_RING_LOAD(&ring->read_idx));
+      size_t offset    = write_idx & ring->mask;
+      size_t chunk     = size - written;
+
+      if (!avail)
+      {
+         /* Dropping is the only option when nobody drains
+          * the ring. */
+         if (     thr->nonblock
+               ||  AUDIO_THREAD_FLAG_GET(&thr->stopped)
+               || !AUDIO_THREAD_FLAG_GET(&thr->alive))
+            break;
+
+         AUDIO_RING_STORE_SC(&ring->producer_waiting, 1);
+
+         slock_lock(thr->lock);
+         while (     AUDIO_RING_LOAD_SC(&ring->producer_waiting)
+               &&    AUDIO_RING_LOAD_SC(&ring->read_idx) == write_idx - ring->size
+               &&    thr->alive
+               &&   !thr->stopped)
+            scond_wait(thr->space_cond, thr->lock);
+         AUDIO_RING_STORE_SC(&ring->producer_waiting, 0);
+         slock_unlock(thr->lock);
+         continue;
+      }
+
+      if (chunk > avail)
+         chunk = avail;
+      if (chunk > ring->size - offset)
+         chunk = ring->size - offset;
+
+      memcpy(ring->data + offset, src + written, chunk);
+      AUDIO_RING_STORE_SC(&ring->write_idx, write_idx + chunk);
+      written += chunk;
+
+      audio_thread_ring_wake(thr, &ring->consumer_waiting, thr->cond);
+   }
+
+   if (!AUDIO_THREAD_FLAG_GET(&thr->alive))
+      return -1;
+   return written;
+}
+
+/* Lock-free, lets audio_driver_flush() do dynamic
+ * rate control against the fill level of the ring. */
+static size_t audio_thread_ring_write_avail(void *data)
+{
+   audio_thread_t *thr = (audio_thread_t*)data;
+   if (!thr || !thr->ring)
+      return 0;
+   return thr->ring->size - audio_thread_ring_fill(thr->ring);
+}
+
+static size_t audio_thread_ring_buffer_size(void *data)
+{
+   audio_thread_t *thr = (audio_thread_t*)data;
+   if (!thr || !thr->ring)
+      return 0;
+   return thr->ring->size;
+}
+
+static const audio_driver_t audio_thread_ring = {
+   NULL,
+   audio_thread_ring_write,
+   audio_thread_stop,
+   audio_thread_start,
+   audio_thread_alive,
+   audio_thread_set_nonblock_state,
+   audio_thread_free,
+   audio_thread_use_float,
+   "audio-thread-ring",
+   NULL,
+   NULL,
+   audio_thread_ring_write_avail,
+   audio_thread_ring_buffer_size
+};
+#endif
+
+bool audio_thread_get_ring_stats(const audio_driver_t *drv, void *data,
+      size_t *fill, unsigned *underruns)
+{
+#ifdef HAVE_AUDIO_THREAD_RING
+   audio_thread_t *thr = (audio_thread_t*)data;
+
+   if (drv != &audio_thread_ring || !thr || !thr->ring)
+      return false;
+
+   *fill      = audio_thread_ring_fill(thr->ring);
+   *underruns = AUDIO_RING_LOAD(&thr->ring->underruns);
+   return true;
+#else
+   return false;
+#endif
+}
+
 static const audio_driver_t audio_thread = {
    NULL,
    audio_thread_write,
@@ -271,18 +583,22 @@ static const audio_driver_t audio_thread = {
  * @out_rate                  : output audio rate
  * @latency                   : audio latency
  * @driver                    : audio driver
+ * @use_ring                  : feed the driver from a ring buffer
  *
  * Starts a audio driver in a new thread.
  * Access to audio driver will be mediated through this driver.
- * This driver interfaces with audio callback and is
- * only used in that case.
+ * By default this driver interfaces with audio callback and is
+ * only used in that case. If @use_ring is set, samples written
+ * from the main thread are instead queued in a lock-free ring
+ * and forwarded to the driver from the audio thread.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool audio_init_thread(const audio_driver_t **out_driver,
       void **out_data, const char *device, unsigned audio_out_rate,
       unsigned *new_rate, unsigned latency,
-      unsigned block_frames, const audio_driver_t *drv)
+      unsigned block_frames, const audio_driver_t *drv,
+      bool use_ring)
 {
    audio_thread_t *thr = (audio_thread_t*)calloc(1, sizeof(*thr));
    if (!thr)
@@ -315,6 +631,30 @@ bool audio_init_thread(const audio_driver_t **out_driver,
    if (thr->inited < 0) /* Thread failed. */
       goto error;
 
+#ifdef HAVE_AUDIO_THREAD_RING
+   if (use_ring)
+   {
+      /* Hold half of the configured latency, the driver's
+       * own buffer holds the rest. */
+      unsigned rate      = (new_rate && *new_rate) ? *new_rate : audio_out_rate;
+      size_t frame_size  = 2 * (thr->use_float ? sizeof(float) : sizeof(int16_t));
+      size_t ring_size   = (size_t)rate * latency / 2000 * frame_size;
+
+      if (!(thr->space_cond = scond_new()))
+         goto error;
+      if (!(thr->ring    = audio_thread_ring_new(
+                  MAX(ring_size, 1024 * frame_size))))
+         goto error;
+
+      RARCH_LOG("[Audio]: Threaded ring of %u bytes.\n",
+            (unsigned)thr->ring->size);
+
+      *out_driver        = &audio_thread_ring;
+      *out_data          = thr;
+      return true;
+   }
+#endif
+
    *out_driver         = &audio_thread;
    *out_data           = thr;
    return true;
@@ -21,6 +21,12 @@
 
 #include "../retroarch.h"
 
+/* The ring mode relies on the GCC/Clang atomic builtins. */
+#if defined(HAVE_THREADS) && (defined(__clang__) || (defined(__GNUC__) \
+      && (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))))
+#define HAVE_AUDIO_THREAD_RING
+#endif
+
 /**
  * audio_init_thread:
  * @out_driver                : output driver
@@ -30,16 +36,35 @@
  * @new_rate                  : new output audio rate
  * @latency                   : audio latency
  * @driver                    : audio driver
+ * @use_ring                  : feed the driver from a ring buffer
  *
  * Starts a audio driver in a new thread.
  * Access to audio driver will be mediated through this driver.
- * This driver interfaces with audio callback and is only used in that case.
+ * This driver interfaces with audio callback, or with @use_ring,
+ * queues samples written from the main thread in a lock-free
+ * single-producer/single-consumer ring for the audio thread.
  *
  * Returns: true (1) if successful, otherwise false (0).
  **/
 bool audio_init_thread(const audio_driver_t **out_driver, void **out_data,
       const char *device, unsigned out_rate, unsigned *new_rate, unsigned latency,
       unsigned block_frames,
-      const audio_driver_t *driver);
+      const audio_driver_t *driver, bool use_ring);
+
+/**
+ * audio_thread_get_ring_stats:
+ * @drv                       : current audio driver
+ * @data                      : its data
+ * @fill                      : bytes queued in the ring
+ * @underruns                 : times the ring ran dry while playing
+ *
+ * Lock-free, so audio_driver_flush() can use it for dynamic
+ * rate control on every flush.
+ *
+ * Returns: true if @drv is the threaded driver in ring mode,
+ * otherwise false and @fill and @underruns are left alone.
+ **/
+bool audio_thread_get_ring_stats(const audio_driver_t *drv, void *data,
+      size_t *fill, unsigned *underruns);
 
 #endif
@@ -291,6 +291,12 @@
 #define DEFAULT_THREADED_DATA_RUNLOOP_ENABLE false
 #endif
 
+/* Number of worker threads running background tasks
+ * when the threaded data runloop is enabled. Task
+ * handlers written before this was configurable assume
+ * a single worker, so keep that as the default. */
+#define DEFAULT_THREADED_DATA_RUNLOOP_WORKERS 1
+
 /* Set to true if HW render cores should get their private context. */
 #define DEFAULT_VIDEO_SHARED_CONTEXT false
 
@@ -710,6 +716,18 @@ static const float message_bgcolor_opacity = 1.0f;
 /* Watch shader files for changes and auto-apply as necessary. */
 #define DEFAULT_VIDEO_SHADER_WATCH_FILES false
 
+/* Keep compiled slang shaders (SPIR-V and reflection)
+ * in the cache directory, or in the config directory if
+ * no cache directory is set, so unchanged passes are not
+ * recompiled every time a preset is loaded. */
+#define DEFAULT_VIDEO_SHADER_CACHE_ENABLE true
+
+/* Number of threads compiling the passes of a slang
+ * preset. 0 uses one per CPU core, 1 compiles each
+ * pass in turn on the video thread. Kept low so that
+ * loading a preset doesn't stall a running core */
+#define DEFAULT_VIDEO_SHADER_COMPILE_THREADS 4
+
 /* Initialise file browser with last used directory
  * when selecting shader presets/passes via the menu */
 #define DEFAULT_VIDEO_SHADER_REMEMBER_LAST_DIR false
@@ -879,6 +897,14 @@ static const bool audio_enable_menu_bgm    = false;
  * is enabled */
 #define DEFAULT_AUDIO_FASTFORWARD_MUTE false
 
+/* Run conversion, DSP, resampling and mixing in
+ * small chunks instead of one full pass per stage */
+#define DEFAULT_AUDIO_FUSED_PIPELINE false
+
+/* Run the audio driver on its own thread, fed from
+ * a lock-free ring buffer */
+#define DEFAULT_AUDIO_THREAD_RING false
+
 /* MISC */
 
 /* Enables displaying the current frames per second. */
@@ -903,6 +929,15 @@ static const bool audio_enable_menu_bgm    = false;
  * depending on the save state buffer. */
 #define DEFAULT_REWIND_ENABLE false
 
+/* Store rewind deltas at 64-byte block granularity. Much
+ * cheaper to compute for large save states, at the cost of
+ * somewhat larger deltas. */
+#define DEFAULT_REWIND_BLOCK_DELTA false
+
+/* Compress rewind states on a separate thread. The main
+ * thread then only has to serialize the core state. */
+#define DEFAULT_REWIND_THREADED false
+
 /* When set, any time a cheat is toggled it is immediately applied. */
 #define DEFAULT_APPLY_CHEATS_AFTER_TOGGLE false
 
@@ -916,6 +951,10 @@ static const bool audio_enable_menu_bgm    = false;
 /* The amount of MB to increase/decrease the rewind_buffer_size when it is changed via the UI. */
 #define DEFAULT_REWIND_BUFFER_SIZE_STEP 10 /* 10MB */
 
+/* Size in MB of the file receiving compressed rewind
+ * states evicted from the rewind buffer. 0 disables it. */
+#define DEFAULT_REWIND_SPILL_SIZE 0
+
 /* How many frames to rewind at a time. */
 #define DEFAULT_REWIND_GRANULARITY 1
 
@@ -1022,6 +1061,10 @@ static const bool savestate_thumbnail_enable = false;
 /* When using the Run Ahead feature, use a secondary instance of the core. */
 #define DEFAULT_RUN_AHEAD_SECONDARY_INSTANCE true
 
+/* When using the Run Ahead feature without a secondary instance,
+ * keep a ring of savestates and only roll back when input changes. */
+#define DEFAULT_RUN_AHEAD_STATE_RING false
+
 /* Hide warning messages when using the Run Ahead feature. */
 #define DEFAULT_RUN_AHEAD_HIDE_WARNINGS false
 
@@ -1049,6 +1092,12 @@ static const uint16_t network_remote_base_port = 55400;
  * a new one) */
 #define DEFAULT_CORE_UPDATER_AUTO_BACKUP_HISTORY_SIZE 1
 
+/* Keep the parsed contents of all core info files
+ * in a single cache file in the cache directory (or
+ * next to the config file), so only new or modified
+ * info files are read when the core list is built */
+#define DEFAULT_CORE_INFO_CACHE_ENABLE true
+
 #if defined(ANDROID) || defined(IOS)
 #define DEFAULT_NETWORK_ON_DEMAND_THUMBNAILS true
 #else
@@ -1090,6 +1139,16 @@ static const int default_content_favorites_size = 200;
 
 #define DEFAULT_SCAN_WITHOUT_CORE_MATCH false
 
+/* When scanning directories, load the CRC and serial
+ * keys of every database into one hash table up front
+ * instead of walking each database for every file */
+#define DEFAULT_SCAN_HASH_INDEX false
+
+/* Number of threads hashing content ahead of the
+ * scanner while it matches against the databases.
+ * 0 hashes every file on the scanner task itself */
+#define DEFAULT_SCAN_WORKERS 0
+
 #ifdef __WINRT__
 /* Be paranoid about WinRT file I/O performance, and leave this disabled by
  * default */
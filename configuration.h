@@ -167,6 +167,9 @@ typedef struct settings
       unsigned libretro_log_level;
       unsigned rewind_granularity;
       unsigned rewind_buffer_size_step;
+      unsigned rewind_spill_size;
+      unsigned threaded_data_runloop_workers;
+      unsigned scan_workers;
       unsigned autosave_interval;
       unsigned network_cmd_port;
       unsigned network_remote_base_port;
@@ -202,6 +205,7 @@ typedef struct settings
       unsigned video_overscan_correction_bottom;
 #endif
       unsigned video_shader_delay;
+      unsigned video_shader_compile_threads;
       unsigned notification_show_screenshot_duration;
       unsigned notification_show_screenshot_flash;
 
@@ -469,6 +473,7 @@ typedef struct settings
       bool video_scale_integer;
       bool video_shader_enable;
       bool video_shader_watch_files;
+      bool video_shader_cache_enable;
       bool video_shader_remember_last_dir;
       bool video_threaded;
       bool video_font_enable;
@@ -505,6 +510,8 @@ typedef struct settings
       bool audio_wasapi_exclusive_mode;
       bool audio_wasapi_float_format;
       bool audio_fastforward_mute;
+      bool audio_fused_pipeline;
+      bool audio_thread_ring;
 
       /* Input */
       bool input_remap_binds_enable;
@@ -672,6 +679,7 @@ typedef struct settings
       bool network_buildbot_show_experimental_cores;
       bool network_on_demand_thumbnails;
       bool core_updater_auto_backup;
+      bool core_info_cache_enable;
 
       /* UI */
       bool ui_menubar_enable;
@@ -724,11 +732,14 @@ typedef struct settings
       bool history_list_enable;
       bool playlist_entry_rename;
       bool rewind_enable;
+      bool rewind_block_delta;
+      bool rewind_threaded;
       bool vrr_runloop_enable;
       bool apply_cheats_after_toggle;
       bool apply_cheats_after_load;
       bool run_ahead_enabled;
       bool run_ahead_secondary_instance;
+      bool run_ahead_state_ring;
       bool run_ahead_hide_warnings;
       bool pause_nonactive;
       bool block_sram_overwrite;
@@ -798,6 +809,7 @@ typedef struct settings
       bool log_to_file_timestamp;
 
       bool scan_without_core_match;
+      bool scan_hash_index;
 
       bool ai_service_enable;
       bool ai_service_pause;
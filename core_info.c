@@ -15,7 +15,11 @@
  *  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <stdint.h>
+#include <stddef.h>
+
 #include <compat/strl.h>
+#include <retro_miscellaneous.h>
 #include <string/stdstring.h>
 #include <file/config_file.h>
 #include <file/file_path.h>
@@ -31,6 +35,7 @@
 
 #include "core_info.h"
 #include "file_path_special.h"
+#include "verbosity.h"
 
 #if defined(__WINRT__) || defined(WINAPI_FAMILY) && WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP
 #include "uwp/uwp_func.h"
@@ -40,6 +45,14 @@
 #include "play_feature_delivery/play_feature_delivery.h"
 #endif
 
+#if defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__)
+#include <sys/stat.h>
+#include <encodings/utf.h>
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
 enum compare_op
 {
    COMPARE_OP_EQUAL = 0,
@@ -90,57 +103,641 @@ static void core_info_list_resolve_all_extensions(
 #endif
 }
 
-static void core_info_list_resolve_all_firmware(
-      core_info_list_t *core_info_list)
+/* String fields read from a core info file, in the
+ * order they are stored in the core info cache */
+static const struct
+{
+   const char *key;
+   size_t offset;
+} core_info_string_fields[] = {
+   { "display_name",         offsetof(core_info_t, display_name)         },
+   { "display_version",      offsetof(core_info_t, display_version)      },
+   { "corename",             offsetof(core_info_t, core_name)            },
+   { "systemname",           offsetof(core_info_t, systemname)           },
+   { "systemid",             offsetof(core_info_t, system_id)            },
+   { "manufacturer",         offsetof(core_info_t, system_manufacturer)  },
+   { "supported_extensions", offsetof(core_info_t, supported_extensions) },
+   { "authors",              offsetof(core_info_t, authors)              },
+   { "permissions",          offsetof(core_info_t, permissions)          },
+   { "license",              offsetof(core_info_t, licenses)             },
+   { "categories",           offsetof(core_info_t, categories)           },
+   { "database",             offsetof(core_info_t, databases)            },
+   { "notes",                offsetof(core_info_t, notes)                },
+   { "required_hw_api",      offsetof(core_info_t, required_hw_api)      },
+   { "description",          offsetof(core_info_t, description)          }
+};
+
+#define CORE_INFO_STRING_FIELD(info, i) \
+   (*(char**)((uint8_t*)(info) + core_info_string_fields[i].offset))
+
+static void core_info_resolve_lists(core_info_t *info)
+{
+   if (info->supported_extensions)
+      info->supported_extensions_list =
+         string_split(info->supported_extensions, "|");
+   if (info->authors)
+      info->authors_list         = string_split(info->authors, "|");
+   if (info->permissions)
+      info->permissions_list     = string_split(info->permissions, "|");
+   if (info->licenses)
+      info->licenses_list        = string_split(info->licenses, "|");
+   if (info->categories)
+      info->categories_list      = string_split(info->categories, "|");
+   if (info->databases)
+      info->databases_list       = string_split(info->databases, "|");
+   if (info->notes)
+      info->note_list            = string_split(info->notes, "|");
+   if (info->required_hw_api)
+      info->required_hw_api_list = string_split(info->required_hw_api, "|");
+}
+
+static void core_info_parse_firmware(core_info_t *info,
+      config_file_t *conf)
 {
-   size_t i;
    unsigned c;
+   core_info_firmware_t *firmware = NULL;
 
-   for (i = 0; i < core_info_list->count; i++)
+   if (!info->firmware_count)
+      return;
+
+   firmware = (core_info_firmware_t*)
+      calloc(info->firmware_count, sizeof(*firmware));
+
+   if (!firmware)
+      return;
+
+   info->firmware = firmware;
+
+   for (c = 0; c < info->firmware_count; c++)
    {
-      unsigned count                  = 0;
-      core_info_firmware_t *firmware  = NULL;
-      core_info_t *info               = (core_info_t*)&core_info_list->list[i];
-      config_file_t *config           = (config_file_t*)info->config_data;
+      char path_key[64];
+      char desc_key[64];
+      char opt_key[64];
+      struct config_entry_list 
+         *entry         = NULL;
+      bool tmp_bool     = false;
+      path_key[0]       = desc_key[0] = opt_key[0] = '\0';
 
-      if (!config || !config_get_uint(config, "firmware_count", &count))
-         continue;
+      snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
+      snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
+      snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
+
+      entry             = config_get_entry(conf, path_key);
+
+      if (entry && !string_is_empty(entry->value))
+         firmware[c].path = strdup(entry->value);
+
+      entry             = config_get_entry(conf, desc_key);
+
+      if (entry && !string_is_empty(entry->value))
+         firmware[c].desc     = strdup(entry->value);
+
+      if (config_get_bool(conf, opt_key , &tmp_bool))
+         firmware[c].optional = tmp_bool;
+   }
+}
+
+static void core_info_parse_config_file(core_info_t *info,
+      config_file_t *conf)
+{
+   size_t i;
+   bool tmp_bool     = false;
+   unsigned tmp_uint = 0;
+
+   for (i = 0; i < ARRAY_SIZE(core_info_string_fields); i++)
+   {
+      struct config_entry_list *entry = config_get_entry(conf,
+            core_info_string_fields[i].key);
+
+      if (entry && !string_is_empty(entry->value))
+         CORE_INFO_STRING_FIELD(info, i) = strdup(entry->value);
+   }
+
+   config_get_uint(conf, "firmware_count", &tmp_uint);
+   info->firmware_count = tmp_uint;
+   core_info_parse_firmware(info, conf);
+
+   if (config_get_bool(conf, "supports_no_game",
+            &tmp_bool))
+      info->supports_no_game = tmp_bool;
+
+   if (config_get_bool(conf, "database_match_archive_member",
+            &tmp_bool))
+      info->database_match_archive_member = tmp_bool;
+
+   if (config_get_bool(conf, "is_experimental",
+            &tmp_bool))
+      info->is_experimental = tmp_bool;
+
+   info->has_info = true;
+}
+
+/* Core info cache
+ *
+ * core_info.cache sits in the cache directory chosen
+ * by the caller and holds one record per info file:
+ *
+ *   u32 record size, excluding this field
+ *   str info file path
+ *   u64 info file size
+ *   u64 info file modification time
+ *   str string fields, see core_info_string_fields
+ *   u8  flags, see CORE_INFO_CACHE_FLAG_*
+ *   u32 firmware count
+ *       per firmware: str path, str desc, u8 optional
+ *
+ * after a header of magic, version and record count.
+ * All integers are little endian. Strings are a u32
+ * length (CORE_INFO_CACHE_NULL for NULL) followed by
+ * that many bytes and a terminating zero.
+ *
+ * Records are matched on path, size and mtime, so
+ * editing, adding or removing an info file only costs
+ * a parse of that one file. Anything that depends on
+ * state outside the info file (lock status, missing
+ * firmware, the display name fallback) is not stored. */
+
+#define CORE_INFO_CACHE_MAGIC   0x49434152 /* "RACI" */
+#define CORE_INFO_CACHE_VERSION 1
+#define CORE_INFO_CACHE_NULL    0xFFFFFFFF
+#define CORE_INFO_CACHE_HEADER  12
+
+enum core_info_cache_flags
+{
+   CORE_INFO_CACHE_FLAG_SUPPORTS_NO_GAME = (1 << 0),
+   CORE_INFO_CACHE_FLAG_DB_MATCH_MEMBER  = (1 << 1),
+   CORE_INFO_CACHE_FLAG_EXPERIMENTAL     = (1 << 2)
+};
+
+typedef struct
+{
+   const uint8_t *data;
+   size_t size;
+   size_t pos;
+   bool error;
+} core_info_cache_reader_t;
+
+typedef struct
+{
+   uint8_t *data;
+   size_t size;
+   size_t capacity;
+   unsigned count;
+   bool error;
+} core_info_cache_writer_t;
+
+typedef struct
+{
+   const char *info_path;
+   const uint8_t *record;
+   size_t record_size;
+   size_t payload_pos;
+   uint64_t info_size;
+   uint64_t info_mtime;
+   bool used;
+} core_info_cache_entry_t;
+
+typedef struct
+{
+   uint8_t *data;
+   core_info_cache_entry_t *entries;
+   size_t count;
+   size_t hint;
+} core_info_cache_t;
+
+/* Size and modification time of an info file,
+ * or false if it doesn't exist or the platform
+ * can't tell, in which case the cache is unused */
+static bool core_info_cache_stat(const char *path,
+      uint64_t *size, uint64_t *mtime)
+{
+#if defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__)
+   struct _stat64 buf;
+   int ret             = -1;
+   wchar_t *path_wide  = utf8_to_utf16_string_alloc(path);
+
+   if (!path_wide)
+      return false;
+
+   ret = _wstat64(path_wide, &buf);
+   free(path_wide);
+
+   if (ret != 0 || (buf.st_mode & _S_IFDIR))
+      return false;
+
+   *size  = (uint64_t)buf.st_size;
+   *mtime = (uint64_t)buf.st_mtime;
+   return true;
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+   struct stat buf;
+
+   if (stat(path, &buf) != 0 || S_ISDIR(buf.st_mode))
+      return false;
+
+   *size  = (uint64_t)buf.st_size;
+   *mtime = (uint64_t)buf.st_mtime;
+   return true;
+#else
+   return false;
+#endif
+}
+
+static uint8_t core_info_cache_get_u8(core_info_cache_reader_t *reader)
+{
+   if (reader->error || reader->size - reader->pos < 1)
+   {
+      reader->error = true;
+      return 0;
+   }
+   return reader->data[reader->pos++];
+}
+
+static uint32_t core_info_cache_get_u32(core_info_cache_reader_t *reader)
+{
+   const uint8_t *p = NULL;
+
+   if (reader->error || reader->size - reader->pos < 4)
+   {
+      reader->error = true;
+      return 0;
+   }
+
+   p            = reader->data + reader->pos;
+   reader->pos += 4;
+   return (uint32_t)p[0]         | ((uint32_t)p[1] << 8)
+      | ((uint32_t)p[2] << 16)   | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t core_info_cache_get_u64(core_info_cache_reader_t *reader)
+{
+   uint64_t lo = core_info_cache_get_u32(reader);
+   uint64_t hi = core_info_cache_get_u32(reader);
+   return lo | (hi << 32);
+}
+
+/* Returns a pointer to the string inside the cache
+ * buffer, or NULL for a NULL string or on error */
+static const char *core_info_cache_get_string(
+      core_info_cache_reader_t *reader)
+{
+   const char *str = NULL;
+   uint32_t len    = core_info_cache_get_u32(reader);
+
+   if (reader->error || len == CORE_INFO_CACHE_NULL)
+      return NULL;
+
+   if (     reader->size - reader->pos < (size_t)len + 1
+         || reader->data[reader->pos + len] != '\0')
+   {
+      reader->error = true;
+      return NULL;
+   }
+
+   str          = (const char*)reader->data + reader->pos;
+   reader->pos += (size_t)len + 1;
+   return str;
+}
+
+static char *core_info_cache_dup_string(
+      core_info_cache_reader_t *reader)
+{
+   const char *str = core_info_cache_get_string(reader);
+   return str ? strdup(str) : NULL;
+}
+
+static void core_info_cache_put(core_info_cache_writer_t *writer,
+      const void *data, size_t len)
+{
+   if (writer->error)
+      return;
+
+   if (writer->capacity - writer->size < len)
+   {
+      size_t capacity = writer->capacity ? writer->capacity * 2 : 16384;
+      uint8_t *tmp    = NULL;
+
+      while (capacity - writer->size < len)
+         capacity *= 2;
+
+      if (!(tmp = (uint8_t*)realloc(writer->data, capacity)))
+      {
+         writer->error = true;
+         return;
+      }
+
+      writer->data     = tmp;
+      writer->capacity = capacity;
+   }
+
+   memcpy(writer->data + writer->size, data, len);
+   writer->size += len;
+}
+
+static void core_info_cache_put_u8(core_info_cache_writer_t *writer,
+      uint8_t val)
+{
+   core_info_cache_put(writer, &val, 1);
+}
+
+static void core_info_cache_put_u32(core_info_cache_writer_t *writer,
+      uint32_t val)
+{
+   uint8_t buf[4];
+   buf[0] = (uint8_t)(val);
+   buf[1] = (uint8_t)(val >> 8);
+   buf[2] = (uint8_t)(val >> 16);
+   buf[3] = (uint8_t)(val >> 24);
+   core_info_cache_put(writer, buf, sizeof(buf));
+}
+
+static void core_info_cache_put_u64(core_info_cache_writer_t *writer,
+      uint64_t val)
+{
+   core_info_cache_put_u32(writer, (uint32_t)val);
+   core_info_cache_put_u32(writer, (uint32_t)(val >> 32));
+}
+
+static void core_info_cache_put_string(core_info_cache_writer_t *writer,
+      const char *str)
+{
+   size_t len;
+
+   if (!str)
+   {
+      core_info_cache_put_u32(writer, CORE_INFO_CACHE_NULL);
+      return;
+   }
+
+   len = strlen(str);
+   core_info_cache_put_u32(writer, (uint32_t)len);
+   core_info_cache_put(writer, str, len + 1);
+}
+
+static void core_info_cache_free(core_info_cache_t *cache)
+{
+   if (!cache)
+      return;
+
+   free(cache->entries);
+   free(cache->data);
+   free(cache);
+}
+
+static core_info_cache_t *core_info_cache_read(const char *path)
+{
+   size_t i;
+   void *data                      = NULL;
+   int64_t len                     = 0;
+   uint32_t count                  = 0;
+   core_info_cache_reader_t reader = {0};
+   core_info_cache_t *cache        = NULL;
+
+   if (!path_is_valid(path))
+      return NULL;
+
+   if (!filestream_read_file(path, &data, &len) || !data)
+      return NULL;
+
+   reader.data = (const uint8_t*)data;
+   reader.size = (size_t)len;
+
+   if (     core_info_cache_get_u32(&reader) != CORE_INFO_CACHE_MAGIC
+         || core_info_cache_get_u32(&reader) != CORE_INFO_CACHE_VERSION)
+      goto error;
+
+   count = core_info_cache_get_u32(&reader);
+
+   /* Every record takes at least 25 bytes */
+   if (reader.error || count > (reader.size - reader.pos) / 25)
+      goto error;
 
-      firmware = (core_info_firmware_t*)calloc(count, sizeof(*firmware));
+   if (!(cache = (core_info_cache_t*)calloc(1, sizeof(*cache))))
+      goto error;
+
+   cache->data = (uint8_t*)data;
+
+   if (count && !(cache->entries = (core_info_cache_entry_t*)
+            calloc(count, sizeof(*cache->entries))))
+      goto error;
+
+   for (i = 0; i < count; i++)
+   {
+      core_info_cache_entry_t *entry = &cache->entries[i];
+      size_t start                   = reader.pos;
+      uint32_t record_size           = core_info_cache_get_u32(&reader);
+
+      if (reader.error || record_size > reader.size - reader.pos)
+         goto error;
+
+      entry->record      = reader.data + start;
+      entry->record_size = 4 + (size_t)record_size;
+      entry->info_path   = core_info_cache_get_string(&reader);
+      entry->info_size   = core_info_cache_get_u64(&reader);
+      entry->info_mtime  = core_info_cache_get_u64(&reader);
+      entry->payload_pos = reader.pos - start;
+
+      if (     reader.error
+            || !entry->info_path
+            || reader.pos > start + entry->record_size)
+         goto error;
+
+      reader.pos         = start + entry->record_size;
+   }
+
+   cache->count = count;
+   return cache;
+
+error:
+   RARCH_WARN("[Core Info]: Ignoring invalid cache \"%s\"\n", path);
+   if (cache)
+      core_info_cache_free(cache);
+   else
+      free(data);
+   return NULL;
+}
+
+/* Cores are listed in the same order every time,
+ * so the record after the last match is tried first */
+static core_info_cache_entry_t *core_info_cache_find(
+      core_info_cache_t *cache, const char *info_path,
+      uint64_t info_size, uint64_t info_mtime)
+{
+   size_t i;
+
+   if (!cache)
+      return NULL;
+
+   for (i = 0; i < cache->count; i++)
+   {
+      size_t idx                     = (cache->hint + i) % cache->count;
+      core_info_cache_entry_t *entry = &cache->entries[idx];
 
-      if (!firmware)
+      if (!string_is_equal(entry->info_path, info_path))
          continue;
 
-      info->firmware = firmware;
+      cache->hint = idx + 1;
 
-      for (c = 0; c < count; c++)
+      if (     entry->info_size  != info_size
+            || entry->info_mtime != info_mtime)
+         return NULL;
+
+      return entry;
+   }
+
+   return NULL;
+}
+
+static void core_info_cache_clear(core_info_t *info)
+{
+   size_t i;
+
+   for (i = 0; i < ARRAY_SIZE(core_info_string_fields); i++)
+   {
+      free(CORE_INFO_STRING_FIELD(info, i));
+      CORE_INFO_STRING_FIELD(info, i) = NULL;
+   }
+
+   if (info->firmware)
+   {
+      for (i = 0; i < info->firmware_count; i++)
       {
-         char path_key[64];
-         char desc_key[64];
-         char opt_key[64];
-         struct config_entry_list 
-            *entry         = NULL;
-         bool tmp_bool     = false;
-         path_key[0]       = desc_key[0] = opt_key[0] = '\0';
+         free(info->firmware[i].path);
+         free(info->firmware[i].desc);
+      }
+      free(info->firmware);
+   }
 
-         snprintf(path_key, sizeof(path_key), "firmware%u_path", c);
-         snprintf(desc_key, sizeof(desc_key), "firmware%u_desc", c);
-         snprintf(opt_key,  sizeof(opt_key),  "firmware%u_opt",  c);
+   info->firmware       = NULL;
+   info->firmware_count = 0;
+}
 
-         entry             = config_get_entry(config, path_key);
+static bool core_info_cache_load(core_info_cache_entry_t *entry,
+      core_info_t *info)
+{
+   size_t i;
+   uint8_t flags                   = 0;
+   uint32_t firmware_count         = 0;
+   core_info_cache_reader_t reader = {0};
 
-         if (entry && !string_is_empty(entry->value))
-            info->firmware[c].path = strdup(entry->value);
+   reader.data = entry->record;
+   reader.size = entry->record_size;
+   reader.pos  = entry->payload_pos;
 
-         entry             = config_get_entry(config, desc_key);
+   for (i = 0; i < ARRAY_SIZE(core_info_string_fields); i++)
+      CORE_INFO_STRING_FIELD(info, i) = core_info_cache_dup_string(&reader);
 
-         if (entry && !string_is_empty(entry->value))
-            info->firmware[c].desc     = strdup(entry->value);
+   flags          = core_info_cache_get_u8(&reader);
+   firmware_count = core_info_cache_get_u32(&reader);
 
-         if (config_get_bool(config, opt_key , &tmp_bool))
-            info->firmware[c].optional = tmp_bool;
+   /* Every firmware takes at least 9 bytes */
+   if (     !reader.error
+         && firmware_count
+         && firmware_count <= (reader.size - reader.pos) / 9)
+   {
+      info->firmware = (core_info_firmware_t*)
+         calloc(firmware_count, sizeof(*info->firmware));
+
+      if (info->firmware)
+      {
+         info->firmware_count = firmware_count;
+
+         for (i = 0; i < firmware_count; i++)
+         {
+            info->firmware[i].path     = core_info_cache_dup_string(&reader);
+            info->firmware[i].desc     = core_info_cache_dup_string(&reader);
+            info->firmware[i].optional = core_info_cache_get_u8(&reader) != 0;
+         }
+      }
+   }
+
+   if (reader.error || info->firmware_count != firmware_count)
+   {
+      core_info_cache_clear(info);
+      return false;
+   }
+
+   info->supports_no_game              = 
+      (flags & CORE_INFO_CACHE_FLAG_SUPPORTS_NO_GAME) != 0;
+   info->database_match_archive_member = 
+      (flags & CORE_INFO_CACHE_FLAG_DB_MATCH_MEMBER)  != 0;
+   info->is_experimental               = 
+      (flags & CORE_INFO_CACHE_FLAG_EXPERIMENTAL)     != 0;
+   info->has_info                      = true;
+
+   return true;
+}
+
+static void core_info_cache_add(core_info_cache_writer_t *writer,
+      const char *info_path, uint64_t info_size, uint64_t info_mtime,
+      const core_info_t *info)
+{
+   size_t i;
+   size_t start  = writer->size;
+   uint8_t flags = 0;
+
+   if (info->supports_no_game)
+      flags |= CORE_INFO_CACHE_FLAG_SUPPORTS_NO_GAME;
+   if (info->database_match_archive_member)
+      flags |= CORE_INFO_CACHE_FLAG_DB_MATCH_MEMBER;
+   if (info->is_experimental)
+      flags |= CORE_INFO_CACHE_FLAG_EXPERIMENTAL;
+
+   /* Record size, filled in below */
+   core_info_cache_put_u32(writer, 0);
+   core_info_cache_put_string(writer, info_path);
+   core_info_cache_put_u64(writer, info_size);
+   core_info_cache_put_u64(writer, info_mtime);
+
+   for (i = 0; i < ARRAY_SIZE(core_info_string_fields); i++)
+      core_info_cache_put_string(writer,
+            CORE_INFO_STRING_FIELD(info, i));
+
+   core_info_cache_put_u8(writer, flags);
+
+   /* A firmware list that couldn't be allocated
+    * is stored as empty */
+   if (!info->firmware)
+      core_info_cache_put_u32(writer, 0);
+   else
+   {
+      core_info_cache_put_u32(writer, (uint32_t)info->firmware_count);
+
+      for (i = 0; i < info->firmware_count; i++)
+      {
+         core_info_cache_put_string(writer, info->firmware[i].path);
+         core_info_cache_put_string(writer, info->firmware[i].desc);
+         core_info_cache_put_u8(writer, info->firmware[i].optional);
       }
    }
+
+   if (writer->error)
+      return;
+
+   {
+      uint32_t record_size = (uint32_t)(writer->size - start - 4);
+      writer->data[start]     = (uint8_t)(record_size);
+      writer->data[start + 1] = (uint8_t)(record_size >> 8);
+      writer->data[start + 2] = (uint8_t)(record_size >> 16);
+      writer->data[start + 3] = (uint8_t)(record_size >> 24);
+   }
+
+   writer->count++;
+}
+
+static void core_info_cache_write(core_info_cache_writer_t *writer,
+      const char *path)
+{
+   size_t i;
+
+   if (writer->error || writer->size < CORE_INFO_CACHE_HEADER)
+      return;
+
+   for (i = 0; i < 4; i++)
+      writer->data[8 + i] = (uint8_t)(writer->count >> (i * 8));
+
+   /* The cache is only an optimisation, so a read-only
+    * location just means parsing again next time */
+   filestream_write_file(path, writer->data, writer->size);
 }
 
 static void core_info_list_free(core_info_list_t *core_info_list)
@@ -178,7 +775,6 @@ static void core_info_list_free(core_info_list_t *core_info_list)
       string_list_free(info->categories_list);
       string_list_free(info->databases_list);
       string_list_free(info->required_hw_api_list);
-      config_file_free((config_file_t*)info->config_data);
 
       for (j = 0; j < info->firmware_count; j++)
       {
@@ -195,17 +791,13 @@ static void core_info_list_free(core_info_list_t *core_info_list)
    free(core_info_list);
 }
 
-static config_file_t *core_info_list_iterate(
+static void core_info_get_info_path(
       const char *current_path,
-      const char *path_basedir)
+      const char *path_basedir,
+      char *info_path, size_t len)
 {
-   char info_path[PATH_MAX_LENGTH];
    char info_path_base[PATH_MAX_LENGTH];
 
-   if (!current_path)
-      return NULL;
-
-   info_path     [0]          = '\0';
    info_path_base[0]          = '\0';
 
    fill_pathname_base_noext(info_path_base,
@@ -224,10 +816,23 @@ static config_file_t *core_info_list_iterate(
 
    fill_pathname_join(info_path,
          path_basedir,
-         info_path_base, sizeof(info_path_base));
+         info_path_base, len);
+}
+
+static config_file_t *core_info_list_iterate(
+      const char *current_path,
+      const char *path_basedir)
+{
+   char info_path[PATH_MAX_LENGTH];
+
+   if (!current_path)
+      return NULL;
+
+   info_path[0] = '\0';
+
+   core_info_get_info_path(current_path, path_basedir,
+         info_path, sizeof(info_path));
 
-   // RARCH_LOG("core_info_list_iterate log result. current_path: %s, path_basedir: %s, info_path: %s\n",
-   //    current_path, path_basedir, info_path);
    if (path_is_valid(info_path))
       return config_file_new_from_path_to_string(info_path);
    return NULL;
@@ -236,16 +841,22 @@ static config_file_t *core_info_list_iterate(
 static core_info_list_t *core_info_list_new(const char *path,
       const char *libretro_info_dir,
       const char *exts,
-      bool dir_show_hidden_files)
+      bool dir_show_hidden_files,
+      const char *cache_dir)
 {
-   // RARCH_LOG("core_info_list_new log req. path: %s, libretro_info_dir: %s, exts: %s, dir_show_hidden_files: %u\n",
-   //    path, libretro_info_dir, exts, dir_show_hidden_files);
    size_t i;
+   char cache_path[PATH_MAX_LENGTH];
    struct string_list contents      = {0};
    core_info_t *core_info           = NULL;
    core_info_list_t *core_info_list = NULL;
+   core_info_cache_t *cache         = NULL;
+   core_info_cache_writer_t writer  = {0};
    const char       *path_basedir   = libretro_info_dir;
    bool                          ok = false;
+   bool                 cache_dirty = false;
+   bool                enable_cache = !string_is_empty(cache_dir);
+
+   cache_path[0]                    = '\0';
 
    string_list_initialize(&contents);
 
@@ -293,142 +904,77 @@ static core_info_list_t *core_info_list_new(const char *path,
    core_info_list->list    = core_info;
    core_info_list->count   = contents.size;
 
+   if (enable_cache)
+   {
+      fill_pathname_join(cache_path, cache_dir,
+            FILE_PATH_CORE_INFO_CACHE, sizeof(cache_path));
+      cache = core_info_cache_read(cache_path);
+
+      /* Header, record count is filled in on write */
+      core_info_cache_put_u32(&writer, CORE_INFO_CACHE_MAGIC);
+      core_info_cache_put_u32(&writer, CORE_INFO_CACHE_VERSION);
+      core_info_cache_put_u32(&writer, 0);
+   }
+
    for (i = 0; i < contents.size; i++)
    {
+      char info_path[PATH_MAX_LENGTH];
       const char *base_path = contents.elems[i].data;
-      config_file_t *conf   = core_info_list_iterate(base_path,
-            path_basedir);
-
-      if (conf)
-      {
-         bool tmp_bool      = false;
-         unsigned tmp_uint  = 0;
-         struct config_entry_list 
-            *entry = config_get_entry(conf, "display_name");
-
-         if (entry && !string_is_empty(entry->value))
-            core_info[i].display_name = strdup(entry->value);
-
-         entry = config_get_entry(conf, "display_version");
-
-         if (entry && !string_is_empty(entry->value))
-            core_info[i].display_version = strdup(entry->value);
-
-         entry = config_get_entry(conf, "corename");
-
-         if (entry && !string_is_empty(entry->value))
-            core_info[i].core_name = strdup(entry->value);
-
-         entry = config_get_entry(conf, "systemname");
-
-         if (entry && !string_is_empty(entry->value))
-               core_info[i].systemname = strdup(entry->value);
-
-         entry = config_get_entry(conf, "systemid");
-
-         if (entry && !string_is_empty(entry->value))
-            core_info[i].system_id = strdup(entry->value);
-
-         entry = config_get_entry(conf, "manufacturer");
-
-         if (entry && !string_is_empty(entry->value))
-            core_info[i].system_manufacturer = strdup(entry->value);
-
-         config_get_uint(conf, "firmware_count", &tmp_uint);
-         core_info[i].firmware_count = tmp_uint;
-
-         entry = config_get_entry(conf, "supported_extensions");
-
-         if (entry && !string_is_empty(entry->value))
-         {
-            core_info[i].supported_extensions      = strdup(entry->value);
-            core_info[i].supported_extensions_list =
-               string_split(core_info[i].supported_extensions, "|");
-         }
-
-         entry = config_get_entry(conf, "authors");
-
-         if (entry && !string_is_empty(entry->value))
-         {
-            core_info[i].authors      = strdup(entry->value);
-            core_info[i].authors_list =
-               string_split(core_info[i].authors, "|");
-         }
-
-         entry = config_get_entry(conf, "permissions");
-
-         if (entry && !string_is_empty(entry->value))
-         {
-            core_info[i].permissions      = strdup(entry->value);
-            core_info[i].permissions_list =
-               string_split(core_info[i].permissions, "|");
-         }
+      uint64_t info_size    = 0;
+      uint64_t info_mtime   = 0;
+      bool info_stat        = false;
 
-         entry = config_get_entry(conf, "license");
+      info_path[0]          = '\0';
 
-         if (entry && !string_is_empty(entry->value))
-         {
-            core_info[i].licenses      = strdup(entry->value);
-            core_info[i].licenses_list =
-               string_split(core_info[i].licenses, "|");
-         }
+      if (!string_is_empty(base_path))
+         core_info_get_info_path(base_path, path_basedir,
+               info_path, sizeof(info_path));
 
-         entry = config_get_entry(conf, "categories");
+      if (enable_cache && !string_is_empty(info_path))
+         info_stat = core_info_cache_stat(info_path,
+               &info_size, &info_mtime);
 
-         if (entry && !string_is_empty(entry->value))
-         {
-            core_info[i].categories      = strdup(entry->value);
-            core_info[i].categories_list =
-               string_split(core_info[i].categories, "|");
-         }
-
-         entry = config_get_entry(conf, "database");
+      if (info_stat)
+      {
+         core_info_cache_entry_t *entry = core_info_cache_find(cache,
+               info_path, info_size, info_mtime);
 
-         if (entry && !string_is_empty(entry->value))
+         if (entry && core_info_cache_load(entry, &core_info[i]))
          {
-            core_info[i].databases      = strdup(entry->value);
-            core_info[i].databases_list =
-               string_split(core_info[i].databases, "|");
+            /* Several cores may share an info file */
+            if (!entry->used)
+            {
+               core_info_cache_put(&writer,
+                     entry->record, entry->record_size);
+               writer.count++;
+               entry->used = true;
+            }
          }
+      }
 
-         entry = config_get_entry(conf, "notes");
+      if (     !core_info[i].has_info
+            && (info_stat || (!string_is_empty(info_path)
+                  && path_is_valid(info_path))))
+      {
+         config_file_t *conf = config_file_new_from_path_to_string(
+               info_path);
 
-         if (entry && !string_is_empty(entry->value))
+         if (conf)
          {
-            core_info[i].notes     = strdup(entry->value);
-            core_info[i].note_list =
-               string_split(core_info[i].notes, "|");
-         }
+            core_info_parse_config_file(&core_info[i], conf);
+            config_file_free(conf);
 
-         entry = config_get_entry(conf, "required_hw_api");
-
-         if (entry && !string_is_empty(entry->value))
-         {
-            core_info[i].required_hw_api      = strdup(entry->value);
-            core_info[i].required_hw_api_list =
-               string_split(core_info[i].required_hw_api, "|");
+            if (info_stat)
+            {
+               core_info_cache_add(&writer, info_path,
+                     info_size, info_mtime, &core_info[i]);
+               cache_dirty = true;
+            }
          }
-
-         entry = config_get_entry(conf, "description");
-
-         if (entry && !string_is_empty(entry->value))
-            core_info[i].description = strdup(entry->value);
-
-         if (config_get_bool(conf, "supports_no_game",
-                  &tmp_bool))
-            core_info[i].supports_no_game = tmp_bool;
-
-         if (config_get_bool(conf, "database_match_archive_member",
-                  &tmp_bool))
-            core_info[i].database_match_archive_member = tmp_bool;
-
-         if (config_get_bool(conf, "is_experimental",
-                  &tmp_bool))
-            core_info[i].is_experimental = tmp_bool;
-
-         core_info[i].config_data = conf;
       }
 
+      core_info_resolve_lists(&core_info[i]);
+
       if (!string_is_empty(base_path))
       {
          const char *core_filename = path_basename(base_path);
@@ -473,7 +1019,21 @@ static core_info_list_t *core_info_list_new(const char *path,
    }
 
    core_info_list_resolve_all_extensions(core_info_list);
-   core_info_list_resolve_all_firmware(core_info_list);
+
+   if (enable_cache)
+   {
+      /* Rewrite the cache when an info file was parsed
+       * or one that was cached has gone away */
+      for (i = 0; cache && i < cache->count; i++)
+         if (!cache->entries[i].used)
+            cache_dirty = true;
+
+      if (cache_dirty)
+         core_info_cache_write(&writer, cache_path);
+
+      core_info_cache_free(cache);
+      free(writer.data);
+   }
 
    string_list_deinitialize(&contents);
    return core_info_list;
@@ -653,7 +1213,7 @@ bool core_info_init_current_core(void)
    current->is_locked                     = false;
    current->firmware_count                = 0;
    current->path                          = NULL;
-   current->config_data                   = NULL;
+   current->has_info                      = false;
    current->display_name                  = NULL;
    current->display_version               = NULL;
    current->core_name                     = NULL;
@@ -704,13 +1264,14 @@ void core_info_deinit_list(void)
 }
 
 bool core_info_init_list(const char *path_info, const char *dir_cores,
-      const char *exts, bool dir_show_hidden_files)
+      const char *exts, bool dir_show_hidden_files, const char *cache_dir)
 {
    core_info_state_t *p_coreinfo = coreinfo_get_ptr();
    if (!(p_coreinfo->curr_list = core_info_list_new(dir_cores,
                !string_is_empty(path_info) ? path_info : dir_cores,
                exts,
-               dir_show_hidden_files)))
+               dir_show_hidden_files,
+               cache_dir)))
       return false;
    return true;
 }
@@ -952,9 +1513,7 @@ size_t core_info_list_num_info_files(core_info_list_t *core_info_list)
 
    for (i = 0; i < core_info_list->count; i++)
    {
-      config_file_t *conf = (config_file_t*)
-         core_info_list->list[i].config_data;
-      num += !!conf;
+      num += core_info_list->list[i].has_info;
    }
 
    return num;
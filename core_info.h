@@ -63,7 +63,6 @@ typedef struct
 typedef struct
 {
    char *path;
-   void *config_data;
    char *display_name;
    char *display_version;
    char *core_name;
@@ -91,6 +90,7 @@ typedef struct
    core_file_id_t core_file_id; /* ptr alignment */
    void *userdata;
    size_t firmware_count;
+   bool has_info;
    bool supports_no_game;
    bool database_match_archive_member;
    bool is_experimental;
@@ -176,7 +176,7 @@ bool core_info_get_current_core(core_info_t **core);
 void core_info_deinit_list(void);
 
 bool core_info_init_list(const char *path_info, const char *dir_cores,
-      const char *exts, bool show_hidden_files);
+      const char *exts, bool show_hidden_files, const char *cache_dir);
 
 bool core_info_get_list(core_info_list_t **core);
 
@@ -294,15 +294,12 @@ static int database_cursor_iterate(libretrodb_cursor_t *cur,
    return 0;
 }
 
-static int database_cursor_open(libretrodb_t *db,
-      libretrodb_cursor_t *cur, const char *path, const char *query)
+static int database_cursor_open_query(libretrodb_t *db,
+      libretrodb_cursor_t *cur, const char *query)
 {
    const char *error     = NULL;
    libretrodb_query_t *q = NULL;
 
-   if ((libretrodb_open(path, db)) != 0)
-      return -1;
-
    if (query)
       q = (libretrodb_query_t*)libretrodb_query_compile(db, query,
       strlen(query), &error);
@@ -320,11 +317,25 @@ static int database_cursor_open(libretrodb_t *db,
 error:
    if (q)
       libretrodb_query_free(q);
-   libretrodb_close(db);
 
    return -1;
 }
 
+static int database_cursor_open(libretrodb_t *db,
+      libretrodb_cursor_t *cur, const char *path, const char *query)
+{
+   if ((libretrodb_open(path, db)) != 0)
+      return -1;
+
+   if (database_cursor_open_query(db, cur, query) != 0)
+   {
+      libretrodb_close(db);
+      return -1;
+   }
+
+   return 0;
+}
+
 static int database_cursor_close(libretrodb_t *db, libretrodb_cursor_t *cur)
 {
    libretrodb_cursor_close(cur);
@@ -431,27 +442,19 @@ void database_info_free(database_info_handle_t *db)
    string_list_free(db->list);
 }
 
-database_info_list_t *database_info_list_new(
-      const char *rdb_path, const char *query)
+static database_info_list_t *database_info_list_read(
+      libretrodb_cursor_t *cur)
 {
    int ret                                  = 0;
    unsigned k                               = 0;
    database_info_t *database_info           = NULL;
    database_info_list_t *database_info_list = NULL;
-   libretrodb_t *db                         = libretrodb_new();
-   libretrodb_cursor_t *cur                 = libretrodb_cursor_new();
-
-   if (!db || !cur)
-      goto end;
-
-   if ((database_cursor_open(db, cur, rdb_path, query) != 0))
-      goto end;
 
    database_info_list = (database_info_list_t*)
       malloc(sizeof(*database_info_list));
 
    if (!database_info_list)
-      goto end;
+      return NULL;
 
    database_info_list->count  = 0;
    database_info_list->list   = NULL;
@@ -506,8 +509,7 @@ database_info_list_t *database_info_list_new(
             database_info_list_free(database_info_list);
             free(database_info);
             free(database_info_list);
-            database_info_list = NULL;
-            goto end;
+            return NULL;
          }
 
          database_info = new_ptr;
@@ -522,6 +524,24 @@ database_info_list_t *database_info_list_new(
    database_info_list->list  = database_info;
    database_info_list->count = k;
 
+   return database_info_list;
+}
+
+database_info_list_t *database_info_list_new(
+      const char *rdb_path, const char *query)
+{
+   database_info_list_t *database_info_list = NULL;
+   libretrodb_t *db                         = libretrodb_new();
+   libretrodb_cursor_t *cur                 = libretrodb_cursor_new();
+
+   if (!db || !cur)
+      goto end;
+
+   if ((database_cursor_open(db, cur, rdb_path, query) != 0))
+      goto end;
+
+   database_info_list = database_info_list_read(cur);
+
 end:
    if (db)
    {
@@ -534,6 +554,101 @@ end:
    return database_info_list;
 }
 
+struct database_info_cache_entry
+{
+   char *path;
+   libretrodb_t *db;
+};
+
+/* Databases kept open by path, see database_info_cache_list_new() */
+struct database_info_cache
+{
+   struct database_info_cache_entry *entries;
+   size_t count;
+};
+
+database_info_cache_t *database_info_cache_new(void)
+{
+   return (database_info_cache_t*)calloc(1, sizeof(database_info_cache_t));
+}
+
+void database_info_cache_free(database_info_cache_t *cache)
+{
+   size_t i;
+
+   if (!cache)
+      return;
+
+   for (i = 0; i < cache->count; i++)
+   {
+      libretrodb_close(cache->entries[i].db);
+      libretrodb_free(cache->entries[i].db);
+      free(cache->entries[i].path);
+   }
+
+   free(cache->entries);
+   free(cache);
+}
+
+static libretrodb_t *database_info_cache_open(database_info_cache_t *cache,
+      const char *rdb_path)
+{
+   size_t i;
+   libretrodb_t *db;
+   struct database_info_cache_entry *entries;
+
+   for (i = 0; i < cache->count; i++)
+      if (string_is_equal(cache->entries[i].path, rdb_path))
+         return cache->entries[i].db;
+
+   if (!(db = libretrodb_new()))
+      return NULL;
+
+   if (libretrodb_open(rdb_path, db) != 0)
+   {
+      libretrodb_free(db);
+      return NULL;
+   }
+
+   if (!(entries = (struct database_info_cache_entry*)realloc(
+               cache->entries, (cache->count + 1) * sizeof(*entries))))
+   {
+      libretrodb_close(db);
+      libretrodb_free(db);
+      return NULL;
+   }
+
+   cache->entries                    = entries;
+   cache->entries[cache->count].path = strdup(rdb_path);
+   cache->entries[cache->count++].db = db;
+
+   return db;
+}
+
+database_info_list_t *database_info_cache_list_new(
+      database_info_cache_t *cache, const char *rdb_path, const char *query)
+{
+   database_info_list_t *database_info_list = NULL;
+   libretrodb_t *db                         = NULL;
+   libretrodb_cursor_t *cur                 = NULL;
+
+   if (!(db = database_info_cache_open(cache, rdb_path)))
+      return NULL;
+
+   if (!(cur = libretrodb_cursor_new()))
+      return NULL;
+
+   if (database_cursor_open_query(db, cur, query) == 0)
+   {
+      database_info_list = database_info_list_read(cur);
+      libretrodb_cursor_close(cur);
+   }
+
+   libretrodb_cursor_free(cur);
+
+   return database_info_list;
+}
+
 void database_info_list_free(database_info_list_t *database_info_list)
 {
    size_t i;
@@ -587,3 +702,370 @@ void database_info_list_free(database_info_list_t *database_info_list)
 
    free(database_info_list->list);
 }
+
+/* Scan index
+ *
+ * Maps the CRC and serial of every entry of a set of databases
+ * to the database and the offset of the entry, so a scanned file
+ * resolves with a single hash lookup instead of a query over
+ * every database.
+ *
+ * The databases we ship don't carry an on-disk index, so the
+ * table is built with one cursor walk per database.
+ */
+
+#define DATABASE_INDEX_CRC    0
+#define DATABASE_INDEX_SERIAL 1
+
+struct database_info_index_entry
+{
+   uint64_t key;    /* CRC, or hash of the serial */
+   uint64_t offset; /* 0 marks an empty slot */
+   uint32_t db;
+   uint32_t type;
+};
+
+struct database_info_index
+{
+   struct database_info_index_entry *table;
+   struct string_list *paths;
+   libretrodb_t *db;          /* Database the cursor is open on */
+   libretrodb_cursor_t *cur;
+   size_t size;               /* Power of two */
+   size_t count;
+   unsigned db_open;
+   unsigned next;             /* Next database to index */
+};
+
+static uint64_t database_info_index_hash_serial(const char *s, size_t len)
+{
+   size_t i;
+   uint64_t hash = 0xcbf29ce484222325ULL;
+
+   for (i = 0; i < len; i++)
+   {
+      hash ^= (uint8_t)s[i];
+      hash *= 0x100000001b3ULL;
+   }
+
+   return hash;
+}
+
+static INLINE size_t database_info_index_slot(
+      const database_info_index_t *index, uint64_t key, uint32_t type)
+{
+   key = (key ^ type) * 0x9e3779b97f4a7c15ULL;
+   return (size_t)(key >> 32) & (index->size - 1);
+}
+
+static void database_info_index_put(database_info_index_t *index,
+      const struct database_info_index_entry *entry)
+{
+   size_t i = database_info_index_slot(index, entry->key, entry->type);
+
+   while (index->table[i].offset)
+      i = (i + 1) & (index->size - 1);
+
+   index->table[i] = *entry;
+   index->count++;
+}
+
+static bool database_info_index_insert(database_info_index_t *index,
+      uint64_t key, uint32_t type, uint32_t db, uint64_t offset)
+{
+   struct database_info_index_entry entry;
+
+   /* Keep the load factor under 1/2 */
+   if ((index->count + 1) * 2 > index->size)
+   {
+      size_t i;
+      struct database_info_index_entry *old = index->table;
+      size_t old_size                       = index->size;
+      size_t new_size                       = old_size ? old_size * 2 : 4096;
+
+      index->table = (struct database_info_index_entry*)
+         calloc(new_size, sizeof(*index->table));
+
+      if (!index->table)
+      {
+         index->table = old;
+         return false;
+      }
+
+      index->size  = new_size;
+      index->count = 0;
+
+      for (i = 0; i < old_size; i++)
+         if (old[i].offset)
+            database_info_index_put(index, &old[i]);
+
+      free(old);
+   }
+
+   entry.key    = key;
+   entry.offset = offset;
+   entry.db     = db;
+   entry.type   = type;
+
+   database_info_index_put(index, &entry);
+   return true;
+}
+
+static bool database_info_index_add_db(database_info_index_t *index,
+      const char *rdb_path, uint32_t db_index)
+{
+   struct rmsgpack_dom_value crc_key;
+   struct rmsgpack_dom_value serial_key;
+   struct rmsgpack_dom_value item;
+   uint64_t offset;
+   bool ret                 = true;
+   libretrodb_t *db         = libretrodb_new();
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   if (!db || !cur)
+      goto error;
+
+   if (database_cursor_open(db, cur, rdb_path, NULL) != 0)
+      goto error;
+
+   crc_key.type               = RDT_STRING;
+   crc_key.val.string.len     = STRLEN_CONST("crc");
+   crc_key.val.string.buff    = (char*)"crc";
+   serial_key.type            = RDT_STRING;
+   serial_key.val.string.len  = STRLEN_CONST("serial");
+   serial_key.val.string.buff = (char*)"serial";
+
+   offset                     = libretrodb_cursor_tell(cur);
+
+   while (ret && libretrodb_cursor_read_item(cur, &item) == 0)
+   {
+      if (item.type == RDT_MAP)
+      {
+         const struct rmsgpack_dom_value *val =
+            rmsgpack_dom_value_map_value(&item, &crc_key);
+
+         if (     val
+               && val->type == RDT_BINARY
+               && val->val.binary.len == sizeof(uint32_t))
+         {
+            uint32_t crc;
+            memcpy(&crc, val->val.binary.buff, sizeof(crc));
+            crc = swap_if_little32(crc);
+
+            /* Entries without a CRC never match */
+            if (crc)
+               ret = database_info_index_insert(index, crc,
+                     DATABASE_INDEX_CRC, db_index, offset);
+         }
+
+         val = rmsgpack_dom_value_map_value(&item, &serial_key);
+
+         if (     ret
+               && val
+               && (val->type == RDT_STRING || val->type == RDT_BINARY)
+               && val->val.string.len)
+            ret = database_info_index_insert(index,
+                  database_info_index_hash_serial(val->val.string.buff,
+                     val->val.string.len),
+                  DATABASE_INDEX_SERIAL, db_index, offset);
+      }
+
+      rmsgpack_dom_value_free(&item);
+      offset = libretrodb_cursor_tell(cur);
+   }
+
+   database_cursor_close(db, cur);
+   libretrodb_free(db);
+   libretrodb_cursor_free(cur);
+   return ret;
+
+error:
+   if (db)
+      libretrodb_free(db);
+   if (cur)
+      libretrodb_cursor_free(cur);
+   /* Unreadable databases simply don't contribute entries */
+   return true;
+}
+
+database_info_index_t *database_info_index_new(
+      const struct string_list *rdb_list)
+{
+   size_t i;
+   union string_list_elem_attr attr;
+   database_info_index_t *index = NULL;
+
+   if (!rdb_list)
+      return NULL;
+
+   index = (database_info_index_t*)calloc(1, sizeof(*index));
+   if (!index)
+      return NULL;
+
+   index->db_open = (unsigned)-1;
+
+   if (!(index->paths = string_list_new()))
+      goto error;
+
+   attr.i = 0;
+
+   for (i = 0; i < rdb_list->size; i++)
+      if (!string_list_append(index->paths, rdb_list->elems[i].data, attr))
+         goto error;
+
+   return index;
+
+error:
+   database_info_index_free(index);
+   return NULL;
+}
+
+int database_info_index_iterate(database_info_index_t *index)
+{
+   if (!index)
+      return -1;
+
+   if (index->next >= index->paths->size)
+      return 0;
+
+   if (!database_info_index_add_db(index,
+            index->paths->elems[index->next].data, index->next))
+      return -1;
+
+   index->next++;
+   return 1;
+}
+
+void database_info_index_free(database_info_index_t *index)
+{
+   if (!index)
+      return;
+
+   if (index->cur)
+   {
+      if (index->db_open != (unsigned)-1)
+         database_cursor_close(index->db, index->cur);
+      libretrodb_cursor_free(index->cur);
+   }
+   if (index->db)
+      libretrodb_free(index->db);
+   if (index->paths)
+      string_list_free(index->paths);
+   free(index->table);
+   free(index);
+}
+
+static bool database_info_index_find(database_info_index_t *index,
+      uint64_t key, uint32_t type, database_info_index_pos_t *pos)
+{
+   size_t i;
+   bool found           = false;
+   unsigned best_db     = 0;
+   uint64_t best_offset = 0;
+
+   if (!index || !index->size)
+      return false;
+
+   /* Duplicates live in the same probe run, pick the first
+    * entry in (database, offset) order after *pos */
+   for (i = database_info_index_slot(index, key, type);
+         index->table[i].offset; i = (i + 1) & (index->size - 1))
+   {
+      const struct database_info_index_entry *entry = &index->table[i];
+
+      if (entry->key != key || entry->type != type)
+         continue;
+
+      if (     entry->db < pos->db
+            || (entry->db == pos->db && entry->offset <= pos->offset))
+         continue;
+
+      if (     !found
+            || entry->db < best_db
+            || (entry->db == best_db && entry->offset < best_offset))
+      {
+         found       = true;
+         best_db     = entry->db;
+         best_offset = entry->offset;
+      }
+   }
+
+   if (found)
+   {
+      pos->db     = best_db;
+      pos->offset = best_offset;
+   }
+
+   return found;
+}
+
+bool database_info_index_find_crc(database_info_index_t *index,
+      uint32_t crc, database_info_index_pos_t *pos)
+{
+   if (!crc)
+      return false;
+   return database_info_index_find(index, crc, DATABASE_INDEX_CRC, pos);
+}
+
+bool database_info_index_find_serial(database_info_index_t *index,
+      const char *serial, database_info_index_pos_t *pos)
+{
+   if (string_is_empty(serial))
+      return false;
+   return database_info_index_find(index,
+         database_info_index_hash_serial(serial, strlen(serial)),
+         DATABASE_INDEX_SERIAL, pos);
+}
+
+database_info_list_t *database_info_index_read(
+      database_info_index_t *index, const database_info_index_pos_t *pos)
+{
+   database_info_list_t *database_info_list = NULL;
+
+   if (!index || pos->db >= index->paths->size)
+      return NULL;
+
+   /* Keep the last database open, matches tend to come in runs */
+   if (index->db_open != pos->db)
+   {
+      if (!index->db)
+         index->db  = libretrodb_new();
+      if (!index->cur)
+         index->cur = libretrodb_cursor_new();
+      if (!index->db || !index->cur)
+         return NULL;
+
+      if (index->db_open != (unsigned)-1)
+         database_cursor_close(index->db, index->cur);
+      index->db_open = (unsigned)-1;
+
+      if (database_cursor_open(index->db, index->cur,
+               index->paths->elems[pos->db].data, NULL) != 0)
+         return NULL;
+
+      index->db_open = pos->db;
+   }
+
+   if (libretrodb_cursor_seek(index->cur, pos->offset) != 0)
+      return NULL;
+
+   database_info_list = (database_info_list_t*)
+      malloc(sizeof(*database_info_list));
+   if (!database_info_list)
+      return NULL;
+
+   database_info_list->count = 1;
+   database_info_list->list  = (database_info_t*)
+      calloc(1, sizeof(*database_info_list->list));
+
+   if (     !database_info_list->list
+         || database_cursor_iterate(index->cur,
+            database_info_list->list) != 0)
+   {
+      free(database_info_list->list);
+      free(database_info_list);
+      return NULL;
+   }
+
+   return database_info_list;
+}
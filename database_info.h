@@ -119,11 +119,37 @@ typedef struct
    size_t count;
 } database_info_list_t;
 
+typedef struct database_info_index database_info_index_t;
+
+typedef struct database_info_cache database_info_cache_t;
+
+/* Position of an entry in a database_info_index_t:
+ * the database (as index into the list the index was built
+ * from) and the offset of the entry in that database. */
+typedef struct
+{
+   uint64_t offset;
+   unsigned db;
+} database_info_index_pos_t;
+
 database_info_list_t *database_info_list_new(const char *rdb_path,
       const char *query);
 
 void database_info_list_free(database_info_list_t *list);
 
+/* Keeps each database it is asked about open until it is freed.
+ * Field indexes the databases build in memory for a query are
+ * then reused by the next one, instead of every query walking
+ * the whole database. */
+database_info_cache_t *database_info_cache_new(void);
+
+void database_info_cache_free(database_info_cache_t *cache);
+
+/* database_info_list_new() through a database kept in @cache */
+database_info_list_t *database_info_cache_list_new(
+      database_info_cache_t *cache, const char *rdb_path,
+      const char *query);
+
 database_info_handle_t *database_info_dir_init(const char *dir,
       enum database_type type, retro_task_t *task,
       bool show_hidden_files);
@@ -133,6 +159,33 @@ database_info_handle_t *database_info_file_init(const char *path,
 
 void database_info_free(database_info_handle_t *handle);
 
+/* Creates an empty hash index over the CRC and serial fields
+ * of every database in @rdb_list. It has to be built with
+ * database_info_index_iterate() before it is searched. */
+database_info_index_t *database_info_index_new(
+      const struct string_list *rdb_list);
+
+/* Adds the next database to the index.
+ * Returns 1 if there are more to add, 0 once the index is
+ * complete and -1 on error. */
+int database_info_index_iterate(database_info_index_t *index);
+
+void database_info_index_free(database_info_index_t *index);
+
+/* Find the first entry after @pos, in database order, whose
+ * CRC (or serial) matches. Start with @pos zeroed.
+ * Updates @pos and returns true when found. */
+bool database_info_index_find_crc(database_info_index_t *index,
+      uint32_t crc, database_info_index_pos_t *pos);
+
+bool database_info_index_find_serial(database_info_index_t *index,
+      const char *serial, database_info_index_pos_t *pos);
+
+/* Reads the entry at @pos into a single entry list.
+ * Free with database_info_list_free() and free(). */
+database_info_list_t *database_info_index_read(
+      database_info_index_t *index, const database_info_index_pos_t *pos);
+
 int database_info_build_query_enum(
       char *query, size_t len, enum database_query_type type, const char *path);
 
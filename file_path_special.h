@@ -40,6 +40,7 @@ RETRO_BEGIN_DECLS
 #define FILE_PATH_BSV_EXTENSION ".bsv"
 #define FILE_PATH_OPT_EXTENSION ".opt"
 #define FILE_PATH_CORE_INFO_EXTENSION ".info"
+#define FILE_PATH_CORE_INFO_CACHE "core_info.cache"
 #define FILE_PATH_CONFIG_EXTENSION ".cfg"
 #define FILE_PATH_REMAP_EXTENSION ".rmp"
 #define FILE_PATH_RTC_EXTENSION ".rtc"
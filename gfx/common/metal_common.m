@@ -1228,14 +1228,20 @@ typedef struct MTLALIGN(16)
    settings_t        *settings  = config_get_ptr();
    const char *dir_video_shader = settings->paths.directory_video_shader;
    NSString *shadersPath = [NSString stringWithFormat:@"%s/", dir_video_shader];
+   slang_batch_t *batch  = NULL;
 
    @try
    {
       unsigned i;
+      char cache_dir[PATH_MAX_LENGTH];
       texture_t *source = NULL;
       if (!video_shader_read_conf_preset(conf, shader))
          return NO;
 
+      video_shader_get_cache_dir(cache_dir, sizeof(cache_dir));
+      batch = slang_batch_new(shader, RARCH_SHADER_METAL, 20000, cache_dir,
+            video_shader_get_compile_threads());
+
       source = &_engine.frame.texture[0];
 
       for (i = 0; i < shader->passes; source = &_engine.pass[i++].rt)
@@ -1279,7 +1285,7 @@ typedef struct MTLALIGN(16)
          };
          /* clang-format on */
 
-         if (!slang_process(shader, i, RARCH_SHADER_METAL, 20000, &semantics_map, &_engine.pass[i].semantics))
+         if (!slang_batch_process(batch, i, &semantics_map, &_engine.pass[i].semantics))
             return NO;
 
 #ifdef DEBUG
@@ -1440,6 +1446,8 @@ typedef struct MTLALIGN(16)
    }
    @finally
    {
+      slang_batch_free(batch);
+
       if (shader)
       {
          [self _freeVideoShader:shader];
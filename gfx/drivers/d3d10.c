@@ -336,7 +336,9 @@ static bool d3d10_gfx_set_shader(void* data, enum rarch_shader_type type, const
 {
 #if defined(HAVE_SLANG) && defined(HAVE_SPIRV_CROSS)
    unsigned         i;
+   char           cache_dir[PATH_MAX_LENGTH];
    config_file_t* conf     = NULL;
+   slang_batch_t* batch    = NULL;
    d3d10_texture_t* source = NULL;
    d3d10_video_t*   d3d10  = (d3d10_video_t*)data;
 
@@ -363,6 +365,10 @@ static bool d3d10_gfx_set_shader(void* data, enum rarch_shader_type type, const
    if (!video_shader_read_conf_preset(conf, d3d10->shader_preset))
       goto error;
 
+   video_shader_get_cache_dir(cache_dir, sizeof(cache_dir));
+   batch = slang_batch_new(d3d10->shader_preset, RARCH_SHADER_HLSL, 40,
+         cache_dir, video_shader_get_compile_threads());
+
    source = &d3d10->frame.texture[0];
    for (i = 0; i < d3d10->shader_preset->passes; source = &d3d10->pass[i++].rt)
    {
@@ -404,9 +410,8 @@ static bool d3d10_gfx_set_shader(void* data, enum rarch_shader_type type, const
       };
       /* clang-format on */
 
-      if (!slang_process(
-               d3d10->shader_preset, i, RARCH_SHADER_HLSL, 40, &semantics_map,
-               &d3d10->pass[i].semantics))
+      if (!slang_batch_process(
+               batch, i, &semantics_map, &d3d10->pass[i].semantics))
          goto error;
 
       {
@@ -482,6 +487,9 @@ static bool d3d10_gfx_set_shader(void* data, enum rarch_shader_type type, const
       }
    }
 
+   slang_batch_free(batch);
+   batch = NULL;
+
    for (i = 0; i < d3d10->shader_preset->luts; i++)
    {
       struct texture_image image = { 0 };
@@ -517,6 +525,7 @@ static bool d3d10_gfx_set_shader(void* data, enum rarch_shader_type type, const
    return true;
 
 error:
+   slang_batch_free(batch);
    d3d10_free_shader_preset(d3d10);
 #endif
 
@@ -342,7 +342,9 @@ static bool d3d12_gfx_set_shader(void* data, enum rarch_shader_type type, const
 {
 #if defined(HAVE_SLANG) && defined(HAVE_SPIRV_CROSS)
    unsigned         i;
+   char           cache_dir[PATH_MAX_LENGTH];
    config_file_t* conf     = NULL;
+   slang_batch_t* batch    = NULL;
    d3d12_texture_t* source = NULL;
    d3d12_video_t*   d3d12  = (d3d12_video_t*)data;
 
@@ -369,6 +371,10 @@ static bool d3d12_gfx_set_shader(void* data, enum rarch_shader_type type, const
    if (!video_shader_read_conf_preset(conf, d3d12->shader_preset))
       goto error;
 
+   video_shader_get_cache_dir(cache_dir, sizeof(cache_dir));
+   batch = slang_batch_new(d3d12->shader_preset, RARCH_SHADER_HLSL, 50,
+         cache_dir, video_shader_get_compile_threads());
+
    source = &d3d12->frame.texture[0];
    for (i = 0; i < d3d12->shader_preset->passes; source = &d3d12->pass[i++].rt)
    {
@@ -410,9 +416,8 @@ static bool d3d12_gfx_set_shader(void* data, enum rarch_shader_type type, const
       };
       /* clang-format on */
 
-      if (!slang_process(
-               d3d12->shader_preset, i, RARCH_SHADER_HLSL, 50, &semantics_map,
-               &d3d12->pass[i].semantics))
+      if (!slang_batch_process(
+               batch, i, &semantics_map, &d3d12->pass[i].semantics))
          goto error;
 
       {
@@ -508,6 +513,9 @@ static bool d3d12_gfx_set_shader(void* data, enum rarch_shader_type type, const
       }
    }
 
+   slang_batch_free(batch);
+   batch = NULL;
+
    for (i = 0; i < d3d12->shader_preset->luts; i++)
    {
       struct texture_image image = { 0 };
@@ -542,6 +550,7 @@ static bool d3d12_gfx_set_shader(void* data, enum rarch_shader_type type, const
    return true;
 
 error:
+   slang_batch_free(batch);
    d3d12_free_shader_preset(d3d12);
 #endif
    return false;
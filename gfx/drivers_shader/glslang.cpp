@@ -45,25 +45,41 @@ struct SlangProcess
       TBuiltInResource Resources;
 };
 
-/* We don't use glslang from multiple threads, but to be sure.
- * Initializing TLS and freeing it for glslang works around 
+/* Initializing TLS and freeing it for glslang works around 
  * a really bizarre issue where the TLS key is suddenly 
  * corrupted *somehow*.
+ *
+ * Compiles may overlap, but glslang re-creates its own global
+ * lock whenever it is initialized, so that must only happen
+ * while nobody else is using it. Hence the separate count.
  */
 static std::mutex glslang_global_lock;
+static unsigned glslang_users;
+
+static void glslang_acquire(void)
+{
+   std::lock_guard<std::mutex> lock(glslang_global_lock);
+   if (glslang_users++ == 0)
+      InitializeProcess();
+}
+
+static void glslang_release(void)
+{
+   std::lock_guard<std::mutex> lock(glslang_global_lock);
+   if (--glslang_users == 0)
+      FinalizeProcess();
+}
 
 struct SlangProcessHolder
 {
    SlangProcessHolder()
    {
-      glslang_global_lock.lock();
-      InitializeProcess();
+      glslang_acquire();
    }
 
    ~SlangProcessHolder()
    {
-      FinalizeProcess();
-      glslang_global_lock.unlock();
+      glslang_release();
    }
 };
 
@@ -457,3 +473,18 @@ bool glslang::compile_spirv(const string &source, Stage stage,
    GlslangToSpv(*program.getIntermediate(language), *spirv);
    return true;
 }
+
+void glslang::begin_batch(void)
+{
+   glslang_acquire();
+}
+
+void glslang::end_batch(void)
+{
+   glslang_release();
+}
+
+const char *glslang::compiler_version(void)
+{
+   return GetGlslVersionString();
+}
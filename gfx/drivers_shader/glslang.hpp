@@ -17,7 +17,17 @@ namespace glslang
         StageCompute
     };
 
+    /* Safe to call from several threads at once. */
     bool compile_spirv(const std::string &source, Stage stage, std::vector<uint32_t> *spirv);
+
+    /* Each compile_spirv() call sets glslang up and tears it
+     * down again, built-in symbol tables included. Compiles
+     * between begin_batch() and end_batch() share one setup. */
+    void begin_batch(void);
+    void end_batch(void);
+
+    /* Identifies the compiler build, for keying cached output. */
+    const char *compiler_version(void);
 }
 
 #endif
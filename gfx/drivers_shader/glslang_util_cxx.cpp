@@ -14,13 +14,23 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <vector>
 #include <algorithm>
 
 #include <retro_miscellaneous.h>
+#include <compat/strl.h>
+#include <encodings/crc32.h>
 #include <file/file_path.h>
 #include <file/config_file.h>
+#include <lists/dir_list.h>
+#include <rhash.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <rthreads/tpool.h>
+#endif
 #include <streams/file_stream.h>
 #include <string/stdstring.h>
 
@@ -35,6 +45,26 @@
 #endif
 #include "../../verbosity.h"
 
+#if defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__)
+#include <sys/stat.h>
+#include <encodings/utf.h>
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+#include <sys/types.h>
+#include <sys/stat.h>
+#endif
+
+#define SLANG_CACHE_MAGIC   0x41434c53 /* "SLCA" */
+#define SLANG_CACHE_HEADER  4
+
+/* Part of every key. Bump it whenever the layout of an
+ * entry changes, or something that affects an entry but
+ * isn't hashed into its key does (e.g. SPIRV-Cross). */
+#define SLANG_CACHE_VERSION 1
+
+/* slang_cache_prune() starts deleting entries once the
+ * cache directory holds more than this many bytes */
+#define SLANG_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
 static std::string build_stage_source(
       const struct string_list *lines, const char *stage)
 {
@@ -217,7 +247,346 @@ bool glslang_parse_meta(const struct string_list *lines, glslang_meta *meta)
    return true;
 }
 
-bool glslang_compile_shader(const char *shader_path, glslang_output *output)
+static bool slang_cache_path(const char *cache_dir,
+      const std::string &key, char *s, size_t len)
+{
+   if (string_is_empty(cache_dir))
+      return false;
+
+   fill_pathname_join(s, cache_dir, key.c_str(), len);
+   return true;
+}
+
+std::string slang_cache_key(const std::string &data)
+{
+   char hash[65];
+   std::string tagged = "slang " + std::to_string(SLANG_CACHE_VERSION)
+      + "\n" + data;
+
+   hash[0] = '\0';
+   sha256_hash(hash, (const uint8_t*)tagged.data(), tagged.size());
+   return hash;
+}
+
+/* Entries are stored as magic, version, payload size in
+ * words and payload CRC, followed by the payload. A
+ * truncated or damaged entry is a miss and gets rewritten. */
+bool slang_cache_load(const char *cache_dir,
+      const std::string &key, std::vector<uint32_t> *data)
+{
+   char path[PATH_MAX_LENGTH];
+   void *buf          = NULL;
+   int64_t len        = 0;
+   const uint32_t *in = NULL;
+   size_t count       = 0;
+   bool ret           = false;
+
+   path[0]            = '\0';
+
+   if (     !slang_cache_path(cache_dir, key, path, sizeof(path))
+         || !path_is_valid(path))
+      return false;
+
+   if (!filestream_read_file(path, &buf, &len) || !buf)
+      return false;
+
+   in    = (const uint32_t*)buf;
+   count = (size_t)len / sizeof(uint32_t);
+
+   if (     (size_t)len % sizeof(uint32_t) == 0
+         && count >= SLANG_CACHE_HEADER
+         && in[0] == SLANG_CACHE_MAGIC
+         && in[1] == SLANG_CACHE_VERSION
+         && in[2] == count - SLANG_CACHE_HEADER
+         && in[3] == encoding_crc32(0, (const uint8_t*)
+            (in + SLANG_CACHE_HEADER), in[2] * sizeof(uint32_t)))
+   {
+      data->assign(in + SLANG_CACHE_HEADER, in + count);
+      ret = true;
+   }
+   else
+      RARCH_WARN("[slang]: Ignoring damaged cache entry \"%s\".\n", path);
+
+   free(buf);
+   return ret;
+}
+
+void slang_cache_store(const char *cache_dir,
+      const std::string &key, const std::vector<uint32_t> &data)
+{
+   char path[PATH_MAX_LENGTH];
+   char tmp_path[PATH_MAX_LENGTH];
+   std::vector<uint32_t> out;
+
+   path[0] = tmp_path[0] = '\0';
+
+   if (!slang_cache_path(cache_dir, key, path, sizeof(path)))
+      return;
+
+   if (!path_is_directory(cache_dir) && !path_mkdir(cache_dir))
+      return;
+
+   out.reserve(SLANG_CACHE_HEADER + data.size());
+   out.push_back(SLANG_CACHE_MAGIC);
+   out.push_back(SLANG_CACHE_VERSION);
+   out.push_back((uint32_t)data.size());
+   out.push_back(encoding_crc32(0, (const uint8_t*)data.data(),
+            data.size() * sizeof(uint32_t)));
+   out.insert(out.end(), data.begin(), data.end());
+
+   /* Another instance, or another pass compiled in parallel,
+    * may store or load the same entry at once, so never let
+    * a reader see it half written */
+#ifdef HAVE_THREADS
+   snprintf(tmp_path, sizeof(tmp_path), "%s.%lx.tmp", path,
+         (unsigned long)sthread_get_current_thread_id());
+#else
+   snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+#endif
+
+   if (!filestream_write_file(tmp_path, out.data(),
+            out.size() * sizeof(uint32_t)))
+   {
+      RARCH_WARN("[slang]: Failed to write cache entry \"%s\".\n", path);
+      return;
+   }
+
+   /* Renaming onto an existing file fails on Windows, which
+    * is fine if someone else just stored the same entry */
+   if (filestream_rename(tmp_path, path) != 0)
+   {
+      filestream_delete(tmp_path);
+      if (!path_is_valid(path))
+         RARCH_WARN("[slang]: Failed to write cache entry \"%s\".\n", path);
+   }
+}
+
+struct slang_cache_file
+{
+   std::string path;
+   uint64_t size;
+   uint64_t mtime;
+};
+
+/* Size and modification time of a cache entry, or false
+ * if it is gone or the platform can't tell */
+static bool slang_cache_stat(const char *path,
+      uint64_t *size, uint64_t *mtime)
+{
+#if defined(_WIN32) && !defined(_XBOX) && !defined(__WINRT__)
+   struct _stat64 buf;
+   int ret            = -1;
+   wchar_t *path_wide = utf8_to_utf16_string_alloc(path);
+
+   if (!path_wide)
+      return false;
+
+   ret = _wstat64(path_wide, &buf);
+   free(path_wide);
+
+   if (ret != 0 || (buf.st_mode & _S_IFDIR))
+      return false;
+
+   *size  = (uint64_t)buf.st_size;
+   *mtime = (uint64_t)buf.st_mtime;
+   return true;
+#elif defined(__unix__) || defined(__APPLE__) || defined(__HAIKU__)
+   struct stat buf;
+
+   if (stat(path, &buf) != 0 || S_ISDIR(buf.st_mode))
+      return false;
+
+   *size  = (uint64_t)buf.st_size;
+   *mtime = (uint64_t)buf.st_mtime;
+   return true;
+#else
+   return false;
+#endif
+}
+
+static bool slang_cache_file_older(const slang_cache_file &a,
+      const slang_cache_file &b)
+{
+   return a.mtime < b.mtime;
+}
+
+void slang_cache_prune(const char *cache_dir)
+{
+   size_t i;
+   uint64_t total           = 0;
+   struct string_list *list = NULL;
+   std::vector<slang_cache_file> files;
+
+   if (     string_is_empty(cache_dir)
+         || !(list = dir_list_new(cache_dir, NULL,
+               false, true, false, false)))
+      return;
+
+   for (i = 0; i < list->size; i++)
+   {
+      slang_cache_file file;
+      const char *path = list->elems[i].data;
+
+      /* Still being stored by someone. Where there are no
+       * modification times nothing is counted, so the cache
+       * is never pruned. */
+      if (     string_ends_with(path, ".tmp")
+            || !slang_cache_stat(path, &file.size, &file.mtime))
+         continue;
+
+      file.path  = path;
+      total     += file.size;
+      files.push_back(file);
+   }
+
+   dir_list_free(list);
+
+   if (total <= SLANG_CACHE_MAX_SIZE)
+      return;
+
+   /* Oldest first, down to well below the limit so the
+    * next preset doesn't have to prune again */
+   std::sort(files.begin(), files.end(), slang_cache_file_older);
+
+   for (i = 0; i < files.size() && total > SLANG_CACHE_MAX_SIZE / 4 * 3; i++)
+      if (filestream_delete(files[i].path.c_str()) == 0)
+         total -= files[i].size;
+
+   RARCH_LOG("[slang]: Pruned shader cache to %u KiB.\n",
+         (unsigned)(total / 1024));
+}
+
+void slang_cache_put_string(std::vector<uint32_t> *out,
+      const std::string &str)
+{
+   size_t words = (str.size() + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+   size_t pos   = out->size() + 1;
+
+   out->push_back((uint32_t)str.size());
+   out->resize(pos + words, 0);
+   if (!str.empty())
+      memcpy(out->data() + pos, str.data(), str.size());
+}
+
+void slang_cache_put_words(std::vector<uint32_t> *out,
+      const std::vector<uint32_t> &words)
+{
+   out->push_back((uint32_t)words.size());
+   out->insert(out->end(), words.begin(), words.end());
+}
+
+uint32_t slang_cache_get(slang_cache_reader *reader)
+{
+   if (reader->error || reader->pos >= reader->size)
+   {
+      reader->error = true;
+      return 0;
+   }
+   return reader->data[reader->pos++];
+}
+
+std::string slang_cache_get_string(slang_cache_reader *reader)
+{
+   size_t len   = slang_cache_get(reader);
+   size_t words = (len + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+   std::string str;
+
+   if (reader->error || words > reader->size - reader->pos)
+   {
+      reader->error = true;
+      return str;
+   }
+
+   str.assign((const char*)(reader->data + reader->pos), len);
+   reader->pos += words;
+   return str;
+}
+
+void slang_cache_get_words(slang_cache_reader *reader,
+      std::vector<uint32_t> *words)
+{
+   size_t count = slang_cache_get(reader);
+
+   if (reader->error || count > reader->size - reader->pos)
+   {
+      reader->error = true;
+      return;
+   }
+
+   words->assign(reader->data + reader->pos,
+         reader->data + reader->pos + count);
+   reader->pos += count;
+}
+
+#ifdef HAVE_THREADS
+struct slang_parallel_state
+{
+   void (*job)(void *data, unsigned index);
+   void *data;
+};
+
+static void slang_parallel_range(void *arg, size_t begin, size_t end)
+{
+   slang_parallel_state *state = (slang_parallel_state*)arg;
+
+   for (; begin < end; begin++)
+      state->job(state->data, (unsigned)begin);
+}
+#endif
+
+void slang_parallel_run(unsigned count, unsigned num_threads,
+      void (*job)(void *data, unsigned index), void *data)
+{
+   unsigned i;
+#ifdef HAVE_THREADS
+   tpool_t *tp = NULL;
+
+   if (num_threads > count)
+      num_threads = count;
+
+   /* The calling thread takes part, so the pool only needs
+    * the other threads. If it can't be created, everything
+    * runs on the calling thread. */
+   if (num_threads > 1 && (tp = tpool_create(num_threads - 1)))
+   {
+      slang_parallel_state state;
+
+      state.job  = job;
+      state.data = data;
+
+      tpool_parallel_for(tp, count, 1, slang_parallel_range, &state);
+      tpool_destroy(tp);
+      return;
+   }
+#endif
+
+   for (i = 0; i < count; i++)
+      job(data, i);
+}
+
+#if defined(HAVE_GLSLANG)
+static bool glslang_compile_stage(const char *cache_dir,
+      const std::string &source, glslang::Stage stage,
+      std::vector<uint32_t> *spirv)
+{
+   std::string key = slang_cache_key(std::string("spirv ")
+         + glslang::compiler_version()
+         + (stage == glslang::StageVertex ? " vertex\n" : " fragment\n")
+         + source);
+
+   if (slang_cache_load(cache_dir, key, spirv))
+      return true;
+
+   if (!glslang::compile_spirv(source, stage, spirv))
+      return false;
+
+   slang_cache_store(cache_dir, key, *spirv);
+   return true;
+}
+#endif
+
+bool glslang_compile_shader(const char *shader_path, glslang_output *output,
+      const char *cache_dir)
 {
 #if defined(HAVE_GLSLANG)
    struct string_list lines;
@@ -233,14 +602,16 @@ bool glslang_compile_shader(const char *shader_path, glslang_output *output)
    if (!glslang_parse_meta(&lines, &output->meta))
       goto error;
 
-   if (!glslang::compile_spirv(build_stage_source(&lines, "vertex"),
+   if (!glslang_compile_stage(cache_dir,
+            build_stage_source(&lines, "vertex"),
             glslang::StageVertex, &output->vertex))
    {
       RARCH_ERR("Failed to compile vertex shader stage.\n");
       goto error;
    }
 
-   if (!glslang::compile_spirv(build_stage_source(&lines, "fragment"),
+   if (!glslang_compile_stage(cache_dir,
+            build_stage_source(&lines, "fragment"),
             glslang::StageFragment, &output->fragment))
    {
       RARCH_ERR("Failed to compile fragment shader stage.\n");
@@ -257,3 +628,49 @@ error:
 
    return false;
 }
+
+struct glslang_compile_job
+{
+   const char *const *paths;
+   const char *cache_dir;
+   glslang_output *outputs;
+   bool *compiled;
+};
+
+static void glslang_compile_job_run(void *data, unsigned index)
+{
+   glslang_compile_job *job = (glslang_compile_job*)data;
+
+   job->compiled[index] = glslang_compile_shader(
+         job->paths[index], &job->outputs[index], job->cache_dir);
+}
+
+bool glslang_compile_shaders(const char *const *paths, unsigned count,
+      glslang_output *outputs, bool *compiled, const char *cache_dir,
+      unsigned num_threads)
+{
+#if defined(HAVE_GLSLANG)
+   unsigned i;
+   glslang_compile_job job;
+
+   job.paths     = paths;
+   job.cache_dir = cache_dir;
+   job.outputs   = outputs;
+   job.compiled  = compiled;
+
+   /* Once per preset, before it adds its own entries */
+   slang_cache_prune(cache_dir);
+
+   glslang::begin_batch();
+   slang_parallel_run(count, num_threads, glslang_compile_job_run, &job);
+   glslang::end_batch();
+
+   for (i = 0; i < count; i++)
+      if (!compiled[i])
+         return false;
+
+   return true;
+#else
+   return false;
+#endif
+}
@@ -53,9 +53,64 @@ struct glslang_output
    glslang_meta meta;
 };
 
-bool glslang_compile_shader(const char *shader_path, glslang_output *output);
+/* cache_dir is the shader cache directory, see
+ * video_shader_get_cache_dir(). NULL compiles without
+ * the cache. */
+bool glslang_compile_shader(const char *shader_path, glslang_output *output,
+      const char *cache_dir);
+
+/* Compiles paths[i] into outputs[i] for every i, on up to
+ * num_threads threads, and sets compiled[i] to whether it
+ * succeeded. Returns false if any of them failed. */
+bool glslang_compile_shaders(const char *const *paths, unsigned count,
+      glslang_output *outputs, bool *compiled, const char *cache_dir,
+      unsigned num_threads);
+
+/* Calls job(data, index) once for every index below count,
+ * spread over up to num_threads threads (the calling one
+ * included), and returns when all calls have. */
+void slang_parallel_run(unsigned count, unsigned num_threads,
+      void (*job)(void *data, unsigned index), void *data);
 
 /* Helpers for internal use. */
 bool glslang_parse_meta(const struct string_list *lines, glslang_meta *meta);
 
+/* On-disk cache of compiler output.
+ * Entries are blobs of 32-bit words, addressed by a key
+ * hashed from everything that went into producing them.
+ * Every function takes the cache directory, and does
+ * nothing if it is NULL or empty. */
+struct slang_cache_reader
+{
+   const uint32_t *data;
+   size_t size;
+   size_t pos;
+   bool error;
+};
+
+std::string slang_cache_key(const std::string &data);
+
+bool slang_cache_load(const char *cache_dir,
+      const std::string &key, std::vector<uint32_t> *data);
+
+void slang_cache_store(const char *cache_dir,
+      const std::string &key, const std::vector<uint32_t> &data);
+
+/* Deletes the oldest entries if the cache has grown
+ * past its size limit */
+void slang_cache_prune(const char *cache_dir);
+
+void slang_cache_put_string(std::vector<uint32_t> *out,
+      const std::string &str);
+
+void slang_cache_put_words(std::vector<uint32_t> *out,
+      const std::vector<uint32_t> &words);
+
+uint32_t slang_cache_get(slang_cache_reader *reader);
+
+std::string slang_cache_get_string(slang_cache_reader *reader);
+
+void slang_cache_get_words(slang_cache_reader *reader,
+      std::vector<uint32_t> *words);
+
 #endif
@@ -2146,6 +2146,10 @@ gl_core_filter_chain_t *gl_core_filter_chain_create_from_preset(
       const char *path, glslang_filter_chain_filter filter)
 {
    unsigned i;
+   char cache_dir[PATH_MAX_LENGTH];
+   const char *paths[GFX_MAX_SHADERS];
+   bool compiled[GFX_MAX_SHADERS];
+   vector<glslang_output> outputs;
    config_file_t *conf            = NULL;
    unique_ptr<video_shader> shader{ new video_shader() };
    if (!shader)
@@ -2171,9 +2175,19 @@ gl_core_filter_chain_t *gl_core_filter_chain_create_from_preset(
 
    shader->num_parameters = 0;
 
+   /* Passes don't depend on each other until they're
+    * linked up below, so compile them all at once */
+   for (i = 0; i < shader->passes; i++)
+      paths[i] = shader->pass[i].source.path;
+
+   outputs.resize(shader->passes);
+   video_shader_get_cache_dir(cache_dir, sizeof(cache_dir));
+   glslang_compile_shaders(paths, shader->passes, outputs.data(), compiled,
+         cache_dir, video_shader_get_compile_threads());
+
    for (i = 0; i < shader->passes; i++)
    {
-      glslang_output output;
+      glslang_output &output = outputs[i];
       struct gl_core_filter_chain_pass_info pass_info;
       const video_shader_pass *pass      = &shader->pass[i];
       const video_shader_pass *next_pass =
@@ -2189,7 +2203,7 @@ gl_core_filter_chain_t *gl_core_filter_chain_create_from_preset(
       pass_info.address       = GLSLANG_FILTER_CHAIN_ADDRESS_REPEAT;
       pass_info.max_levels    = 0;
 
-      if (!glslang_compile_shader(pass->source.path, &output))
+      if (!compiled[i])
       {
          RARCH_ERR("Failed to compile shader: \"%s\".\n",
                pass->source.path);
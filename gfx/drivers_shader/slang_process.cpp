@@ -100,22 +100,20 @@ static string get_size_semantic_name(
    return get_semantic_name(reflection.texture_semantic_uniform_map, semantic, index);
 }
 
-static bool slang_process_reflection(
-      const Compiler*        vs_compiler,
-      const Compiler*        ps_compiler,
-      const ShaderResources& vs_resources,
-      const ShaderResources& ps_resources,
-      video_shader*          shader_info,
-      unsigned               pass_number,
-      const semantics_map_t* map,
-      pass_semantics_t*      out)
+struct slang_semantic_maps
 {
-   int semantic;
-   unsigned i;
-   vector<texture_sem_t> textures;
-   vector<uniform_sem_t> uniforms[SLANG_CBUFFER_MAX];
    unordered_map<string, slang_texture_semantic_map> texture_semantic_map;
    unordered_map<string, slang_texture_semantic_map> texture_semantic_uniform_map;
+   unordered_map<string, slang_semantic_map>         uniform_semantic_map;
+};
+
+static bool slang_build_semantic_maps(
+      const video_shader*  shader_info,
+      unsigned             pass_number,
+      unsigned             num_parameters,
+      slang_semantic_maps* maps)
+{
+   unsigned i;
 
    for (i = 0; i <= pass_number; i++)
    {
@@ -125,25 +123,25 @@ static bool slang_process_reflection(
       string name = shader_info->pass[i].alias;
 
       if (!slang_set_unique_map(
-                texture_semantic_map, name,
+                maps->texture_semantic_map, name,
                 slang_texture_semantic_map{
                 SLANG_TEXTURE_SEMANTIC_PASS_OUTPUT, i }))
          return false;
 
       if (!slang_set_unique_map(
-                texture_semantic_uniform_map, name + "Size",
+                maps->texture_semantic_uniform_map, name + "Size",
                 slang_texture_semantic_map{
                 SLANG_TEXTURE_SEMANTIC_PASS_OUTPUT, i }))
          return false;
 
       if (!slang_set_unique_map(
-                texture_semantic_map, name + "Feedback",
+                maps->texture_semantic_map, name + "Feedback",
                 slang_texture_semantic_map{
                 SLANG_TEXTURE_SEMANTIC_PASS_FEEDBACK, i }))
          return false;
 
       if (!slang_set_unique_map(
-                texture_semantic_uniform_map, name + "FeedbackSize",
+                maps->texture_semantic_uniform_map, name + "FeedbackSize",
                 slang_texture_semantic_map{
                 SLANG_TEXTURE_SEMANTIC_PASS_FEEDBACK, i }))
          return false;
@@ -152,43 +150,95 @@ static bool slang_process_reflection(
    for (i = 0; i < shader_info->luts; i++)
    {
       if (!slang_set_unique_map(
-                texture_semantic_map, shader_info->lut[i].id,
+                maps->texture_semantic_map, shader_info->lut[i].id,
                 slang_texture_semantic_map{
                 SLANG_TEXTURE_SEMANTIC_USER, i }))
          return false;
 
       if (!slang_set_unique_map(
-                texture_semantic_uniform_map,
+                maps->texture_semantic_uniform_map,
                 string(shader_info->lut[i].id) + "Size",
                 slang_texture_semantic_map{
                 SLANG_TEXTURE_SEMANTIC_USER, i }))
          return false;
    }
 
-   unordered_map<string, slang_semantic_map> uniform_semantic_map;
-
-   for (i = 0; i < shader_info->num_parameters; i++)
+   for (i = 0; i < num_parameters; i++)
    {
       if (!slang_set_unique_map(
-                uniform_semantic_map, shader_info->parameters[i].id,
+                maps->uniform_semantic_map, shader_info->parameters[i].id,
                 slang_semantic_map{ SLANG_SEMANTIC_FLOAT_PARAMETER, i }))
          return false;
    }
 
-   slang_reflection sl_reflection;
-   sl_reflection.pass_number                  = pass_number;
-   sl_reflection.texture_semantic_map         = &texture_semantic_map;
-   sl_reflection.texture_semantic_uniform_map = &texture_semantic_uniform_map;
-   sl_reflection.semantic_map                 = &uniform_semantic_map;
+   return true;
+}
 
-   if (!slang_reflect(*vs_compiler, *ps_compiler,
-            vs_resources, ps_resources, &sl_reflection))
-   {
-      RARCH_ERR("[slang]: Failed to reflect SPIR-V."
-            " Resource usage is inconsistent with "
-                "expectations.\n");
-      return false;
-   }
+/* Cached results of a pass depend on its SPIR-V, the
+ * target and the names the semantic maps are built from */
+static string slang_process_cache_key(
+      const glslang_output&  output,
+      const video_shader*    shader_info,
+      unsigned               pass_number,
+      unsigned               num_parameters,
+      enum rarch_shader_type dst_type,
+      unsigned               version)
+{
+   unsigned i;
+   vector<uint32_t> data;
+
+   data.push_back(dst_type);
+   data.push_back(version);
+   data.push_back(pass_number);
+   slang_cache_put_words(&data, output.vertex);
+   slang_cache_put_words(&data, output.fragment);
+
+   for (i = 0; i <= pass_number; i++)
+      slang_cache_put_string(&data, shader_info->pass[i].alias);
+
+   data.push_back(shader_info->luts);
+   for (i = 0; i < shader_info->luts; i++)
+      slang_cache_put_string(&data, shader_info->lut[i].id);
+
+   data.push_back(num_parameters);
+   for (i = 0; i < num_parameters; i++)
+      slang_cache_put_string(&data, shader_info->parameters[i].id);
+
+   return slang_cache_key(string("reflect\n") + string(
+            (const char*)data.data(), data.size() * sizeof(uint32_t)));
+}
+
+static bool slang_process_load_cached(
+      const vector<uint32_t>& data,
+      string*                 vs_code,
+      string*                 ps_code,
+      slang_reflection*       sl_reflection)
+{
+   slang_cache_reader reader = { data.data(), data.size(), 0, false };
+
+   *vs_code = slang_cache_get_string(&reader);
+   *ps_code = slang_cache_get_string(&reader);
+
+   if (     slang_reflection_deserialize(sl_reflection, &reader)
+         && reader.pos == reader.size)
+      return true;
+
+   vs_code->clear();
+   ps_code->clear();
+   return false;
+}
+
+static bool slang_process_reflection(
+      slang_reflection&      sl_reflection,
+      video_shader*          shader_info,
+      unsigned               pass_number,
+      const semantics_map_t* map,
+      pass_semantics_t*      out)
+{
+   int semantic;
+   unsigned i;
+   vector<texture_sem_t> textures;
+   vector<uniform_sem_t> uniforms[SLANG_CBUFFER_MAX];
 
    out->cbuffers[SLANG_CBUFFER_UBO].stage_mask = sl_reflection.ubo_stage_mask;
    out->cbuffers[SLANG_CBUFFER_UBO].binding    = sl_reflection.ubo_binding;
@@ -203,16 +253,16 @@ static bool slang_process_reflection(
       if (src.push_constant || src.uniform)
       {
          uniform_sem_t uniform;
-         const char *uniform_id = get_semantic_name(
-               sl_reflection, (slang_semantic)semantic, 0).c_str();
+         string uniform_id      = get_semantic_name(
+               sl_reflection, (slang_semantic)semantic, 0);
 
          uniform.data           = map->uniforms[semantic];
          uniform.size           = src.num_components * (unsigned)sizeof(float);
          uniform.offset         = 0;
          uniform.id[0]          = '\0';
 
-         if (!string_is_empty(uniform_id))
-            strlcpy(uniform.id, uniform_id, sizeof(uniform.id));
+         if (!uniform_id.empty())
+            strlcpy(uniform.id, uniform_id.c_str(), sizeof(uniform.id));
 
          if (src.push_constant)
          {
@@ -234,15 +284,15 @@ static bool slang_process_reflection(
       if (src.push_constant || src.uniform)
       {
          uniform_sem_t uniform;
-         const char *uniform_id = get_semantic_name(
-               sl_reflection, SLANG_SEMANTIC_FLOAT_PARAMETER, i).c_str();
+         string uniform_id      = get_semantic_name(
+               sl_reflection, SLANG_SEMANTIC_FLOAT_PARAMETER, i);
 
          uniform.data           = &shader_info->parameters[i].current;
          uniform.size           = sizeof(float);
          uniform.offset         = 0;
          uniform.id[0]          = '\0';
 
-         strlcpy(uniform.id, uniform_id, sizeof(uniform.id));
+         strlcpy(uniform.id, uniform_id.c_str(), sizeof(uniform.id));
 
          if (src.push_constant)
          {
@@ -304,10 +354,10 @@ static bool slang_process_reflection(
          if (src.push_constant || src.uniform)
          {
             uniform_sem_t uniform;
-            const char *uniform_id =
+            string uniform_id      =
                   get_size_semantic_name(
                         sl_reflection,
-                        (slang_texture_semantic)semantic, index).c_str();
+                        (slang_texture_semantic)semantic, index);
 
             uniform.data           = (void*)((uintptr_t)
                   map->textures[semantic].size
@@ -316,7 +366,7 @@ static bool slang_process_reflection(
             uniform.offset         = 0;
             uniform.id[0]          = '\0';
 
-            strlcpy(uniform.id, uniform_id, sizeof(uniform.id));
+            strlcpy(uniform.id, uniform_id.c_str(), sizeof(uniform.id));
 
             if (src.push_constant)
             {
@@ -447,21 +497,32 @@ error:
    return false;
 }
 
-bool slang_process(
-      video_shader*          shader_info,
-      unsigned               pass_number,
-      enum rarch_shader_type dst_type,
-      unsigned               version,
-      const semantics_map_t* semantics_map,
-      pass_semantics_t*      out)
+/* Pass state between compiling it with glslang and
+ * filling in its pass_semantics_t. Splitting slang_process()
+ * along these lines lets slang_batch_new() run the slow
+ * steps for all passes at once. */
+struct slang_pass_output
 {
-   glslang_output     output;
-   Compiler*          vs_compiler = NULL;
-   Compiler*          ps_compiler = NULL;
-   video_shader_pass& pass        = shader_info->pass[pass_number];
-
-   if (!glslang_compile_shader(pass.source.path, &output))
-      return false;
+   slang_semantic_maps maps;
+   slang_reflection    reflection;
+   string              vs_code;
+   string              ps_code;
+   glslang_format      format;
+   /* Parameters known once this pass was prepared; later
+    * passes' parameters don't exist yet as far as it is
+    * concerned. */
+   unsigned            num_parameters;
+};
+
+/* Has to run for each pass in order, as it adds the pass'
+ * parameters and alias to shader_info for later passes. */
+static bool slang_process_prepare(
+      video_shader*         shader_info,
+      unsigned              pass_number,
+      glslang_output&       output,
+      slang_pass_output*    pass_out)
+{
+   video_shader_pass& pass = shader_info->pass[pass_number];
 
    if (!slang_preprocess_parse_parameters(output.meta, shader_info))
       return false;
@@ -469,27 +530,63 @@ bool slang_process(
    if (!*pass.alias && !output.meta.name.empty())
       strlcpy(pass.alias, output.meta.name.c_str(), sizeof(pass.alias) - 1);
 
-   out->format = output.meta.rt_format;
+   pass_out->format = output.meta.rt_format;
 
-   if (out->format == SLANG_FORMAT_UNKNOWN)
+   if (pass_out->format == SLANG_FORMAT_UNKNOWN)
    {
       if (pass.fbo.srgb_fbo)
-         out->format = SLANG_FORMAT_R8G8B8A8_SRGB;
+         pass_out->format = SLANG_FORMAT_R8G8B8A8_SRGB;
       else if (pass.fbo.fp_fbo)
-         out->format = SLANG_FORMAT_R16G16B16A16_SFLOAT;
+         pass_out->format = SLANG_FORMAT_R16G16B16A16_SFLOAT;
       else
-         out->format = SLANG_FORMAT_R8G8B8A8_UNORM;
+         pass_out->format = SLANG_FORMAT_R8G8B8A8_UNORM;
    }
 
-   pass.source.string.vertex   = NULL;
-   pass.source.string.fragment = NULL;
+   pass_out->num_parameters = shader_info->num_parameters;
+
+   return true;
+}
+
+/* Reflects and cross-compiles a prepared pass. Only reads
+ * shader_info, so passes can go through this concurrently. */
+static bool slang_process_cross(
+      const video_shader*    shader_info,
+      unsigned               pass_number,
+      enum rarch_shader_type dst_type,
+      unsigned               version,
+      const char*            cache_dir,
+      const glslang_output&  output,
+      slang_pass_output*     pass_out)
+{
+   string              cache_key;
+   vector<uint32_t>    cached;
+   Compiler*           vs_compiler = NULL;
+   Compiler*           ps_compiler = NULL;
+
+   if (!slang_build_semantic_maps(shader_info, pass_number,
+            pass_out->num_parameters, &pass_out->maps))
+      return false;
+
+   pass_out->reflection.pass_number                  = pass_number;
+   pass_out->reflection.texture_semantic_map         =
+      &pass_out->maps.texture_semantic_map;
+   pass_out->reflection.texture_semantic_uniform_map =
+      &pass_out->maps.texture_semantic_uniform_map;
+   pass_out->reflection.semantic_map                 =
+      &pass_out->maps.uniform_semantic_map;
+
+   cache_key = slang_process_cache_key(output, shader_info, pass_number,
+         pass_out->num_parameters, dst_type, version);
+
+   if (     slang_cache_load(cache_dir, cache_key, &cached)
+         && slang_process_load_cached(cached,
+            &pass_out->vs_code, &pass_out->ps_code, &pass_out->reflection))
+      return true;
 
    try
    {
       ShaderResources vs_resources;
       ShaderResources ps_resources;
-      string          vs_code;
-      string          ps_code;
 
       switch (dst_type)
       {
@@ -543,8 +640,8 @@ bool slang_process(
                options.shader_model     = version;
                vs->set_hlsl_options(options);
                ps->set_hlsl_options(options);
-               vs_code = vs->compile();
-               ps_code = ps->compile();
+               pass_out->vs_code = vs->compile();
+               pass_out->ps_code = ps->compile();
             }
 #endif
             break;
@@ -601,8 +698,8 @@ bool slang_process(
                remap_generic_resource(vs, vs_resources.sampled_images);
                remap_generic_resource(ps, ps_resources.sampled_images);
 
-               vs_code = vs->compile();
-               ps_code = ps->compile();
+               pass_out->vs_code = vs->compile();
+               pass_out->ps_code = ps->compile();
             }
             break;
          case RARCH_SHADER_GLSL:
@@ -614,23 +711,22 @@ bool slang_process(
                ps->set_common_options(options);
                vs->set_common_options(options);
 
-               vs_code = vs->compile();
-               ps_code = ps->compile();
+               pass_out->vs_code = vs->compile();
+               pass_out->ps_code = ps->compile();
             }
             break;
          default:
             goto error;
       }
 
-      pass.source.string.vertex   = strdup(vs_code.c_str());
-      pass.source.string.fragment = strdup(ps_code.c_str());
-
-      if (!slang_process_reflection(
-                vs_compiler, ps_compiler,
-                vs_resources, ps_resources, shader_info, pass_number,
-                semantics_map, out))
+      if (!slang_reflect(*vs_compiler, *ps_compiler,
+               vs_resources, ps_resources, &pass_out->reflection))
+      {
+         RARCH_ERR("[slang]: Failed to reflect SPIR-V."
+               " Resource usage is inconsistent with "
+               "expectations.\n");
          goto error;
-
+      }
    }
    catch (const std::exception& e)
    {
@@ -638,20 +734,168 @@ bool slang_process(
       goto error;
    }
 
+   cached.clear();
+   slang_cache_put_string(&cached, pass_out->vs_code);
+   slang_cache_put_string(&cached, pass_out->ps_code);
+   slang_reflection_serialize(pass_out->reflection, &cached);
+   slang_cache_store(cache_dir, cache_key, cached);
+
    delete vs_compiler;
    delete ps_compiler;
 
    return true;
 
 error:
+   delete vs_compiler;
+   delete ps_compiler;
+
+   return false;
+}
+
+static bool slang_process_finish(
+      video_shader*          shader_info,
+      unsigned               pass_number,
+      const semantics_map_t* semantics_map,
+      slang_pass_output*     pass_out,
+      pass_semantics_t*      out)
+{
+   video_shader_pass& pass     = shader_info->pass[pass_number];
+
+   out->format                 = pass_out->format;
+   pass.source.string.vertex   = strdup(pass_out->vs_code.c_str());
+   pass.source.string.fragment = strdup(pass_out->ps_code.c_str());
+
+   if (slang_process_reflection(pass_out->reflection, shader_info,
+            pass_number, semantics_map, out))
+      return true;
+
    free(pass.source.string.vertex);
    free(pass.source.string.fragment);
 
    pass.source.string.vertex   = NULL;
    pass.source.string.fragment = NULL;
 
-   delete vs_compiler;
-   delete ps_compiler;
-
    return false;
 }
+
+bool slang_process(
+      video_shader*          shader_info,
+      unsigned               pass_number,
+      enum rarch_shader_type dst_type,
+      unsigned               version,
+      const semantics_map_t* semantics_map,
+      pass_semantics_t*      out)
+{
+   glslang_output    output;
+   slang_pass_output pass_out;
+   video_shader_pass& pass = shader_info->pass[pass_number];
+
+   if (!glslang_compile_shader(pass.source.path, &output, NULL))
+      return false;
+
+   if (!slang_process_prepare(shader_info, pass_number, output, &pass_out))
+      return false;
+
+   pass.source.string.vertex   = NULL;
+   pass.source.string.fragment = NULL;
+
+   if (!slang_process_cross(shader_info, pass_number, dst_type, version,
+            NULL, output, &pass_out))
+      return false;
+
+   return slang_process_finish(shader_info, pass_number,
+         semantics_map, &pass_out, out);
+}
+
+struct slang_batch
+{
+   video_shader*             shader_info;
+   enum rarch_shader_type    dst_type;
+   unsigned                  version;
+   const char*               cache_dir;
+   /* Passes that made it through slang_process_prepare(),
+    * which stops at the first failure like slang_process()
+    * called pass by pass would */
+   unsigned                  num_prepared;
+   vector<glslang_output>    outputs;
+   vector<slang_pass_output> passes;
+   bool                      compiled[GFX_MAX_SHADERS];
+   bool                      crossed[GFX_MAX_SHADERS];
+};
+
+static void slang_batch_cross(void *data, unsigned pass_number)
+{
+   slang_batch_t *batch          = (slang_batch_t*)data;
+
+   batch->crossed[pass_number]   = slang_process_cross(
+         batch->shader_info, pass_number,
+         batch->dst_type, batch->version, batch->cache_dir,
+         batch->outputs[pass_number], &batch->passes[pass_number]);
+}
+
+slang_batch_t *slang_batch_new(
+      video_shader*          shader_info,
+      enum rarch_shader_type dst_type,
+      unsigned               version,
+      const char*            cache_dir,
+      unsigned               num_threads)
+{
+   unsigned i;
+   const char *paths[GFX_MAX_SHADERS];
+   slang_batch_t *batch = new slang_batch_t();
+
+   batch->shader_info  = shader_info;
+   batch->dst_type     = dst_type;
+   batch->version      = version;
+   batch->cache_dir    = cache_dir;
+   batch->num_prepared = 0;
+   /* Never resized again, the reflections point into these */
+   batch->outputs.resize(shader_info->passes);
+   batch->passes.resize(shader_info->passes);
+
+   for (i = 0; i < shader_info->passes; i++)
+      paths[i] = shader_info->pass[i].source.path;
+
+   glslang_compile_shaders(paths, shader_info->passes,
+         batch->outputs.data(), batch->compiled, cache_dir, num_threads);
+
+   for (i = 0; i < shader_info->passes; i++)
+   {
+      if (     !batch->compiled[i]
+            || !slang_process_prepare(shader_info, i,
+               batch->outputs[i], &batch->passes[i]))
+         break;
+
+      shader_info->pass[i].source.string.vertex   = NULL;
+      shader_info->pass[i].source.string.fragment = NULL;
+      batch->num_prepared++;
+   }
+
+   slang_parallel_run(batch->num_prepared, num_threads,
+         slang_batch_cross, batch);
+
+   /* Only needed while the passes were compiled */
+   batch->cache_dir    = NULL;
+
+   return batch;
+}
+
+bool slang_batch_process(
+      slang_batch_t*         batch,
+      unsigned               pass_number,
+      const semantics_map_t* semantics_map,
+      pass_semantics_t*      out)
+{
+   if (     !batch
+         || pass_number >= batch->num_prepared
+         || !batch->crossed[pass_number])
+      return false;
+
+   return slang_process_finish(batch->shader_info, pass_number,
+         semantics_map, &batch->passes[pass_number], out);
+}
+
+void slang_batch_free(slang_batch_t *batch)
+{
+   delete batch;
+}
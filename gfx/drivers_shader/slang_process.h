@@ -91,6 +91,7 @@ RETRO_BEGIN_DECLS
 bool slang_preprocess_parse_parameters(const char *shader_path,
       struct video_shader *shader);
 
+/* Doesn't use the shader cache */
 bool slang_process(
       struct video_shader*   shader_info,
       unsigned               pass_number,
@@ -99,6 +100,30 @@ bool slang_process(
       const semantics_map_t* semantics_map,
       pass_semantics_t*      out);
 
+typedef struct slang_batch slang_batch_t;
+
+/* Does the work of slang_process() for every pass of
+ * shader_info up front, compiling and reflecting the passes
+ * on up to num_threads threads.
+ * slang_batch_process() then stands in for slang_process()
+ * and must be called for each pass in order, with
+ * shader_info left untouched in between.
+ * cache_dir is the shader cache directory, or NULL. */
+slang_batch_t *slang_batch_new(
+      struct video_shader*   shader_info,
+      enum rarch_shader_type dst_type,
+      unsigned               version,
+      const char*            cache_dir,
+      unsigned               num_threads);
+
+bool slang_batch_process(
+      slang_batch_t*         batch,
+      unsigned               pass_number,
+      const semantics_map_t* semantics_map,
+      pass_semantics_t*      out);
+
+void slang_batch_free(slang_batch_t *batch);
+
 RETRO_END_DECLS
 
 #ifdef __cplusplus
@@ -736,3 +736,126 @@ bool slang_reflect_spirv(const std::vector<uint32_t> &vertex,
       return false;
    }
 }
+
+static void slang_serialize_semantic(const slang_semantic_meta &meta,
+      std::vector<uint32_t> *out)
+{
+   out->push_back((uint32_t)meta.ubo_offset);
+   out->push_back((uint32_t)meta.push_constant_offset);
+   out->push_back(meta.num_components);
+   out->push_back((meta.uniform ? 1 : 0) | (meta.push_constant ? 2 : 0));
+}
+
+static void slang_deserialize_semantic(slang_semantic_meta *meta,
+      slang_cache_reader *reader)
+{
+   uint32_t flags;
+   meta->ubo_offset           = slang_cache_get(reader);
+   meta->push_constant_offset = slang_cache_get(reader);
+   meta->num_components       = slang_cache_get(reader);
+   flags                      = slang_cache_get(reader);
+   meta->uniform              = (flags & 1) != 0;
+   meta->push_constant        = (flags & 2) != 0;
+}
+
+void slang_reflection_serialize(const slang_reflection &reflection,
+      std::vector<uint32_t> *out)
+{
+   unsigned i;
+
+   out->push_back((uint32_t)reflection.ubo_size);
+   out->push_back((uint32_t)reflection.push_constant_size);
+   out->push_back(reflection.ubo_binding);
+   out->push_back(reflection.ubo_stage_mask);
+   out->push_back(reflection.push_constant_stage_mask);
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      out->push_back((uint32_t)reflection.semantic_textures[i].size());
+
+      for (auto &meta : reflection.semantic_textures[i])
+      {
+         out->push_back((uint32_t)meta.ubo_offset);
+         out->push_back((uint32_t)meta.push_constant_offset);
+         out->push_back(meta.binding);
+         out->push_back(meta.stage_mask);
+         out->push_back((meta.texture ? 1 : 0)
+               | (meta.uniform ? 2 : 0) | (meta.push_constant ? 4 : 0));
+      }
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      slang_serialize_semantic(reflection.semantics[i], out);
+
+   out->push_back((uint32_t)reflection.semantic_float_parameters.size());
+   for (auto &meta : reflection.semantic_float_parameters)
+      slang_serialize_semantic(meta, out);
+}
+
+bool slang_reflection_deserialize(slang_reflection *reflection,
+      slang_cache_reader *reader)
+{
+   unsigned i, j;
+   uint32_t count;
+   slang_reflection tmp;
+
+   tmp.ubo_size                 = slang_cache_get(reader);
+   tmp.push_constant_size       = slang_cache_get(reader);
+   tmp.ubo_binding              = slang_cache_get(reader);
+   tmp.ubo_stage_mask           = slang_cache_get(reader);
+   tmp.push_constant_stage_mask = slang_cache_get(reader);
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+   {
+      /* Every texture takes 5 words */
+      count = slang_cache_get(reader);
+      if (reader->error || count > (reader->size - reader->pos) / 5)
+         return false;
+
+      tmp.semantic_textures[i].resize(count);
+
+      for (j = 0; j < count; j++)
+      {
+         uint32_t flags;
+         slang_texture_semantic_meta &meta = tmp.semantic_textures[i][j];
+
+         meta.ubo_offset           = slang_cache_get(reader);
+         meta.push_constant_offset = slang_cache_get(reader);
+         meta.binding              = slang_cache_get(reader);
+         meta.stage_mask           = slang_cache_get(reader);
+         flags                     = slang_cache_get(reader);
+         meta.texture              = (flags & 1) != 0;
+         meta.uniform              = (flags & 2) != 0;
+         meta.push_constant        = (flags & 4) != 0;
+      }
+   }
+
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      slang_deserialize_semantic(&tmp.semantics[i], reader);
+
+   /* Every parameter takes 4 words */
+   count = slang_cache_get(reader);
+   if (reader->error || count > (reader->size - reader->pos) / 4)
+      return false;
+
+   tmp.semantic_float_parameters.resize(count);
+   for (j = 0; j < count; j++)
+      slang_deserialize_semantic(&tmp.semantic_float_parameters[j], reader);
+
+   if (reader->error)
+      return false;
+
+   reflection->ubo_size                 = tmp.ubo_size;
+   reflection->push_constant_size       = tmp.push_constant_size;
+   reflection->ubo_binding              = tmp.ubo_binding;
+   reflection->ubo_stage_mask           = tmp.ubo_stage_mask;
+   reflection->push_constant_stage_mask = tmp.push_constant_stage_mask;
+
+   for (i = 0; i < SLANG_NUM_TEXTURE_SEMANTICS; i++)
+      reflection->semantic_textures[i].swap(tmp.semantic_textures[i]);
+   for (i = 0; i < SLANG_NUM_SEMANTICS; i++)
+      reflection->semantics[i] = tmp.semantics[i];
+   reflection->semantic_float_parameters.swap(tmp.semantic_float_parameters);
+
+   return true;
+}
@@ -21,6 +21,9 @@
 #include <stdint.h>
 #include <spirv_cross.hpp>
 
+#include "glslang_util.h"
+#include "glslang_util_cxx.h"
+
 struct slang_semantic_location
 {
    int ubo_vertex    = -1;
@@ -103,4 +106,14 @@ bool slang_reflect(
       const spirv_cross::ShaderResources &fragment,
       slang_reflection *reflection);
 
+/* Stores the results of slang_reflect() for the shader
+ * cache. The semantic maps and locations are left out,
+ * as they aren't produced by reflection. Deserializing
+ * leaves *reflection untouched on failure. */
+void slang_reflection_serialize(const slang_reflection &reflection,
+      std::vector<uint32_t> *out);
+
+bool slang_reflection_deserialize(slang_reflection *reflection,
+      slang_cache_reader *reader);
+
 #endif
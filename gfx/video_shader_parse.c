@@ -25,6 +25,7 @@
 #include <compat/posix_string.h>
 #include <compat/msvc.h>
 #include <compat/strl.h>
+#include <features/features_cpu.h>
 #include <file/file_path.h>
 #include <rhash.h>
 #include <string/stdstring.h>
@@ -1184,6 +1185,54 @@ bool video_shader_is_supported(enum rarch_shader_type type)
    return BIT32_GET(flags.flags, testflag);
 }
 
+/**
+ * video_shader_get_cache_dir:
+ * @s                 : Buffer to store the directory in.
+ * @len               : Size of @s.
+ *
+ * Gets the directory compiled slang shaders are cached in:
+ * 'shader_cache' in the cache directory, or in the menu
+ * config directory if there is no cache directory.
+ *
+ * Returns: false if the shader cache is disabled.
+ **/
+bool video_shader_get_cache_dir(char *s, size_t len)
+{
+   settings_t *settings = config_get_ptr();
+   const char *base_dir = NULL;
+
+   *s                   = '\0';
+
+   if (!settings || !settings->bools.video_shader_cache_enable)
+      return false;
+
+   base_dir = settings->paths.directory_cache;
+   if (string_is_empty(base_dir))
+      base_dir = settings->paths.directory_menu_config;
+   if (string_is_empty(base_dir))
+      return false;
+
+   fill_pathname_join(s, base_dir, "shader_cache", len);
+   return true;
+}
+
+/**
+ * video_shader_get_compile_threads:
+ *
+ * Returns: the number of threads to compile the passes
+ * of a slang preset on.
+ **/
+unsigned video_shader_get_compile_threads(void)
+{
+   settings_t *settings = config_get_ptr();
+   unsigned num_threads = settings
+      ? settings->uints.video_shader_compile_threads : 1;
+
+   if (!num_threads)
+      num_threads = cpu_features_get_core_amount();
+   return num_threads;
+}
+
 const char *video_shader_get_preset_extension(enum rarch_shader_type type)
 {
    switch (type)
@@ -258,6 +258,10 @@ bool video_shader_any_supported(void);
 
 bool video_shader_check_for_changes(void);
 
+bool video_shader_get_cache_dir(char *s, size_t len);
+
+unsigned video_shader_get_compile_threads(void);
+
 const char *video_shader_to_str(enum rarch_shader_type type);
 
 const char *video_shader_get_preset_extension(enum rarch_shader_type type);
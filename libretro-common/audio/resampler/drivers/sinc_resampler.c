@@ -59,6 +59,14 @@ enum sinc_window
    SINC_WINDOW_LANCZOS
 };
 
+/* Number of input frames the FMA path appends to its
+ * linear history before sliding the last 'taps' frames
+ * back to the start of the buffer. */
+#define SINC_BLOCK_FRAMES 512
+
+/* Number of output frames computed per FMA kernel call. */
+#define SINC_BLOCK_OUTPUTS 4
+
 /* For the little amount of taps we're using,
  * SSE1 is faster than AVX for some reason.
  * AVX code is kept here though as by increasing number
@@ -75,6 +83,7 @@ typedef struct rarch_sinc_resampler
    float *buffer_l;
    float *buffer_r;
    unsigned enable_avx;
+   unsigned enable_fma;
    unsigned phase_bits;
    unsigned subphase_bits;
    unsigned subphase_mask;
@@ -148,6 +157,235 @@ static void resampler_sinc_process_neon(void *re_, struct resampler_data *data)
 }
 #endif
 
+#if defined(__AVX__) && defined(__FMA__)
+/* Block polyphase path.
+ *
+ * Unlike the other paths, history is kept as a linear, forward
+ * buffer (oldest sample first) and the Kaiser table is stored
+ * reversed, with values and deltas interleaved in groups of 8:
+ *
+ * phase N: [8 values][8 deltas][8 values][8 deltas] ...
+ *
+ * Each group is exactly one cache line, so interpolating a
+ * coefficient and applying it are a pair of aligned loads.
+ * Output frames are queued up and computed SINC_BLOCK_OUTPUTS
+ * at a time so the history loads can be shared in cache
+ * between neighbouring frames. */
+struct sinc_fma_output
+{
+   unsigned end;
+   uint32_t time;
+};
+
+static void resampler_sinc_fma_kernel1(rarch_sinc_resampler_t *resamp,
+      const struct sinc_fma_output *pending, float *output)
+{
+   unsigned i;
+   __m128 sum;
+   unsigned taps            = resamp->taps;
+   const float *buffer_l    = resamp->buffer_l + pending->end - taps;
+   const float *buffer_r    = resamp->buffer_r + pending->end - taps;
+   const float *phase_table = resamp->phase_table +
+      (pending->time >> resamp->subphase_bits) * taps * 2;
+   __m256 delta             = _mm256_set1_ps((float)
+         (pending->time & resamp->subphase_mask) * resamp->subphase_mod);
+   __m256 sum_l             = _mm256_setzero_ps();
+   __m256 sum_r             = _mm256_setzero_ps();
+
+   for (i = 0; i < taps; i += 8, phase_table += 16)
+   {
+      __m256 sinc = _mm256_fmadd_ps(_mm256_load_ps(phase_table + 8),
+            delta, _mm256_load_ps(phase_table));
+      sum_l       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_l + i), sinc, sum_l);
+      sum_r       = _mm256_fmadd_ps(_mm256_loadu_ps(buffer_r + i), sinc, sum_r);
+   }
+
+   /* { L, R, L, R } in each lane after two hadds. */
+   sum_l = _mm256_hadd_ps(sum_l, sum_r);
+   sum_l = _mm256_hadd_ps(sum_l, sum_l);
+   sum   = _mm_add_ps(_mm256_castps256_ps128(sum_l),
+         _mm256_extractf128_ps(sum_l, 1));
+
+   _mm_storel_pi((__m64*)output, sum);
+}
+
+static void resampler_sinc_fma_kernel4(rarch_sinc_resampler_t *resamp,
+      const struct sinc_fma_output *pending, float *output)
+{
+   unsigned i;
+   __m256 t0, t1, t2, t3;
+   unsigned taps            = resamp->taps;
+   size_t phase_stride      = taps * 2;
+   const float *l0          = resamp->buffer_l + pending[0].end - taps;
+   const float *l1          = resamp->buffer_l + pending[1].end - taps;
+   const float *l2          = resamp->buffer_l + pending[2].end - taps;
+   const float *l3          = resamp->buffer_l + pending[3].end - taps;
+   const float *r0          = resamp->buffer_r + pending[0].end - taps;
+   const float *r1          = resamp->buffer_r + pending[1].end - taps;
+   const float *r2          = resamp->buffer_r + pending[2].end - taps;
+   const float *r3          = resamp->buffer_r + pending[3].end - taps;
+   const float *p0          = resamp->phase_table +
+      (pending[0].time >> resamp->subphase_bits) * phase_stride;
+   const float *p1          = resamp->phase_table +
+      (pending[1].time >> resamp->subphase_bits) * phase_stride;
+   const float *p2          = resamp->phase_table +
+      (pending[2].time >> resamp->subphase_bits) * phase_stride;
+   const float *p3          = resamp->phase_table +
+      (pending[3].time >> resamp->subphase_bits) * phase_stride;
+   __m256 d0                = _mm256_set1_ps((float)
+         (pending[0].time & resamp->subphase_mask) * resamp->subphase_mod);
+   __m256 d1                = _mm256_set1_ps((float)
+         (pending[1].time & resamp->subphase_mask) * resamp->subphase_mod);
+   __m256 d2                = _mm256_set1_ps((float)
+         (pending[2].time & resamp->subphase_mask) * resamp->subphase_mod);
+   __m256 d3                = _mm256_set1_ps((float)
+         (pending[3].time & resamp->subphase_mask) * resamp->subphase_mod);
+   __m256 sum_l0            = _mm256_setzero_ps();
+   __m256 sum_r0            = _mm256_setzero_ps();
+   __m256 sum_l1            = _mm256_setzero_ps();
+   __m256 sum_r1            = _mm256_setzero_ps();
+   __m256 sum_l2            = _mm256_setzero_ps();
+   __m256 sum_r2            = _mm256_setzero_ps();
+   __m256 sum_l3            = _mm256_setzero_ps();
+   __m256 sum_r3            = _mm256_setzero_ps();
+
+   for (i = 0; i < taps; i += 8, p0 += 16, p1 += 16, p2 += 16, p3 += 16)
+   {
+      __m256 sinc0 = _mm256_fmadd_ps(_mm256_load_ps(p0 + 8), d0,
+            _mm256_load_ps(p0));
+      __m256 sinc1 = _mm256_fmadd_ps(_mm256_load_ps(p1 + 8), d1,
+            _mm256_load_ps(p1));
+      __m256 sinc2 = _mm256_fmadd_ps(_mm256_load_ps(p2 + 8), d2,
+            _mm256_load_ps(p2));
+      __m256 sinc3 = _mm256_fmadd_ps(_mm256_load_ps(p3 + 8), d3,
+            _mm256_load_ps(p3));
+
+      sum_l0       = _mm256_fmadd_ps(_mm256_loadu_ps(l0 + i), sinc0, sum_l0);
+      sum_r0       = _mm256_fmadd_ps(_mm256_loadu_ps(r0 + i), sinc0, sum_r0);
+      sum_l1       = _mm256_fmadd_ps(_mm256_loadu_ps(l1 + i), sinc1, sum_l1);
+      sum_r1       = _mm256_fmadd_ps(_mm256_loadu_ps(r1 + i), sinc1, sum_r1);
+      sum_l2       = _mm256_fmadd_ps(_mm256_loadu_ps(l2 + i), sinc2, sum_l2);
+      sum_r2       = _mm256_fmadd_ps(_mm256_loadu_ps(r2 + i), sinc2, sum_r2);
+      sum_l3       = _mm256_fmadd_ps(_mm256_loadu_ps(l3 + i), sinc3, sum_l3);
+      sum_r3       = _mm256_fmadd_ps(_mm256_loadu_ps(r3 + i), sinc3, sum_r3);
+   }
+
+   /* Reduce all eight accumulators at once.
+    * After the two rounds of hadd, each 128-bit lane of
+    * t0 holds partial { L0, R0, L1, R1 } and each lane of
+    * t1 holds partial { L2, R2, L3, R3 }; adding the lanes
+    * together yields the four interleaved output frames. */
+   t0 = _mm256_hadd_ps(sum_l0, sum_r0);
+   t1 = _mm256_hadd_ps(sum_l1, sum_r1);
+   t2 = _mm256_hadd_ps(sum_l2, sum_r2);
+   t3 = _mm256_hadd_ps(sum_l3, sum_r3);
+   t0 = _mm256_hadd_ps(t0, t1);
+   t1 = _mm256_hadd_ps(t2, t3);
+
+   _mm256_storeu_ps(output, _mm256_add_ps(
+            _mm256_permute2f128_ps(t0, t1, 0x20),
+            _mm256_permute2f128_ps(t0, t1, 0x31)));
+}
+
+static void resampler_sinc_process_fma(void *re_, struct resampler_data *data)
+{
+   struct sinc_fma_output pending[SINC_BLOCK_OUTPUTS];
+   rarch_sinc_resampler_t *resamp = (rarch_sinc_resampler_t*)re_;
+   unsigned phases                = 1 << (resamp->phase_bits + resamp->subphase_bits);
+   unsigned taps                  = resamp->taps;
+   unsigned capacity              = taps + SINC_BLOCK_FRAMES;
+   unsigned queued                = 0;
+
+   uint32_t ratio                 = phases / data->ratio;
+   const float *input             = data->data_in;
+   float *output                  = data->data_out;
+   size_t frames                  = data->input_frames;
+   size_t out_frames              = 0;
+
+   while (frames)
+   {
+      while (frames && resamp->time >= phases)
+      {
+         if (resamp->ptr == capacity)
+         {
+            unsigned i;
+
+            /* Pending frames still refer to the old window. */
+            for (i = 0; i < queued; i++, output += 2)
+               resampler_sinc_fma_kernel1(resamp, &pending[i], output);
+            queued = 0;
+
+            memmove(resamp->buffer_l, resamp->buffer_l + capacity - taps,
+                  taps * sizeof(float));
+            memmove(resamp->buffer_r, resamp->buffer_r + capacity - taps,
+                  taps * sizeof(float));
+            resamp->ptr = taps;
+         }
+
+         resamp->buffer_l[resamp->ptr]   = *input++;
+         resamp->buffer_r[resamp->ptr++] = *input++;
+
+         resamp->time                   -= phases;
+         frames--;
+      }
+
+      while (resamp->time < phases)
+      {
+         pending[queued].end  = resamp->ptr;
+         pending[queued].time = resamp->time;
+
+         if (++queued == SINC_BLOCK_OUTPUTS)
+         {
+            resampler_sinc_fma_kernel4(resamp, pending, output);
+            output += 2 * SINC_BLOCK_OUTPUTS;
+            queued  = 0;
+         }
+
+         out_frames++;
+         resamp->time += ratio;
+      }
+   }
+
+   if (queued)
+   {
+      unsigned i;
+      for (i = 0; i < queued; i++, output += 2)
+         resampler_sinc_fma_kernel1(resamp, &pending[i], output);
+   }
+
+   data->output_frames = out_frames;
+}
+
+/* Rewrites a Kaiser table generated by sinc_init_table_kaiser
+ * into the reversed, interleaved layout used by
+ * resampler_sinc_process_fma. */
+static bool sinc_init_table_fma(float *phase_table, int phases, int taps)
+{
+   int i, j;
+   float *tmp = (float*)malloc(2 * taps * sizeof(float));
+
+   if (!tmp)
+      return false;
+
+   for (i = 0; i < phases; i++)
+   {
+      float *phase = phase_table + i * taps * 2;
+
+      for (j = 0; j < taps; j++)
+      {
+         int dst             = (j >> 3) * 16 + (j & 7);
+         tmp[dst]            = phase[taps - 1 - j];
+         tmp[dst + 8]        = phase[taps + taps - 1 - j];
+      }
+
+      memcpy(phase, tmp, 2 * taps * sizeof(float));
+   }
+
+   free(tmp);
+   return true;
+}
+#endif
+
 #if defined(__AVX__)
 static void resampler_sinc_process_avx(void *re_, struct resampler_data *data)
 {
@@ -799,10 +1037,24 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 #endif
    }
 
+#if defined(__AVX__) && defined(__FMA__)
+   /* Every CPU with AVX2 also implements FMA3. Only take the
+    * block path when it doesn't change the filter length. */
+   if (     mask & RESAMPLER_SIMD_AVX2
+         && re->window_type == SINC_WINDOW_KAISER
+         && !(re->taps & 7))
+      re->enable_fma = 1;
+#endif
+
    phase_elems     = ((1 << re->phase_bits) * re->taps);
    if (re->window_type == SINC_WINDOW_KAISER)
       phase_elems  = phase_elems * 2;
-   elems           = phase_elems + 4 * re->taps;
+   /* The FMA path keeps a linear history instead of a
+    * mirrored ring buffer. */
+   if (re->enable_fma)
+      elems        = phase_elems + 2 * (re->taps + SINC_BLOCK_FRAMES);
+   else
+      elems        = phase_elems + 4 * re->taps;
 
    re->main_buffer = (float*)memalign_alloc(128, sizeof(float) * elems);
    if (!re->main_buffer)
@@ -812,7 +1064,14 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 
    re->phase_table = re->main_buffer;
    re->buffer_l    = re->main_buffer + phase_elems;
-   re->buffer_r    = re->buffer_l + 2 * re->taps;
+   if (re->enable_fma)
+   {
+      /* Start out with a window of silence, like the ring buffer. */
+      re->buffer_r = re->buffer_l + re->taps + SINC_BLOCK_FRAMES;
+      re->ptr      = re->taps;
+   }
+   else
+      re->buffer_r = re->buffer_l + 2 * re->taps;
 
    switch (re->window_type)
    {
@@ -830,7 +1089,16 @@ static void *resampler_sinc_new(const struct resampler_config *config,
 
    sinc_resampler.process = resampler_sinc_process_c;
 
-   if (mask & RESAMPLER_SIMD_AVX && re->enable_avx)
+   if (re->enable_fma)
+   {
+#if defined(__AVX__) && defined(__FMA__)
+      if (!sinc_init_table_fma(re->phase_table,
+               1 << re->phase_bits, re->taps))
+         goto error;
+      sinc_resampler.process = resampler_sinc_process_fma;
+#endif
+   }
+   else if (mask & RESAMPLER_SIMD_AVX && re->enable_avx)
    {
 #if defined(__AVX__)
       sinc_resampler.process = resampler_sinc_process_avx;
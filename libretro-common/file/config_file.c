@@ -50,12 +50,175 @@
 
 #define MAX_INCLUDE_DEPTH 16
 
+/* Files with fewer entries than this have no hash index,
+ * lookups just walk the list */
+#define CONFIG_FILE_MAP_MIN_ENTRIES 16
+
 struct config_include_list
 {
    char *path;
    struct config_include_list *next;
 };
 
+/* Slot of the hash index. Each key maps to its first entry
+ * in list order, which is the one a walk of the list finds.
+ * The list itself stays the authority, and keeps the order
+ * entries are written in. */
+struct config_entry_map
+{
+   struct config_entry_list *entry;
+   uint32_t hash;
+};
+
+static uint32_t config_file_map_hash(const char *key)
+{
+   /* FNV-1a */
+   uint32_t hash = 2166136261u;
+
+   while (*key)
+   {
+      hash ^= (uint8_t)*key++;
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+static void config_file_map_free(config_file_t *conf)
+{
+   free(conf->map);
+   conf->map       = NULL;
+   conf->map_size  = 0;
+   conf->map_count = 0;
+}
+
+static struct config_entry_list *config_file_map_find(
+      const config_file_t *conf, const char *key, uint32_t hash)
+{
+   size_t mask = conf->map_size - 1;
+   size_t i    = hash & mask;
+
+   while (conf->map[i].entry)
+   {
+      if (     conf->map[i].hash == hash
+            && string_is_equal(conf->map[i].entry->key, key))
+         return conf->map[i].entry;
+      i = (i + 1) & mask;
+   }
+
+   return NULL;
+}
+
+static bool config_file_map_grow(config_file_t *conf, size_t size)
+{
+   size_t i;
+   struct config_entry_map *old = conf->map;
+   size_t old_size              = conf->map_size;
+   struct config_entry_map *map = (struct config_entry_map*)
+      calloc(size, sizeof(*map));
+
+   if (!map)
+      return false;
+
+   for (i = 0; i < old_size; i++)
+   {
+      size_t j;
+
+      if (!old[i].entry)
+         continue;
+
+      j = old[i].hash & (size - 1);
+      while (map[j].entry)
+         j = (j + 1) & (size - 1);
+      map[j] = old[i];
+   }
+
+   free(old);
+   conf->map      = map;
+   conf->map_size = size;
+   return true;
+}
+
+static void config_file_map_build(config_file_t *conf, size_t count);
+
+/* Adds an entry that was appended to the list. Keys that
+ * are already indexed keep pointing at the earlier entry.
+ * Without an index this only counts the entry, and builds
+ * the index once there are enough of them. */
+static void config_file_map_add(config_file_t *conf,
+      struct config_entry_list *entry)
+{
+   size_t i, mask;
+   uint32_t hash;
+
+   if (!conf->map)
+   {
+      if (++conf->map_count >= CONFIG_FILE_MAP_MIN_ENTRIES)
+         config_file_map_build(conf, conf->map_count);
+      return;
+   }
+
+   if (!entry->key)
+      return;
+
+   if (     (conf->map_count + 1) * 4 > conf->map_size * 3
+         && !config_file_map_grow(conf, conf->map_size * 2))
+   {
+      config_file_map_free(conf);
+      return;
+   }
+
+   hash = config_file_map_hash(entry->key);
+   mask = conf->map_size - 1;
+   i    = hash & mask;
+
+   while (conf->map[i].entry)
+   {
+      if (     conf->map[i].hash == hash
+            && string_is_equal(conf->map[i].entry->key, entry->key))
+         return;
+      i = (i + 1) & mask;
+   }
+
+   conf->map[i].entry = entry;
+   conf->map[i].hash  = hash;
+   conf->map_count++;
+}
+
+static void config_file_map_build(config_file_t *conf, size_t count)
+{
+   struct config_entry_list *entry = NULL;
+   size_t size                     = 64;
+
+   while (size < count * 2)
+      size *= 2;
+
+   conf->map_count                 = 0;
+   if (!config_file_map_grow(conf, size))
+      return;
+
+   for (entry = conf->entries; entry && conf->map; entry = entry->next)
+      config_file_map_add(conf, entry);
+}
+
+/* Rebuilds the index from scratch, for changes that
+ * reorder or unlink entries */
+static void config_file_map_reindex(config_file_t *conf)
+{
+   size_t count                    = 0;
+   struct config_entry_list *entry = NULL;
+
+   config_file_map_free(conf);
+
+   for (entry = conf->entries; entry; entry = entry->next)
+      count++;
+
+   if (count >= CONFIG_FILE_MAP_MIN_ENTRIES)
+      config_file_map_build(conf, count);
+   else
+      conf->map_count = count;
+}
+
 /* Forward declaration */
 static bool config_file_parse_line(config_file_t *conf,
       struct config_entry_list *list, char *line, config_file_cb_t *cb);
@@ -277,6 +440,19 @@ static char *config_file_extract_value(char *line, bool is_value)
    return strdup("");
 }
 
+static void config_file_rebase_tail(config_file_t *conf)
+{
+   struct config_entry_list *head = conf->entries;
+
+   if (head)
+   {
+      while (head->next)
+         head = head->next;
+   }
+
+   conf->tail = head;
+}
+
 /* Move semantics? */
 static void config_file_add_child_list(config_file_t *parent, config_file_t *child)
 {
@@ -308,18 +484,8 @@ static void config_file_add_child_list(config_file_t *parent, config_file_t *chi
 
    child->entries = NULL;
 
-   /* Rebase tail. */
-   if (parent->entries)
-   {
-      struct config_entry_list *head =
-         (struct config_entry_list*)parent->entries;
-
-      while (head->next)
-         head = head->next;
-      parent->tail = head;
-   }
-   else
-      parent->tail = NULL;
+   config_file_rebase_tail(parent);
+   config_file_map_reindex(parent);
 }
 
 static void config_file_get_realpath(char *s, size_t len,
@@ -433,6 +599,7 @@ static int config_file_load_internal(
             conf->entries    = list;
 
          conf->tail = list;
+         config_file_map_add(conf, list);
 
          if (cb && list->key && list->value)
             cb->config_file_new_entry_cb(list->key, list->value) ;
@@ -605,6 +772,7 @@ static int config_file_from_string_internal(
             conf->entries    = list;
 
          conf->tail          = list;
+         config_file_map_add(conf, list);
       }
 
       if (list != conf->tail)
@@ -656,6 +824,8 @@ bool config_file_deinitialize(config_file_t *conf)
          free(hold);
    }
 
+   config_file_map_free(conf);
+
    if (conf->path)
       free(conf->path);
    return true;
@@ -677,8 +847,11 @@ bool config_append_file(config_file_t *conf, const char *path)
    if (new_conf->tail)
    {
       new_conf->tail->next = conf->entries;
+      if (!conf->entries)
+         conf->tail        = new_conf->tail;
       conf->entries        = new_conf->entries; /* Pilfer. */
       new_conf->entries    = NULL;
+      config_file_map_reindex(conf);
    }
 
    config_file_free(new_conf);
@@ -775,6 +948,9 @@ void config_file_initialize(struct config_file *conf)
    conf->tail                     = NULL;
    conf->last                     = NULL;
    conf->includes                 = NULL;
+   conf->map                      = NULL;
+   conf->map_size                 = 0;
+   conf->map_count                = 0;
    conf->include_depth            = 0;
    conf->guaranteed_no_duplicates = false;
    conf->modified                 = false;
@@ -789,6 +965,7 @@ config_file_t *config_file_new_alloc(void)
    return conf;
 }
 
+/* On a miss, *prev is set to the last entry of the list */
 static struct config_entry_list *config_get_entry_internal(
       const config_file_t *conf,
       const char *key, struct config_entry_list **prev)
@@ -796,30 +973,38 @@ static struct config_entry_list *config_get_entry_internal(
    struct config_entry_list *entry    = NULL;
    struct config_entry_list *previous = prev ? *prev : NULL;
 
+   if (conf->map)
+   {
+      if (     (entry = config_file_map_find(conf, key,
+                  config_file_map_hash(key)))
+            || !prev)
+         return entry;
+
+      if (conf->tail)
+      {
+         *prev = conf->tail;
+         return NULL;
+      }
+   }
+
    for (entry = conf->entries; entry; entry = entry->next)
    {
       if (string_is_equal(key, entry->key))
-         return entry;
+         break;
 
       previous = entry;
    }
 
-   if (prev)
+   if (!entry && prev)
       *prev = previous;
 
-   return NULL;
+   return entry;
 }
 
 struct config_entry_list *config_get_entry(
       const config_file_t *conf, const char *key)
 {
-   struct config_entry_list *entry    = NULL;
-   for (entry = conf->entries; entry; entry = entry->next)
-   {
-      if (string_is_equal(key, entry->key))
-         return entry;
-   }
-   return NULL;
+   return config_get_entry_internal(conf, key, NULL);
 }
 
 
@@ -1094,6 +1279,18 @@ void config_set_string(config_file_t *conf, const char *key, const char *val)
       conf->entries = entry;
 
    conf->last       = entry;
+
+   /* Anything past 'last' was unlinked */
+   if (last != conf->tail)
+   {
+      conf->tail    = entry;
+      config_file_map_reindex(conf);
+   }
+   else
+   {
+      conf->tail    = entry;
+      config_file_map_add(conf, entry);
+   }
 }
 
 void config_unset(config_file_t *conf, const char *key)
@@ -1119,6 +1316,9 @@ void config_unset(config_file_t *conf, const char *key)
    entry->key     = NULL;
    entry->value   = NULL;
    conf->modified = true;
+
+   /* A later entry with the same key becomes visible */
+   config_file_map_reindex(conf);
 }
 
 void config_set_path(config_file_t *conf, const char *entry, const char *val)
@@ -1258,6 +1458,8 @@ void config_file_dump_orbis(config_file_t *conf, int fd)
          (struct config_entry_list*)conf->entries,
          config_file_sort_compare_func);
    conf->entries = list;
+   config_file_rebase_tail(conf);
+   config_file_map_reindex(conf);
 
    while (list)
    {
@@ -1285,14 +1487,17 @@ void config_file_dump(config_file_t *conf, FILE *file, bool sort)
    }
 
    if (sort)
+   {
       list = config_file_merge_sort_linked_list(
             (struct config_entry_list*)conf->entries,
             config_file_sort_compare_func);
+      conf->entries = list;
+      config_file_rebase_tail(conf);
+      config_file_map_reindex(conf);
+   }
    else
       list = (struct config_entry_list*)conf->entries;
 
-   conf->entries = list;
-
    while (list)
    {
       if (!list->readonly && list->key)
@@ -1303,16 +1508,7 @@ void config_file_dump(config_file_t *conf, FILE *file, bool sort)
 
 bool config_entry_exists(config_file_t *conf, const char *entry)
 {
-   struct config_entry_list *list = conf->entries;
-
-   while (list)
-   {
-      if (string_is_equal(entry, list->key))
-         return true;
-      list = list->next;
-   }
-
-   return false;
+   return config_get_entry(conf, entry) != NULL;
 }
 
 bool config_get_entry_list_head(config_file_t *conf,
@@ -37,8 +37,23 @@
 #include <streams/trans_stream.h>
 #include <string/stdstring.h>
 
+#ifdef HAVE_THREADS
+#include <rthreads/tpool.h>
+#endif
+
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "rpng_internal.h"
 
+/* Images with fewer pixels than this are converted on the
+ * calling thread even when a thread pool is attached */
+#define RPNG_FAST_THREAD_PIXELS (256 * 256)
+#define RPNG_FAST_GRAIN_ROWS    32
+
 enum png_ihdr_color_type
 {
    PNG_IHDR_COLOR_GRAY       = 0,
@@ -114,6 +129,7 @@ struct rpng_process
 struct rpng
 {
    struct rpng_process *process;
+   struct tpool *pool;
    uint8_t *buff_data;
    uint8_t *buff_end;
    struct idat_buffer idat_buf; /* ptr alignment */
@@ -124,6 +140,7 @@ struct rpng
    bool has_iend;
    bool has_plte;
    bool has_trns;
+   bool fast_path;
 };
 
 static const struct adam7_pass passes[] = {
@@ -224,11 +241,28 @@ static bool png_process_ihdr(struct png_ihdr *ihdr)
 static void png_reverse_filter_copy_line_rgb(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+#if defined(__SSSE3__)
+   if (bpp == 1)
+   {
+      const __m128i shuf  = _mm_setr_epi8(
+            2, 1, 0, -1, 5, 4, 3, -1, 8, 7, 6, -1, 11, 10, 9, -1);
+      const __m128i alpha = _mm_set1_epi32((int)0xff000000u);
+
+      /* Loads 16 bytes for 12, so stay clear of the end of the line */
+      for (; i + 6 <= width; i += 4, decoded += 12)
+      {
+         __m128i px = _mm_loadu_si128((const __m128i*)decoded);
+         px         = _mm_or_si128(_mm_shuffle_epi8(px, shuf), alpha);
+         _mm_storeu_si128((__m128i*)(data + i), px);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b;
 
@@ -245,11 +279,30 @@ static void png_reverse_filter_copy_line_rgb(uint32_t *data,
 static void png_reverse_filter_copy_line_rgba(uint32_t *data,
       const uint8_t *decoded, unsigned width, unsigned bpp)
 {
-   unsigned i;
+   unsigned i = 0;
 
    bpp /= 8;
 
-   for (i = 0; i < width; i++)
+#if defined(__SSE2__)
+   if (bpp == 1)
+   {
+      const __m128i ag = _mm_set1_epi32((int)0xff00ff00u);
+      const __m128i rb = _mm_set1_epi32(0x00ff00ff);
+
+      /* RGBA bytes read as 0xAABBGGRR, swap R and B */
+      for (; i + 4 <= width; i += 4, decoded += 16)
+      {
+         __m128i px  = _mm_loadu_si128((const __m128i*)decoded);
+         __m128i xrb = _mm_and_si128(px, rb);
+         xrb         = _mm_or_si128(_mm_slli_epi32(xrb, 16),
+               _mm_srli_epi32(xrb, 16));
+         px          = _mm_or_si128(_mm_and_si128(px, ag), xrb);
+         _mm_storeu_si128((__m128i*)(data + i), px);
+      }
+   }
+#endif
+
+   for (; i < width; i++)
    {
       uint32_t r, g, b, a;
       r        = *decoded;
@@ -414,6 +467,32 @@ static void png_reverse_filter_copy_line_plt(uint32_t *data,
    }
 }
 
+static void png_reverse_filter_convert_line(uint32_t *data,
+      const struct png_ihdr *ihdr, const uint8_t *decoded,
+      const uint32_t *palette)
+{
+   switch (ihdr->color_type)
+   {
+      case PNG_IHDR_COLOR_GRAY:
+         png_reverse_filter_copy_line_bw(data, decoded, ihdr->width, ihdr->depth);
+         break;
+      case PNG_IHDR_COLOR_RGB:
+         png_reverse_filter_copy_line_rgb(data, decoded, ihdr->width, ihdr->depth);
+         break;
+      case PNG_IHDR_COLOR_PLT:
+         png_reverse_filter_copy_line_plt(data, decoded, ihdr->width,
+               ihdr->depth, palette);
+         break;
+      case PNG_IHDR_COLOR_GRAY_ALPHA:
+         png_reverse_filter_copy_line_gray_alpha(data, decoded, ihdr->width,
+               ihdr->depth);
+         break;
+      case PNG_IHDR_COLOR_RGBA:
+         png_reverse_filter_copy_line_rgba(data, decoded, ihdr->width, ihdr->depth);
+         break;
+   }
+}
+
 static void png_pass_geom(const struct png_ihdr *ihdr,
       unsigned width, unsigned height,
       unsigned *bpp_out, unsigned *pitch_out, size_t *pass_size)
@@ -600,26 +679,8 @@ static int png_reverse_filter_copy_line(uint32_t *data, const struct png_ihdr *i
          return IMAGE_PROCESS_ERROR_END;
    }
 
-   switch (ihdr->color_type)
-   {
-      case PNG_IHDR_COLOR_GRAY:
-         png_reverse_filter_copy_line_bw(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
-         break;
-      case PNG_IHDR_COLOR_RGB:
-         png_reverse_filter_copy_line_rgb(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
-         break;
-      case PNG_IHDR_COLOR_PLT:
-         png_reverse_filter_copy_line_plt(data, pngp->decoded_scanline, ihdr->width,
-               ihdr->depth, pngp->palette);
-         break;
-      case PNG_IHDR_COLOR_GRAY_ALPHA:
-         png_reverse_filter_copy_line_gray_alpha(data, pngp->decoded_scanline, ihdr->width,
-               ihdr->depth);
-         break;
-      case PNG_IHDR_COLOR_RGBA:
-         png_reverse_filter_copy_line_rgba(data, pngp->decoded_scanline, ihdr->width, ihdr->depth);
-         break;
-   }
+   png_reverse_filter_convert_line(data, ihdr,
+         pngp->decoded_scanline, pngp->palette);
 
    memcpy(pngp->prev_scanline, pngp->decoded_scanline, pngp->pitch);
 
@@ -751,6 +812,358 @@ static int png_reverse_filter_iterate(rpng_t *rpng, uint32_t **data)
    return png_reverse_filter_regular_iterate(data, &rpng->ihdr, rpng->process);
 }
 
+/* Fast path
+ *
+ * By the time inflating is done the whole IDAT stream sits in
+ * inflate_buf, so instead of handing out one scanline per call
+ * every row is unfiltered in place and then converted in one go.
+ * Unfiltering has to stay row-sequential, but converting rows
+ * (and scattering the Adam7 passes) can be split across the
+ * attached thread pool.
+ */
+
+static void png_unfilter_sub(uint8_t *row, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+   for (i = bpp; i < pitch; i++)
+      row[i] += row[i - bpp];
+}
+
+static void png_unfilter_up(uint8_t *row, const uint8_t *prev,
+      unsigned pitch)
+{
+   unsigned i = 0;
+
+#if defined(__SSE2__)
+   for (; i + 16 <= pitch; i += 16)
+   {
+      __m128i x = _mm_loadu_si128((const __m128i*)(row  + i));
+      __m128i b = _mm_loadu_si128((const __m128i*)(prev + i));
+      _mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+   }
+#endif
+
+   for (; i < pitch; i++)
+      row[i] += prev[i];
+}
+
+static void png_unfilter_avg(uint8_t *row, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+   for (i = 0; i < bpp; i++)
+      row[i] += prev[i] >> 1;
+   for (; i < pitch; i++)
+      row[i] += (row[i - bpp] + prev[i]) >> 1;
+}
+
+static void png_unfilter_paeth(uint8_t *row, const uint8_t *prev,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+
+   for (i = 0; i < bpp; i++)
+      row[i] += prev[i];
+   for (; i < pitch; i++)
+      row[i] += paeth(row[i - bpp], prev[i], prev[i - bpp]);
+}
+
+#if defined(__SSE2__)
+/* Sub/Avg/Paeth only depend on the previous pixel, so for 8-bit
+ * RGB and RGBA a whole pixel is processed per step. */
+static INLINE __m128i png_load_pixel(const uint8_t *p, unsigned bpp)
+{
+   uint32_t v = 0;
+   memcpy(&v, p, bpp);
+   return _mm_cvtsi32_si128((int)v);
+}
+
+static INLINE void png_store_pixel(uint8_t *p, __m128i v, unsigned bpp)
+{
+   uint32_t x = (uint32_t)_mm_cvtsi128_si32(v);
+   memcpy(p, &x, bpp);
+}
+
+static INLINE void png_unfilter_sub_sse2(uint8_t *row,
+      unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   __m128i a = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      a = _mm_add_epi8(a, png_load_pixel(row + i, bpp));
+      png_store_pixel(row + i, a, bpp);
+   }
+}
+
+static INLINE void png_unfilter_avg_sse2(uint8_t *row,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i ones = _mm_set1_epi8(1);
+   __m128i a          = _mm_setzero_si128();
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      __m128i b   = png_load_pixel(prev + i, bpp);
+      /* pavgb rounds up, take the carry back off */
+      __m128i avg = _mm_sub_epi8(_mm_avg_epu8(a, b),
+            _mm_and_si128(_mm_xor_si128(a, b), ones));
+      a           = _mm_add_epi8(avg, png_load_pixel(row + i, bpp));
+      png_store_pixel(row + i, a, bpp);
+   }
+}
+
+static INLINE __m128i png_abs_epi16(__m128i x)
+{
+   __m128i neg = _mm_cmplt_epi16(x, _mm_setzero_si128());
+   return _mm_sub_epi16(_mm_xor_si128(x, neg), neg);
+}
+
+static INLINE __m128i png_select(__m128i mask, __m128i t, __m128i f)
+{
+   return _mm_or_si128(_mm_and_si128(mask, t), _mm_andnot_si128(mask, f));
+}
+
+static INLINE void png_unfilter_paeth_sse2(uint8_t *row,
+      const uint8_t *prev, unsigned pitch, unsigned bpp)
+{
+   unsigned i;
+   const __m128i zero = _mm_setzero_si128();
+   __m128i a          = zero;
+   __m128i c          = zero;
+
+   for (i = 0; i < pitch; i += bpp)
+   {
+      /* Work on 16-bit lanes; p - a = b - c, p - b = a - c */
+      __m128i b  = _mm_unpacklo_epi8(png_load_pixel(prev + i, bpp), zero);
+      __m128i x  = _mm_unpacklo_epi8(png_load_pixel(row  + i, bpp), zero);
+      __m128i pa = _mm_sub_epi16(b, c);
+      __m128i pb = _mm_sub_epi16(a, c);
+      __m128i pc = png_abs_epi16(_mm_add_epi16(pa, pb));
+      __m128i smallest, pred;
+
+      pa         = png_abs_epi16(pa);
+      pb         = png_abs_epi16(pb);
+      smallest   = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+      pred       = png_select(_mm_cmpeq_epi16(smallest, pa), a,
+                   png_select(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+      /* Byte-wise add keeps every lane within 0..255 */
+      a          = _mm_add_epi8(x, pred);
+      c          = b;
+      png_store_pixel(row + i, _mm_packus_epi16(a, a), bpp);
+   }
+}
+#endif
+
+static bool png_unfilter_rows(uint8_t *buf, const uint8_t *zero_row,
+      unsigned pitch, unsigned bpp, unsigned height)
+{
+   unsigned y;
+   const uint8_t *prev = zero_row;
+#if defined(__SSE2__)
+   bool simd           = (bpp == 3 || bpp == 4) && !(pitch % bpp);
+#endif
+
+   for (y = 0; y < height; y++, buf += pitch + 1)
+   {
+      uint8_t *row = buf + 1;
+
+      switch (buf[0])
+      {
+         case PNG_FILTER_NONE:
+            break;
+         case PNG_FILTER_SUB:
+#if defined(__SSE2__)
+            if (simd)
+            {
+               if (bpp == 4)
+                  png_unfilter_sub_sse2(row, pitch, 4);
+               else
+                  png_unfilter_sub_sse2(row, pitch, 3);
+               break;
+            }
+#endif
+            png_unfilter_sub(row, pitch, bpp);
+            break;
+         case PNG_FILTER_UP:
+            png_unfilter_up(row, prev, pitch);
+            break;
+         case PNG_FILTER_AVERAGE:
+#if defined(__SSE2__)
+            if (simd)
+            {
+               if (bpp == 4)
+                  png_unfilter_avg_sse2(row, prev, pitch, 4);
+               else
+                  png_unfilter_avg_sse2(row, prev, pitch, 3);
+               break;
+            }
+#endif
+            png_unfilter_avg(row, prev, pitch, bpp);
+            break;
+         case PNG_FILTER_PAETH:
+#if defined(__SSE2__)
+            if (simd)
+            {
+               if (bpp == 4)
+                  png_unfilter_paeth_sse2(row, prev, pitch, 4);
+               else
+                  png_unfilter_paeth_sse2(row, prev, pitch, 3);
+               break;
+            }
+#endif
+            png_unfilter_paeth(row, prev, pitch, bpp);
+            break;
+         default:
+            return false;
+      }
+
+      prev = row;
+   }
+
+   return true;
+}
+
+struct png_fast_pass
+{
+   const struct adam7_pass *pass;
+   const uint8_t *rows;
+   const uint32_t *palette;
+   uint32_t *data;
+   struct png_ihdr ihdr; /* uint32_t alignment, pass dimensions */
+   unsigned pitch;
+   unsigned width;       /* width of the whole image */
+   bool failed;
+};
+
+static void png_fast_convert_rows(void *arg, size_t begin, size_t end)
+{
+   size_t y;
+   struct png_fast_pass *fp = (struct png_fast_pass*)arg;
+   const struct adam7_pass *pass = fp->pass;
+   uint32_t *line                = NULL;
+
+   if (pass->stride_x > 1)
+   {
+      if (!(line = (uint32_t*)malloc(fp->ihdr.width * sizeof(uint32_t))))
+      {
+         fp->failed = true;
+         return;
+      }
+   }
+
+   for (y = begin; y < end; y++)
+   {
+      const uint8_t *decoded = fp->rows + y * (fp->pitch + 1) + 1;
+      uint32_t *out          = fp->data + (y * pass->stride_y + pass->y)
+         * fp->width + pass->x;
+
+      if (line)
+      {
+         unsigned x;
+         png_reverse_filter_convert_line(line, &fp->ihdr,
+               decoded, fp->palette);
+         for (x = 0; x < fp->ihdr.width; x++, out += pass->stride_x)
+            *out = line[x];
+      }
+      else
+         png_reverse_filter_convert_line(out, &fp->ihdr,
+               decoded, fp->palette);
+   }
+
+   free(line);
+}
+
+static int png_reverse_filter_fast(rpng_t *rpng, uint32_t *data)
+{
+   unsigned i, pitch;
+   static const struct adam7_pass whole = { 0, 0, 1, 1 };
+   struct png_fast_pass fp[ARRAY_SIZE(passes)];
+   unsigned count               = 0;
+   unsigned num_passes          = rpng->ihdr.interlace
+      ? ARRAY_SIZE(passes) : 1;
+   struct rpng_process *pngp    = rpng->process;
+   uint8_t *buf                 = pngp->inflate_buf;
+   size_t avail                 = pngp->total_out;
+   uint8_t *zero_row            = NULL;
+
+   png_pass_geom(&rpng->ihdr, rpng->ihdr.width, rpng->ihdr.height,
+         NULL, &pitch, NULL);
+
+   if (!(zero_row = (uint8_t*)calloc(1, pitch)))
+      return IMAGE_PROCESS_ERROR;
+
+   /* Unfilter every pass in place; later rows depend on
+    * earlier ones so this part stays on one thread */
+   for (i = 0; i < num_passes; i++)
+   {
+      unsigned bpp;
+      size_t pass_size;
+      const struct adam7_pass *pass = rpng->ihdr.interlace
+         ? &passes[i] : &whole;
+
+      if (     rpng->ihdr.width  <= pass->x
+            || rpng->ihdr.height <= pass->y) /* Empty pass */
+         continue;
+
+      fp[count].pass        = pass;
+      fp[count].palette     = rpng->palette;
+      fp[count].data        = data;
+      fp[count].width       = rpng->ihdr.width;
+      fp[count].failed      = false;
+      fp[count].ihdr        = rpng->ihdr;
+      fp[count].ihdr.width  = (rpng->ihdr.width - pass->x
+            + pass->stride_x - 1) / pass->stride_x;
+      fp[count].ihdr.height = (rpng->ihdr.height - pass->y
+            + pass->stride_y - 1) / pass->stride_y;
+
+      png_pass_geom(&fp[count].ihdr, fp[count].ihdr.width,
+            fp[count].ihdr.height, &bpp, &fp[count].pitch, &pass_size);
+
+      if (pass_size > avail)
+         goto error;
+
+      if (!png_unfilter_rows(buf, zero_row, fp[count].pitch, bpp,
+               fp[count].ihdr.height))
+         goto error;
+
+      fp[count].rows        = buf;
+      buf                  += pass_size;
+      avail                -= pass_size;
+      count++;
+   }
+
+   for (i = 0; i < count; i++)
+   {
+#ifdef HAVE_THREADS
+      if (rpng->pool && (size_t)fp[i].ihdr.width * fp[i].ihdr.height
+            >= RPNG_FAST_THREAD_PIXELS)
+      {
+         if (!tpool_parallel_for(rpng->pool, fp[i].ihdr.height,
+                  RPNG_FAST_GRAIN_ROWS, png_fast_convert_rows, &fp[i]))
+            goto error;
+      }
+      else
+#endif
+         png_fast_convert_rows(&fp[i], 0, fp[i].ihdr.height);
+
+      if (fp[i].failed)
+         goto error;
+   }
+
+   free(zero_row);
+   return IMAGE_PROCESS_END;
+
+error:
+   free(zero_row);
+   return IMAGE_PROCESS_ERROR;
+}
+
 static int rpng_load_image_argb_process_inflate_init(rpng_t *rpng, uint32_t **data)
 {
    bool zstatus;
@@ -794,7 +1207,7 @@ end:
    process->restore_buf_size       = 0;
    process->palette                = rpng->palette;
 
-   if (rpng->ihdr.interlace != 1)
+   if (rpng->ihdr.interlace != 1 && !rpng->fast_path)
       if (png_reverse_filter_init(&rpng->ihdr, process) == -1)
          goto false_end;
 
@@ -990,7 +1403,6 @@ static enum png_chunk_type read_chunk_header(
 
 bool rpng_iterate_image(rpng_t *rpng)
 {
-   unsigned i;
    uint8_t *buf             = (uint8_t*)rpng->buff_data;
    uint32_t chunk_size      = 0;
 
@@ -1108,8 +1520,7 @@ bool rpng_iterate_image(rpng_t *rpng)
 
          buf += 8;
 
-         for (i = 0; i < chunk_size; i++)
-            rpng->idat_buf.data[i + rpng->idat_buf.size] = buf[i];
+         memcpy(rpng->idat_buf.data + rpng->idat_buf.size, buf, chunk_size);
 
          rpng->idat_buf.size += chunk_size;
 
@@ -1160,6 +1571,9 @@ int rpng_process_image(rpng_t *rpng,
    *width  = rpng->ihdr.width;
    *height = rpng->ihdr.height;
 
+   if (rpng->fast_path)
+      return png_reverse_filter_fast(rpng, *data);
+
    return png_reverse_filter_iterate(rpng, data);
 
 error:
@@ -1170,6 +1584,7 @@ error:
       if (rpng->process->stream)
          rpng->process->stream_backend->stream_free(rpng->process->stream);
       free(rpng->process);
+      rpng->process = NULL;
    }
    return IMAGE_PROCESS_ERROR;
 }
@@ -1217,6 +1632,18 @@ bool rpng_start(rpng_t *rpng)
    return true;
 }
 
+void rpng_set_fast_path(rpng_t *rpng, bool enable)
+{
+   if (rpng)
+      rpng->fast_path = enable;
+}
+
+void rpng_set_thread_pool(rpng_t *rpng, struct tpool *pool)
+{
+   if (rpng)
+      rpng->pool = pool;
+}
+
 bool rpng_is_valid(rpng_t *rpng)
 {
    /* A valid PNG image must contain an IHDR chunk,
@@ -58,6 +58,11 @@ struct config_file
    struct config_entry_list *tail;
    struct config_entry_list *last;
    struct config_include_list *includes;
+   /* Hash index over 'entries', once there are enough of
+    * them. Until then 'map_count' counts the entries. */
+   struct config_entry_map *map;
+   size_t map_size;
+   size_t map_count;
    unsigned include_depth;
    bool guaranteed_no_duplicates;
    bool modified;
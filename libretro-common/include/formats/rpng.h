@@ -34,6 +34,8 @@ RETRO_BEGIN_DECLS
 
 typedef struct rpng rpng_t;
 
+struct tpool;
+
 rpng_t *rpng_init(const char *path);
 
 bool rpng_is_valid(rpng_t *rpng);
@@ -51,6 +53,28 @@ int rpng_process_image(rpng_t *rpng,
 
 bool rpng_start(rpng_t *rpng);
 
+/**
+ * rpng_set_fast_path:
+ * @rpng         : PNG handle.
+ * @enable       : Decode the whole image at once.
+ *
+ * When enabled, rpng_process_image() unfilters and converts the
+ * whole image in the call following inflation instead of one
+ * scanline per call. Must be set before the first call to
+ * rpng_process_image().
+ **/
+void rpng_set_fast_path(rpng_t *rpng, bool enable);
+
+/**
+ * rpng_set_thread_pool:
+ * @rpng         : PNG handle.
+ * @pool         : Thread pool, or NULL.
+ *
+ * Lets the fast path convert rows and deinterlace Adam7 passes
+ * of large images on @pool. Ignored without HAVE_THREADS.
+ **/
+void rpng_set_thread_pool(rpng_t *rpng, struct tpool *pool);
+
 bool rpng_save_image_argb(const char *path, const uint32_t *data,
       unsigned width, unsigned height, unsigned pitch);
 bool rpng_save_image_bgr24(const char *path, const uint8_t *data,
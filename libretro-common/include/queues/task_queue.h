@@ -44,7 +44,24 @@ enum task_type
    TASK_TYPE_BLOCKING
 };
 
+/* Scheduling class of a task, only used by the threaded
+ * task queue. When several tasks are ready, workers pick
+ * interactive tasks first, then I/O, then bulk. */
+enum task_priority
+{
+   /* Downloads, saves, decompression...
+    * Default for tasks that don't set a priority. */
+   TASK_PRIORITY_IO = 0,
+   /* The user is waiting on the result (e.g. thumbnails). */
+   TASK_PRIORITY_INTERACTIVE,
+   /* Long running work that can wait (e.g. database scans).
+    * With more than one worker, bulk tasks never occupy
+    * all of them at once. */
+   TASK_PRIORITY_BULK
+};
+
 typedef struct retro_task retro_task_t;
+struct tpool;
 typedef void (*retro_task_callback_t)(retro_task_t *task,
       void *task_data,
       void *user_data, const char *error);
@@ -115,6 +132,8 @@ struct retro_task
 
    enum task_type type;
 
+   enum task_priority priority;
+
    /* if set to true, frontend will
    use an alternative look for the
    task progress display */
@@ -130,6 +149,10 @@ struct retro_task
 
    /* if true no OSD messages will be displayed. */
    bool mute;
+
+   /* set by the task system while a worker
+    * runs the handler, don't touch. */
+   bool busy;
 };
 
 typedef struct task_finder_data
@@ -197,6 +220,16 @@ void task_queue_unset_threaded(void);
 
 bool task_queue_is_threaded(void);
 
+/* Sets the number of worker threads used by the
+ * threaded task queue (0 is treated as 1).
+ * Takes effect on the next task_queue_check(). */
+void task_queue_set_workers(unsigned workers);
+
+/* Thread pool which task handlers may split their own
+ * work across with tpool_parallel_for(), or NULL when
+ * tasks don't run on threads. */
+struct tpool *task_queue_get_thread_pool(void);
+
 /**
  * Calls func for every running task
  * until it returns true.
@@ -30,6 +30,7 @@
 
 #include <retro_common_api.h>
 
+#include <stddef.h>
 #include <boolean.h>
 
 #include <retro_inline.h>
@@ -48,12 +49,23 @@ typedef struct tpool tpool_t;
  **/
 typedef void (*thread_func_t)(void *arg);
 
+/**
+ * (*tpool_for_func_t):
+ * @arg           : Argument.
+ * @begin         : First index of the range.
+ * @end           : One past the last index of the range.
+ *
+ * Callback function for tpool_parallel_for.
+ **/
+typedef void (*tpool_for_func_t)(void *arg, size_t begin, size_t end);
+
 /**
  * tpool_create:
  * @num           : Number of threads the pool should have.
  *                  If 0 defaults to 2.
  *
- * Create a thread pool.
+ * Create a thread pool. Every thread owns a work queue and
+ * steals work from the other queues when its own runs dry.
  * 
  * Returns: pool.
  */
@@ -83,6 +95,41 @@ void tpool_destroy(tpool_t *tp);
  **/
 bool tpool_add_work(tpool_t *tp, thread_func_t func, void *arg);
 
+/**
+ * tpool_add_work_n:
+ * @tp         : Thread pool.
+ * @func       : Function the pool should call.
+ * @args       : Array of @n arguments, one per call of func.
+ *               Can be NULL to pass NULL to every call.
+ * @n          : Number of work items.
+ *
+ * Add a batch of work to a thread pool. Cheaper than
+ * calling tpool_add_work @n times.
+ *
+ * Returns: true if all work was added, otherwise false
+ * (in which case none of it was added).
+ **/
+bool tpool_add_work_n(tpool_t *tp, thread_func_t func,
+      void **args, size_t n);
+
+/**
+ * tpool_parallel_for:
+ * @tp         : Thread pool. If NULL, runs on the calling thread.
+ * @count      : Number of indices to process.
+ * @grain      : Number of indices per call of func.
+ * @func       : Function to call for each range.
+ * @arg        : Argument to pass to func.
+ *
+ * Splits [0, count) in ranges of @grain indices and runs them
+ * on the pool. The calling thread takes part and this only
+ * returns once every range has been processed, so it can be
+ * used from inside a work function as well.
+ *
+ * Returns: true if the whole range was processed, otherwise false.
+ **/
+bool tpool_parallel_for(tpool_t *tp, size_t count, size_t grain,
+      tpool_for_func_t func, void *arg);
+
 /**
  * tpool_wait:
  * @tp Thread pool.
@@ -30,6 +30,7 @@
 
 #ifdef HAVE_THREADS
 #include <rthreads/rthreads.h>
+#include <rthreads/tpool.h>
 #define SLOCK_LOCK(x) slock_lock(x)
 #define SLOCK_UNLOCK(x) slock_unlock(x)
 #else
@@ -71,9 +72,21 @@ static slock_t *finished_lock               = NULL;
 static slock_t *property_lock               = NULL;
 static slock_t *queue_lock                  = NULL;
 static scond_t *worker_cond                 = NULL;
-static sthread_t *worker_thread             = NULL;
+static sthread_t **worker_threads           = NULL;
+static unsigned worker_count                = 0;
+static unsigned worker_count_wanted         = 1;
+/* use running_lock when touching these */
 static bool worker_continue                 = true; 
-/* use running_lock when touching it */
+static unsigned workers_busy_bulk           = 0;
+/* For tasks to split their own work across */
+static tpool_t *worker_pool                 = NULL;
+
+/* Order in which workers pick tasks, indexed by task_priority. */
+static const unsigned task_priority_rank[]  = {
+   1, /* TASK_PRIORITY_IO */
+   0, /* TASK_PRIORITY_INTERACTIVE */
+   2  /* TASK_PRIORITY_BULK */
+};
 #endif
 
 static void task_queue_msg_push(retro_task_t *task,
@@ -470,6 +483,60 @@ static void retro_task_threaded_retrieve(task_retriever_data_t *data)
    slock_unlock(running_lock);
 }
 
+/* 'running_lock' must be held for the duration of this function.
+ *
+ * Picks the task a worker should run next: the first idle task
+ * of the best priority class that is due. Since unfinished tasks
+ * are moved to the back of the queue after each run, tasks of
+ * the same class are served round-robin.
+ *
+ * If nothing is due, @delay is set to the time until the next
+ * scheduled task (or 0 if there is none). */
+static retro_task_t *task_queue_pick(retro_time_t *delay)
+{
+   retro_task_t *task = NULL;
+   retro_task_t *best = NULL;
+   retro_time_t now   = 0;
+   /* Keep a worker free for everything else. */
+   unsigned max_bulk  = worker_count > 1 ? worker_count - 1 : 1;
+
+   *delay             = 0;
+
+   for (task = tasks_running.front; task; task = task->next)
+   {
+      if (task->busy)
+         continue;
+
+      if (     task->priority == TASK_PRIORITY_BULK
+            && workers_busy_bulk >= max_bulk)
+         continue;
+
+      if (task->when)
+      {
+         retro_time_t task_delay;
+
+         if (!now)
+            now        = cpu_features_get_time_usec();
+
+         /* allow half a millisecond for context switching */
+         task_delay    = task->when - now - 500;
+         if (task_delay > 0)
+         {
+            if (!*delay || task_delay < *delay)
+               *delay  = task_delay;
+            continue;
+         }
+      }
+
+      if (  !best ||
+            task_priority_rank[task->priority] <
+            task_priority_rank[best->priority])
+         best          = task;
+   }
+
+   return best;
+}
+
 static void threaded_worker(void *userdata)
 {
    (void)userdata;
@@ -477,34 +544,36 @@ static void threaded_worker(void *userdata)
    for (;;)
    {
       retro_task_t *task  = NULL;
+      retro_time_t delay  = 0;
       bool       finished = false;
-
-      if (!worker_continue)
-         break; /* should we keep running until all tasks finished? */
+      bool           bulk = false;
 
       slock_lock(running_lock);
 
-      /* Get first task to run */
-      task = tasks_running.front;
-      if (!task)
+      if (!worker_continue)
       {
-         scond_wait(worker_cond, running_lock);
+         /* should we keep running until all tasks finished? */
          slock_unlock(running_lock);
-         continue;
+         break;
       }
 
-      if (task->when)
+      task = task_queue_pick(&delay);
+      if (!task)
       {
-         retro_time_t now   = cpu_features_get_time_usec();
-         retro_time_t delay = task->when - now - 500; /* allow half a millisecond for context switching */
          if (delay > 0)
-         {
             scond_wait_timeout(worker_cond, running_lock, delay);
-            slock_unlock(running_lock);
-            continue;
-         }
+         else
+            scond_wait(worker_cond, running_lock);
+         slock_unlock(running_lock);
+         continue;
       }
 
+      /* No other worker may run this task until we're done. */
+      task->busy = true;
+      bulk       = (task->priority == TASK_PRIORITY_BULK);
+      if (bulk)
+         workers_busy_bulk++;
+
       slock_unlock(running_lock);
 
       task->handler(task);
@@ -514,33 +583,39 @@ static void threaded_worker(void *userdata)
       slock_unlock(property_lock);
 
       /* Update queue */
+      slock_lock(running_lock);
+      slock_lock(queue_lock);
+
+      task->busy = false;
+      if (bulk)
+         workers_busy_bulk--;
+
       if (!finished)
       {
          /* Move the task to the back of the queue */
          /* mimics retro_task_threaded_push_running, 
           * but also includes a task_queue_remove */
-         slock_lock(running_lock);
-         slock_lock(queue_lock);
 
          /* do nothing if only item in queue */
          if (task->next) 
          {
             task_queue_remove(&tasks_running, task);
             task_queue_put(&tasks_running, task);
-            scond_signal(worker_cond);
          }
-         slock_unlock(queue_lock);
-         slock_unlock(running_lock);
       }
       else
-      {
          /* Remove task from running queue */
-         slock_lock(running_lock);
-         slock_lock(queue_lock);
          task_queue_remove(&tasks_running, task);
-         slock_unlock(queue_lock);
-         slock_unlock(running_lock);
 
+      /* The task (or a bulk slot) is available again. */
+      if (worker_count > 1)
+         scond_signal(worker_cond);
+
+      slock_unlock(queue_lock);
+      slock_unlock(running_lock);
+
+      if (finished)
+      {
          /* Add task to finished queue */
          slock_lock(finished_lock);
          task_queue_put(&tasks_finished, task);
@@ -551,27 +626,48 @@ static void threaded_worker(void *userdata)
 
 static void retro_task_threaded_init(void)
 {
-   running_lock    = slock_new();
-   finished_lock   = slock_new();
-   property_lock   = slock_new();
-   queue_lock      = slock_new();
-   worker_cond     = scond_new();
+   unsigned i;
+
+   running_lock      = slock_new();
+   finished_lock     = slock_new();
+   property_lock     = slock_new();
+   queue_lock        = slock_new();
+   worker_cond       = scond_new();
 
    slock_lock(running_lock);
-   worker_continue = true;
+   worker_continue   = true;
+   workers_busy_bulk = 0;
    slock_unlock(running_lock);
 
-   worker_thread   = sthread_create(threaded_worker, NULL);
+   worker_count      = worker_count_wanted;
+   worker_threads    = (sthread_t**)calloc(worker_count,
+         sizeof(*worker_threads));
+
+   for (i = 0; i < worker_count; i++)
+      worker_threads[i] = sthread_create(threaded_worker, NULL);
+
+   /* The task itself takes part in what it splits up */
+   if (cpu_features_get_core_amount() > 1)
+      worker_pool    = tpool_create(cpu_features_get_core_amount() - 1);
 }
 
 static void retro_task_threaded_deinit(void)
 {
+   unsigned i;
+
    slock_lock(running_lock);
    worker_continue = false;
-   scond_signal(worker_cond);
+   scond_broadcast(worker_cond);
    slock_unlock(running_lock);
 
-   sthread_join(worker_thread);
+   for (i = 0; i < worker_count; i++)
+      if (worker_threads[i])
+         sthread_join(worker_threads[i]);
+
+   free(worker_threads);
+
+   if (worker_pool)
+      tpool_destroy(worker_pool);
 
    scond_free(worker_cond);
    slock_free(running_lock);
@@ -579,7 +675,9 @@ static void retro_task_threaded_deinit(void)
    slock_free(property_lock);
    slock_free(queue_lock);
 
-   worker_thread   = NULL;
+   worker_threads  = NULL;
+   worker_pool     = NULL;
+   worker_count    = 0;
    worker_cond     = NULL;
    running_lock    = NULL;
    finished_lock   = NULL;
@@ -645,6 +743,22 @@ bool task_queue_is_threaded(void)
    return task_threaded_enable;
 }
 
+void task_queue_set_workers(unsigned workers)
+{
+#ifdef HAVE_THREADS
+   worker_count_wanted = workers ? workers : 1;
+#endif
+}
+
+struct tpool *task_queue_get_thread_pool(void)
+{
+#ifdef HAVE_THREADS
+   if (impl_current == &impl_threaded)
+      return worker_pool;
+#endif
+   return NULL;
+}
+
 bool task_queue_find(task_finder_data_t *find_data)
 {
    if (!impl_current->find(find_data->func, find_data->userdata))
@@ -663,7 +777,8 @@ void task_queue_check(void)
    bool current_threaded = (impl_current == &impl_threaded);
    bool want_threaded    = task_threaded_enable;
 
-   if (want_threaded != current_threaded)
+   if (     want_threaded != current_threaded
+         || (current_threaded && worker_count != worker_count_wanted))
       task_queue_deinit();
 
    if (!impl_current)
@@ -911,6 +1026,8 @@ retro_task_t *task_init(void)
    task->progress_cb       = NULL;
    task->title             = NULL;
    task->type              = TASK_TYPE_NONE;
+   task->priority          = TASK_PRIORITY_IO;
+   task->busy              = false;
    task->ident             = task_count++;
    task->frontend_userdata = NULL;
    task->alternative_look  = false;
@@ -26,180 +26,360 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <boolean.h>
 
 #include <rthreads/rthreads.h>
 #include <rthreads/tpool.h>
 
-/* Work object which will sit in a queue
- * waiting for the pool to process it.
+/* Work-stealing thread pool.
  *
- * It is a singly linked list acting as a FIFO queue. */
+ * Every worker owns a queue protected by its own lock. New work
+ * is spread round-robin over the queues, each worker takes work
+ * from the front of its own queue and, once that is empty,
+ * steals from the back of the other queues. This keeps the
+ * workers from all serializing on a single queue lock.
+ *
+ * The pool-wide lock is only taken to put idle workers to sleep,
+ * to wake them up and to account for finished work. */
+
+#define TPOOL_QUEUE_INITIAL_SIZE 16
+
+/* Work item, stored by value in the queues. */
 struct tpool_work
 {
-   thread_func_t      func;  /* Function to be called. */
-   void              *arg;   /* Data to be passed to func. */
-   struct tpool_work *next;  /* Next work item in the queue. */
+   thread_func_t func;  /* Function to be called. */
+   void         *arg;   /* Data to be passed to func. */
 };
 typedef struct tpool_work tpool_work_t;
 
+/* Per-worker queue, a growable ring buffer. */
+struct tpool_queue
+{
+   slock_t       *lock;
+   tpool_work_t  *items;
+   size_t         head;   /* Index of the oldest item. */
+   size_t         count;  /* Number of queued items. */
+   size_t         size;   /* Capacity of items, a power of two. */
+};
+typedef struct tpool_queue tpool_queue_t;
+
+struct tpool_thread
+{
+   struct tpool *tp;
+   size_t        index;   /* Which queue this worker owns. */
+};
+
 struct tpool
 {
-   tpool_work_t    *work_first;   /* First work item in the work queue. */
-   tpool_work_t    *work_last;    /* Last work item in the work queue. */
-   slock_t         *work_mutex;   /* Mutex protecting inserting and removing work from the work queue. */
-   scond_t         *work_cond;    /* Conditional to signal when there is work to process. */
-   scond_t         *working_cond; /* Conditional to signal when there is no work processing.
-                                       This will also signal when there are no threads running. */
-   size_t           working_cnt;  /* The number of threads processing work (Not waiting for work). */
-   size_t           thread_cnt;   /* Total number of threads within the pool. */
-   bool             stop;         /* Marker to tell the work threads to exit. */
+   tpool_queue_t       *queues;       /* One queue per worker. */
+   struct tpool_thread *threads;
+   slock_t             *work_mutex;   /* Protects the counters below and idle workers. */
+   scond_t             *work_cond;    /* Conditional to signal when there is work to process. */
+   scond_t             *working_cond; /* Conditional to signal when there is no work processing.
+                                           This will also signal when there are no threads running. */
+   size_t               pending;      /* Work items added but not completed yet. */
+   size_t               idle_cnt;     /* The number of threads waiting for work. */
+   size_t               thread_cnt;   /* Total number of threads within the pool. */
+   size_t               queue_cnt;    /* Number of queues (and initial threads). */
+   size_t               next_queue;   /* Round-robin cursor for new work. */
+   bool                 stop;         /* Marker to tell the work threads to exit. */
 };
 
-static tpool_work_t *tpool_work_create(thread_func_t func, void *arg)
+/* Shared state of a tpool_parallel_for() call. It is reference
+ * counted because helper jobs may still be queued after the
+ * caller has returned. */
+struct tpool_for
 {
-   tpool_work_t *work;
+   tpool_for_func_t func;
+   void            *arg;
+   slock_t         *lock;
+   scond_t         *cond;
+   size_t           count;
+   size_t           grain;
+   size_t           next;
+   size_t           done;
+   unsigned         refs;
+};
 
-   if (!func)
-      return NULL;
+static void tpool_for_release(struct tpool_for *pf);
+static void tpool_for_worker(void *arg);
 
-   work       = (tpool_work_t*)calloc(1, sizeof(*work));
-   work->func = func;
-   work->arg  = arg;
-   work->next = NULL;
-   return work;
+static bool tpool_queue_init(tpool_queue_t *queue)
+{
+   queue->lock  = slock_new();
+   queue->items = (tpool_work_t*)malloc(
+         TPOOL_QUEUE_INITIAL_SIZE * sizeof(*queue->items));
+   queue->head  = 0;
+   queue->count = 0;
+   queue->size  = TPOOL_QUEUE_INITIAL_SIZE;
+
+   return queue->lock && queue->items;
 }
 
-static void tpool_work_destroy(tpool_work_t *work)
+static void tpool_queue_deinit(tpool_queue_t *queue)
 {
-   if (work)
-      free(work);
+   if (queue->lock)
+      slock_free(queue->lock);
+   if (queue->items)
+      free(queue->items);
+   queue->lock  = NULL;
+   queue->items = NULL;
 }
 
-/* Pull the first work item out of the queue. */
-static tpool_work_t *tpool_work_get(tpool_t *tp)
+/* Must be called with the queue locked. */
+static bool tpool_queue_reserve(tpool_queue_t *queue, size_t n)
 {
-   tpool_work_t *work;
+   size_t i;
+   size_t size;
+   tpool_work_t *items;
 
-   if (!tp)
-      return NULL;
+   if (queue->count + n <= queue->size)
+      return true;
 
-   work = tp->work_first;
-   if (!work)
-      return NULL;
+   size = queue->size;
+   while (size < queue->count + n)
+      size <<= 1;
+
+   items = (tpool_work_t*)malloc(size * sizeof(*items));
+   if (!items)
+      return false;
 
-   if (!work->next)
+   /* Unwrap the ring while copying. */
+   for (i = 0; i < queue->count; i++)
+      items[i] = queue->items[(queue->head + i) & (queue->size - 1)];
+
+   free(queue->items);
+   queue->items = items;
+   queue->head  = 0;
+   queue->size  = size;
+   return true;
+}
+
+/* Must be called with the queue locked. */
+static void tpool_queue_push(tpool_queue_t *queue,
+      thread_func_t func, void *arg)
+{
+   tpool_work_t *work = &queue->items[
+      (queue->head + queue->count++) & (queue->size - 1)];
+   work->func         = func;
+   work->arg          = arg;
+}
+
+/* Takes the oldest item, used by the owning worker. */
+static bool tpool_queue_pop_front(tpool_queue_t *queue, tpool_work_t *work)
+{
+   bool ret = false;
+
+   slock_lock(queue->lock);
+   if (queue->count)
    {
-      tp->work_first = NULL;
-      tp->work_last  = NULL;
+      *work        = queue->items[queue->head];
+      queue->head  = (queue->head + 1) & (queue->size - 1);
+      queue->count--;
+      ret          = true;
    }
-   else
-      tp->work_first = work->next;
+   slock_unlock(queue->lock);
 
-   return work;
+   return ret;
+}
+
+/* Takes the newest item, used by thieves so they stay out of
+ * the owner's way. */
+static bool tpool_queue_pop_back(tpool_queue_t *queue, tpool_work_t *work)
+{
+   bool ret = false;
+
+   slock_lock(queue->lock);
+   if (queue->count)
+   {
+      queue->count--;
+      *work        = queue->items[
+         (queue->head + queue->count) & (queue->size - 1)];
+      ret          = true;
+   }
+   slock_unlock(queue->lock);
+
+   return ret;
+}
+
+/* Try the worker's own queue first, then steal. */
+static bool tpool_work_get(tpool_t *tp, size_t index, tpool_work_t *work)
+{
+   size_t i;
+
+   if (tpool_queue_pop_front(&tp->queues[index], work))
+      return true;
+
+   for (i = 1; i < tp->queue_cnt; i++)
+      if (tpool_queue_pop_back(
+               &tp->queues[(index + i) % tp->queue_cnt], work))
+         return true;
+
+   return false;
+}
+
+/* Must be called with work_mutex held. Since the producers only
+ * take work_mutex after publishing the work, an empty scan here
+ * means the worker can safely go to sleep. */
+static bool tpool_has_work(tpool_t *tp)
+{
+   size_t i;
+
+   for (i = 0; i < tp->queue_cnt; i++)
+   {
+      size_t count;
+
+      slock_lock(tp->queues[i].lock);
+      count = tp->queues[i].count;
+      slock_unlock(tp->queues[i].lock);
+
+      if (count)
+         return true;
+   }
+
+   return false;
 }
 
 static void tpool_worker(void *arg)
 {
-   tpool_work_t *work = NULL;
-   tpool_t      *tp   = (tpool_t*)arg;
+   tpool_work_t          work;
+   struct tpool_thread *thread = (struct tpool_thread*)arg;
+   tpool_t             *tp     = thread->tp;
 
    for (;;)
    {
+      if (tpool_work_get(tp, thread->index, &work))
+      {
+         work.func(work.arg);
+
+         slock_lock(tp->work_mutex);
+         tp->pending--;
+         /* At this point if there isn't any work processing
+          * and if there is no work signal this is the case. */
+         if (!tp->stop && tp->pending == 0)
+            scond_broadcast(tp->working_cond);
+         slock_unlock(tp->work_mutex);
+         continue;
+      }
+
       slock_lock(tp->work_mutex);
       /* Keep running until told to stop. */
       if (tp->stop)
          break;
 
-      /* If there is no work in the queue wait in the conditional until
-       * there is work to take. */
-      if (!tp->work_first)
-         scond_wait(tp->work_cond, tp->work_mutex);
-
-      /* Try to pull work from the queue. */
-      work = tpool_work_get(tp);
-      tp->working_cnt++;
-      slock_unlock(tp->work_mutex);
-
-      /* Call the work function and let it process.
-       *
-       * work can legitimately be NULL. Since multiple threads from the pool
-       * will wake when there is work, a thread might not get any work. 1
-       * piece of work and 2 threads, both will wake but with 1 only work 1
-       * will get the work and the other won't.
-       *
-       * working_cnt has been increment and work could be NULL. While it's
-       * not true there is work processing the thread is considered working
-       * because it's not waiting in the conditional. Pedantic but...
-       */
-      if (work)
+      /* If there is no work in any queue wait in the
+       * conditional until there is work to take. */
+      if (!tpool_has_work(tp))
       {
-         work->func(work->arg);
-         tpool_work_destroy(work);
+         tp->idle_cnt++;
+         scond_wait(tp->work_cond, tp->work_mutex);
+         tp->idle_cnt--;
       }
-
-      slock_lock(tp->work_mutex);
-      tp->working_cnt--;
-      /* Since we're in a lock no work can be added or removed form the queue.
-       * Also, the working_cnt can't be changed (except the thread holding the lock).
-       * At this point if there isn't any work processing and if there is no work
-       * signal this is the case. */
-      if (!tp->stop && tp->working_cnt == 0 && !tp->work_first)
-         scond_signal(tp->working_cond);
       slock_unlock(tp->work_mutex);
    }
 
    tp->thread_cnt--;
    if (tp->thread_cnt == 0)
-      scond_signal(tp->working_cond);
+      scond_broadcast(tp->working_cond);
    slock_unlock(tp->work_mutex);
 }
 
 tpool_t *tpool_create(size_t num)
 {
    tpool_t   *tp;
-   sthread_t *thread;
    size_t     i;
 
    if (num == 0)
       num = 2;
 
    tp               = (tpool_t*)calloc(1, sizeof(*tp));
-   tp->thread_cnt   = num;
+   if (!tp)
+      return NULL;
 
+   tp->queues       = (tpool_queue_t*)calloc(num, sizeof(*tp->queues));
+   tp->threads      = (struct tpool_thread*)calloc(num, sizeof(*tp->threads));
    tp->work_mutex   = slock_new();
    tp->work_cond    = scond_new();
    tp->working_cond = scond_new();
+   tp->queue_cnt    = num;
 
-   tp->work_first   = NULL;
-   tp->work_last    = NULL;
+   if (     !tp->queues
+         || !tp->threads
+         || !tp->work_mutex
+         || !tp->work_cond
+         || !tp->working_cond)
+      goto error;
+
+   for (i = 0; i < num; i++)
+      if (!tpool_queue_init(&tp->queues[i]))
+         goto error;
 
    /* Create the requested number of thread and detach them. */
    for (i = 0; i < num; i++)
    {
-      thread = sthread_create(tpool_worker, tp);
+      sthread_t *thread;
+
+      tp->threads[i].tp    = tp;
+      tp->threads[i].index = i;
+
+      if (!(thread = sthread_create(tpool_worker, &tp->threads[i])))
+         break;
+
+      slock_lock(tp->work_mutex);
+      tp->thread_cnt++;
+      slock_unlock(tp->work_mutex);
       sthread_detach(thread);
    }
 
+   if (tp->thread_cnt == 0)
+      goto error;
+
    return tp;
+
+error:
+   if (tp->queues)
+      for (i = 0; i < num; i++)
+         tpool_queue_deinit(&tp->queues[i]);
+   if (tp->work_mutex)
+      slock_free(tp->work_mutex);
+   if (tp->work_cond)
+      scond_free(tp->work_cond);
+   if (tp->working_cond)
+      scond_free(tp->working_cond);
+   free(tp->queues);
+   free(tp->threads);
+   free(tp);
+   return NULL;
 }
 
 void tpool_destroy(tpool_t *tp)
 {
-   tpool_work_t *work;
-   tpool_work_t *work2;
+   size_t i;
 
    if (!tp)
       return;
 
-   /* Take all work out of the queue and destroy it. */
+   /* Take all work out of the queues and discard it. */
    slock_lock(tp->work_mutex);
-   work = tp->work_first;
-   while (work)
+   for (i = 0; i < tp->queue_cnt; i++)
    {
-      work2 = work->next;
-      tpool_work_destroy(work);
-      work = work2;
+      size_t j;
+      tpool_queue_t *queue = &tp->queues[i];
+
+      slock_lock(tp->queues[i].lock);
+      /* Leftover tpool_parallel_for() helpers still hold
+       * a reference on a range that is already done. */
+      for (j = 0; j < queue->count; j++)
+      {
+         tpool_work_t *work = &queue->items[
+            (queue->head + j) & (queue->size - 1)];
+         if (work->func == tpool_for_worker)
+            tpool_for_release((struct tpool_for*)work->arg);
+      }
+      tp->pending        -= tp->queues[i].count;
+      tp->queues[i].count = 0;
+      slock_unlock(tp->queues[i].lock);
    }
 
    /* Tell the worker threads to stop. */
@@ -210,42 +390,77 @@ void tpool_destroy(tpool_t *tp)
    /* Wait for all threads to stop. */
    tpool_wait(tp);
 
+   for (i = 0; i < tp->queue_cnt; i++)
+      tpool_queue_deinit(&tp->queues[i]);
+
    slock_free(tp->work_mutex);
    scond_free(tp->work_cond);
    scond_free(tp->working_cond);
 
+   free(tp->queues);
+   free(tp->threads);
    free(tp);
 }
 
-bool tpool_add_work(tpool_t *tp, thread_func_t func, void *arg)
+bool tpool_add_work_n(tpool_t *tp, thread_func_t func,
+      void **args, size_t n)
 {
-   tpool_work_t *work;
+   size_t i;
+   size_t index;
+   tpool_queue_t *queue;
 
-   if (!tp)
+   if (!tp || !func)
       return false;
 
-   work = tpool_work_create(func, arg);
-   if (!work)
-      return false;
+   if (n == 0)
+      return true;
 
+   /* A batch goes to a single queue, idle workers
+    * will steal from it. */
    slock_lock(tp->work_mutex);
-   if (!tp->work_first)
+   index          = tp->next_queue++ % tp->queue_cnt;
+   /* Count the work before it becomes visible, so it can't be
+    * completed (and pending underflow) before we get here. */
+   tp->pending   += n;
+   slock_unlock(tp->work_mutex);
+
+   queue          = &tp->queues[index];
+
+   slock_lock(queue->lock);
+   if (!tpool_queue_reserve(queue, n))
    {
-      tp->work_first      = work;
-      tp->work_last       = tp->work_first;
+      slock_unlock(queue->lock);
+
+      slock_lock(tp->work_mutex);
+      tp->pending -= n;
+      if (!tp->stop && tp->pending == 0)
+         scond_broadcast(tp->working_cond);
+      slock_unlock(tp->work_mutex);
+      return false;
    }
-   else
+
+   for (i = 0; i < n; i++)
+      tpool_queue_push(queue, func, args ? args[i] : NULL);
+   slock_unlock(queue->lock);
+
+   slock_lock(tp->work_mutex);
+   if (tp->idle_cnt)
    {
-      tp->work_last->next = work;
-      tp->work_last       = work;
+      if (n == 1)
+         scond_signal(tp->work_cond);
+      else
+         scond_broadcast(tp->work_cond);
    }
-
-   scond_broadcast(tp->work_cond);
    slock_unlock(tp->work_mutex);
 
    return true;
 }
 
+bool tpool_add_work(tpool_t *tp, thread_func_t func, void *arg)
+{
+   return tpool_add_work_n(tp, func, &arg, 1);
+}
+
 void tpool_wait(tpool_t *tp)
 {
    if (!tp)
@@ -255,10 +470,10 @@ void tpool_wait(tpool_t *tp)
 
    for (;;)
    {
-      /* working_cond is dual use. It signals when we're not stopping but the
-       * working_cnt is 0 indicating there isn't any work processing. If we
-       * are stopping it will trigger when there aren't any threads running. */
-      if ((!tp->stop && tp->working_cnt != 0) || (tp->stop && tp->thread_cnt != 0))
+      /* working_cond is dual use. It signals when we're not stopping but
+       * there isn't any work pending. If we are stopping it will trigger
+       * when there aren't any threads running. */
+      if ((!tp->stop && tp->pending != 0) || (tp->stop && tp->thread_cnt != 0))
          scond_wait(tp->working_cond, tp->work_mutex);
       else
          break;
@@ -266,3 +481,125 @@ void tpool_wait(tpool_t *tp)
 
    slock_unlock(tp->work_mutex);
 }
+
+static void tpool_for_release(struct tpool_for *pf)
+{
+   unsigned refs;
+
+   slock_lock(pf->lock);
+   refs = --pf->refs;
+   slock_unlock(pf->lock);
+
+   if (refs)
+      return;
+
+   slock_free(pf->lock);
+   scond_free(pf->cond);
+   free(pf);
+}
+
+/* Claims and runs chunks until the range is exhausted. */
+static void tpool_for_run(struct tpool_for *pf)
+{
+   for (;;)
+   {
+      size_t begin, end;
+
+      slock_lock(pf->lock);
+      if (pf->next >= pf->count)
+      {
+         slock_unlock(pf->lock);
+         break;
+      }
+      begin     = pf->next;
+      end       = begin + pf->grain;
+      if (end > pf->count)
+         end    = pf->count;
+      pf->next  = end;
+      slock_unlock(pf->lock);
+
+      pf->func(pf->arg, begin, end);
+
+      slock_lock(pf->lock);
+      pf->done += end - begin;
+      if (pf->done == pf->count)
+         scond_signal(pf->cond);
+      slock_unlock(pf->lock);
+   }
+}
+
+static void tpool_for_worker(void *arg)
+{
+   struct tpool_for *pf = (struct tpool_for*)arg;
+   tpool_for_run(pf);
+   tpool_for_release(pf);
+}
+
+bool tpool_parallel_for(tpool_t *tp, size_t count, size_t grain,
+      tpool_for_func_t func, void *arg)
+{
+   size_t i;
+   size_t chunks;
+   size_t helpers;
+   struct tpool_for *pf;
+
+   if (!func)
+      return false;
+
+   if (count == 0)
+      return true;
+
+   if (grain == 0)
+      grain = 1;
+
+   chunks  = (count + grain - 1) / grain;
+   helpers = tp ? MIN(chunks - 1, tp->queue_cnt) : 0;
+
+   /* Nothing to share, don't bother the pool. */
+   if (helpers == 0)
+   {
+      func(arg, 0, count);
+      return true;
+   }
+
+   pf = (struct tpool_for*)calloc(1, sizeof(*pf));
+   if (!pf)
+      return false;
+
+   pf->func  = func;
+   pf->arg   = arg;
+   pf->count = count;
+   pf->grain = grain;
+   pf->lock  = slock_new();
+   pf->cond  = scond_new();
+   /* One reference for the caller, one per helper. */
+   pf->refs  = 1 + (unsigned)helpers;
+
+   if (!pf->lock || !pf->cond)
+   {
+      if (pf->lock)
+         slock_free(pf->lock);
+      if (pf->cond)
+         scond_free(pf->cond);
+      free(pf);
+      return false;
+   }
+
+   /* Queue one helper per worker, each one keeps claiming
+    * chunks until there are none left. */
+   for (i = 0; i < helpers; i++)
+      if (!tpool_add_work(tp, tpool_for_worker, pf))
+         tpool_for_release(pf);
+
+   /* The caller helps too, so this can't deadlock even when
+    * called from inside a worker or when the pool is busy. */
+   tpool_for_run(pf);
+
+   slock_lock(pf->lock);
+   while (pf->done < pf->count)
+      scond_wait(pf->cond, pf->lock);
+   slock_unlock(pf->lock);
+
+   tpool_for_release(pf);
+   return true;
+}
@@ -0,0 +1,197 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (sinc_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Times each sinc resampler backend at every quality level,
+ * feeding it audio in small chunks the way audio_driver_flush()
+ * does, and checks the SIMD output against the C reference. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <audio/audio_resampler.h>
+
+extern retro_resampler_t sinc_resampler;
+
+#define BENCH_IN_RATE  32040.0
+#define BENCH_OUT_RATE 48000.0
+#define BENCH_SECONDS  20
+#define BENCH_CHUNK    534
+
+struct bench_backend
+{
+   const char *ident;
+   resampler_simd_mask_t mask;
+};
+
+static const struct bench_backend backends[] = {
+   { "c",   0 },
+   { "sse", RESAMPLER_SIMD_SSE },
+   { "avx", RESAMPLER_SIMD_AVX },
+   { "fma", RESAMPLER_SIMD_AVX2 },
+};
+
+static const char *quality_names[] = {
+   "dontcare", "lowest", "lower", "normal", "higher", "highest"
+};
+
+static double bench_time(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+/* Returns the number of output frames written. */
+static size_t bench_run(void *re, resampler_process_t process,
+      const float *in, size_t in_frames, float *out, double ratio)
+{
+   size_t pos = 0;
+   size_t out_frames = 0;
+
+   while (pos < in_frames)
+   {
+      struct resampler_data data;
+      size_t chunk       = in_frames - pos;
+
+      if (chunk > BENCH_CHUNK)
+         chunk = BENCH_CHUNK;
+
+      data.data_in       = in + pos * 2;
+      data.data_out      = out + out_frames * 2;
+      data.input_frames  = chunk;
+      data.output_frames = 0;
+      data.ratio         = ratio;
+
+      process(re, &data);
+
+      pos               += chunk;
+      out_frames        += data.output_frames;
+   }
+
+   return out_frames;
+}
+
+int main(void)
+{
+   unsigned i, q, b;
+   double ratio       = BENCH_OUT_RATE / BENCH_IN_RATE;
+   size_t in_frames   = (size_t)(BENCH_IN_RATE * BENCH_SECONDS);
+   size_t out_max     = (size_t)(in_frames * ratio) + 4 * BENCH_CHUNK;
+   float *in          = (float*)malloc(in_frames * 2 * sizeof(float));
+   float *ref         = (float*)malloc(out_max * 2 * sizeof(float));
+   float *out         = (float*)malloc(out_max * 2 * sizeof(float));
+
+   if (!in || !ref || !out)
+      return 1;
+
+   /* Two detuned tones plus a little noise. */
+   srand(1);
+   for (i = 0; i < in_frames; i++)
+   {
+      float noise   = ((float)rand() / RAND_MAX - 0.5f) * 0.01f;
+      in[2 * i + 0] = 0.5f * sinf(i * 0.031f) + noise;
+      in[2 * i + 1] = 0.5f * sinf(i * 0.047f) - noise;
+   }
+
+   printf("%u s of %.0f Hz stereo -> %.0f Hz, %u frame chunks\n\n",
+         BENCH_SECONDS, BENCH_IN_RATE, BENCH_OUT_RATE, BENCH_CHUNK);
+   printf("%-8s %-4s %10s %12s %10s %12s\n",
+         "quality", "simd", "ms", "Mframes/s", "speedup", "max diff");
+
+   for (q = RESAMPLER_QUALITY_LOWEST; q <= RESAMPLER_QUALITY_HIGHEST; q++)
+   {
+      resampler_process_t seen[sizeof(backends) / sizeof(backends[0])];
+      size_t ref_frames = 0;
+      double ref_time   = 0.0;
+
+      for (b = 0; b < sizeof(backends) / sizeof(backends[0]); b++)
+      {
+         unsigned j;
+         size_t out_frames;
+         double start, elapsed;
+         float max_diff = 0.0f;
+         bool duplicate = false;
+         void *re       = sinc_resampler.init(NULL, ratio,
+               (enum resampler_quality)q, backends[b].mask);
+
+         seen[b]        = sinc_resampler.process;
+
+         if (!re)
+            return 1;
+
+         /* The driver falls back when a path doesn't apply
+          * to this quality (or wasn't compiled in). */
+         for (j = 0; j < b; j++)
+            if (seen[j] == seen[b])
+               duplicate = true;
+
+         if (duplicate)
+         {
+            sinc_resampler.free(re);
+            continue;
+         }
+
+         start      = bench_time();
+         out_frames = bench_run(re, seen[b], in, in_frames,
+               b ? out : ref, ratio);
+         elapsed    = bench_time() - start;
+
+         if (b == 0)
+         {
+            ref_frames = out_frames;
+            ref_time   = elapsed;
+         }
+         else
+         {
+            if (out_frames != ref_frames)
+            {
+               fprintf(stderr, "%s/%s: produced %u frames, expected %u\n",
+                     quality_names[q], backends[b].ident,
+                     (unsigned)out_frames, (unsigned)ref_frames);
+               return 1;
+            }
+
+            for (j = 0; j < out_frames * 2; j++)
+            {
+               float diff = fabsf(out[j] - ref[j]);
+               if (diff > max_diff)
+                  max_diff = diff;
+            }
+         }
+
+         printf("%-8s %-4s %10.2f %12.2f %9.2fx %12.3g\n",
+               quality_names[q], backends[b].ident,
+               elapsed * 1000.0, out_frames / elapsed / 1000000.0,
+               ref_time / elapsed, max_diff);
+
+         sinc_resampler.free(re);
+      }
+   }
+
+   free(in);
+   free(ref);
+   free(out);
+   return 0;
+}
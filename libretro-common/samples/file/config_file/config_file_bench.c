@@ -0,0 +1,179 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (config_file_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Loads config files and reads back every key in them, the
+ * way retroarch.cfg and core .info files are consumed, once
+ * through the config_file API and once with a plain walk of
+ * the entry list, which is how lookups used to work.
+ *
+ * Usage: config_file_bench <retroarch.cfg> [core .info files...]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <file/config_file.h>
+#include <string/stdstring.h>
+
+#define BENCH_ROUNDS 20
+
+static double bench_now(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static const char *bench_walk(config_file_t *conf, const char *key)
+{
+   struct config_file_entry entry;
+
+   if (!config_get_entry_list_head(conf, &entry))
+      return NULL;
+
+   do
+   {
+      if (string_is_equal(entry.key, key))
+         return entry.value;
+   } while (config_get_entry_list_next(&entry));
+
+   return NULL;
+}
+
+enum bench_mode
+{
+   BENCH_WALK = 0,
+   BENCH_INDEX,
+   BENCH_VERIFY
+};
+
+static const char *bench_lookup(config_file_t *conf, const char *key,
+      enum bench_mode mode)
+{
+   struct config_entry_list *found = NULL;
+
+   if (mode == BENCH_WALK)
+      return bench_walk(conf, key);
+
+   found = config_get_entry(conf, key);
+   return found ? found->value : NULL;
+}
+
+/* Keys are read back in file order, each followed by a
+ * miss, as for options a file doesn't set */
+static unsigned bench_file(const char *path, enum bench_mode mode,
+      unsigned *lookups)
+{
+   struct config_file_entry entry;
+   char miss[256];
+   unsigned bad        = 0;
+   config_file_t *conf = config_file_new(path);
+
+   if (!conf)
+   {
+      fprintf(stderr, "Can't load %s\n", path);
+      return 1;
+   }
+
+   if (config_get_entry_list_head(conf, &entry))
+   {
+      do
+      {
+         const char *value = NULL;
+
+         if (!entry.key)
+            continue;
+
+         snprintf(miss, sizeof(miss), "%s_unset", entry.key);
+
+         value = bench_lookup(conf, entry.key, mode);
+         if (!value || bench_lookup(conf, miss, mode))
+            bad++;
+
+         /* Must find the same entry as the walk, which
+          * matters when a key is set more than once */
+         if (mode == BENCH_VERIFY && value != bench_walk(conf, entry.key))
+            bad++;
+
+         *lookups += 2;
+      } while (config_get_entry_list_next(&entry));
+   }
+
+   config_file_free(conf);
+   return bad;
+}
+
+static unsigned bench_run(char **paths, int count, enum bench_mode mode)
+{
+   int i;
+   unsigned r;
+   unsigned bad     = 0;
+   unsigned lookups = 0;
+   unsigned rounds  = (mode == BENCH_VERIFY) ? 1 : BENCH_ROUNDS;
+   double start     = bench_now();
+   double secs;
+
+   for (r = 0; r < rounds; r++)
+      for (i = 0; i < count; i++)
+         bad += bench_file(paths[i], mode, &lookups);
+
+   secs = (bench_now() - start) / rounds;
+
+   if (mode != BENCH_VERIFY)
+      printf("%-6s %4d file(s), %7u lookups: %9.3f ms per load\n",
+            mode == BENCH_WALK ? "walk" : "index", count,
+            lookups / rounds, secs * 1000.0);
+
+   return bad;
+}
+
+int main(int argc, char *argv[])
+{
+   unsigned bad = 0;
+
+   if (argc < 2)
+   {
+      fprintf(stderr, "Usage: %s <retroarch.cfg> [core .info files...]\n",
+            argv[0]);
+      return 1;
+   }
+
+   bench_run(argv + 1, 1, BENCH_WALK);
+   bench_run(argv + 1, 1, BENCH_INDEX);
+
+   if (argc > 2)
+   {
+      bench_run(argv + 2, argc - 2, BENCH_WALK);
+      bench_run(argv + 2, argc - 2, BENCH_INDEX);
+   }
+
+   bad = bench_run(argv + 1, argc - 1, BENCH_VERIFY);
+   if (bad)
+   {
+      fprintf(stderr, "%u lookups disagreed\n", bad);
+      return 1;
+   }
+
+   return 0;
+}
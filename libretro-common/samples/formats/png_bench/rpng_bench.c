@@ -0,0 +1,246 @@
+/* Copyright  (C) 2010-2020 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rpng_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/* Decodes a corpus of PNG files (e.g. a boxart thumbnail
+ * directory) with the scanline-at-a-time decoder and with the
+ * fast path, with and without a thread pool, and checks that
+ * every mode produces the same pixels.
+ *
+ * Usage: rpng_bench [-n iterations] [-t threads] file.png...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <formats/rpng.h>
+#include <formats/image.h>
+#include <rthreads/tpool.h>
+
+struct bench_file
+{
+   const char *path;
+   void *data;
+   size_t len;
+   uint32_t *pixels; /* reference decode */
+   unsigned width;
+   unsigned height;
+};
+
+static double bench_time(void)
+{
+   struct timespec ts;
+   clock_gettime(CLOCK_MONOTONIC, &ts);
+   return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+}
+
+static bool bench_read_file(struct bench_file *file)
+{
+   long len;
+   FILE *fp = fopen(file->path, "rb");
+
+   if (!fp)
+      return false;
+
+   fseek(fp, 0, SEEK_END);
+   len = ftell(fp);
+   fseek(fp, 0, SEEK_SET);
+
+   if (len <= 0 || !(file->data = malloc(len)))
+   {
+      fclose(fp);
+      return false;
+   }
+
+   file->len = fread(file->data, 1, len, fp);
+   fclose(fp);
+   return file->len == (size_t)len;
+}
+
+static uint32_t *bench_decode(const struct bench_file *file,
+      bool fast, tpool_t *pool, unsigned *width, unsigned *height)
+{
+   int retval;
+   uint32_t *data = NULL;
+   rpng_t *rpng   = rpng_alloc();
+
+   if (!rpng)
+      return NULL;
+
+   rpng_set_fast_path(rpng, fast);
+   rpng_set_thread_pool(rpng, pool);
+
+   if (     !rpng_set_buf_ptr(rpng, file->data, file->len)
+         || !rpng_start(rpng))
+      goto error;
+
+   while (rpng_iterate_image(rpng));
+
+   if (!rpng_is_valid(rpng))
+      goto error;
+
+   do
+   {
+      retval = rpng_process_image(rpng,
+            (void**)&data, file->len, width, height);
+   } while (retval == IMAGE_PROCESS_NEXT);
+
+   if (retval == IMAGE_PROCESS_ERROR || retval == IMAGE_PROCESS_ERROR_END)
+      goto error;
+
+   rpng_free(rpng);
+   return data;
+
+error:
+   rpng_free(rpng);
+   free(data);
+   return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+   int i;
+   unsigned m, it;
+   size_t num_files       = 0;
+   double pixels          = 0.0;
+   unsigned iterations    = 10;
+   unsigned threads       = 4;
+   tpool_t *pool          = NULL;
+   struct bench_file *files;
+   int ret                = 0;
+   const struct
+   {
+      const char *ident;
+      bool fast;
+      bool threaded;
+   } modes[] = {
+      { "scanline",      false, false },
+      { "fast",          true,  false },
+      { "fast+threads",  true,  true  },
+   };
+
+   if (!(files = (struct bench_file*)calloc(argc, sizeof(*files))))
+      return 1;
+
+   for (i = 1; i < argc; i++)
+   {
+      if (!strcmp(argv[i], "-n") && i + 1 < argc)
+         iterations = (unsigned)strtoul(argv[++i], NULL, 0);
+      else if (!strcmp(argv[i], "-t") && i + 1 < argc)
+         threads    = (unsigned)strtoul(argv[++i], NULL, 0);
+      else
+      {
+         struct bench_file *file = &files[num_files];
+
+         file->path = argv[i];
+
+         if (!bench_read_file(file))
+         {
+            fprintf(stderr, "Cannot read %s, skipping.\n", file->path);
+            continue;
+         }
+
+         if (!(file->pixels = bench_decode(file, false, NULL,
+                     &file->width, &file->height)))
+         {
+            fprintf(stderr, "Cannot decode %s, skipping.\n", file->path);
+            free(file->data);
+            continue;
+         }
+
+         pixels += (double)file->width * file->height;
+         num_files++;
+      }
+   }
+
+   if (!num_files || !iterations)
+   {
+      fprintf(stderr, "Usage: %s [-n iterations] [-t threads] file.png...\n",
+            argv[0]);
+      return 1;
+   }
+
+   if (threads > 1)
+      pool = tpool_create(threads);
+
+   printf("%u files, %.2f Mpixels, %u iterations, %u threads\n",
+         (unsigned)num_files, pixels / 1000000.0, iterations, threads);
+
+   for (m = 0; m < sizeof(modes) / sizeof(modes[0]); m++)
+   {
+      size_t f;
+      double elapsed;
+      double start    = bench_time();
+      unsigned errors = 0;
+
+      if (modes[m].threaded && !pool)
+         continue;
+
+      for (it = 0; it < iterations; it++)
+      {
+         for (f = 0; f < num_files; f++)
+         {
+            unsigned width  = 0;
+            unsigned height = 0;
+            uint32_t *data  = bench_decode(&files[f], modes[m].fast,
+                  modes[m].threaded ? pool : NULL, &width, &height);
+
+            if (     !data
+                  || width  != files[f].width
+                  || height != files[f].height
+                  || memcmp(data, files[f].pixels,
+                     (size_t)width * height * sizeof(uint32_t)))
+            {
+               if (it == 0)
+                  fprintf(stderr, "%s: %s differs from the reference.\n",
+                        modes[m].ident, files[f].path);
+               errors++;
+            }
+
+            free(data);
+         }
+      }
+
+      elapsed = bench_time() - start;
+
+      printf("%-14s %9.2f ms/iteration %9.2f Mpixels/s%s\n",
+            modes[m].ident, elapsed * 1000.0 / iterations,
+            pixels * iterations / elapsed / 1000000.0,
+            errors ? "  MISMATCH" : "");
+
+      if (errors)
+         ret = 1;
+   }
+
+   if (pool)
+      tpool_destroy(pool);
+
+   for (i = 0; i < (int)num_files; i++)
+   {
+      free(files[i].data);
+      free(files[i].pixels);
+   }
+   free(files);
+
+   return ret;
+}
@@ -0,0 +1,148 @@
+/* Checks encoding_crc32() against the plain bytewise table
+ * loop it used to be and compares their throughput.
+ *
+ * Usage: crc32_bench [megabytes]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <boolean.h>
+#include <encodings/crc32.h>
+#include <features/features_cpu.h>
+
+static uint32_t crc32_reference_table[256];
+
+static void crc32_reference_init(void)
+{
+   unsigned i, k;
+
+   for (i = 0; i < 256; i++)
+   {
+      uint32_t c = i;
+      for (k = 0; k < 8; k++)
+         c = (c >> 1) ^ (0xedb88320 & (0 - (c & 1)));
+      crc32_reference_table[i] = c;
+   }
+}
+
+static uint32_t crc32_reference(uint32_t crc, const uint8_t *buf, size_t len)
+{
+   crc = ~crc;
+
+   while (len--)
+      crc = crc32_reference_table[(crc ^ *buf++) & 0xff] ^ (crc >> 8);
+
+   return ~crc;
+}
+
+static unsigned crc32_bench_verify(const uint8_t *buf, size_t size)
+{
+   unsigned i;
+   unsigned bad = 0;
+
+   /* Odd lengths and offsets exercise every head and tail */
+   for (i = 0; i < 2000; i++)
+   {
+      size_t off    = rand() % 64;
+      size_t len    = (i < 300) ? i : (size_t)(rand() % 70000);
+      uint32_t seed = (i & 1) ? (uint32_t)rand() : 0;
+
+      if (off + len > size)
+         continue;
+
+      if (     encoding_crc32(seed, buf + off, len)
+            != crc32_reference(seed, buf + off, len))
+      {
+         fprintf(stderr, "Mismatch: offset %u length %u\n",
+               (unsigned)off, (unsigned)len);
+         bad++;
+      }
+   }
+
+   /* Chunked must equal one shot */
+   {
+      uint32_t crc  = 0;
+      size_t pos    = 0;
+
+      while (pos < size)
+      {
+         size_t chunk = 1 + rand() % 5000;
+         if (chunk > size - pos)
+            chunk = size - pos;
+         crc  = encoding_crc32(crc, buf + pos, chunk);
+         pos += chunk;
+      }
+
+      if (crc != encoding_crc32(0, buf, size))
+      {
+         fprintf(stderr, "Chunked mismatch\n");
+         bad++;
+      }
+   }
+
+   return bad;
+}
+
+static void crc32_bench_run(const uint8_t *buf, size_t size,
+      size_t block, bool reference)
+{
+   retro_time_t start, end;
+   size_t done       = 0;
+   uint32_t crc      = 0;
+   double secs;
+
+   start = cpu_features_get_time_usec();
+   while (done < size)
+   {
+      size_t i;
+      for (i = 0; i + block <= size && done < size; i += block)
+      {
+         crc   = reference
+            ? crc32_reference(crc, buf + i, block)
+            : encoding_crc32(crc, buf + i, block);
+         done += block;
+      }
+   }
+   end  = cpu_features_get_time_usec();
+   secs = (end - start) / 1000000.0;
+
+   printf("%-10s %8u bytes: %8.3f GB/s (%08x)\n",
+         reference ? "bytewise" : "crc32",
+         (unsigned)block,
+         secs > 0.0 ? (done / secs) / 1e9 : 0.0, crc);
+}
+
+int main(int argc, char *argv[])
+{
+   static const size_t blocks[] = { 16, 64, 256, 1024, 16384, 1048576 };
+   unsigned i;
+   size_t size   = (argc > 1 ? (size_t)atoi(argv[1]) : 64) << 20;
+   uint8_t *buf  = (uint8_t*)malloc(size);
+
+   if (!buf || size < 1048576)
+   {
+      fprintf(stderr, "Usage: %s [megabytes, at least 1]\n", argv[0]);
+      free(buf);
+      return 1;
+   }
+
+   for (i = 0; i < size; i++)
+      buf[i] = (uint8_t)rand();
+
+   crc32_reference_init();
+
+   if (crc32_bench_verify(buf, size))
+   {
+      free(buf);
+      return 1;
+   }
+
+   crc32_bench_run(buf, size, 1048576, true);
+   for (i = 0; i < sizeof(blocks) / sizeof(*blocks); i++)
+      crc32_bench_run(buf, size, blocks[i], false);
+
+   free(buf);
+   return 0;
+}
@@ -36,6 +36,11 @@
 #include <retro_endianness.h>
 #include <string/stdstring.h>
 #include <compat/strl.h>
+#include <memmap.h>
+
+#ifdef HAVE_MMAN
+#include <fcntl.h>
+#endif
 
 #include "libretrodb.h"
 #include "rmsgpack_dom.h"
@@ -48,26 +53,46 @@
 
 struct node_iter_ctx
 {
-	libretrodb_t *db;
+	RFILE *fd;
 	libretrodb_index_t *idx;
 };
 
+struct libretrodb_index
+{
+	char name[50];
+	char field[50]; /* Field the keys come from */
+	uint64_t key_size;
+	uint64_t next;
+	uint64_t offset; /* Where the keys start in the file */
+};
+
+/* Index over a field, built in memory the first time a query
+ * needs one and the file has none, see libretrodb_memory_index().
+ * Keys are hashed, so string and binary values of any length
+ * are covered and items may share a key. */
+struct libretrodb_memory_index
+{
+   char field[50];
+   uint64_t *entries;   /* Key hash and item offset pairs, sorted */
+   uint64_t count;
+};
+
 struct libretrodb
 {
 	RFILE *fd;
    char *path;
+   const uint8_t *map;           /* Read-only mapping of the file, or NULL */
+   size_t map_size;
+   int map_tried;                /* Mapped on first use, see libretrodb_map() */
+   libretrodb_index_t *indexes;  /* Index headers, parsed at open */
+   struct libretrodb_memory_index *memory_indexes;
+   unsigned index_count;
+   unsigned memory_index_count;
 	uint64_t root;
 	uint64_t count;
 	uint64_t first_index_offset;
 };
 
-struct libretrodb_index
-{
-	char name[50];
-	uint64_t key_size;
-	uint64_t next;
-};
-
 typedef struct libretrodb_metadata
 {
 	uint64_t count;
@@ -84,6 +109,11 @@ struct libretrodb_cursor
    RFILE *fd;
 	libretrodb_query_t *query;
 	libretrodb_t *db;
+   uint64_t *offsets;      /* Items found through an index, NULL to scan */
+   uint8_t *view_buf;      /* Current item, for views when it isn't mapped */
+   size_t view_buf_size;
+   unsigned offset_count;
+   unsigned offset_pos;
 	int is_valid;
 	int eof;
 };
@@ -181,34 +211,183 @@ clean:
    return rv;
 }
 
+static const struct rmsgpack_dom_value *libretrodb_index_header_value(
+      const struct rmsgpack_dom_value *map, const char *name,
+      enum rmsgpack_dom_type type)
+{
+   struct rmsgpack_dom_value key;
+   const struct rmsgpack_dom_value *value;
+
+   key.type            = RDT_STRING;
+   key.val.string.len  = (uint32_t)strlen(name);
+   key.val.string.buff = (char*)name;
+
+   value = rmsgpack_dom_value_map_value(map, &key);
+   return (value && value->type == type) ? value : NULL;
+}
+
+/* "field" was added later, headers without it are
+ * taken to be named after their field. */
 static int libretrodb_read_index_header(RFILE *fd, libretrodb_index_t *idx)
 {
-   uint64_t name_len = 50;
-   return rmsgpack_dom_read_into(fd,
-         "name", idx->name, &name_len,
-         "key_size", &idx->key_size,
-         "next", &idx->next, NULL);
+   struct rmsgpack_dom_value map;
+   const struct rmsgpack_dom_value *name, *field, *key_size, *next;
+   int rv = rmsgpack_dom_read(fd, &map);
+
+   if (rv < 0)
+      return rv;
+
+   rv = -EINVAL;
+
+   if (map.type != RDT_MAP)
+      goto clean;
+
+   name     = libretrodb_index_header_value(&map, "name",     RDT_STRING);
+   field    = libretrodb_index_header_value(&map, "field",    RDT_STRING);
+   key_size = libretrodb_index_header_value(&map, "key_size", RDT_UINT);
+   next     = libretrodb_index_header_value(&map, "next",     RDT_UINT);
+
+   if (!name || !key_size || !next)
+      goto clean;
+
+   if (!field)
+      field = name;
+
+   strlcpy(idx->name,  name->val.string.buff,  sizeof(idx->name));
+   strlcpy(idx->field, field->val.string.buff, sizeof(idx->field));
+   idx->key_size = key_size->val.uint_;
+   idx->next     = next->val.uint_;
+   rv            = 0;
+
+clean:
+   rmsgpack_dom_value_free(&map);
+   return rv;
 }
 
 static void libretrodb_write_index_header(RFILE *fd, libretrodb_index_t *idx)
 {
-   rmsgpack_write_map_header(fd, 3);
+   rmsgpack_write_map_header(fd, 4);
    rmsgpack_write_string(fd, "name", STRLEN_CONST("name"));
    rmsgpack_write_string(fd, idx->name, (uint32_t)strlen(idx->name));
+   rmsgpack_write_string(fd, "field", STRLEN_CONST("field"));
+   rmsgpack_write_string(fd, idx->field, (uint32_t)strlen(idx->field));
    rmsgpack_write_string(fd, "key_size", (uint32_t)STRLEN_CONST("key_size"));
    rmsgpack_write_uint(fd, idx->key_size);
    rmsgpack_write_string(fd, "next", STRLEN_CONST("next"));
    rmsgpack_write_uint(fd, idx->next);
 }
 
+static void libretrodb_unmap(libretrodb_t *db)
+{
+#ifdef HAVE_MMAN
+   if (db->map)
+      munmap((void*)db->map, db->map_size);
+#endif
+   db->map       = NULL;
+   db->map_size  = 0;
+   db->map_tried = 0;
+}
+
+/* Maps the whole file read-only so index lookups and views
+ * don't have to read it in. This happens on their first use,
+ * so databases only opened to be written never get mapped.
+ * Failing is fine, they then fall back to reading through
+ * the file stream. */
+static void libretrodb_map(libretrodb_t *db)
+{
+#ifdef HAVE_MMAN
+   void *map;
+   int64_t size;
+   int fd;
+
+   if (db->map_tried)
+      return;
+
+   db->map_tried = 1;
+
+   if ((size = filestream_get_size(db->fd)) <= 0)
+      return;
+
+   if ((fd = open(db->path, O_RDONLY)) < 0)
+      return;
+
+   map = mmap(NULL, (size_t)size, PROT_READ, MAP_SHARED, fd, 0);
+   close(fd);
+
+   if (map == MAP_FAILED)
+      return;
+
+   db->map      = (const uint8_t*)map;
+   db->map_size = (size_t)size;
+#endif
+}
+
+/* Walks the index headers behind the metadata once, so
+ * lookups don't have to. */
+static int libretrodb_read_indexes(libretrodb_t *db)
+{
+   int64_t eof    = filestream_get_size(db->fd);
+   int64_t offset = (int64_t)db->first_index_offset;
+
+   free(db->indexes);
+   db->indexes     = NULL;
+   db->index_count = 0;
+
+   filestream_seek(db->fd, offset, RETRO_VFS_SEEK_POSITION_START);
+
+   while (offset < eof)
+   {
+      libretrodb_index_t idx;
+      libretrodb_index_t *indexes;
+
+      if (libretrodb_read_index_header(db->fd, &idx) < 0)
+         break;
+
+      idx.offset = (uint64_t)filestream_tell(db->fd);
+
+      if (idx.key_size == 0 || idx.offset + idx.next > (uint64_t)eof)
+         break;
+
+      indexes = (libretrodb_index_t*)realloc(db->indexes,
+            (db->index_count + 1) * sizeof(*indexes));
+      if (!indexes)
+         return -ENOMEM;
+
+      db->indexes                    = indexes;
+      db->indexes[db->index_count++] = idx;
+
+      offset = (int64_t)(idx.offset + idx.next);
+      filestream_seek(db->fd, offset, RETRO_VFS_SEEK_POSITION_START);
+   }
+
+   return 0;
+}
+
+static void libretrodb_free_memory_indexes(libretrodb_t *db)
+{
+   unsigned i;
+
+   for (i = 0; i < db->memory_index_count; i++)
+      free(db->memory_indexes[i].entries);
+   free(db->memory_indexes);
+
+   db->memory_indexes     = NULL;
+   db->memory_index_count = 0;
+}
+
 void libretrodb_close(libretrodb_t *db)
 {
+   libretrodb_unmap(db);
+   libretrodb_free_memory_indexes(db);
    if (db->fd)
       filestream_close(db->fd);
    if (!string_is_empty(db->path))
       free(db->path);
-   db->path = NULL;
-   db->fd   = NULL;
+   free(db->indexes);
+   db->indexes     = NULL;
+   db->index_count = 0;
+   db->path        = NULL;
+   db->fd          = NULL;
 }
 
 int libretrodb_open(const char *path, libretrodb_t *db)
@@ -226,6 +405,8 @@ int libretrodb_open(const char *path, libretrodb_t *db)
    if (!string_is_empty(db->path))
       free(db->path);
 
+   libretrodb_free_memory_indexes(db);
+
    db->path  = strdup(path);
    db->root  = filestream_tell(fd);
 
@@ -254,6 +435,14 @@ int libretrodb_open(const char *path, libretrodb_t *db)
    db->count              = md.count;
    db->first_index_offset = filestream_tell(fd);
    db->fd                 = fd;
+
+   if ((rv = libretrodb_read_indexes(db)) < 0)
+   {
+      db->fd = NULL;
+      goto error;
+   }
+
+   libretrodb_unmap(db);
    return 0;
 
 error:
@@ -262,91 +451,244 @@ error:
    return rv;
 }
 
-static int libretrodb_find_index(libretrodb_t *db, const char *index_name,
-      libretrodb_index_t *idx)
+static const libretrodb_index_t *libretrodb_find_index(
+      const libretrodb_t *db, const char *index_name)
 {
-   ssize_t eof    = filestream_get_size(db->fd);
-   ssize_t offset = filestream_seek(db->fd,
-         (ssize_t)db->first_index_offset,
+   unsigned i;
+
+   for (i = 0; i < db->index_count; i++)
+      if (string_is_equal(index_name, db->indexes[i].name))
+         return &db->indexes[i];
+
+   return NULL;
+}
+
+/* Index entries are the key followed by the offset of the item,
+ * sorted by key. Narrows down to the last entry not greater
+ * than the key; the loop body compiles to a conditional move. */
+static int libretrodb_binsearch(const uint8_t *keys, uint64_t count,
+      size_t key_size, const void *key, uint64_t *offset)
+{
+   size_t item_size   = key_size + sizeof(uint64_t);
+   const uint8_t *cur = keys;
+
+   if (count == 0)
+      return -1;
+
+   while (count > 1)
+   {
+      uint64_t half      = count / 2;
+      const uint8_t *mid = cur + half * item_size;
+
+      cur    = (memcmp(mid, key, key_size) <= 0) ? mid : cur;
+      count -= half;
+   }
+
+   if (memcmp(cur, key, key_size) != 0)
+      return -1;
+
+   memcpy(offset, cur + key_size, sizeof(*offset));
+   return 0;
+}
+
+/* Returns the entries of an index, straight from the mapping
+ * when there is one, otherwise read into *buff which the caller
+ * has to free. */
+static const uint8_t *libretrodb_index_entries(libretrodb_t *db,
+      const libretrodb_index_t *idx, uint8_t **buff)
+{
+   int64_t nread = 0;
+   int64_t len   = (int64_t)idx->next;
+
+   *buff         = NULL;
+
+   libretrodb_map(db);
+
+   if (db->map)
+      return db->map + idx->offset;
+
+   if (!(*buff = (uint8_t*)malloc((size_t)len)))
+      return NULL;
+
+   filestream_seek(db->fd, (int64_t)idx->offset,
          RETRO_VFS_SEEK_POSITION_START);
 
-   /* TODO: this should use filestream_eof instead */
-   while (offset < eof)
+   while (nread < len)
    {
-      libretrodb_read_index_header(db->fd, idx);
+      int64_t rd = filestream_read(db->fd, *buff + nread, len - nread);
 
-      if (strncmp(index_name, idx->name, strlen(idx->name)) == 0)
-         return 0;
+      if (rd <= 0)
+      {
+         free(*buff);
+         *buff = NULL;
+         return NULL;
+      }
+      nread += rd;
+   }
 
-      filestream_seek(db->fd, (ssize_t)idx->next,
-            RETRO_VFS_SEEK_POSITION_CURRENT);
-      offset = filestream_tell(db->fd);
+   return *buff;
+}
+
+uint64_t libretrodb_index_key_size(libretrodb_t *db, const char *index_name)
+{
+   const libretrodb_index_t *idx = libretrodb_find_index(db, index_name);
+   return idx ? idx->key_size : 0;
+}
+
+const char *libretrodb_index_for_field(libretrodb_t *db,
+      const char *field, uint64_t *key_size)
+{
+   unsigned i;
+
+   for (i = 0; i < db->index_count; i++)
+   {
+      if (string_is_equal(field, db->indexes[i].field))
+      {
+         if (key_size)
+            *key_size = db->indexes[i].key_size;
+         return db->indexes[i].name;
+      }
    }
 
-   return -1;
+   return NULL;
 }
 
-static int binsearch(const void *buff, const void *item,
-      uint64_t count, uint8_t field_size, uint64_t *offset)
+uint64_t libretrodb_key_hash(enum rmsgpack_dom_type type,
+      const void *key, size_t len)
 {
-   int mid            = (int)(count / 2);
-   int item_size      = field_size + sizeof(uint64_t);
-   uint64_t *current  = (uint64_t *)buff + (mid * item_size);
-   int rv             = memcmp(current, item, field_size);
+   size_t i;
+   const uint8_t *data = (const uint8_t*)key;
+   uint64_t hash       = 0xcbf29ce484222325ULL;
+
+   /* FNV-1a, over the type too so b"x" and "x" differ */
+   hash ^= (uint8_t)type;
+   hash *= 0x100000001b3ULL;
 
-   if (rv == 0)
+   for (i = 0; i < len; i++)
    {
-      *offset = *(uint64_t *)(current + field_size);
-      return 0;
+      hash ^= data[i];
+      hash *= 0x100000001b3ULL;
    }
 
-   if (count == 0)
-      return -1;
+   return hash;
+}
 
-   if (rv > 0)
-      return binsearch(buff, item, mid, field_size, offset);
+static int libretrodb_memory_entry_compare(const void *a, const void *b)
+{
+   const uint64_t *x = (const uint64_t*)a;
+   const uint64_t *y = (const uint64_t*)b;
 
-   return binsearch(current + item_size, item,
-         count - mid, field_size, offset);
+   if (x[0] != y[0])
+      return (x[0] > y[0]) - (x[0] < y[0]);
+   return (x[1] > y[1]) - (x[1] < y[1]);
 }
 
-int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
-      const void *key, struct rmsgpack_dom_value *out)
+/* Returns the in-memory index over @field, walking the items
+ * once to build it if this is the first time it is asked for.
+ * Items without a string or binary value for @field are left out. */
+static const struct libretrodb_memory_index *libretrodb_memory_index(
+      libretrodb_t *db, const char *field)
 {
-   libretrodb_index_t idx;
-   int rv;
-   void *buff;
-   uint64_t offset;
-   ssize_t bufflen, nread = 0;
+   unsigned i;
+   struct rmsgpack_view item;
+   struct libretrodb_memory_index midx;
+   struct libretrodb_memory_index *indexes;
+   libretrodb_cursor_t cur = {0};
+   uint64_t cap            = 0;
 
-   if (libretrodb_find_index(db, index_name, &idx) < 0)
-      return -1;
+   for (i = 0; i < db->memory_index_count; i++)
+      if (string_is_equal(field, db->memory_indexes[i].field))
+         return &db->memory_indexes[i];
 
-   bufflen = idx.next;
-   buff    = malloc(bufflen);
+   strlcpy(midx.field, field, sizeof(midx.field));
+   midx.entries = NULL;
+   midx.count   = 0;
 
-   if (!buff)
-      return -ENOMEM;
+   if (libretrodb_cursor_open(db, &cur, NULL) != 0)
+      return NULL;
 
-   while (nread < bufflen)
+   for (;;)
    {
-      void *buff_ = (uint64_t *)buff + nread;
-      rv          = (int)filestream_read(db->fd, buff_, bufflen - nread);
+      struct rmsgpack_view value;
+      uint64_t offset = libretrodb_cursor_tell(&cur);
+
+      if (libretrodb_cursor_read_view(&cur, &item) != 0)
+         break;
+
+      if (     item.type != RDT_MAP
+            || !rmsgpack_dom_view_map_values(&item, &field, 1, &value))
+         continue;
+      if (value.type != RDT_STRING && value.type != RDT_BINARY)
+         continue;
 
-      if (rv <= 0)
+      if (midx.count == cap)
       {
-         free(buff);
-         return -errno;
+         uint64_t *entries;
+
+         cap     = cap ? cap * 2 : 1024;
+         entries = (uint64_t*)realloc(midx.entries,
+               (size_t)cap * 2 * sizeof(uint64_t));
+
+         if (!entries)
+         {
+            free(midx.entries);
+            libretrodb_cursor_close(&cur);
+            return NULL;
+         }
+
+         midx.entries = entries;
       }
-      nread += rv;
+
+      /* Strings and binaries are laid out alike */
+      midx.entries[midx.count * 2]     = libretrodb_key_hash(value.type,
+            value.val.binary.buff, value.val.binary.len);
+      midx.entries[midx.count * 2 + 1] = offset;
+      midx.count++;
    }
 
-   rv = binsearch(buff, key, db->count, (ssize_t)idx.key_size, &offset);
+   libretrodb_cursor_close(&cur);
+
+   qsort(midx.entries, (size_t)midx.count, 2 * sizeof(uint64_t),
+         libretrodb_memory_entry_compare);
+
+   if (!(indexes = (struct libretrodb_memory_index*)realloc(
+               db->memory_indexes,
+               (db->memory_index_count + 1) * sizeof(*indexes))))
+   {
+      free(midx.entries);
+      return NULL;
+   }
+
+   db->memory_indexes                           = indexes;
+   db->memory_indexes[db->memory_index_count++] = midx;
+
+   return &db->memory_indexes[db->memory_index_count - 1];
+}
+
+int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
+      const void *key, struct rmsgpack_dom_value *out)
+{
+   int rv;
+   uint64_t offset;
+   uint8_t *buff                 = NULL;
+   const uint8_t *keys           = NULL;
+   const libretrodb_index_t *idx = libretrodb_find_index(db, index_name);
+
+   if (!idx)
+      return -1;
+
+   if (!(keys = libretrodb_index_entries(db, idx, &buff)))
+      return -EIO;
+
+   rv = libretrodb_binsearch(keys,
+         idx->next / (idx->key_size + sizeof(uint64_t)),
+         (size_t)idx->key_size, key, &offset);
    free(buff);
 
-   if (rv == 0)
-      filestream_seek(db->fd, (ssize_t)offset,
-            RETRO_VFS_SEEK_POSITION_START);
+   if (rv != 0)
+      return -1;
+
+   filestream_seek(db->fd, (int64_t)offset, RETRO_VFS_SEEK_POSITION_START);
 
    return rmsgpack_dom_read(db->fd, out);
 }
@@ -361,7 +703,8 @@ int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
  **/
 int libretrodb_cursor_reset(libretrodb_cursor_t *cursor)
 {
-   cursor->eof = 0;
+   cursor->eof        = 0;
+   cursor->offset_pos = 0;
    return (int)filestream_seek(cursor->fd,
          (ssize_t)(cursor->db->root + sizeof(libretrodb_header_t)),
          RETRO_VFS_SEEK_POSITION_START);
@@ -376,6 +719,19 @@ int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       return EOF;
 
 retry:
+   if (cursor->offsets)
+   {
+      if (cursor->offset_pos >= cursor->offset_count)
+      {
+         cursor->eof = 1;
+         return EOF;
+      }
+
+      filestream_seek(cursor->fd,
+            (int64_t)cursor->offsets[cursor->offset_pos++],
+            RETRO_VFS_SEEK_POSITION_START);
+   }
+
    rv = rmsgpack_dom_read(cursor->fd, out);
    if (rv < 0)
       return rv;
@@ -398,6 +754,101 @@ retry:
    return 0;
 }
 
+/* Reads the item at @pos into the cursor's buffer, growing it
+ * until the whole item fits. */
+static size_t libretrodb_cursor_read_view_stream(
+      libretrodb_cursor_t *cursor, int64_t pos, struct rmsgpack_view *out)
+{
+   size_t want = cursor->view_buf_size ? cursor->view_buf_size : 4096;
+
+   for (;;)
+   {
+      size_t len;
+      int64_t rd;
+
+      if (want > cursor->view_buf_size)
+      {
+         uint8_t *buf = (uint8_t*)realloc(cursor->view_buf, want);
+
+         if (!buf)
+            return 0;
+
+         cursor->view_buf      = buf;
+         cursor->view_buf_size = want;
+      }
+
+      filestream_seek(cursor->fd, pos, RETRO_VFS_SEEK_POSITION_START);
+
+      if ((rd = filestream_read(cursor->fd, cursor->view_buf, want)) <= 0)
+         return 0;
+
+      if ((len = rmsgpack_dom_view_read(cursor->view_buf, (size_t)rd, out)))
+         return len;
+
+      /* Invalid rather than cut off */
+      if ((size_t)rd < want)
+         return 0;
+
+      want *= 2;
+   }
+}
+
+int libretrodb_cursor_read_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_view *out)
+{
+   size_t len;
+   int64_t pos;
+
+   if (cursor->eof)
+      return EOF;
+
+   if (cursor->query)
+      return -EINVAL;
+
+   if ((pos = filestream_tell(cursor->fd)) < 0)
+      return -EIO;
+
+   libretrodb_map(cursor->db);
+
+   if (cursor->db->map)
+   {
+      if ((size_t)pos >= cursor->db->map_size)
+         return -EIO;
+
+      len = rmsgpack_dom_view_read(cursor->db->map + pos,
+            cursor->db->map_size - pos, out);
+   }
+   else
+      len = libretrodb_cursor_read_view_stream(cursor, pos, out);
+
+   if (!len)
+      return -EINVAL;
+
+   if (out->type == RDT_NULL)
+   {
+      cursor->eof = 1;
+      return EOF;
+   }
+
+   filestream_seek(cursor->fd, pos + (int64_t)len,
+         RETRO_VFS_SEEK_POSITION_START);
+   return 0;
+}
+
+uint64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor)
+{
+   return (uint64_t)filestream_tell(cursor->fd);
+}
+
+int libretrodb_cursor_seek(libretrodb_cursor_t *cursor, uint64_t offset)
+{
+   cursor->eof = 0;
+   if (filestream_seek(cursor->fd, (int64_t)offset,
+            RETRO_VFS_SEEK_POSITION_START) < 0)
+      return -1;
+   return 0;
+}
+
 /**
  * libretrodb_cursor_close:
  * @cursor              : Handle to database cursor.
@@ -415,11 +866,161 @@ void libretrodb_cursor_close(libretrodb_cursor_t *cursor)
    if (cursor->query)
       libretrodb_query_free(cursor->query);
 
-   cursor->is_valid = 0;
-   cursor->eof      = 1;
-   cursor->fd       = NULL;
-   cursor->db       = NULL;
-   cursor->query    = NULL;
+   free(cursor->offsets);
+   free(cursor->view_buf);
+
+   cursor->view_buf      = NULL;
+   cursor->view_buf_size = 0;
+   cursor->is_valid     = 0;
+   cursor->eof          = 1;
+   cursor->fd           = NULL;
+   cursor->db           = NULL;
+   cursor->query        = NULL;
+   cursor->offsets      = NULL;
+   cursor->offset_count = 0;
+   cursor->offset_pos   = 0;
+}
+
+static int libretrodb_offset_compare(const void *a, const void *b)
+{
+   uint64_t x = *(const uint64_t*)a;
+   uint64_t y = *(const uint64_t*)b;
+   return (x > y) - (x < y);
+}
+
+/* Looks up unique keys in an index stored in the file.
+ * Returns the number of offsets found. */
+static unsigned libretrodb_cursor_plan_index(libretrodb_cursor_t *cursor,
+      const char *index_name, const uint8_t *keys, size_t key_size,
+      unsigned count)
+{
+   unsigned i;
+   uint64_t entry_count;
+   const libretrodb_index_t *idx;
+   const uint8_t *entries = NULL;
+   uint8_t *buff          = NULL;
+   unsigned found         = 0;
+
+   if (!(idx = libretrodb_find_index(cursor->db, index_name)))
+      return 0;
+   if (idx->key_size != key_size)
+      return 0;
+
+   if (!(entries = libretrodb_index_entries(cursor->db, idx, &buff)))
+      return 0;
+
+   if ((cursor->offsets = (uint64_t*)malloc(count * sizeof(uint64_t))))
+   {
+      entry_count = idx->next / (idx->key_size + sizeof(uint64_t));
+
+      for (i = 0; i < count; i++)
+         if (libretrodb_binsearch(entries, entry_count, key_size,
+                  keys + i * key_size, &cursor->offsets[found]) == 0)
+            found++;
+   }
+
+   free(buff);
+   return found;
+}
+
+/* Looks up key hashes in the in-memory index over @field, where
+ * each can lead to any number of items, including ones that only
+ * share the hash. Returns the number of offsets found. */
+static unsigned libretrodb_cursor_plan_memory_index(
+      libretrodb_cursor_t *cursor, const char *field,
+      const uint64_t *hashes, unsigned count)
+{
+   unsigned i;
+   const struct libretrodb_memory_index *midx;
+   unsigned cap   = count;
+   unsigned found = 0;
+
+   if (!(midx = libretrodb_memory_index(cursor->db, field)))
+      return 0;
+
+   if (!(cursor->offsets = (uint64_t*)malloc(cap * sizeof(uint64_t))))
+      return 0;
+
+   for (i = 0; i < count; i++)
+   {
+      /* First entry with the hash */
+      uint64_t lo = 0;
+      uint64_t hi = midx->count;
+
+      while (lo < hi)
+      {
+         uint64_t mid = lo + (hi - lo) / 2;
+
+         if (midx->entries[mid * 2] < hashes[i])
+            lo = mid + 1;
+         else
+            hi = mid;
+      }
+
+      for (; lo < midx->count && midx->entries[lo * 2] == hashes[i]; lo++)
+      {
+         if (found == cap)
+         {
+            uint64_t *offsets = (uint64_t*)realloc(cursor->offsets,
+                  cap * 2 * sizeof(uint64_t));
+
+            /* Scan instead of missing items */
+            if (!offsets)
+            {
+               free(cursor->offsets);
+               cursor->offsets = NULL;
+               return 0;
+            }
+
+            cursor->offsets = offsets;
+            cap            *= 2;
+         }
+
+         cursor->offsets[found++] = midx->entries[lo * 2 + 1];
+      }
+   }
+
+   return found;
+}
+
+/* When the query pins a field to one or more keys, looks them
+ * up front so reading only visits those items, in file order.
+ * The query is still applied to each of them. Fields without
+ * an index in the file go through one built in memory, which
+ * the first such query on the handle pays for. */
+static void libretrodb_cursor_plan(libretrodb_cursor_t *cursor)
+{
+   unsigned i, count, found;
+   size_t key_size;
+   int hashed                = 0;
+   const uint8_t *query_keys = NULL;
+   const char *index_name    = libretrodb_query_index_keys(
+         cursor->query, &query_keys, &key_size, &count, &hashed);
+
+   if (!index_name || !count)
+      return;
+
+   if (hashed)
+      found = libretrodb_cursor_plan_memory_index(cursor, index_name,
+            (const uint64_t*)query_keys, count);
+   else
+      found = libretrodb_cursor_plan_index(cursor, index_name,
+            query_keys, key_size, count);
+
+   /* Without offsets the cursor falls back to a full scan */
+   if (!cursor->offsets)
+      return;
+
+   qsort(cursor->offsets, found, sizeof(uint64_t),
+         libretrodb_offset_compare);
+
+   /* or() may list a key twice */
+   cursor->offset_count = 0;
+   for (i = 0; i < found; i++)
+      if (     cursor->offset_count == 0
+            || cursor->offsets[cursor->offset_count - 1]
+            != cursor->offsets[i])
+         cursor->offsets[cursor->offset_count++] = cursor->offsets[i];
 }
 
 /**
@@ -454,7 +1055,10 @@ int libretrodb_cursor_open(libretrodb_t *db,
    cursor->query    = q;
 
    if (q)
+   {
       libretrodb_query_inc_ref(q);
+      libretrodb_cursor_plan(cursor);
+   }
 
    return 0;
 }
@@ -463,16 +1067,17 @@ static int node_iter(void *value, void *ctx)
 {
    struct node_iter_ctx *nictx = (struct node_iter_ctx*)ctx;
 
-   if (filestream_write(nictx->db->fd, value,
-            (ssize_t)(nictx->idx->key_size + sizeof(uint64_t))) > 0)
+   if (filestream_write(nictx->fd, value,
+            (int64_t)(nictx->idx->key_size + sizeof(uint64_t))) > 0)
       return 0;
 
    return -1;
 }
 
-static uint64_t libretrodb_tell(libretrodb_t *db)
+static int node_free(void *value, void *ctx)
 {
-   return filestream_tell(db->fd);
+   free(value);
+   return 0;
 }
 
 static int node_compare(const void *a, const void *b, void *ctx)
@@ -489,10 +1094,11 @@ int libretrodb_create_index(libretrodb_t *db,
    struct rmsgpack_dom_value item;
    libretrodb_cursor_t cur          = {0};
    struct rmsgpack_dom_value *field = NULL;
-   void *buff                       = NULL;
-   uint64_t *buff_u64               = NULL;
+   RFILE *fd                        = NULL;
+   uint8_t *buff                    = NULL;
    uint8_t field_size               = 0;
-   uint64_t item_loc                = libretrodb_tell(db);
+   uint64_t item_count              = 0;
+   uint64_t item_loc                = 0;
    bintree_t *tree                  = bintree_new(node_compare, &field_size);
 
    item.type                        = RDT_NULL;
@@ -500,6 +1106,8 @@ int libretrodb_create_index(libretrodb_t *db,
    if (!tree || (libretrodb_cursor_open(db, &cur, NULL) != 0))
       goto clean;
 
+   item_loc            = libretrodb_cursor_tell(&cur);
+
    key.type            = RDT_STRING;
    key.val.string.len  = (uint32_t)strlen(field_name);
    key.val.string.buff = (char *) field_name;   /* We know we aren't going to change it */
@@ -540,15 +1148,13 @@ int libretrodb_create_index(libretrodb_t *db,
          goto clean;
       }
 
-      buff = malloc(field_size + sizeof(uint64_t));
+      buff = (uint8_t*)malloc(field_size + sizeof(uint64_t));
       if (!buff)
          goto clean;
 
+      /* Key followed by the offset of the item */
       memcpy(buff, field->val.binary.buff, field_size);
-
-      buff_u64 = (uint64_t *)buff + field_size;
-
-      memcpy(buff_u64, &item_loc, sizeof(uint64_t));
+      memcpy(buff + field_size, &item_loc, sizeof(uint64_t));
 
       if (bintree_insert(tree, buff) != 0)
       {
@@ -558,22 +1164,36 @@ int libretrodb_create_index(libretrodb_t *db,
          goto clean;
       }
       buff     = NULL;
+      item_count++;
       rmsgpack_dom_value_free(&item);
-      item_loc = libretrodb_tell(db);
+      item_loc = libretrodb_cursor_tell(&cur);
    }
 
-   filestream_seek(db->fd, 0, RETRO_VFS_SEEK_POSITION_END);
+   /* db->fd is read-only, append through a second handle */
+   fd = filestream_open(db->path,
+         RETRO_VFS_FILE_ACCESS_READ_WRITE
+         | RETRO_VFS_FILE_ACCESS_UPDATE_EXISTING,
+         RETRO_VFS_FILE_ACCESS_HINT_NONE);
 
-   strncpy(idx.name, name, 50);
+   if (!fd)
+      goto clean;
 
-   idx.name[49] = '\0';
+   filestream_seek(fd, 0, RETRO_VFS_SEEK_POSITION_END);
+
+   strlcpy(idx.name,  name,       sizeof(idx.name));
+   strlcpy(idx.field, field_name, sizeof(idx.field));
    idx.key_size = field_size;
-   idx.next     = db->count * (field_size + sizeof(uint64_t));
-   libretrodb_write_index_header(db->fd, &idx);
+   idx.next     = item_count * (field_size + sizeof(uint64_t));
+   libretrodb_write_index_header(fd, &idx);
 
-   nictx.db  = db;
+   nictx.fd  = fd;
    nictx.idx = &idx;
    bintree_iterate(tree, node_iter, &nictx);
+   filestream_close(fd);
+
+   /* Pick up the new index, the mapping no longer covers it */
+   libretrodb_read_indexes(db);
+   libretrodb_unmap(db);
 
 clean:
    rmsgpack_dom_value_free(&item);
@@ -582,7 +1202,10 @@ clean:
    if (cur.is_valid)
       libretrodb_cursor_close(&cur);
    if (tree)
+   {
+      bintree_iterate(tree, node_free, NULL);
       bintree_free(tree);
+   }
    free(tree);
    return 0;
 }
@@ -600,6 +1223,11 @@ libretrodb_cursor_t *libretrodb_cursor_new(void)
    dbc->eof                 = 0;
    dbc->query               = NULL;
    dbc->db                  = NULL;
+   dbc->offsets             = NULL;
+   dbc->view_buf            = NULL;
+   dbc->view_buf_size       = 0;
+   dbc->offset_count        = 0;
+   dbc->offset_pos          = 0;
 
    return dbc;
 }
@@ -620,6 +1248,13 @@ libretrodb_t *libretrodb_new(void)
       return NULL;
 
    db->fd                 = NULL;
+   db->map                = NULL;
+   db->map_size           = 0;
+   db->map_tried          = 0;
+   db->indexes            = NULL;
+   db->index_count        = 0;
+   db->memory_indexes     = NULL;
+   db->memory_index_count = 0;
    db->root               = 0;
    db->count              = 0;
    db->first_index_offset = 0;
@@ -57,6 +57,40 @@ int libretrodb_create_index(libretrodb_t *db, const char *name,
 int libretrodb_find_entry(libretrodb_t *db, const char *index_name,
         const void *key, struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_index_key_size:
+ * @db                  : Handle to database.
+ * @index_name          : Name of the index.
+ *
+ * Returns: size of the keys in index @index_name,
+ * 0 if the database has no such index.
+ **/
+uint64_t libretrodb_index_key_size(libretrodb_t *db, const char *index_name);
+
+/**
+ * libretrodb_index_for_field:
+ * @db                  : Handle to database.
+ * @field               : Name of a field of the items.
+ * @key_size            : Set to the size of the keys, may be NULL.
+ *
+ * Returns: name of an index over @field, or NULL if the
+ * database has none.
+ **/
+const char *libretrodb_index_for_field(libretrodb_t *db,
+      const char *field, uint64_t *key_size);
+
+/**
+ * libretrodb_key_hash:
+ * @type                : RDT_STRING or RDT_BINARY.
+ * @key                 : Value of a field.
+ * @len                 : Size of @key.
+ *
+ * Returns: hash of @key, as looked up in the indexes a database
+ * builds in memory for fields it has no index over.
+ **/
+uint64_t libretrodb_key_hash(enum rmsgpack_dom_type type,
+      const void *key, size_t len);
+
 libretrodb_t *libretrodb_new(void);
 
 void libretrodb_free(libretrodb_t *db);
@@ -102,9 +136,62 @@ void *libretrodb_query_compile(libretrodb_t *db, const char *query,
 
 void libretrodb_query_free(void *q);
 
+/**
+ * libretrodb_query_index_keys:
+ * @q                   : Compiled query.
+ * @keys                : Keys to look up, back to back.
+ * @key_size            : Size of each key.
+ * @count               : Number of keys.
+ * @hashed              : Set if the keys are libretrodb_key_hash()
+ *                        values for an index built in memory.
+ *
+ * Cursors use this to answer a query through an index
+ * instead of scanning every item.
+ *
+ * Returns: name of the index the query can be answered through,
+ * the field for @hashed keys, or NULL if it needs a full scan.
+ **/
+const char *libretrodb_query_index_keys(libretrodb_query_t *q,
+      const uint8_t **keys, size_t *key_size, unsigned *count,
+      int *hashed);
+
 int libretrodb_cursor_read_item(libretrodb_cursor_t *cursor,
       struct rmsgpack_dom_value *out);
 
+/**
+ * libretrodb_cursor_read_view:
+ * @cursor              : Handle to database cursor, opened without a query.
+ * @out                 : View of the next item.
+ *
+ * Like libretrodb_cursor_read_item(), but decodes the item in
+ * place instead of allocating it, see struct rmsgpack_view.
+ * The view stays valid until the next read or until the cursor
+ * is closed.
+ *
+ * Returns: 0 if successful, EOF at the end, otherwise negative.
+ **/
+int libretrodb_cursor_read_view(libretrodb_cursor_t *cursor,
+      struct rmsgpack_view *out);
+
+/**
+ * libretrodb_cursor_tell:
+ * @cursor              : Handle to database cursor.
+ *
+ * Returns: offset of the item the next read will return.
+ **/
+uint64_t libretrodb_cursor_tell(libretrodb_cursor_t *cursor);
+
+/**
+ * libretrodb_cursor_seek:
+ * @cursor              : Handle to database cursor.
+ * @offset              : Item offset, from libretrodb_cursor_tell().
+ *
+ * Moves the cursor so the next read returns the item at @offset.
+ *
+ * Returns: 0 if successful, otherwise negative.
+ **/
+int libretrodb_cursor_seek(libretrodb_cursor_t *cursor, uint64_t offset);
+
 RETRO_END_DECLS
 
 #endif
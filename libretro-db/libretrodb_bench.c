@@ -0,0 +1,242 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (libretrodb_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
+
+/* Measures keyed lookups through an index against a linear
+ * cursor scan. The index has to exist already, create it with
+ * 'libretrodb_tool <db file> create-index <index> <field>'. */
+
+struct bench_keys
+{
+   uint8_t *data;
+   size_t size;   /* Key size */
+   size_t count;
+};
+
+static struct rmsgpack_dom_value *bench_get_field(
+      struct rmsgpack_dom_value *item, const char *field_name)
+{
+   struct rmsgpack_dom_value key;
+
+   key.type            = RDT_STRING;
+   key.val.string.len  = (uint32_t)strlen(field_name);
+   key.val.string.buff = (char*)field_name;
+
+   if (item->type != RDT_MAP)
+      return NULL;
+
+   return rmsgpack_dom_value_map_value(item, &key);
+}
+
+static int bench_collect_keys(libretrodb_t *db, const char *field_name,
+      struct bench_keys *keys)
+{
+   struct rmsgpack_dom_value item;
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+   size_t cap               = 0;
+
+   if (!cur || libretrodb_cursor_open(db, cur, NULL) != 0)
+   {
+      libretrodb_cursor_free(cur);
+      return -1;
+   }
+
+   while (libretrodb_cursor_read_item(cur, &item) == 0)
+   {
+      struct rmsgpack_dom_value *field = bench_get_field(&item, field_name);
+
+      if (field && field->type == RDT_BINARY && field->val.binary.len)
+      {
+         if (!keys->size)
+            keys->size = field->val.binary.len;
+
+         if (field->val.binary.len == keys->size)
+         {
+            if (keys->count == cap)
+            {
+               uint8_t *data;
+               cap  = cap ? cap * 2 : 1024;
+               data = (uint8_t*)realloc(keys->data, cap * keys->size);
+               if (!data)
+               {
+                  rmsgpack_dom_value_free(&item);
+                  break;
+               }
+               keys->data = data;
+            }
+
+            memcpy(keys->data + keys->count * keys->size,
+                  field->val.binary.buff, keys->size);
+            keys->count++;
+         }
+      }
+
+      rmsgpack_dom_value_free(&item);
+   }
+
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_free(cur);
+   return keys->count ? 0 : -1;
+}
+
+/* What a lookup costs without an index */
+static int bench_scan(libretrodb_t *db, const char *field_name,
+      const struct bench_keys *keys, const uint8_t *key)
+{
+   struct rmsgpack_dom_value item;
+   int found                = 0;
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+
+   if (!cur || libretrodb_cursor_open(db, cur, NULL) != 0)
+   {
+      libretrodb_cursor_free(cur);
+      return 0;
+   }
+
+   while (!found && libretrodb_cursor_read_item(cur, &item) == 0)
+   {
+      struct rmsgpack_dom_value *field = bench_get_field(&item, field_name);
+
+      if (     field
+            && field->type == RDT_BINARY
+            && field->val.binary.len == keys->size
+            && memcmp(field->val.binary.buff, key, keys->size) == 0)
+         found = 1;
+
+      rmsgpack_dom_value_free(&item);
+   }
+
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_free(cur);
+   return found;
+}
+
+static double bench_seconds(clock_t start)
+{
+   return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char **argv)
+{
+   size_t i;
+   clock_t start;
+   double secs;
+   struct bench_keys keys;
+   unsigned found           = 0;
+   unsigned lookups         = 100000;
+   unsigned scans           = 0;
+   uint32_t seed            = 1;
+   const char *path         = NULL;
+   const char *index_name   = NULL;
+   const char *field_name   = NULL;
+   libretrodb_t *db         = NULL;
+   int ret                  = 1;
+
+   if (argc < 4)
+   {
+      printf("Usage: %s <db file> <index name> <field name> [lookups]\n",
+            argv[0]);
+      return 1;
+   }
+
+   path       = argv[1];
+   index_name = argv[2];
+   field_name = argv[3];
+
+   if (argc > 4)
+      lookups = (unsigned)strtoul(argv[4], NULL, 10);
+
+   keys.data  = NULL;
+   keys.size  = 0;
+   keys.count = 0;
+
+   if (!(db = libretrodb_new()))
+      return 1;
+
+   if (libretrodb_open(path, db) != 0)
+   {
+      printf("Could not open db file '%s'\n", path);
+      goto end;
+   }
+
+   if (bench_collect_keys(db, field_name, &keys) != 0)
+   {
+      printf("No binary '%s' fields in '%s'\n", field_name, path);
+      goto end;
+   }
+
+   printf("%u keys of %u bytes\n", (unsigned)keys.count, (unsigned)keys.size);
+
+   start = clock();
+   for (i = 0; i < lookups; i++)
+   {
+      struct rmsgpack_dom_value item;
+
+      seed = seed * 1664525 + 1013904223;
+
+      if (libretrodb_find_entry(db, index_name,
+               keys.data + (seed % keys.count) * keys.size, &item) < 0)
+         continue;
+
+      found++;
+      rmsgpack_dom_value_free(&item);
+   }
+   secs = bench_seconds(start);
+
+   if (!found)
+   {
+      printf("No hits, does index '%s' exist?\n", index_name);
+      goto end;
+   }
+
+   printf("index: %u lookups, %u found, %.0f lookups/s\n",
+         lookups, found, secs > 0 ? lookups / secs : 0.0);
+
+   /* Keep the scan short, it is linear in the size of the db */
+   start = clock();
+   found = 0;
+   for (scans = 0; scans < 1000 && bench_seconds(start) < 2.0; scans++)
+   {
+      seed   = seed * 1664525 + 1013904223;
+      found += bench_scan(db, field_name, &keys,
+            keys.data + (seed % keys.count) * keys.size);
+   }
+   secs = bench_seconds(start);
+
+   printf("scan:  %u lookups, %u found, %.0f lookups/s\n",
+         scans, found, secs > 0 ? scans / secs : 0.0);
+
+   ret = 0;
+
+end:
+   free(keys.data);
+   libretrodb_close(db);
+   libretrodb_free(db);
+   return ret;
+}
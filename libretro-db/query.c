@@ -83,7 +83,24 @@ struct argument
 struct query
 {
    struct invocation root; /* ptr alignment */
+   uint8_t *index_keys;    /* Keys to look up in index_name, or NULL */
+   size_t index_key_size;
+   unsigned index_key_count;
    unsigned ref_count;
+   char index_name[50];
+   bool index_hashed;      /* index_name is a field, see query_plan_term() */
+};
+
+/* Equality terms on an indexed field, gathered at compile time */
+struct query_plan
+{
+   libretrodb_t *db;
+   const char *index_name;
+   uint8_t *keys;
+   size_t key_size;
+   unsigned count;
+   unsigned cap;
+   bool hashed;
 };
 
 struct registered_func
@@ -904,8 +921,25 @@ static struct buffer query_parse_table(
       *error = s;
       goto clean;
    }
-   memcpy(invocation->argv, args,
-         sizeof(struct argument) * argi);
+
+   /* Plain comparisons go first, they are cheap and the
+    * first mismatch ends the evaluation */
+   {
+      unsigned j = 0;
+
+      for (i = 0; i < argi; i += 2)
+         if (args[i + 1].type == AT_VALUE)
+         {
+            invocation->argv[j++] = args[i];
+            invocation->argv[j++] = args[i + 1];
+         }
+      for (i = 0; i < argi; i += 2)
+         if (args[i + 1].type != AT_VALUE)
+         {
+            invocation->argv[j++] = args[i];
+            invocation->argv[j++] = args[i + 1];
+         }
+   }
 
    goto success;
 clean:
@@ -915,6 +949,206 @@ success:
    return buff;
 }
 
+/* @key_size is 0 for the in-memory index, which also takes
+ * strings, of any size */
+static bool query_plan_key_fits(struct query_plan *plan,
+      const char *index_name, uint64_t key_size,
+      const struct argument *arg)
+{
+   if (arg->type != AT_VALUE)
+      return false;
+
+   if (key_size)
+   {
+      if (     arg->a.value.type != RDT_BINARY
+            || arg->a.value.val.binary.len != key_size)
+         return false;
+   }
+   else if (   arg->a.value.type != RDT_BINARY
+            && arg->a.value.type != RDT_STRING)
+      return false;
+
+   /* All keys have to go to the same index */
+   return !plan->index_name
+      || (     string_is_equal(index_name, plan->index_name)
+            && plan->hashed == (key_size == 0));
+}
+
+static bool query_plan_add_key(struct query_plan *plan,
+      const char *index_name, bool hashed, const struct argument *arg)
+{
+   if (!plan->index_name)
+   {
+      plan->index_name = index_name;
+      plan->hashed     = hashed;
+      plan->key_size   = hashed ? sizeof(uint64_t)
+         : arg->a.value.val.binary.len;
+   }
+
+   if (plan->count == plan->cap)
+   {
+      unsigned cap  = plan->cap ? plan->cap * 2 : 4;
+      uint8_t *keys = (uint8_t*)realloc(plan->keys, cap * plan->key_size);
+
+      if (!keys)
+         return false;
+
+      plan->keys = keys;
+      plan->cap  = cap;
+   }
+
+   if (plan->hashed)
+   {
+      uint64_t hash = libretrodb_key_hash(arg->a.value.type,
+            arg->a.value.val.binary.buff, arg->a.value.val.binary.len);
+      memcpy(plan->keys + plan->count * plan->key_size,
+            &hash, sizeof(hash));
+   }
+   else
+      memcpy(plan->keys + plan->count * plan->key_size,
+            arg->a.value.val.binary.buff, plan->key_size);
+   plan->count++;
+   return true;
+}
+
+/* field: b"..." or field: or(b"...", b"...") */
+static bool query_plan_term(struct query_plan *plan,
+      const struct argument *field, const struct argument *arg)
+{
+   unsigned i;
+   bool hashed       = false;
+   uint64_t key_size = 0;
+   const char *name  = NULL;
+
+   if (field->type != AT_VALUE || field->a.value.type != RDT_STRING)
+      return false;
+
+   /* Indexes are named by whoever created them,
+    * look them up by the field they cover. Without one
+    * the database builds an index over the field in memory. */
+   if (!(name = libretrodb_index_for_field(plan->db,
+               field->a.value.val.string.buff, &key_size)))
+   {
+      name     = field->a.value.val.string.buff;
+      hashed   = true;
+      key_size = 0;
+   }
+
+   if (arg->type == AT_VALUE)
+      return query_plan_key_fits(plan, name, key_size, arg)
+         && query_plan_add_key(plan, name, hashed, arg);
+
+   if (     arg->a.invocation.func != query_func_operator_or
+         || arg->a.invocation.argc == 0)
+      return false;
+
+   for (i = 0; i < arg->a.invocation.argc; i++)
+      if (!query_plan_key_fits(plan, name, key_size,
+               &arg->a.invocation.argv[i]))
+         return false;
+
+   for (i = 0; i < arg->a.invocation.argc; i++)
+      if (!query_plan_add_key(plan, name, hashed,
+               &arg->a.invocation.argv[i]))
+         return false;
+
+   return true;
+}
+
+/* Gathers the keys that any item matching @inv must have in one
+ * index. Returns false if no such set exists, without adding to
+ * the plan. */
+static bool query_plan_invocation(struct query_plan *plan,
+      const struct invocation *inv)
+{
+   unsigned i;
+
+   if (inv->func == query_func_all_map)
+   {
+      /* Any one indexed term narrows it down */
+      for (i = 0; i + 1 < inv->argc; i += 2)
+      {
+         unsigned count         = plan->count;
+         const char *index_name = plan->index_name;
+
+         if (query_plan_term(plan, &inv->argv[i], &inv->argv[i + 1]))
+            return true;
+
+         plan->count      = count;
+         plan->index_name = index_name;
+      }
+   }
+   else if (inv->func == query_func_operator_and)
+   {
+      for (i = 0; i < inv->argc; i++)
+         if (     inv->argv[i].type == AT_FUNCTION
+               && query_plan_invocation(plan, &inv->argv[i].a.invocation))
+            return true;
+   }
+   else if (inv->func == query_func_operator_or && inv->argc > 0)
+   {
+      /* Every branch has to go through the same index */
+      unsigned count         = plan->count;
+      const char *index_name = plan->index_name;
+
+      for (i = 0; i < inv->argc; i++)
+      {
+         if (     inv->argv[i].type != AT_FUNCTION
+               || !query_plan_invocation(plan, &inv->argv[i].a.invocation))
+         {
+            plan->count      = count;
+            plan->index_name = index_name;
+            return false;
+         }
+      }
+
+      return true;
+   }
+
+   return false;
+}
+
+static void query_plan(struct query *q, libretrodb_t *db)
+{
+   struct query_plan plan;
+
+   plan.db         = db;
+   plan.index_name = NULL;
+   plan.keys       = NULL;
+   plan.key_size   = 0;
+   plan.count      = 0;
+   plan.cap        = 0;
+   plan.hashed     = false;
+
+   if (     query_plan_invocation(&plan, &q->root)
+         && plan.count)
+   {
+      strlcpy(q->index_name, plan.index_name, sizeof(q->index_name));
+      q->index_keys      = plan.keys;
+      q->index_key_size  = plan.key_size;
+      q->index_key_count = plan.count;
+      q->index_hashed    = plan.hashed;
+   }
+   else
+      free(plan.keys);
+}
+
+const char *libretrodb_query_index_keys(libretrodb_query_t *q,
+      const uint8_t **keys, size_t *key_size, unsigned *count,
+      int *hashed)
+{
+   struct query *real_q = (struct query*)q;
+
+   if (!real_q || !real_q->index_keys)
+      return NULL;
+
+   *keys     = real_q->index_keys;
+   *key_size = real_q->index_key_size;
+   *count    = real_q->index_key_count;
+   *hashed   = real_q->index_hashed;
+   return real_q->index_name;
+}
+
 void libretrodb_query_free(void *q)
 {
    unsigned i;
@@ -927,6 +1161,7 @@ void libretrodb_query_free(void *q)
    for (i = 0; i < real_q->root.argc; i++)
       query_argument_free(&real_q->root.argv[i]);
 
+   free(real_q->index_keys);
    free(real_q->root.argv);
    real_q->root.argv = NULL;
    real_q->root.argc = 0;
@@ -949,6 +1184,11 @@ void *libretrodb_query_compile(libretrodb_t *db,
    q->root.argc          = 0;
    q->root.func          = NULL;
    q->root.argv          = NULL;
+   q->index_keys         = NULL;
+   q->index_key_size     = 0;
+   q->index_key_count    = 0;
+   q->index_name[0]      = '\0';
+   q->index_hashed       = false;
 
    buff.data             = query;
    buff.len              = buff_len;
@@ -986,6 +1226,9 @@ void *libretrodb_query_compile(libretrodb_t *db,
       goto error;
    }
 
+   if (db)
+      query_plan(q, db);
+
    return q;
 
 error:
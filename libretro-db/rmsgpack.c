@@ -266,13 +266,8 @@ int rmsgpack_write_nil(RFILE *fd)
 
 int rmsgpack_write_bool(RFILE *fd, int value)
 {
-   if (value)
-   {
-      if (filestream_write(fd, &MPF_TRUE, sizeof(MPF_TRUE)) == -1)
-         goto error;
-   }
-
-   if (filestream_write(fd, &MPF_FALSE, sizeof(MPF_FALSE)) == -1)
+   if (filestream_write(fd, value ? &MPF_TRUE : &MPF_FALSE,
+            sizeof(uint8_t)) == -1)
       goto error;
 
    return sizeof(uint8_t);
@@ -505,3 +505,219 @@ clean:
    rmsgpack_dom_value_free(&map);
    return 0;
 }
+
+static uint64_t dom_view_read_be(const uint8_t *p, unsigned size)
+{
+   unsigned i;
+   uint64_t v = 0;
+
+   for (i = 0; i < size; i++)
+      v = (v << 8) | p[i];
+
+   return v;
+}
+
+static size_t dom_view_read(const uint8_t *data, size_t len,
+      struct rmsgpack_view *out, unsigned depth)
+{
+   unsigned size;
+   uint64_t count;
+   size_t pos   = 1;
+   uint8_t type;
+
+   if (len < 1 || depth >= MAX_DEPTH)
+      return 0;
+
+   type         = data[0];
+
+   if (type < 0x80 || type >= 0xe0) /* Positive / negative fixint */
+   {
+      out->type     = RDT_INT;
+      out->val.int_ = (int8_t)type;
+      return 1;
+   }
+
+   if (type < 0xa0) /* Fixmap, fixarray */
+   {
+      count = type & 0x0f;
+      type  = (type < 0x90) ? 0xde : 0xdc;
+      goto container;
+   }
+
+   if (type < 0xc0) /* Fixstr */
+   {
+      count = type - 0xa0;
+      size  = 0;
+      type  = 0xd9;
+      goto buffer;
+   }
+
+   switch (type)
+   {
+      case 0xc0:
+         out->type      = RDT_NULL;
+         return 1;
+      case 0xc2:
+      case 0xc3:
+         out->type      = RDT_BOOL;
+         out->val.bool_ = (type == 0xc3);
+         return 1;
+      case 0xc4: /* bin 8/16/32 */
+      case 0xc5:
+      case 0xc6:
+         size = 1 << (type - 0xc4);
+         break;
+      case 0xd9: /* str 8/16/32 */
+      case 0xda:
+      case 0xdb:
+         size = 1 << (type - 0xd9);
+         break;
+      case 0xcc: /* uint 8/16/32/64 */
+      case 0xcd:
+      case 0xce:
+      case 0xcf:
+         size = 1 << (type - 0xcc);
+         if (len < 1 + size)
+            return 0;
+         out->type      = RDT_UINT;
+         out->val.uint_ = dom_view_read_be(data + 1, size);
+         return 1 + size;
+      case 0xd0: /* int 8/16/32/64 */
+      case 0xd1:
+      case 0xd2:
+      case 0xd3:
+         size = 1 << (type - 0xd0);
+         if (len < 1 + size)
+            return 0;
+         count          = dom_view_read_be(data + 1, size);
+         out->type      = RDT_INT;
+         switch (size)
+         {
+            case 1:
+               out->val.int_ = (int8_t)count;
+               break;
+            case 2:
+               out->val.int_ = (int16_t)count;
+               break;
+            case 4:
+               out->val.int_ = (int32_t)count;
+               break;
+            default:
+               out->val.int_ = (int64_t)count;
+               break;
+         }
+         return 1 + size;
+      case 0xdc: /* array 16/32 */
+      case 0xdd:
+      case 0xde: /* map 16/32 */
+      case 0xdf:
+         size = 2 << (type & 1);
+         if (len < 1 + size)
+            return 0;
+         count = dom_view_read_be(data + 1, size);
+         pos  += size;
+         type &= ~1;
+         goto container;
+      default: /* Extensions and floats aren't used */
+         return 0;
+   }
+
+   if (len < 1 + size)
+      return 0;
+   count = dom_view_read_be(data + 1, size);
+   pos  += size;
+
+buffer:
+   if (count > len - pos)
+      return 0;
+
+   out->type            = (type == 0xd9 || type == 0xda || type == 0xdb)
+      ? RDT_STRING : RDT_BINARY;
+   out->val.string.len  = (uint32_t)count;
+   out->val.string.buff = (const char*)data + pos;
+   return pos + (size_t)count;
+
+container:
+   {
+      /* Only skip over the items, they are decoded on request */
+      size_t start = pos;
+      uint64_t items = (type == 0xde) ? count * 2 : count;
+
+      for (; items > 0; items--)
+      {
+         struct rmsgpack_view item;
+         size_t item_len = dom_view_read(data + pos, len - pos,
+               &item, depth + 1);
+
+         if (!item_len)
+            return 0;
+         pos += item_len;
+      }
+
+      out->type            = (type == 0xde) ? RDT_MAP : RDT_ARRAY;
+      out->val.map.len     = (uint32_t)count;
+      out->val.map.items   = data + start;
+      out->val.map.size    = pos - start;
+   }
+
+   return pos;
+}
+
+size_t rmsgpack_dom_view_read(const void *data, size_t len,
+      struct rmsgpack_view *out)
+{
+   return dom_view_read((const uint8_t*)data, len, out, 0);
+}
+
+unsigned rmsgpack_dom_view_map_values(const struct rmsgpack_view *map,
+      const char **keys, unsigned count, struct rmsgpack_view *values)
+{
+   unsigned i, j;
+   unsigned found     = 0;
+   const uint8_t *pos = NULL;
+   const uint8_t *end = NULL;
+
+   for (j = 0; j < count; j++)
+      values[j].type = RDT_NULL;
+
+   if (map->type != RDT_MAP)
+      return 0;
+
+   pos = map->val.map.items;
+   end = pos + map->val.map.size;
+
+   for (i = 0; i < map->val.map.len && found < count; i++)
+   {
+      struct rmsgpack_view key;
+      struct rmsgpack_view value;
+      size_t key_len   = dom_view_read(pos, end - pos, &key, 1);
+      size_t value_len;
+
+      if (!key_len)
+         break;
+      pos += key_len;
+
+      if (!(value_len = dom_view_read(pos, end - pos, &value, 1)))
+         break;
+
+      if (key.type == RDT_STRING)
+      {
+         for (j = 0; j < count; j++)
+         {
+            if (     values[j].type == RDT_NULL
+                  && strlen(keys[j]) == key.val.string.len
+                  && memcmp(keys[j], key.val.string.buff,
+                     key.val.string.len) == 0)
+            {
+               values[j] = value;
+               found++;
+               break;
+            }
+         }
+      }
+
+      pos += value_len;
+   }
+
+   return found;
+}
@@ -79,6 +79,43 @@ struct rmsgpack_dom_pair
 	struct rmsgpack_dom_value value; /* uint64_t alignment */
 };
 
+/* A value decoded in place from a buffer, without allocating.
+ * Strings and binaries point into the buffer and are not NUL
+ * terminated. Maps and arrays only record where their encoded
+ * items are, see rmsgpack_dom_view_map_values(). */
+struct rmsgpack_view
+{
+   union
+   {
+      uint64_t uint_;
+      int64_t int_;
+      struct
+      {
+         uint32_t len;
+         const char *buff;
+      } string;
+      struct
+      {
+         uint32_t len;
+         const char *buff;
+      } binary;
+      int bool_;
+      struct
+      {
+         uint32_t len;
+         const uint8_t *items;
+         size_t size;
+      } map;
+      struct
+      {
+         uint32_t len;
+         const uint8_t *items;
+         size_t size;
+      } array;
+   } val;
+   enum rmsgpack_dom_type type;
+};
+
 void rmsgpack_dom_value_print(struct rmsgpack_dom_value *obj);
 void rmsgpack_dom_value_free(struct rmsgpack_dom_value *v);
 
@@ -95,6 +132,33 @@ int rmsgpack_dom_write(RFILE *fd, const struct rmsgpack_dom_value *obj);
 
 int rmsgpack_dom_read_into(RFILE *fd, ...);
 
+/**
+ * rmsgpack_dom_view_read:
+ * @data                : Encoded data.
+ * @len                 : Size of @data.
+ * @out                 : View of the first value in @data.
+ *
+ * Returns: size of the encoded value, 0 if it is invalid or
+ * runs past @len.
+ **/
+size_t rmsgpack_dom_view_read(const void *data, size_t len,
+      struct rmsgpack_view *out);
+
+/**
+ * rmsgpack_dom_view_map_values:
+ * @map                 : View of a map.
+ * @keys                : String keys to look up.
+ * @count               : Number of keys.
+ * @values              : Receives the value of each key,
+ *                        RDT_NULL for missing ones.
+ *
+ * Decodes only the values of @keys, in one pass over @map.
+ *
+ * Returns: number of keys found.
+ **/
+unsigned rmsgpack_dom_view_map_values(const struct rmsgpack_view *map,
+      const char **keys, unsigned count, struct rmsgpack_view *values);
+
 RETRO_END_DECLS
 
 #endif
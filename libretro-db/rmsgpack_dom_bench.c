@@ -0,0 +1,186 @@
+/* Copyright  (C) 2010-2017 The RetroArch team
+ *
+ * ---------------------------------------------------------------------------------------
+ * The following license statement only applies to this file (rmsgpack_dom_bench.c).
+ * ---------------------------------------------------------------------------------------
+ *
+ * Permission is hereby granted, free of charge,
+ * to any person obtaining a copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "libretrodb.h"
+#include "rmsgpack_dom.h"
+
+/* Reads every item of a database twice, as a DOM and as a view,
+ * picking out the fields a browser would, and reports the time
+ * and heap allocations each takes. Allocations are counted by
+ * linking with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc
+ * (see the Makefile), without that they read as 0. */
+
+static unsigned long bench_allocs = 0;
+
+#ifdef RMSGPACK_BENCH_WRAP
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+void *__wrap_malloc(size_t size)
+{
+   bench_allocs++;
+   return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+   bench_allocs++;
+   return __real_calloc(nmemb, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+   bench_allocs++;
+   return __real_realloc(ptr, size);
+}
+#endif
+
+static const char *bench_keys[] = { "name", "crc", "developer", "releaseyear" };
+
+#define BENCH_KEY_COUNT (sizeof(bench_keys) / sizeof(bench_keys[0]))
+
+struct bench_result
+{
+   unsigned long items;
+   unsigned long found;
+   unsigned long allocs;
+   double secs;
+};
+
+static int bench_dom(libretrodb_t *db, struct bench_result *res)
+{
+   unsigned i;
+   struct rmsgpack_dom_value item;
+   struct rmsgpack_dom_value keys[BENCH_KEY_COUNT];
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+   unsigned long allocs     = bench_allocs;
+   clock_t start            = clock();
+
+   if (!cur || libretrodb_cursor_open(db, cur, NULL) != 0)
+   {
+      libretrodb_cursor_free(cur);
+      return -1;
+   }
+
+   for (i = 0; i < BENCH_KEY_COUNT; i++)
+   {
+      keys[i].type            = RDT_STRING;
+      keys[i].val.string.len  = (uint32_t)strlen(bench_keys[i]);
+      keys[i].val.string.buff = (char*)bench_keys[i];
+   }
+
+   while (libretrodb_cursor_read_item(cur, &item) == 0)
+   {
+      if (item.type == RDT_MAP)
+         for (i = 0; i < BENCH_KEY_COUNT; i++)
+            if (rmsgpack_dom_value_map_value(&item, &keys[i]))
+               res->found++;
+
+      res->items++;
+      rmsgpack_dom_value_free(&item);
+   }
+
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_free(cur);
+
+   res->secs   = (double)(clock() - start) / CLOCKS_PER_SEC;
+   res->allocs = bench_allocs - allocs;
+   return 0;
+}
+
+static int bench_view(libretrodb_t *db, struct bench_result *res)
+{
+   struct rmsgpack_view item;
+   struct rmsgpack_view values[BENCH_KEY_COUNT];
+   libretrodb_cursor_t *cur = libretrodb_cursor_new();
+   unsigned long allocs     = bench_allocs;
+   clock_t start            = clock();
+
+   if (!cur || libretrodb_cursor_open(db, cur, NULL) != 0)
+   {
+      libretrodb_cursor_free(cur);
+      return -1;
+   }
+
+   while (libretrodb_cursor_read_view(cur, &item) == 0)
+   {
+      res->found += rmsgpack_dom_view_map_values(&item,
+            bench_keys, BENCH_KEY_COUNT, values);
+      res->items++;
+   }
+
+   libretrodb_cursor_close(cur);
+   libretrodb_cursor_free(cur);
+
+   res->secs   = (double)(clock() - start) / CLOCKS_PER_SEC;
+   res->allocs = bench_allocs - allocs;
+   return 0;
+}
+
+static void bench_print(const char *name, const struct bench_result *res)
+{
+   printf("%-5s %lu items, %lu fields, %.3f s, %lu allocations (%.1f per item)\n",
+         name, res->items, res->found, res->secs, res->allocs,
+         res->items ? (double)res->allocs / res->items : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+   struct bench_result dom;
+   struct bench_result view;
+   libretrodb_t *db = NULL;
+
+   if (argc != 2)
+   {
+      printf("Usage: %s <db file>\n", argv[0]);
+      return 1;
+   }
+
+   memset(&dom,  0, sizeof(dom));
+   memset(&view, 0, sizeof(view));
+
+   if (!(db = libretrodb_new()))
+      return 1;
+
+   if (libretrodb_open(argv[1], db) != 0)
+   {
+      printf("Could not open db file '%s'\n", argv[1]);
+      libretrodb_free(db);
+      return 1;
+   }
+
+   if (bench_dom(db, &dom) == 0 && bench_view(db, &view) == 0)
+   {
+      bench_print("dom:", &dom);
+      bench_print("view:", &view);
+   }
+
+   libretrodb_close(db);
+   libretrodb_free(db);
+   return 0;
+}
@@ -26,6 +26,18 @@
 #include <retro_inline.h>
 #include <compat/strl.h>
 #include <compat/intrinsics.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#endif
+
+#if defined(HAVE_MMAP) && defined(HAVE_ZLIB) && !defined(_WIN32)
+#define HAVE_REWIND_SPILL
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <file/file_path.h>
+#include <streams/trans_stream.h>
+#endif
 
 #include "state_manager.h"
 #include "../msg_hash.h"
@@ -62,6 +74,49 @@
 #include <emmintrin.h>
 #endif
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Granularity of the block delta backend, in bytes. */
+#define REWIND_BLOCK_SIZE 64
+
+#ifdef HAVE_REWIND_SPILL
+/* Second tier - deltas evicted from the rewind buffer are
+ * deflated into a memory mapped file. It is used as a stack:
+ * once the rewind buffer runs dry, popping continues from the
+ * most recently evicted delta. When full, the oldest deltas
+ * are dropped. */
+struct state_manager_spill
+{
+   uint8_t *data;
+   /* Deflated delta being written. */
+   uint8_t *scratch;
+   /* Inflated delta being read. */
+   uint8_t *patch;
+   void *deflate_stream;
+   void *inflate_stream;
+   const struct trans_stream_backend *deflate_backend;
+   const struct trans_stream_backend *inflate_backend;
+
+   size_t capacity;
+   size_t scratch_size;
+   /* Offsets into 'data'. */
+   size_t head;
+   size_t tail;
+   /* End of the upper region while 'head' has wrapped
+    * around before 'tail', otherwise 0. */
+   size_t wrap;
+
+   /* Statistics, in bytes. */
+   uint64_t evicted_bytes;
+   uint64_t stored_bytes;
+   uint64_t dropped_bytes;
+
+   unsigned entries;
+};
+#endif
+
 struct state_manager
 {
    uint8_t *data;
@@ -85,8 +140,14 @@ struct state_manager
     * (yes, the math is a bit ugly). */
    size_t maxcompsize;
 
+#ifdef HAVE_REWIND_SPILL
+   struct state_manager_spill *spill;
+#endif
+
    unsigned entries;
    bool thisblock_valid;
+   /* Use the block delta backend instead of the uint16 one. */
+   bool block_delta;
 };
 
 struct state_manager_rewind_state
@@ -94,6 +155,20 @@ struct state_manager_rewind_state
    /* Rewind support. */
    state_manager_t *state;
    size_t size;
+#ifdef HAVE_THREADS
+   /* Asynchronous capture - the main thread only serializes
+    * into one of the capture buffers, the worker thread
+    * owns 'state' and does the delta compression. */
+   sthread_t *thread;
+   slock_t *lock;
+   scond_t *cond;
+   uint8_t *capture[2];
+   /* Index of the capture buffer waiting for the worker,
+    * and of the one it is compressing, or -1. */
+   int capture_pending;
+   int capture_busy;
+   bool thread_alive;
+#endif
 };
 
 /* Format per frame (pseudocode): */
@@ -116,6 +191,27 @@ repeat {
 size thisstart;
 #endif
 
+/* Block delta format per frame (pseudocode): */
+#if 0
+size nextstart;
+repeat {
+   uint32 numunchanged; /* everything is counted in REWIND_BLOCK_SIZE blocks */
+   uint32 numchanged;
+   if (!numchanged)
+      break;
+   uint8[numchanged * REWIND_BLOCK_SIZE] changeddata;
+}
+size thisstart;
+#endif
+
+/* Spilled delta format (pseudocode): */
+#if 0
+size complen;
+size rawlen; /* same as complen if stored uncompressed */
+uint8[complen] data;
+size thisstart;
+#endif
+
 /* TODO/FIXME - static public global variables */
 static struct state_manager_rewind_state rewind_state;
 static bool frame_is_reversed                         = false;
@@ -217,6 +313,185 @@ static size_t find_same(const uint16_t *a, const uint16_t *b)
    return a - a_org;
 }
 
+/* Returns true if the REWIND_BLOCK_SIZE bytes at 'a' and 'b'
+ * are identical. Both must be at least sizeof(size_t) aligned. */
+static INLINE bool block_is_same(const uint8_t *a, const uint8_t *b)
+{
+#if defined(__AVX2__)
+   __m256i a0 = _mm256_loadu_si256((const __m256i*)a);
+   __m256i a1 = _mm256_loadu_si256((const __m256i*)(a + 32));
+   __m256i b0 = _mm256_loadu_si256((const __m256i*)b);
+   __m256i b1 = _mm256_loadu_si256((const __m256i*)(b + 32));
+   __m256i c  = _mm256_and_si256(
+         _mm256_cmpeq_epi8(a0, b0), _mm256_cmpeq_epi8(a1, b1));
+   return _mm256_movemask_epi8(c) == -1;
+#elif __SSE2__
+   __m128i c0 = _mm_cmpeq_epi8(
+         _mm_loadu_si128((const __m128i*)a),
+         _mm_loadu_si128((const __m128i*)b));
+   __m128i c1 = _mm_cmpeq_epi8(
+         _mm_loadu_si128((const __m128i*)(a + 16)),
+         _mm_loadu_si128((const __m128i*)(b + 16)));
+   __m128i c2 = _mm_cmpeq_epi8(
+         _mm_loadu_si128((const __m128i*)(a + 32)),
+         _mm_loadu_si128((const __m128i*)(b + 32)));
+   __m128i c3 = _mm_cmpeq_epi8(
+         _mm_loadu_si128((const __m128i*)(a + 48)),
+         _mm_loadu_si128((const __m128i*)(b + 48)));
+   __m128i c  = _mm_and_si128(_mm_and_si128(c0, c1), _mm_and_si128(c2, c3));
+   return _mm_movemask_epi8(c) == 0xffff;
+#else
+   unsigned i;
+   const size_t *a_big = (const size_t*)a;
+   const size_t *b_big = (const size_t*)b;
+   size_t diff         = 0;
+
+   for (i = 0; i < REWIND_BLOCK_SIZE / sizeof(size_t); i++)
+      diff |= a_big[i] ^ b_big[i];
+   return !diff;
+#endif
+}
+
+static INLINE void write_uint32(uint8_t *ptr, uint32_t val)
+{
+   memcpy(ptr, &val, sizeof(val));
+}
+
+static INLINE uint32_t read_uint32(const uint8_t *ptr)
+{
+   uint32_t ret;
+
+   memcpy(&ret, ptr, sizeof(ret));
+   return ret;
+}
+
+/* Returns the maximum size of a block delta of a savestate. */
+static size_t state_manager_block_maxsize(size_t uncomp)
+{
+   size_t numblocks = (uncomp + REWIND_BLOCK_SIZE - 1) / REWIND_BLOCK_SIZE;
+   /* At worst, every other block changed: one record
+    * per changed block, plus the terminating record. */
+   return numblocks * REWIND_BLOCK_SIZE +
+      (numblocks / 2 + 2) * sizeof(uint32_t) * 2;
+}
+
+/*
+ * Block delta equivalent of state_manager_raw_alloc().
+ * The buffer is rounded up to a whole number of blocks, the
+ * padding is zeroed and never written to.
+ */
+static void *state_manager_block_alloc(size_t len)
+{
+   size_t lenblocks = (len + REWIND_BLOCK_SIZE - 1) & -REWIND_BLOCK_SIZE;
+   return calloc(lenblocks ? lenblocks : REWIND_BLOCK_SIZE, 1);
+}
+
+/*
+ * Block delta equivalent of state_manager_raw_compress().
+ * Unchanged blocks are skipped, changed runs of blocks are
+ * stored whole. 'src' and 'dst' must be returned from
+ * state_manager_block_alloc() with the same 'len'.
+ *
+ * 'patch' must be size 'state_manager_block_maxsize(len)' or more.
+ * Returns the number of bytes actually written to 'patch'.
+ */
+static size_t state_manager_block_compress(const void *src,
+      const void *dst, size_t len, void *patch)
+{
+   const uint8_t *old8 = (const uint8_t*)src;
+   const uint8_t *new8 = (const uint8_t*)dst;
+   uint8_t        *out = (uint8_t*)patch;
+   size_t    numblocks = (len + REWIND_BLOCK_SIZE - 1) / REWIND_BLOCK_SIZE;
+   size_t            i = 0;
+
+   while (i < numblocks)
+   {
+      size_t skip, changed;
+      size_t start = i;
+
+      while (i < numblocks && block_is_same(
+               old8 + i * REWIND_BLOCK_SIZE, new8 + i * REWIND_BLOCK_SIZE))
+         i++;
+
+      if (i >= numblocks)
+         break;
+
+      skip  = i - start;
+      start = i;
+
+      while (i < numblocks && !block_is_same(
+               old8 + i * REWIND_BLOCK_SIZE, new8 + i * REWIND_BLOCK_SIZE))
+         i++;
+
+      changed = i - start;
+
+      write_uint32(out, (uint32_t)skip);
+      write_uint32(out + sizeof(uint32_t), (uint32_t)changed);
+      out += sizeof(uint32_t) * 2;
+
+      memcpy(out, old8 + start * REWIND_BLOCK_SIZE,
+            changed * REWIND_BLOCK_SIZE);
+      out += changed * REWIND_BLOCK_SIZE;
+   }
+
+   write_uint32(out, 0);
+   write_uint32(out + sizeof(uint32_t), 0);
+   out += sizeof(uint32_t) * 2;
+
+   return out - (uint8_t*)patch;
+}
+
+/*
+ * Block delta equivalent of state_manager_raw_decompress().
+ */
+static void state_manager_block_decompress(const void *patch,
+      size_t patchlen, void *data, size_t datalen)
+{
+   uint8_t          *out8 = (uint8_t*)data;
+   const uint8_t *patch8  = (const uint8_t*)patch;
+
+   (void)patchlen;
+   (void)datalen;
+
+   for (;;)
+   {
+      uint32_t numunchanged = read_uint32(patch8);
+      uint32_t numchanged   = read_uint32(patch8 + sizeof(uint32_t));
+
+      if (!numchanged)
+         break;
+
+      patch8 += sizeof(uint32_t) * 2;
+      out8   += (size_t)numunchanged * REWIND_BLOCK_SIZE;
+
+      memcpy(out8, patch8, (size_t)numchanged * REWIND_BLOCK_SIZE);
+      out8   += (size_t)numchanged * REWIND_BLOCK_SIZE;
+      patch8 += (size_t)numchanged * REWIND_BLOCK_SIZE;
+   }
+}
+
+#ifdef HAVE_REWIND_SPILL
+/* Returns the size of a patch from state_manager_block_compress(). */
+static size_t state_manager_block_patch_size(const void *patch)
+{
+   const uint8_t *patch8 = (const uint8_t*)patch;
+
+   for (;;)
+   {
+      uint32_t numchanged = read_uint32(patch8 + sizeof(uint32_t));
+
+      patch8 += sizeof(uint32_t) * 2;
+
+      if (!numchanged)
+         break;
+
+      patch8 += (size_t)numchanged * REWIND_BLOCK_SIZE;
+   }
+
+   return patch8 - (const uint8_t*)patch;
+}
+#endif
+
 /* Returns the maximum compressed size of a savestate.
  * It is very likely to compress to far less. */
 static size_t state_manager_raw_maxsize(size_t uncomp)
@@ -373,6 +648,32 @@ static void state_manager_raw_decompress(const void *patch,
    }
 }
 
+#ifdef HAVE_REWIND_SPILL
+/* Returns the size of a patch from state_manager_raw_compress(). */
+static size_t state_manager_raw_patch_size(const void *patch)
+{
+   const uint16_t *patch16 = (const uint16_t*)patch;
+
+   for (;;)
+   {
+      uint16_t numchanged = *(patch16++);
+
+      if (numchanged)
+         patch16 += 1 + numchanged;
+      else
+      {
+         uint32_t numunchanged = patch16[0] | (patch16[1] << 16);
+
+         patch16 += 2;
+         if (!numunchanged)
+            break;
+      }
+   }
+
+   return (const uint8_t*)patch16 - (const uint8_t*)patch;
+}
+#endif
+
 /* The start offsets point to 'nextstart' of any given compressed frame.
  * Each uint16 is stored native endian; anything that claims any other
  * endianness refers to the endianness of this specific item.
@@ -408,11 +709,290 @@ static INLINE size_t read_size_t(const void *ptr)
    return ret;
 }
 
+#ifdef HAVE_REWIND_SPILL
+static void state_manager_spill_free(struct state_manager_spill *spill)
+{
+   if (!spill)
+      return;
+
+   if (spill->evicted_bytes)
+      RARCH_LOG("[Rewind]: %u KB evicted from the rewind buffer, "
+            "spilled at %.2f:1, %u KB dropped from the spill file.\n",
+            (unsigned)(spill->evicted_bytes >> 10),
+            spill->stored_bytes
+            ? (double)spill->evicted_bytes / spill->stored_bytes : 0.0,
+            (unsigned)(spill->dropped_bytes >> 10));
+
+   if (spill->data)
+      munmap(spill->data, spill->capacity);
+   if (spill->deflate_stream)
+      spill->deflate_backend->stream_free(spill->deflate_stream);
+   if (spill->inflate_stream)
+      spill->inflate_backend->stream_free(spill->inflate_stream);
+   if (spill->scratch)
+      free(spill->scratch);
+   if (spill->patch)
+      free(spill->patch);
+   free(spill);
+}
+
+static struct state_manager_spill *state_manager_spill_new(
+      size_t maxcompsize, size_t spill_size, const char *dir)
+{
+   int fd;
+   char path[PATH_MAX_LENGTH];
+   struct state_manager_spill *spill = NULL;
+
+   path[0] = '\0';
+
+   if (!spill_size)
+      return NULL;
+
+   if (!dir || !*dir)
+   {
+      RARCH_WARN("[Rewind]: No directory for the spill file, "
+            "evicted rewind deltas will be dropped.\n");
+      return NULL;
+   }
+
+   spill = (struct state_manager_spill*)calloc(1, sizeof(*spill));
+   if (!spill)
+      return NULL;
+
+   /* Large enough for deflateBound() of any delta */
+   spill->scratch_size    = maxcompsize + maxcompsize / 1000 + 64;
+   spill->scratch         = (uint8_t*)malloc(spill->scratch_size);
+   spill->patch           = (uint8_t*)malloc(maxcompsize);
+   spill->deflate_backend = trans_stream_get_zlib_deflate_backend();
+   spill->inflate_backend = trans_stream_get_zlib_inflate_backend();
+
+   if (!spill->deflate_backend || !spill->inflate_backend)
+      goto error;
+
+   spill->deflate_stream  = spill->deflate_backend->stream_new();
+   spill->inflate_stream  = spill->inflate_backend->stream_new();
+
+   if (     !spill->scratch
+         || !spill->patch
+         || !spill->deflate_stream
+         || !spill->inflate_stream)
+      goto error;
+
+   /* Favour speed, this runs every frame once the
+    * rewind buffer is full */
+   spill->deflate_backend->define(spill->deflate_stream, "level", 1);
+
+   fill_pathname_join(path, dir, "rewind.spill", sizeof(path));
+
+   fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600);
+   if (fd < 0)
+      goto error;
+
+   if (ftruncate(fd, (off_t)spill_size) == 0)
+   {
+      void *ptr = mmap(NULL, spill_size, PROT_READ | PROT_WRITE,
+            MAP_SHARED, fd, 0);
+      if (ptr != MAP_FAILED)
+      {
+         spill->data     = (uint8_t*)ptr;
+         spill->capacity = spill_size;
+      }
+   }
+
+   /* The mapping stays valid, and the file goes
+    * away with it even if we crash */
+   close(fd);
+   unlink(path);
+
+   if (!spill->data)
+      goto error;
+
+   return spill;
+
+error:
+   RARCH_WARN("[Rewind]: Failed to create spill file \"%s\".\n", path);
+   state_manager_spill_free(spill);
+   return NULL;
+}
+
+static void state_manager_spill_clear(struct state_manager_spill *spill)
+{
+   spill->head    = 0;
+   spill->tail    = 0;
+   spill->wrap    = 0;
+   spill->entries = 0;
+}
+
+static void state_manager_spill_drop(struct state_manager_spill *spill)
+{
+   size_t next = spill->tail + read_size_t(spill->data + spill->tail)
+      + sizeof(size_t) * 3;
+
+   spill->dropped_bytes += next - spill->tail;
+
+   if (--spill->entries == 0)
+      state_manager_spill_clear(spill);
+   else if (next == spill->wrap)
+   {
+      spill->tail = 0;
+      spill->wrap = 0;
+   }
+   else
+      spill->tail = next;
+}
+
+static void state_manager_spill_push(struct state_manager_spill *spill,
+      const uint8_t *patch, size_t len)
+{
+   uint32_t rd, wn;
+   size_t pos, recsize;
+   const uint8_t *payload = patch;
+   size_t complen         = len;
+
+   spill->deflate_backend->set_in(spill->deflate_stream,
+         patch, (uint32_t)len);
+   spill->deflate_backend->set_out(spill->deflate_stream,
+         spill->scratch, (uint32_t)spill->scratch_size);
+
+   if (spill->deflate_backend->trans(spill->deflate_stream,
+            true, &rd, &wn, NULL) && rd == len && wn < len)
+   {
+      payload = spill->scratch;
+      complen = wn;
+   }
+
+   spill->evicted_bytes += len;
+
+   recsize = complen + sizeof(size_t) * 3;
+
+   if (recsize > spill->capacity - sizeof(size_t))
+   {
+      /* The chain of deltas is broken, everything
+       * spilled so far is unreachable now */
+      while (spill->entries)
+         state_manager_spill_drop(spill);
+      return;
+   }
+
+   for (;;)
+   {
+      if (!spill->entries)
+         state_manager_spill_clear(spill);
+
+      if (spill->head >= spill->tail)
+      {
+         if (spill->capacity - spill->head >= recsize)
+         {
+            pos = spill->head;
+            break;
+         }
+         if (recsize < spill->tail)
+         {
+            spill->wrap = spill->head;
+            pos         = 0;
+            break;
+         }
+      }
+      else if (spill->tail - spill->head > recsize)
+      {
+         pos = spill->head;
+         break;
+      }
+
+      state_manager_spill_drop(spill);
+   }
+
+   write_size_t(spill->data + pos, complen);
+   write_size_t(spill->data + pos + sizeof(size_t), len);
+   memcpy(spill->data + pos + sizeof(size_t) * 2, payload, complen);
+   write_size_t(spill->data + pos + sizeof(size_t) * 2 + complen, pos);
+
+   spill->head          = pos + recsize;
+   spill->stored_bytes += recsize;
+   spill->entries++;
+}
+
+/* Pops the most recently spilled delta, returns NULL if there is none. */
+static const uint8_t *state_manager_spill_pop(
+      struct state_manager_spill *spill)
+{
+   size_t pos, complen, len;
+   const uint8_t *payload;
+
+   if (!spill->entries)
+      return NULL;
+
+   if (spill->head)
+      pos = read_size_t(spill->data + spill->head - sizeof(size_t));
+   else
+   {
+      pos         = read_size_t(spill->data + spill->wrap - sizeof(size_t));
+      spill->wrap = 0;
+   }
+
+   complen = read_size_t(spill->data + pos);
+   len     = read_size_t(spill->data + pos + sizeof(size_t));
+   payload = spill->data + pos + sizeof(size_t) * 2;
+
+   if (--spill->entries == 0)
+      state_manager_spill_clear(spill);
+   else
+      spill->head = pos;
+
+   if (complen != len)
+   {
+      uint32_t rd, wn;
+
+      if (!spill->inflate_stream)
+      {
+         state_manager_spill_clear(spill);
+         return NULL;
+      }
+
+      spill->inflate_backend->set_in(spill->inflate_stream,
+            payload, (uint32_t)complen);
+      spill->inflate_backend->set_out(spill->inflate_stream,
+            spill->patch, (uint32_t)len);
+
+      if (!spill->inflate_backend->trans(spill->inflate_stream,
+               true, &rd, &wn, NULL) || wn != len)
+      {
+         /* A failed inflate leaves the stream mid-way,
+          * start the next one from scratch */
+         spill->inflate_backend->stream_free(spill->inflate_stream);
+         spill->inflate_stream = spill->inflate_backend->stream_new();
+         state_manager_spill_clear(spill);
+         return NULL;
+      }
+
+      payload = spill->patch;
+   }
+
+   return payload;
+}
+
+/* Moves the delta at the tail of the rewind buffer to the spill file. */
+static void state_manager_spill_tail(state_manager_t *state)
+{
+   const uint8_t *patch = state->tail + sizeof(size_t);
+   size_t len           = state->block_delta
+      ? state_manager_block_patch_size(patch)
+      : state_manager_raw_patch_size(patch);
+
+   state_manager_spill_push(state->spill, patch, len);
+}
+#endif
+
 static void state_manager_free(state_manager_t *state)
 {
    if (!state)
       return;
 
+#ifdef HAVE_REWIND_SPILL
+   state_manager_spill_free(state->spill);
+   state->spill      = NULL;
+#endif
+
    if (state->data)
       free(state->data);
    if (state->thisblock)
@@ -429,7 +1009,8 @@ static void state_manager_free(state_manager_t *state)
    state->nextblock  = NULL;
 }
 
-static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
+static state_manager_t *state_manager_new(size_t state_size,
+      size_t buffer_size, bool block_delta)
 {
    size_t max_comp_size, block_size;
    uint8_t *next_block    = NULL;
@@ -440,17 +1021,27 @@ static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    if (!state)
       return NULL;
 
-   block_size         = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
-
-   /* the compressed data is surrounded by pointers to the other side */
-   max_comp_size      = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
    state_data         = (uint8_t*)malloc(buffer_size);
 
    if (!state_data)
       goto error;
 
-   this_block         = (uint8_t*)state_manager_raw_alloc(state_size, 0);
-   next_block         = (uint8_t*)state_manager_raw_alloc(state_size, 1);
+   if (block_delta)
+   {
+      block_size      = (state_size + REWIND_BLOCK_SIZE - 1) & -REWIND_BLOCK_SIZE;
+      /* the compressed data is surrounded by pointers to the other side */
+      max_comp_size   = state_manager_block_maxsize(state_size) + sizeof(size_t) * 2;
+      this_block      = (uint8_t*)state_manager_block_alloc(state_size);
+      next_block      = (uint8_t*)state_manager_block_alloc(state_size);
+   }
+   else
+   {
+      block_size      = (state_size + sizeof(uint16_t) - 1) & -sizeof(uint16_t);
+      /* the compressed data is surrounded by pointers to the other side */
+      max_comp_size   = state_manager_raw_maxsize(state_size) + sizeof(size_t) * 2;
+      this_block      = (uint8_t*)state_manager_raw_alloc(state_size, 0);
+      next_block      = (uint8_t*)state_manager_raw_alloc(state_size, 1);
+   }
 
    if (!this_block || !next_block)
       goto error;
@@ -461,6 +1052,7 @@ static state_manager_t *state_manager_new(size_t state_size, size_t buffer_size)
    state->thisblock   = this_block;
    state->nextblock   = next_block;
    state->capacity    = buffer_size;
+   state->block_delta = block_delta;
 
    state->head        = state->data + sizeof(size_t);
    state->tail        = state->data + sizeof(size_t);
@@ -498,17 +1090,40 @@ static bool state_manager_pop(state_manager_t *state, const void **data)
    }
 
    *data = state->thisblock;
+   out   = state->thisblock;
+
    if (state->head == state->tail)
+   {
+#ifdef HAVE_REWIND_SPILL
+      if (state->spill
+            && (compressed = state_manager_spill_pop(state->spill)))
+      {
+         if (state->block_delta)
+            state_manager_block_decompress(compressed,
+                  state->maxcompsize, out, state->blocksize);
+         else
+            state_manager_raw_decompress(compressed,
+                  state->maxcompsize, out, state->blocksize);
+
+         /* Spilled deltas are counted by the spill,
+          * 'entries' only covers the buffer */
+         return true;
+      }
+#endif
       return false;
+   }
 
    start = read_size_t(state->head - sizeof(size_t));
    state->head = state->data + start;
 
    compressed = state->data + start + sizeof(size_t);
-   out = state->thisblock;
 
-   state_manager_raw_decompress(compressed,
-         state->maxcompsize, out, state->blocksize);
+   if (state->block_delta)
+      state_manager_block_decompress(compressed,
+            state->maxcompsize, out, state->blocksize);
+   else
+      state_manager_raw_decompress(compressed,
+            state->maxcompsize, out, state->blocksize);
 
    state->entries--;
    return true;
@@ -561,6 +1176,10 @@ recheckcapacity:;
 
       if (remaining <= state->maxcompsize)
       {
+#ifdef HAVE_REWIND_SPILL
+         if (state->spill)
+            state_manager_spill_tail(state);
+#endif
          state->tail = state->data + read_size_t(state->tail);
          state->entries--;
          goto recheckcapacity;
@@ -570,14 +1189,24 @@ recheckcapacity:;
       newb        = state->nextblock;
       compressed  = state->head + sizeof(size_t);
 
-      compressed += state_manager_raw_compress(oldb, newb,
-            state->blocksize, compressed);
+      if (state->block_delta)
+         compressed += state_manager_block_compress(oldb, newb,
+               state->blocksize, compressed);
+      else
+         compressed += state_manager_raw_compress(oldb, newb,
+               state->blocksize, compressed);
 
       if (compressed - state->data + state->maxcompsize > state->capacity)
       {
          compressed = state->data;
          if (state->tail == state->data + sizeof(size_t))
+         {
+#ifdef HAVE_REWIND_SPILL
+            if (state->spill)
+               state_manager_spill_tail(state);
+#endif
             state->tail = state->data + read_size_t(state->tail);
+         }
       }
       write_size_t(compressed, state->head-state->data);
       compressed += sizeof(size_t);
@@ -612,7 +1241,146 @@ static void state_manager_capacity(state_manager_t *state,
 }
 #endif
 
-void state_manager_event_init(unsigned rewind_buffer_size)
+#ifdef HAVE_THREADS
+static void state_manager_async_loop(void *data)
+{
+   struct state_manager_rewind_state *rewind_st =
+      (struct state_manager_rewind_state*)data;
+
+   for (;;)
+   {
+      int idx;
+      void *state = NULL;
+
+      slock_lock(rewind_st->lock);
+      while (rewind_st->capture_pending < 0 && rewind_st->thread_alive)
+         scond_wait(rewind_st->cond, rewind_st->lock);
+
+      if (rewind_st->capture_pending < 0)
+      {
+         slock_unlock(rewind_st->lock);
+         break;
+      }
+
+      idx                        = rewind_st->capture_pending;
+      rewind_st->capture_pending = -1;
+      rewind_st->capture_busy    = idx;
+      scond_signal(rewind_st->cond);
+      slock_unlock(rewind_st->lock);
+
+      state_manager_push_where(rewind_st->state, &state);
+      memcpy(state, rewind_st->capture[idx], rewind_st->size);
+      state_manager_push_do(rewind_st->state);
+
+      slock_lock(rewind_st->lock);
+      rewind_st->capture_busy    = -1;
+      scond_signal(rewind_st->cond);
+      slock_unlock(rewind_st->lock);
+   }
+}
+
+/* Waits until all captured states have been pushed,
+ * after which 'state' can be accessed from the main thread. */
+static void state_manager_async_flush(
+      struct state_manager_rewind_state *rewind_st)
+{
+   if (!rewind_st->thread)
+      return;
+
+   slock_lock(rewind_st->lock);
+   while (rewind_st->capture_pending >= 0 || rewind_st->capture_busy >= 0)
+      scond_wait(rewind_st->cond, rewind_st->lock);
+   slock_unlock(rewind_st->lock);
+}
+
+static void state_manager_async_push(
+      struct state_manager_rewind_state *rewind_st)
+{
+   int idx;
+   retro_ctx_serialize_info_t serial_info;
+
+   /* Only blocks if the worker is still compressing the
+    * previous state and another one is already waiting */
+   slock_lock(rewind_st->lock);
+   while (rewind_st->capture_pending >= 0)
+      scond_wait(rewind_st->cond, rewind_st->lock);
+   idx = (rewind_st->capture_busy == 0) ? 1 : 0;
+   slock_unlock(rewind_st->lock);
+
+   serial_info.data = rewind_st->capture[idx];
+   serial_info.size = rewind_st->size;
+
+   core_serialize(&serial_info);
+
+   slock_lock(rewind_st->lock);
+   rewind_st->capture_pending = idx;
+   scond_signal(rewind_st->cond);
+   slock_unlock(rewind_st->lock);
+}
+
+static void state_manager_async_deinit(
+      struct state_manager_rewind_state *rewind_st)
+{
+   if (rewind_st->thread)
+   {
+      slock_lock(rewind_st->lock);
+      rewind_st->thread_alive = false;
+      scond_signal(rewind_st->cond);
+      slock_unlock(rewind_st->lock);
+
+      sthread_join(rewind_st->thread);
+   }
+
+   if (rewind_st->lock)
+      slock_free(rewind_st->lock);
+   if (rewind_st->cond)
+      scond_free(rewind_st->cond);
+   if (rewind_st->capture[0])
+      free(rewind_st->capture[0]);
+   if (rewind_st->capture[1])
+      free(rewind_st->capture[1]);
+
+   rewind_st->thread     = NULL;
+   rewind_st->lock       = NULL;
+   rewind_st->cond       = NULL;
+   rewind_st->capture[0] = NULL;
+   rewind_st->capture[1] = NULL;
+}
+
+static bool state_manager_async_init(
+      struct state_manager_rewind_state *rewind_st)
+{
+   rewind_st->capture_pending = -1;
+   rewind_st->capture_busy    = -1;
+   rewind_st->thread_alive    = true;
+   rewind_st->capture[0]      = (uint8_t*)malloc(rewind_st->size);
+   rewind_st->capture[1]      = (uint8_t*)malloc(rewind_st->size);
+   rewind_st->lock            = slock_new();
+   rewind_st->cond            = scond_new();
+
+   if (     !rewind_st->capture[0]
+         || !rewind_st->capture[1]
+         || !rewind_st->lock
+         || !rewind_st->cond)
+      goto error;
+
+   rewind_st->thread          = sthread_create(
+         state_manager_async_loop, rewind_st);
+
+   if (!rewind_st->thread)
+      goto error;
+
+   return true;
+
+error:
+   state_manager_async_deinit(rewind_st);
+   return false;
+}
+#endif
+
+void state_manager_event_init(unsigned rewind_buffer_size,
+      bool rewind_block_delta, bool rewind_threaded,
+      size_t rewind_spill_size, const char *rewind_spill_dir)
 {
    retro_ctx_serialize_info_t serial_info;
    retro_ctx_size_info_t info;
@@ -643,10 +1411,16 @@ void state_manager_event_init(unsigned rewind_buffer_size)
          (unsigned)(rewind_buffer_size / 1000000));
 
    rewind_state.state = state_manager_new(rewind_state.size,
-         rewind_buffer_size);
+         rewind_buffer_size, rewind_block_delta);
 
    if (!rewind_state.state)
       RARCH_WARN("%s.\n", msg_hash_to_str(MSG_REWIND_INIT_FAILED));
+#ifdef HAVE_REWIND_SPILL
+   else if (rewind_spill_size)
+      rewind_state.state->spill = state_manager_spill_new(
+            rewind_state.state->maxcompsize,
+            rewind_spill_size, rewind_spill_dir);
+#endif
 
    state_manager_push_where(rewind_state.state, &state);
 
@@ -656,6 +1430,15 @@ void state_manager_event_init(unsigned rewind_buffer_size)
    core_serialize(&serial_info);
 
    state_manager_push_do(rewind_state.state);
+
+#ifdef HAVE_THREADS
+   if (rewind_threaded && rewind_state.state)
+   {
+      if (!state_manager_async_init(&rewind_state))
+         RARCH_WARN("[Rewind]: Failed to start capture thread, "
+               "compressing on the main thread.\n");
+   }
+#endif
 }
 
 bool state_manager_frame_is_reversed(void)
@@ -665,6 +1448,10 @@ bool state_manager_frame_is_reversed(void)
 
 void state_manager_event_deinit(void)
 {
+#ifdef HAVE_THREADS
+   state_manager_async_deinit(&rewind_state);
+#endif
+
    if (rewind_state.state)
    {
       state_manager_free(rewind_state.state);
@@ -712,6 +1499,10 @@ bool state_manager_check_rewind(bool pressed,
    {
       const void *buf    = NULL;
 
+#ifdef HAVE_THREADS
+      state_manager_async_flush(&rewind_state);
+#endif
+
       if (state_manager_pop(rewind_state.state, &buf))
       {
          retro_ctx_serialize_info_t serial_info;
@@ -776,17 +1567,24 @@ bool state_manager_check_rewind(bool pressed,
 
       if ((cnt == 0) || rarch_ctl(RARCH_CTL_BSV_MOVIE_IS_INITED, NULL))
       {
-         retro_ctx_serialize_info_t serial_info;
-         void *state = NULL;
+#ifdef HAVE_THREADS
+         if (rewind_state.thread)
+            state_manager_async_push(&rewind_state);
+         else
+#endif
+         {
+            retro_ctx_serialize_info_t serial_info;
+            void *state = NULL;
 
-         state_manager_push_where(rewind_state.state, &state);
+            state_manager_push_where(rewind_state.state, &state);
 
-         serial_info.data = state;
-         serial_info.size = rewind_state.size;
+            serial_info.data = state;
+            serial_info.size = rewind_state.size;
 
-         core_serialize(&serial_info);
+            core_serialize(&serial_info);
 
-         state_manager_push_do(rewind_state.state);
+            state_manager_push_do(rewind_state.state);
+         }
       }
    }
 
@@ -32,7 +32,9 @@ bool state_manager_frame_is_reversed(void);
 
 void state_manager_event_deinit(void);
 
-void state_manager_event_init(unsigned rewind_buffer_size);
+void state_manager_event_init(unsigned rewind_buffer_size,
+      bool rewind_block_delta, bool rewind_threaded,
+      size_t rewind_spill_size, const char *rewind_spill_dir);
 
 /**
  * check_rewind:
@@ -472,7 +472,7 @@ static int menu_displaylist_parse_core_info(menu_displaylist_info_t *info)
    else if (core_info_get_current_core(&core_info) && core_info)
       core_path = core_info->path;
 
-   if (!core_info || !core_info->config_data)
+   if (!core_info || !core_info->has_info)
    {
       if (menu_entries_append_enum(info->list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO_CORE_INFORMATION_AVAILABLE),
@@ -3067,7 +3067,7 @@ static unsigned menu_displaylist_parse_information_list(file_list_t *info_list)
           !string_is_equal(system->library_name,
              msg_hash_to_str(MENU_ENUM_LABEL_VALUE_NO_CORE))
          )
-         && core_info && core_info->config_data
+         && core_info && core_info->has_info
       )
       if (menu_entries_append_enum(info_list,
             msg_hash_to_str(MENU_ENUM_LABEL_VALUE_CORE_INFORMATION),
@@ -531,10 +531,20 @@ static void explore_load_icons(explore_state_t *state)
    }
 }
 
+/* RDB fields read besides the explore_by_info ones */
+enum
+{
+   EXPLORE_KEY_CRC = EXPLORE_CAT_COUNT,
+   EXPLORE_KEY_NAME,
+   EXPLORE_KEY_ORIGINAL_TITLE,
+   EXPLORE_KEY_COUNT
+};
+
 static explore_state_t *explore_build_list(void)
 {
    unsigned i;
    char tmp[PATH_MAX_LENGTH];
+   const char *rdb_keys[EXPLORE_KEY_COUNT];
    struct explore_rdb
    {
       libretrodb_t *handle;
@@ -547,6 +557,7 @@ static explore_state_t *explore_build_list(void)
    ex_hashmap32 rdb_indices                 = {0};
    ex_hashmap32 cat_maps[EXPLORE_CAT_COUNT] = {{0}};
    explore_string_t **split_buf             = NULL;
+   char *strings_buf                        = NULL;
    settings_t *settings                     = config_get_ptr();
    const char *directory_playlist           = settings->paths.directory_playlist;
    const char *directory_database           = settings->paths.path_content_database;
@@ -689,99 +700,101 @@ static explore_state_t *explore_build_list(void)
    }
 
    /* Loop through all RDBs referenced in the playlists 
-    * and load meta data strings */
+    * and load meta data strings. Items are decoded in place
+    * and only the fields below are looked at. */
+   rdb_keys[EXPLORE_KEY_CRC]            = "crc";
+   rdb_keys[EXPLORE_KEY_NAME]           = "name";
+   rdb_keys[EXPLORE_KEY_ORIGINAL_TITLE] = "original_title";
+   for (i = 0; i != EXPLORE_CAT_COUNT; i++)
+      rdb_keys[i]                       = explore_by_info[i].rdbkey;
+
    for (i = 0; i != RBUF_LEN(rdbs); i++)
    {
-      struct rmsgpack_dom_value item;
+      struct rmsgpack_view item;
       struct explore_rdb* rdb  = &rdbs[i];
       libretrodb_cursor_t *cur = libretrodb_cursor_new();
       bool more                = 
          (
           libretrodb_cursor_open(rdb->handle, cur, NULL) == 0
-          && libretrodb_cursor_read_item(cur, &item) == 0);
+          && libretrodb_cursor_read_view(cur, &item) == 0);
 
-      for (; more; more = (rmsgpack_dom_value_free(&item),
-               libretrodb_cursor_read_item(cur, &item) == 0))
+      for (; more; more = (libretrodb_cursor_read_view(cur, &item) == 0))
       {
          unsigned k, l, cat;
          explore_entry_t e;
+         struct rmsgpack_view values[EXPLORE_KEY_COUNT];
+         char *strings[EXPLORE_KEY_COUNT];
          char *fields[EXPLORE_CAT_COUNT];
          char numeric_buf[EXPLORE_CAT_COUNT][16];
+         const struct rmsgpack_view *crc    = &values[EXPLORE_KEY_CRC];
          const struct playlist_entry *entry = NULL;
          uint32_t crc32                     = 0;
-         char *name                         = NULL;
-#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-         char *original_title               = NULL;
-#endif
+         size_t strings_len                 = 0;
 
          if (item.type != RDT_MAP)
             continue;
 
-         for (k = 0; k < EXPLORE_CAT_COUNT; k++)
-            fields[k]                       = NULL;
+         rmsgpack_dom_view_map_values(&item,
+               rdb_keys, EXPLORE_KEY_COUNT, values);
 
-         for (k = 0; k < item.val.map.len; k++)
+         if (crc->type == RDT_BINARY && crc->val.binary.len == sizeof(crc32))
          {
-            const char *key_str             = NULL;
-            struct rmsgpack_dom_value *key  = &item.val.map.items[k].key;
-            struct rmsgpack_dom_value *val  = &item.val.map.items[k].value;
-            if (!key || !val || key->type != RDT_STRING)
-               continue;
+            memcpy(&crc32, crc->val.binary.buff, sizeof(crc32));
+            crc32 = swap_if_little32(crc32);
+            entry = (const struct playlist_entry *)ex_hashmap32_getptr(
+                  &rdb->playlist_crcs, crc32);
+         }
 
-            key_str                         = key->val.string.buff;
-            if (string_is_equal(key_str, "crc"))
-            {
-               crc32 = swap_if_little32(*(uint32_t*)val->val.binary.buff);
-               continue;
-            }
-            else if (string_is_equal(key_str, "name"))
-            {
-               name = val->val.string.buff;
-               continue;
-            }
-#ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-            else if (string_is_equal(key_str, "original_title"))
-            {
-               original_title = val->val.string.buff;
-               continue;
-            }
-#endif
+         if (!entry && (     !rdb->playlist_names.len 
+                           || values[EXPLORE_KEY_NAME].type != RDT_STRING))
+            continue;
 
-            for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
-            {
-               if (!string_is_equal(key_str, explore_by_info[cat].rdbkey))
-                  continue;
+         /* Copy the strings out to NUL terminate them, into
+          * a buffer that is reused for every item */
+         for (k = 0; k < EXPLORE_KEY_COUNT; k++)
+            if (values[k].type == RDT_STRING)
+               strings_len += values[k].val.string.len + 1;
 
-               if (explore_by_info[cat].is_numeric)
-               {
-                  if (!val->val.int_)
-                     break;
-                  snprintf(numeric_buf[cat],
-                        sizeof(numeric_buf[cat]),
-                        "%d", (int)val->val.int_);
-                  fields[cat] = numeric_buf[cat];
-                  break;
-               }
-               if (val->type != RDT_STRING)
-                  break;
-               fields[cat] = val->val.string.buff;
-               break;
-            }
-         }
+         RBUF_RESIZE(strings_buf, strings_len);
+         strings_len = 0;
 
-         if (crc32)
+         for (k = 0; k < EXPLORE_KEY_COUNT; k++)
          {
-            entry = (const struct playlist_entry *)ex_hashmap32_getptr(
-                  &rdb->playlist_crcs, crc32);
+            strings[k] = NULL;
+            if (values[k].type != RDT_STRING)
+               continue;
+            strings[k] = strings_buf + strings_len;
+            memcpy(strings[k], values[k].val.string.buff,
+                  values[k].val.string.len);
+            strings[k][values[k].val.string.len] = '\0';
+            strings_len += values[k].val.string.len + 1;
          }
-         if (!entry && name)
-         {
+
+         if (!entry)
             entry = (const struct playlist_entry *)ex_hashmap32_strgetptr(
-                  &rdb->playlist_names, name);
-         }
+                  &rdb->playlist_names, strings[EXPLORE_KEY_NAME]);
          if (!entry)
             continue;
 
+         for (cat = 0; cat != EXPLORE_CAT_COUNT; cat++)
+         {
+            const struct rmsgpack_view *val = &values[cat];
+
+            fields[cat] = strings[cat];
+
+            if (!explore_by_info[cat].is_numeric)
+               continue;
+
+            fields[cat] = NULL;
+            if (     (val->type != RDT_INT && val->type != RDT_UINT)
+                  || !val->val.int_)
+               continue;
+            snprintf(numeric_buf[cat],
+                  sizeof(numeric_buf[cat]),
+                  "%d", (int)val->val.int_);
+            fields[cat] = numeric_buf[cat];
+         }
+
          e.playlist_entry  = entry;
          for (l = 0; l < EXPLORE_CAT_COUNT; l++)
             e.by[l]        = NULL;
@@ -800,12 +813,13 @@ static explore_state_t *explore_build_list(void)
          }
 
 #ifdef EXPLORE_SHOW_ORIGINAL_TITLE
-         if (original_title && *original_title)
+         if (     strings[EXPLORE_KEY_ORIGINAL_TITLE]
+               && *strings[EXPLORE_KEY_ORIGINAL_TITLE])
          {
-            size_t len       = strlen(original_title) + 1;
+            size_t len       = strlen(strings[EXPLORE_KEY_ORIGINAL_TITLE]) + 1;
             e.original_title = (char*)
                ex_arena_alloc(&explore->arena, len);
-            memcpy(e.original_title, original_title, len);
+            memcpy(e.original_title, strings[EXPLORE_KEY_ORIGINAL_TITLE], len);
          }
 #endif
 
@@ -825,10 +839,7 @@ static explore_state_t *explore_build_list(void)
 
          /* if all entries have found connections, we can leave early */
          if (--rdb->count == 0)
-         {
-            rmsgpack_dom_value_free(&item);
             break;
-         }
       }
 
       libretrodb_cursor_close(cur);
@@ -839,6 +850,7 @@ static explore_state_t *explore_build_list(void)
       ex_hashmap32_free(&rdb->playlist_names);
    }
    RBUF_FREE(split_buf);
+   RBUF_FREE(strings_buf);
    ex_hashmap32_free(&rdb_indices);
    RBUF_FREE(rdbs);
 
@@ -15,11 +15,27 @@
 
 #include <stdlib.h>
 
+#include <retro_miscellaneous.h>
 #include <net/net_compat.h>
 #include <net/net_socket.h>
 
+#if defined(__linux__) || defined(__APPLE__) || defined(__FreeBSD__) \
+      || defined(__NetBSD__) || defined(__OpenBSD__)
+#include <sys/uio.h>
+#define HAVE_NETPLAY_SENDMSG
+#endif
+
 #include "netplay_private.h"
 
+/* Most pieces of output one flush hands to the socket at once */
+#define NETPLAY_SEND_IOV_MAX 16
+
+struct netplay_iovec
+{
+   const unsigned char *data;
+   size_t len;
+};
+
 static size_t buf_used(struct socket_buffer *sbuf)
 {
    if (sbuf->end < sbuf->start)
@@ -51,6 +67,128 @@ static size_t buf_remaining(struct socket_buffer *sbuf)
    return sbuf->bufsz - buf_used(sbuf) - 1;
 }
 
+static void buf_release_shared(struct socket_buffer *sbuf)
+{
+   while (sbuf->shared_count)
+   {
+      netplay_shared_block_release(sbuf->shared[sbuf->shared_head].block);
+      sbuf->shared_head = (sbuf->shared_head + 1) % NETPLAY_SHARED_QUEUE_SIZE;
+      sbuf->shared_count--;
+   }
+
+   sbuf->shared_head  = 0;
+   sbuf->shared_sent  = 0;
+   sbuf->shared_ring  = 0;
+   sbuf->shared_bytes = 0;
+}
+
+/* Adds the len bytes of the ring from pos bytes past its start, which may
+ * wrap around its end */
+static unsigned buf_ring_iov(struct socket_buffer *sbuf, size_t pos,
+      size_t len, struct netplay_iovec *iov)
+{
+   size_t first = (sbuf->start + pos) % sbuf->bufsz;
+   size_t chunk = MIN(len, sbuf->bufsz - first);
+
+   if (!len)
+      return 0;
+
+   iov[0].data = sbuf->data + first;
+   iov[0].len  = chunk;
+
+   if (chunk == len)
+      return 1;
+
+   iov[1].data = sbuf->data;
+   iov[1].len  = len - chunk;
+   return 2;
+}
+
+/* Drops the first len bytes of queued output, which have been sent */
+static void buf_consume(struct socket_buffer *sbuf, size_t len)
+{
+   while (len && sbuf->shared_count)
+   {
+      size_t take;
+      struct socket_shared_ref *ref = &sbuf->shared[sbuf->shared_head];
+
+      if (ref->ring_before)
+      {
+         take               = MIN(len, ref->ring_before);
+         sbuf->start        = (sbuf->start + take) % sbuf->bufsz;
+         ref->ring_before  -= take;
+         sbuf->shared_ring -= take;
+         len               -= take;
+         continue;
+      }
+
+      take                = MIN(len, ref->block->size - sbuf->shared_sent);
+      sbuf->shared_sent  += take;
+      sbuf->shared_bytes -= take;
+      len                -= take;
+
+      if (sbuf->shared_sent == ref->block->size)
+      {
+         netplay_shared_block_release(ref->block);
+         sbuf->shared_head = (sbuf->shared_head + 1) % NETPLAY_SHARED_QUEUE_SIZE;
+         sbuf->shared_count--;
+         sbuf->shared_sent = 0;
+      }
+   }
+
+   sbuf->start = (sbuf->start + len) % sbuf->bufsz;
+
+   if (sbuf->start == sbuf->end)
+      sbuf->start = sbuf->end = 0;
+}
+
+/* Sends what it can of the given pieces without blocking, returning how much
+ * that was or -1 on error */
+static ssize_t netplay_send_iov(int sockfd, const struct netplay_iovec *iov,
+      unsigned count)
+{
+#ifdef HAVE_NETPLAY_SENDMSG
+   unsigned i;
+   ssize_t sent;
+   struct msghdr msg;
+   struct iovec vec[NETPLAY_SEND_IOV_MAX];
+
+   for (i = 0; i < count; i++)
+   {
+      vec[i].iov_base = (void*)iov[i].data;
+      vec[i].iov_len  = iov[i].len;
+   }
+
+   memset(&msg, 0, sizeof(msg));
+   msg.msg_iov    = vec;
+   msg.msg_iovlen = count;
+
+   sent           = sendmsg(sockfd, &msg, MSG_NOSIGNAL);
+
+   if (sent < 0)
+      return isagain((int)sent) ? 0 : -1;
+   return sent;
+#else
+   unsigned i;
+   ssize_t total = 0;
+
+   for (i = 0; i < count; i++)
+   {
+      ssize_t sent = socket_send_all_nonblocking(sockfd,
+            iov[i].data, iov[i].len, true);
+
+      if (sent < 0)
+         return -1;
+
+      total += sent;
+      if ((size_t)sent < iov[i].len)
+         break;
+   }
+
+   return total;
+#endif
+}
+
 /**
  * netplay_init_socket_buffer
  *
@@ -64,6 +202,8 @@ bool netplay_init_socket_buffer(
       return false;
    sbuf->bufsz = size;
    sbuf->start = sbuf->read = sbuf->end = 0;
+   sbuf->shared_head  = sbuf->shared_count = sbuf->shared_sent = 0;
+   sbuf->shared_ring  = sbuf->shared_bytes = 0;
    return true;
 }
 
@@ -119,15 +259,80 @@ bool netplay_resize_socket_buffer(
  */
 void netplay_deinit_socket_buffer(struct socket_buffer *sbuf)
 {
+   buf_release_shared(sbuf);
    if (sbuf->data)
       free(sbuf->data);
 }
 
 void netplay_clear_socket_buffer(struct socket_buffer *sbuf)
 {
+   buf_release_shared(sbuf);
    sbuf->start = sbuf->read = sbuf->end = 0;
 }
 
+/**
+ * netplay_shared_block_new
+ *
+ * Allocate a shared block of the given size, holding one reference.
+ */
+struct netplay_shared_block *netplay_shared_block_new(size_t size)
+{
+   struct netplay_shared_block *block = (struct netplay_shared_block*)
+      malloc(sizeof(*block) + size);
+
+   if (!block)
+      return NULL;
+
+   block->data     = (unsigned char*)(block + 1);
+   block->size     = size;
+   block->refcount = 1;
+   return block;
+}
+
+/**
+ * netplay_shared_block_release
+ *
+ * Drop a reference to a shared block, freeing it with the last.
+ */
+void netplay_shared_block_release(struct netplay_shared_block *block)
+{
+   if (block && --block->refcount == 0)
+      free(block);
+}
+
+/**
+ * netplay_send_shared
+ *
+ * Queue a shared block for sending after whatever is queued already, taking a
+ * reference to it rather than copying it.
+ */
+bool netplay_send_shared(struct socket_buffer *sbuf, int sockfd,
+      struct netplay_shared_block *block)
+{
+   struct socket_shared_ref *ref;
+
+   /* Hold back as netplay_send does when the ring is full */
+   if (     sbuf->shared_count == NETPLAY_SHARED_QUEUE_SIZE
+         || (sbuf->shared_count &&
+            sbuf->shared_bytes + block->size > sbuf->bufsz))
+   {
+      if (!netplay_send_flush(sbuf, sockfd, true))
+         return false;
+   }
+
+   ref               = &sbuf->shared[(sbuf->shared_head + sbuf->shared_count)
+      % NETPLAY_SHARED_QUEUE_SIZE];
+   ref->block        = block;
+   ref->ring_before  = buf_used(sbuf) - sbuf->shared_ring;
+
+   sbuf->shared_ring  += ref->ring_before;
+   sbuf->shared_bytes += block->size;
+   sbuf->shared_count++;
+   block->refcount++;
+
+   return true;
+}
+
 /**
  * netplay_send
  *
@@ -182,77 +387,56 @@ bool netplay_send(
  * Flush unsent data in the given socket buffer, blocking to do so if
  * requested.
  *
+ * The ring and any shared blocks queued in between go out together, in one
+ * sendmsg where there is one.
+ *
  * Returns false only on socket failures, true otherwise.
  */
 bool netplay_send_flush(struct socket_buffer *sbuf, int sockfd, bool block)
 {
-   ssize_t sent;
-
-   if (buf_used(sbuf) == 0)
-      return true;
-
-   if (sbuf->end > sbuf->start)
+   for (;;)
    {
-      /* Usual case: Everything's in order */
-      if (block)
+      struct netplay_iovec iov[NETPLAY_SEND_IOV_MAX];
+      size_t i;
+      ssize_t sent;
+      unsigned count  = 0;
+      size_t ring_pos = 0;
+      size_t len      = 0;
+
+      for (i = 0; i < sbuf->shared_count
+            && count + 3 <= NETPLAY_SEND_IOV_MAX; i++)
       {
-         if (!socket_send_all_blocking(
-                  sockfd, sbuf->data + sbuf->start,
-                  buf_used(sbuf), true))
-            return false;
-
-         sbuf->start = sbuf->end = 0;
+         const struct socket_shared_ref *ref = &sbuf->shared[
+            (sbuf->shared_head + i) % NETPLAY_SHARED_QUEUE_SIZE];
+         size_t skip = i ? 0 : sbuf->shared_sent;
+
+         count           += buf_ring_iov(sbuf, ring_pos, ref->ring_before,
+               iov + count);
+         ring_pos        += ref->ring_before;
+         iov[count].data  = ref->block->data + skip;
+         iov[count++].len = ref->block->size - skip;
       }
-      else
-      {
-         sent = socket_send_all_nonblocking(
-               sockfd, sbuf->data + sbuf->start,
-               buf_used(sbuf), true);
 
-         if (sent < 0)
-            return false;
+      /* And the rest of the ring */
+      if (i == sbuf->shared_count && count + 2 <= NETPLAY_SEND_IOV_MAX)
+         count += buf_ring_iov(sbuf, ring_pos, buf_used(sbuf) - ring_pos,
+               iov + count);
 
-         sbuf->start += sent;
+      if (!count)
+         return true;
 
-         if (sbuf->start == sbuf->end)
-            sbuf->start = sbuf->end = 0;
-      }
-   }
-   else
-   {
-      /* Unusual case: Buffer overlaps break */
-      if (block)
-      {
-         if (!socket_send_all_blocking(
-                  sockfd, sbuf->data + sbuf->start,
-                  sbuf->bufsz - sbuf->start, true))
-            return false;
-
-         sbuf->start = 0;
-
-         return netplay_send_flush(sbuf, sockfd, true);
-      }
-      else
-      {
-         sent = socket_send_all_nonblocking(
-               sockfd, sbuf->data + sbuf->start,
-               sbuf->bufsz - sbuf->start, true);
-
-         if (sent < 0)
-            return false;
+      for (i = 0; i < count; i++)
+         len += iov[i].len;
 
-         sbuf->start += sent;
+      if ((sent = netplay_send_iov(sockfd, iov, count)) < 0)
+         return false;
 
-         if (sbuf->start >= sbuf->bufsz)
-         {
-            sbuf->start = 0;
-            return netplay_send_flush(sbuf, sockfd, false);
-         }
-      }
+      buf_consume(sbuf, sent);
 
+      /* Without blocking, stop once the socket won't take more */
+      if (!block && (size_t)sent < len)
+         return true;
    }
-
-   return true;
 }
 
 /**
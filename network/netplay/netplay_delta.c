@@ -16,9 +16,11 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <sys/types.h>
 
 #include <boolean.h>
+#include <retro_miscellaneous.h>
 #include <encodings/crc32.h>
 
 #include "netplay_private.h"
@@ -66,6 +68,7 @@ bool netplay_delta_frame_ready(netplay_t *netplay, struct delta_frame *delta,
       clear_input(delta->simlated_input[i]);
    }
    delta->have_local = false;
+   delta->have_state = false;
    for (i = 0; i < MAX_CLIENTS; i++)
       delta->have_real[i] = false;
    return true;
@@ -208,3 +211,245 @@ uint32_t netplay_expected_input_size(netplay_t *netplay, uint32_t devices)
 
    return ret;
 }
+
+static bool netplay_savestate_delta_init(netplay_t *netplay)
+{
+   if (netplay->delta_buffer)
+      return true;
+
+   if (!netplay->state_size)
+      return false;
+
+   netplay->delta_send_base = (uint8_t*)malloc(netplay->state_size);
+   netplay->delta_recv_base = (uint8_t*)malloc(netplay->state_size);
+   netplay->delta_buffer    = (uint8_t*)malloc(netplay->state_size);
+
+   if (     !netplay->delta_send_base
+         || !netplay->delta_recv_base
+         || !netplay->delta_buffer)
+   {
+      netplay_savestate_delta_free(netplay);
+      return false;
+   }
+
+   netplay->delta_buffer_size = netplay->state_size;
+   return true;
+}
+
+/**
+ * netplay_savestate_delta_can_send
+ *
+ * Whether this peer holds the last savestate we sent, so the next one may be
+ * sent as a delta against it.
+ */
+bool netplay_savestate_delta_can_send(netplay_t *netplay,
+      struct netplay_connection *connection)
+{
+   return netplay->delta_send_valid
+      && connection->delta_supported
+      && connection->delta_acked
+      && connection->delta_ack_frame == netplay->delta_send_frame
+      && connection->delta_ack_crc   == netplay->delta_send_crc;
+}
+
+/**
+ * netplay_savestate_delta_encode
+ *
+ * Encode the blocks of a savestate about to be sent which differ from the
+ * last one sent into netplay->delta_buffer, XORed with it.
+ *
+ * The delta is a list of runs of changed blocks, each an offset and a length
+ * in bytes followed by that many bytes of XOR.
+ *
+ * Returns: True with the size of the delta if some peer can take it, false if
+ * none can or the delta wouldn't be much smaller than the savestate.
+ */
+bool netplay_savestate_delta_encode(netplay_t *netplay, const void *state,
+      size_t size, size_t *delta_size)
+{
+   size_t i;
+   const uint8_t *cur  = (const uint8_t*)state;
+   const uint8_t *base = netplay->delta_send_base;
+   uint8_t *out        = netplay->delta_buffer;
+   /* Past half the savestate, compressing it whole does about as well */
+   size_t max_size     = size / 2;
+   size_t out_size     = 0;
+
+   if (!netplay->delta_send_valid || size != netplay->state_size)
+      return false;
+
+   for (i = 0; i < netplay->connections_size; i++)
+      if (     netplay->connections[i].active
+            && netplay_savestate_delta_can_send(netplay,
+               &netplay->connections[i]))
+         break;
+   if (i == netplay->connections_size)
+      return false;
+
+   i = 0;
+   while (i < size)
+   {
+      uint32_t header[2];
+      size_t start, len, j;
+      size_t block = MIN(NETPLAY_DELTA_BLOCK_SIZE, size - i);
+
+      if (!memcmp(cur + i, base + i, block))
+      {
+         i += block;
+         continue;
+      }
+
+      /* Extend the run over the changed blocks that follow */
+      start = i;
+      for (i += block; i < size; i += block)
+      {
+         block = MIN(NETPLAY_DELTA_BLOCK_SIZE, size - i);
+         if (!memcmp(cur + i, base + i, block))
+            break;
+      }
+      len = i - start;
+
+      if (out_size + sizeof(header) + len > max_size)
+         return false;
+
+      header[0] = htonl((uint32_t)start);
+      header[1] = htonl((uint32_t)len);
+      memcpy(out + out_size, header, sizeof(header));
+      out_size += sizeof(header);
+
+      for (j = 0; j < len; j++)
+         out[out_size + j] = cur[start + j] ^ base[start + j];
+      out_size += len;
+   }
+
+   *delta_size = out_size;
+   return true;
+}
+
+/**
+ * netplay_savestate_delta_sent
+ *
+ * Remember a savestate just sent to our peers as the base for the next delta.
+ */
+void netplay_savestate_delta_sent(netplay_t *netplay, const void *state,
+      size_t size, uint32_t frame)
+{
+   size_t i;
+
+   netplay->delta_send_valid = false;
+
+   /* Don't hold on to it for peers that can't use it */
+   for (i = 0; i < netplay->connections_size; i++)
+      if (     netplay->connections[i].active
+            && netplay->connections[i].delta_supported)
+         break;
+   if (i == netplay->connections_size)
+      return;
+
+   if (size != netplay->state_size || !netplay_savestate_delta_init(netplay))
+      return;
+
+   memcpy(netplay->delta_send_base, state, size);
+   netplay->delta_send_frame = frame;
+   netplay->delta_send_crc   = encoding_crc32(0L,
+         netplay->delta_send_base, size);
+   netplay->delta_send_valid = true;
+}
+
+/**
+ * netplay_savestate_delta_apply
+ *
+ * Rebuild a savestate for the given frame from the delta in
+ * netplay->delta_buffer and the last savestate a peer sent us, which must be
+ * the one at base_frame with CRC base_crc.
+ *
+ * Returns: True with the CRC of the savestate if the delta applied, false
+ * otherwise, after which no delta applies until a full savestate is loaded.
+ */
+bool netplay_savestate_delta_apply(netplay_t *netplay, void *state,
+      size_t delta_size, uint32_t frame, uint32_t base_frame,
+      uint32_t base_crc, uint32_t *crc)
+{
+   size_t pos          = 0;
+   const uint8_t *in   = netplay->delta_buffer;
+   uint8_t *base       = netplay->delta_recv_base;
+
+   if (     !netplay->delta_recv_valid
+         || netplay->delta_recv_frame != base_frame
+         || netplay->delta_recv_crc   != base_crc)
+      return false;
+
+   /* The base is patched in place, so it's no good if we stop halfway */
+   netplay->delta_recv_valid = false;
+
+   while (pos < delta_size)
+   {
+      uint32_t header[2];
+      size_t start, len, j;
+
+      if (delta_size - pos < sizeof(header))
+         return false;
+      memcpy(header, in + pos, sizeof(header));
+      pos  += sizeof(header);
+      start = ntohl(header[0]);
+      len   = ntohl(header[1]);
+
+      if (     start > netplay->state_size
+            || len   > netplay->state_size - start
+            || len   > delta_size - pos)
+         return false;
+
+      for (j = 0; j < len; j++)
+         base[start + j] ^= in[pos + j];
+      pos += len;
+   }
+
+   memcpy(state, base, netplay->state_size);
+   netplay->delta_recv_frame = frame;
+   netplay->delta_recv_crc   = encoding_crc32(0L, base, netplay->state_size);
+   netplay->delta_recv_valid = true;
+   *crc                      = netplay->delta_recv_crc;
+   return true;
+}
+
+/**
+ * netplay_savestate_delta_loaded
+ *
+ * Remember a full savestate loaded from a peer as the base for its next
+ * delta.
+ *
+ * Returns: True with the CRC of the savestate to acknowledge it with, false
+ * if we can't hold it.
+ */
+bool netplay_savestate_delta_loaded(netplay_t *netplay, const void *state,
+      uint32_t frame, uint32_t *crc)
+{
+   if (!netplay_savestate_delta_init(netplay))
+      return false;
+
+   memcpy(netplay->delta_recv_base, state, netplay->state_size);
+   netplay->delta_recv_frame = frame;
+   netplay->delta_recv_crc   = encoding_crc32(0L, netplay->delta_recv_base,
+         netplay->state_size);
+   netplay->delta_recv_valid = true;
+   *crc                      = netplay->delta_recv_crc;
+   return true;
+}
+
+/**
+ * netplay_savestate_delta_free
+ *
+ * Free the savestate delta buffers.
+ */
+void netplay_savestate_delta_free(netplay_t *netplay)
+{
+   free(netplay->delta_send_base);
+   free(netplay->delta_recv_base);
+   free(netplay->delta_buffer);
+   netplay->delta_send_base   = NULL;
+   netplay->delta_recv_base   = NULL;
+   netplay->delta_buffer      = NULL;
+   netplay->delta_buffer_size = 0;
+   netplay->delta_send_valid  = false;
+   netplay->delta_recv_valid  = false;
+}
@@ -395,6 +395,10 @@ bool netplay_handshake_init(netplay_t *netplay,
       connection->compression_supported = 0;
    }
 
+   /* Savestate deltas work with either */
+   connection->delta_supported =
+      (compression & NETPLAY_COMPRESSION_DELTA) ? true : false;
+
    if (!ctrans->decompression_backend)
       ctrans->decompression_backend = ctrans->compression_backend->reverse;
 
@@ -872,7 +876,7 @@ static bool netplay_handshake_pre_info(netplay_t *netplay,
       return true;
    }
 
-   RECV(&info_buf.core_name, cmd_size)
+   RECV(&info_buf.content_crc, cmd_size)
    {
       RARCH_ERR("Failed to receive netplay info payload.\n");
       return false;
@@ -988,6 +992,7 @@ static bool netplay_handshake_pre_sync(netplay_t *netplay,
    netplay->self_frame_count      = netplay->run_frame_count    =
       netplay->other_frame_count  = netplay->unread_frame_count =
       netplay->server_frame_count = new_frame_count;
+   netplay->server_check_frames   = 0;
 
    /* And clear out the framebuffer */
    for (i = 0; i < netplay->buffer_size; i++)
@@ -331,6 +331,7 @@ bool netplay_try_init_serialization(netplay_t *netplay)
 
    if (!core_serialize(&serial_info))
       return false;
+   netplay->buffer[netplay->run_ptr].have_state = true;
 
    /* Once initialized, we no longer exhibit this quirk */
    netplay->quirks &= ~((uint64_t) NETPLAY_QUIRK_INITIALIZATION);
@@ -529,6 +530,16 @@ void netplay_free(netplay_t *netplay)
 {
    size_t i;
 
+   if (netplay->serialized_frames || netplay->unserialized_frames)
+      RARCH_LOG("[netplay] Saved state for %u frames, skipped %u with all input confirmed.\n",
+            netplay->serialized_frames, netplay->unserialized_frames);
+
+   if (netplay->rollbacks)
+      RARCH_LOG("[netplay] Rolled back %u times, replaying %u frames (%u at most) in %lld ms.\n",
+            netplay->rollbacks, netplay->rollback_frames,
+            netplay->rollback_max_frames,
+            (long long)(netplay->rollback_time / 1000));
+
    if (netplay->listen_fd >= 0)
       socket_close(netplay->listen_fd);
 
@@ -560,6 +571,8 @@ void netplay_free(netplay_t *netplay)
    if (netplay->zbuffer)
       free(netplay->zbuffer);
 
+   netplay_savestate_delta_free(netplay);
+
    if (netplay->compress_nil.compression_stream)
    {
       netplay->compress_nil.compression_backend->stream_free(netplay->compress_nil.compression_stream);
@@ -278,6 +278,12 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
    }
    else
    {
+      /* Written once for everyone */
+      struct netplay_shared_block *block =
+         netplay_shared_block_new(bufused*sizeof(uint32_t));
+      if (block)
+         memcpy(block->data, buffer, bufused*sizeof(uint32_t));
+
       for (i = 0; i < netplay->connections_size; i++)
       {
          struct netplay_connection *connection = &netplay->connections[i];
@@ -288,11 +294,16 @@ static bool send_input_frame(netplay_t *netplay, struct delta_frame *dframe,
              (connection->mode != NETPLAY_CONNECTION_PLAYING ||
               i+1 != client_num))
          {
-            if (!netplay_send(&connection->send_packet_buffer, connection->fd,
-                  buffer, bufused*sizeof(uint32_t)))
+            if (block
+                  ? !netplay_send_shared(&connection->send_packet_buffer,
+                     connection->fd, block)
+                  : !netplay_send(&connection->send_packet_buffer,
+                     connection->fd, buffer, bufused*sizeof(uint32_t)))
                netplay_hangup(netplay, connection);
          }
       }
+
+      netplay_shared_block_release(block);
    }
 
    return true;
@@ -392,13 +403,28 @@ bool netplay_send_raw_cmd(netplay_t *netplay,
  * netplay_send_raw_cmd_all
  *
  * Send a raw Netplay command to all connections, optionally excluding one
- * (typically the client that the relevant command came from)
+ * (typically the client that the relevant command came from). The command is
+ * written once and queued for each of them.
  */
 void netplay_send_raw_cmd_all(netplay_t *netplay,
    struct netplay_connection *except, uint32_t cmd, const void *data,
    size_t size)
 {
    size_t i;
+   struct netplay_shared_block *block =
+      netplay_shared_block_new(2*sizeof(uint32_t) + size);
+
+   if (block)
+   {
+      uint32_t cmdbuf[2];
+
+      cmdbuf[0] = htonl(cmd);
+      cmdbuf[1] = htonl(size);
+      memcpy(block->data, cmdbuf, sizeof(cmdbuf));
+      if (size > 0)
+         memcpy(block->data + sizeof(cmdbuf), data, size);
+   }
+
    for (i = 0; i < netplay->connections_size; i++)
    {
       struct netplay_connection *connection = &netplay->connections[i];
@@ -406,10 +432,15 @@ void netplay_send_raw_cmd_all(netplay_t *netplay,
          continue;
       if (connection->active && connection->mode >= NETPLAY_CONNECTION_CONNECTED)
       {
-         if (!netplay_send_raw_cmd(netplay, connection, cmd, data, size))
+         if (block
+               ? !netplay_send_shared(&connection->send_packet_buffer,
+                  connection->fd, block)
+               : !netplay_send_raw_cmd(netplay, connection, cmd, data, size))
             netplay_hangup(netplay, connection);
       }
    }
+
+   netplay_shared_block_release(block);
 }
 
 /**
@@ -1521,6 +1552,23 @@ static bool netplay_get_cmd(netplay_t *netplay,
             buffer[0] = ntohl(buffer[0]);
             buffer[1] = ntohl(buffer[1]);
 
+            /* The server CRCs every frame that is a multiple of its
+             * check period, which may not be ours, so learn it to keep
+             * the states for those frames */
+            if (buffer[0])
+            {
+               uint32_t a = netplay->server_check_frames;
+               uint32_t b = buffer[0];
+
+               while (b)
+               {
+                  uint32_t t = a % b;
+                  a          = b;
+                  b          = t;
+               }
+               netplay->server_check_frames = a;
+            }
+
             /* Received a CRC for some frame. If we still have it, check if it
              * matched. This approach could be improved with some quick modular
              * arithmetic. */
@@ -1542,14 +1590,23 @@ static bool netplay_get_cmd(netplay_t *netplay,
 
             if (buffer[0] <= netplay->other_frame_count)
             {
+               uint32_t local_crc;
+
+               /* We didn't save it, so can't check it */
+               if (!netplay->buffer[tmp_ptr].have_state)
+                  break;
+
                /* We've already replayed up to this frame, so we can check it
                 * directly */
-               uint32_t local_crc = netplay_delta_frame_crc(
+               local_crc = netplay_delta_frame_crc(
                      netplay, &netplay->buffer[tmp_ptr]);
 
                /* Problem! */
                if (buffer[1] != local_crc)
+               {
+                  netplay->crc_mismatches++;
                   netplay_cmd_request_savestate(netplay);
+               }
             }
             else
             {
@@ -1564,9 +1621,34 @@ static bool netplay_get_cmd(netplay_t *netplay,
          /* Delay until next frame so we don't send the savestate after the
           * input */
          netplay->force_send_savestate = true;
+         netplay->savestate_requests++;
          break;
 
+      case NETPLAY_CMD_SAVESTATE_ACK:
+         {
+            uint32_t buffer[2];
+
+            if (cmd_size != sizeof(buffer))
+            {
+               RARCH_ERR("NETPLAY_CMD_SAVESTATE_ACK received unexpected payload size.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            RECV(buffer, sizeof(buffer))
+            {
+               RARCH_ERR("NETPLAY_CMD_SAVESTATE_ACK failed to receive payload.\n");
+               return netplay_cmd_nak(netplay, connection);
+            }
+
+            /* The next savestate may be a delta against this one */
+            connection->delta_ack_frame = ntohl(buffer[0]);
+            connection->delta_ack_crc   = ntohl(buffer[1]);
+            connection->delta_acked     = true;
+            break;
+         }
+
       case NETPLAY_CMD_LOAD_SAVESTATE:
+      case NETPLAY_CMD_LOAD_SAVESTATE_DELTA:
       case NETPLAY_CMD_RESET:
          {
             uint32_t frame;
@@ -1575,6 +1657,11 @@ static bool netplay_get_cmd(netplay_t *netplay,
             uint32_t client;
             uint32_t load_frame_count;
             size_t load_ptr;
+            uint32_t base[2];
+            uint32_t ack[2];
+            size_t header_size                    = 2*sizeof(uint32_t);
+            bool acked                            = false;
+            enum trans_stream_error error;
             struct compression_transcoder *ctrans = NULL;
             uint32_t                   client_num = (uint32_t)
              (connection - netplay->connections + 1);
@@ -1622,8 +1709,11 @@ static bool netplay_get_cmd(netplay_t *netplay,
              * too many places. */
 
             /* Check the payload size */
-            if ((cmd == NETPLAY_CMD_LOAD_SAVESTATE &&
-                 (cmd_size < 2*sizeof(uint32_t) || cmd_size > netplay->zbuffer_size + 2*sizeof(uint32_t))) ||
+            if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               header_size = 4*sizeof(uint32_t);
+            if ((cmd != NETPLAY_CMD_RESET &&
+                 (cmd_size < header_size || cmd_size > netplay->zbuffer_size + header_size)) ||
+                (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA && !connection->delta_supported) ||
                 (cmd == NETPLAY_CMD_RESET && cmd_size != sizeof(uint32_t)))
             {
                RARCH_ERR("CMD_LOAD_SAVESTATE received an unexpected payload size.\n");
@@ -1661,7 +1751,7 @@ static bool netplay_get_cmd(netplay_t *netplay,
             }
 
             /* Now we switch based on whether we're loading a state or resetting */
-            if (cmd == NETPLAY_CMD_LOAD_SAVESTATE)
+            if (cmd != NETPLAY_CMD_RESET)
             {
                RECV(&isize, sizeof(isize))
                {
@@ -1676,7 +1766,18 @@ static bool netplay_get_cmd(netplay_t *netplay,
                   return netplay_cmd_nak(netplay, connection);
                }
 
-               RECV(netplay->zbuffer, cmd_size - 2*sizeof(uint32_t))
+               if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               {
+                  RECV(base, sizeof(base))
+                  {
+                     RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive delta base.\n");
+                     return netplay_cmd_nak(netplay, connection);
+                  }
+                  base[0] = ntohl(base[0]);
+                  base[1] = ntohl(base[1]);
+               }
+
+               RECV(netplay->zbuffer, cmd_size - header_size)
                {
                   RARCH_ERR("CMD_LOAD_SAVESTATE failed to receive savestate.\n");
                   return netplay_cmd_nak(netplay, connection);
@@ -1692,15 +1793,62 @@ static bool netplay_get_cmd(netplay_t *netplay,
                      ctrans = &netplay->compress_nil;
                }
                ctrans->decompression_backend->set_in(ctrans->decompression_stream,
-                  netplay->zbuffer, cmd_size - 2*sizeof(uint32_t));
-               ctrans->decompression_backend->set_out(ctrans->decompression_stream,
-                  (uint8_t*)netplay->buffer[load_ptr].state,
-                  (unsigned)netplay->state_size);
-               ctrans->decompression_backend->trans(ctrans->decompression_stream,
-                  true, &rd, &wn, NULL);
+                  netplay->zbuffer, (uint32_t)(cmd_size - header_size));
+
+               if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+               {
+                  /* Patch the last savestate this peer sent us. If we don't
+                   * hold it any more, have it sent whole. */
+                  if (netplay->delta_buffer)
+                  {
+                     ctrans->decompression_backend->set_out(
+                        ctrans->decompression_stream, netplay->delta_buffer,
+                        (uint32_t)netplay->delta_buffer_size);
+                     acked = ctrans->decompression_backend->trans(
+                           ctrans->decompression_stream, true, &rd, &wn,
+                           &error);
+                  }
+
+                  if (!acked ||
+                        !netplay_savestate_delta_apply(netplay,
+                           netplay->buffer[load_ptr].state, wn, frame,
+                           base[0], base[1], &ack[1]))
+                  {
+                     RARCH_WARN("[netplay] Savestate delta doesn't apply, requesting the full savestate.\n");
+                     netplay->delta_recv_valid = false;
+                     if (!netplay_send_raw_cmd(netplay, connection,
+                              NETPLAY_CMD_REQUEST_SAVESTATE, NULL, 0))
+                        return netplay_cmd_nak(netplay, connection);
+                     netplay->savestate_request_outstanding = true;
+                     break;
+                  }
+               }
+               else
+               {
+                  ctrans->decompression_backend->set_out(ctrans->decompression_stream,
+                     (uint8_t*)netplay->buffer[load_ptr].state,
+                     (unsigned)netplay->state_size);
+                  ctrans->decompression_backend->trans(ctrans->decompression_stream,
+                     true, &rd, &wn, &error);
+
+                  if (connection->delta_supported)
+                     acked = netplay_savestate_delta_loaded(netplay,
+                           netplay->buffer[load_ptr].state, frame, &ack[1]);
+               }
+
+               /* Deltas may now be sent against this savestate */
+               if (acked)
+               {
+                  ack[0] = htonl(frame);
+                  ack[1] = htonl(ack[1]);
+                  if (!netplay_send_raw_cmd(netplay, connection,
+                           NETPLAY_CMD_SAVESTATE_ACK, ack, sizeof(ack)))
+                     return netplay_cmd_nak(netplay, connection);
+               }
 
                /* Force a rewind to the relevant frame */
-               netplay->force_rewind = true;
+               netplay->buffer[load_ptr].have_state = true;
+               netplay->force_rewind                = true;
             }
             else
             {
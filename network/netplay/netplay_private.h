@@ -89,12 +89,22 @@ typedef uint32_t client_bitmap_t;
 
 /* Compression protocols supported */
 #define NETPLAY_COMPRESSION_ZLIB (1<<0)
+/* Not a compression as such: savestates may be sent as a delta against the
+ * last one the peer acknowledged (NETPLAY_CMD_LOAD_SAVESTATE_DELTA) */
+#define NETPLAY_COMPRESSION_DELTA (1<<1)
 #if HAVE_ZLIB
-#define NETPLAY_COMPRESSION_SUPPORTED NETPLAY_COMPRESSION_ZLIB
+#define NETPLAY_COMPRESSION_SUPPORTED \
+   (NETPLAY_COMPRESSION_ZLIB | NETPLAY_COMPRESSION_DELTA)
 #else
-#define NETPLAY_COMPRESSION_SUPPORTED 0
+#define NETPLAY_COMPRESSION_SUPPORTED NETPLAY_COMPRESSION_DELTA
 #endif
 
+/* Savestate deltas are made of the blocks of this size that changed */
+#define NETPLAY_DELTA_BLOCK_SIZE 64
+
+/* How many shared blocks a connection can have waiting to be sent */
+#define NETPLAY_SHARED_QUEUE_SIZE 32
+
 enum netplay_cmd
 {
    /* Basic commands */
@@ -166,6 +176,14 @@ enum netplay_cmd
    /* Sends over cheats enabled on client (unsupported) */
    NETPLAY_CMD_CHEATS         = 0x0047,
 
+   /* Send a savestate as the changes since the last one the client
+    * acknowledged (only with NETPLAY_COMPRESSION_DELTA) */
+   NETPLAY_CMD_LOAD_SAVESTATE_DELTA = 0x0048,
+
+   /* Acknowledge a loaded savestate, which deltas may now be sent
+    * against (only with NETPLAY_COMPRESSION_DELTA) */
+   NETPLAY_CMD_SAVESTATE_ACK  = 0x0049,
+
    /* Misc. commands */
 
    /* Sends multiple config requests over,
@@ -314,9 +332,29 @@ struct delta_frame
    /* Have we read the real (remote) input? */
    bool have_real[MAX_CLIENTS];
 
+   /* Is the savestate for this frame in state? It's not saved if all input
+    * for the frame was confirmed before it ran. */
+   bool have_state;
+
    bool used; /* a bit derpy, but this is how we know if the delta's been used at all */
 };
 
+/* Output written once and queued for several connections, freed when the
+ * last of them has sent it */
+struct netplay_shared_block
+{
+   unsigned char *data;
+   size_t size;
+   unsigned refcount;
+};
+
+/* A shared block, queued to go out after ring_before more bytes of the ring */
+struct socket_shared_ref
+{
+   struct netplay_shared_block *block;
+   size_t ring_before;
+};
+
 struct socket_buffer
 {
    unsigned char *data;
@@ -324,6 +362,16 @@ struct socket_buffer
    size_t start;
    size_t end;
    size_t read;
+
+   /* Shared blocks waiting to be sent, in order with the ring. shared_sent
+    * is how much of the first has gone, shared_ring how many bytes of the
+    * ring go before the last and shared_bytes how much of them is left. */
+   struct socket_shared_ref shared[NETPLAY_SHARED_QUEUE_SIZE];
+   size_t shared_head;
+   size_t shared_count;
+   size_t shared_sent;
+   size_t shared_ring;
+   size_t shared_bytes;
 };
 
 /* Each connection gets a connection struct */
@@ -349,6 +397,10 @@ struct netplay_connection
    /* What compression does this peer support? */
    uint32_t compression_supported;
 
+   /* Frame and CRC of the last savestate this peer acknowledged */
+   uint32_t delta_ack_frame;
+   uint32_t delta_ack_crc;
+
    /* For the server: When was the last time we requested this client to stall?
     * For the client: How many frames of stall do we have left? */
    uint32_t stall_frame;
@@ -373,6 +425,10 @@ struct netplay_connection
 
    /* Is this connection buffer in use? */
    bool active;
+
+   /* Does this peer take savestate deltas, and has it acknowledged one? */
+   bool delta_supported;
+   bool delta_acked;
 };
 
 /* Compression transcoder */
@@ -398,6 +454,9 @@ struct netplay
    retro_time_t frame_run_time[NETPLAY_FRAME_RUN_TIME_WINDOW];
    retro_time_t frame_run_time_sum, frame_run_time_avg;
 
+   /* Time spent replaying frames to roll back, in all and the last time */
+   retro_time_t rollback_time, rollback_last_time;
+
    struct netplay_connection one_connection; /* Client only */ /* retro_time_t alignment */
 
    /* TCP connection for listening (server only) */
@@ -453,6 +512,16 @@ struct netplay
    uint8_t *zbuffer;
    size_t zbuffer_size;
 
+   /* For savestate deltas: the last savestate we sent, the last one a peer
+    * sent us and the delta itself. Only allocated once a peer supporting
+    * them connects. */
+   uint8_t *delta_send_base;
+   uint8_t *delta_recv_base;
+   uint8_t *delta_buffer;
+   size_t delta_buffer_size;
+   uint32_t delta_send_frame, delta_send_crc;
+   uint32_t delta_recv_frame, delta_recv_crc;
+
    /* The size of our packet buffers */
    size_t packet_buffer_size;
 
@@ -495,6 +564,27 @@ struct netplay
    /* Counter for timeouts */
    unsigned timeout_cnt;
 
+   /* How many frames we saved a savestate for, and how many we didn't need
+    * to */
+   unsigned serialized_frames;
+   unsigned unserialized_frames;
+
+   /* How many times we rolled back, how many frames we replayed doing so,
+    * the most at once and the last time */
+   unsigned rollbacks;
+   unsigned rollback_frames;
+   unsigned rollback_max_frames;
+   unsigned rollback_last_frames;
+
+   /* How many savestates we sent, how many of those were deltas and their
+    * size on the wire, how many times a peer asked us for one and how many
+    * CRC checks failed here */
+   unsigned savestates_sent;
+   unsigned savestate_deltas_sent;
+   uint64_t savestate_bytes;
+   unsigned savestate_requests;
+   unsigned crc_mismatches;
+
    int frame_run_time_ptr;
 
    /* Latency frames; positive to hide network latency, negative to hide input latency */
@@ -503,6 +593,9 @@ struct netplay
    /* Frequency with which to check CRCs */
    int check_frames;
 
+   /* On the client, the period the server's CRCs have come at so far */
+   uint32_t server_check_frames;
+
    /* How far behind did we fall? */
    uint32_t catch_up_behind;
 
@@ -552,6 +645,10 @@ struct netplay
    /* Have we requested a savestate as a sync point? */
    bool savestate_request_outstanding;
 
+   /* Do we hold the base for a savestate delta in each direction? */
+   bool delta_send_valid;
+   bool delta_recv_valid;
+
 
    /* Netplay pausing */
    bool local_paused;
@@ -611,6 +708,29 @@ void netplay_deinit_socket_buffer(struct socket_buffer *sbuf);
 bool netplay_send(struct socket_buffer *sbuf, int sockfd, const void *buf,
    size_t len);
 
+/**
+ * netplay_shared_block_new
+ *
+ * Allocate a shared block of the given size, holding one reference.
+ */
+struct netplay_shared_block *netplay_shared_block_new(size_t size);
+
+/**
+ * netplay_shared_block_release
+ *
+ * Drop a reference to a shared block, freeing it with the last.
+ */
+void netplay_shared_block_release(struct netplay_shared_block *block);
+
+/**
+ * netplay_send_shared
+ *
+ * Queue a shared block for sending after whatever is queued already, taking a
+ * reference to it rather than copying it.
+ */
+bool netplay_send_shared(struct socket_buffer *sbuf, int sockfd,
+   struct netplay_shared_block *block);
+
 /**
  * netplay_send_flush
  *
@@ -677,6 +797,68 @@ uint32_t netplay_delta_frame_crc(netplay_t *netplay, struct delta_frame *delta);
  */
 void netplay_delta_frame_free(struct delta_frame *delta);
 
+/**
+ * netplay_savestate_delta_can_send
+ *
+ * Whether this peer holds the last savestate we sent, so the next one may be
+ * sent as a delta against it.
+ */
+bool netplay_savestate_delta_can_send(netplay_t *netplay,
+      struct netplay_connection *connection);
+
+/**
+ * netplay_savestate_delta_encode
+ *
+ * Encode the blocks of a savestate about to be sent which differ from the
+ * last one sent into netplay->delta_buffer, XORed with it.
+ *
+ * Returns: True with the size of the delta if some peer can take it, false if
+ * none can or the delta wouldn't be much smaller than the savestate.
+ */
+bool netplay_savestate_delta_encode(netplay_t *netplay, const void *state,
+      size_t size, size_t *delta_size);
+
+/**
+ * netplay_savestate_delta_sent
+ *
+ * Remember a savestate just sent to our peers as the base for the next delta.
+ */
+void netplay_savestate_delta_sent(netplay_t *netplay, const void *state,
+      size_t size, uint32_t frame);
+
+/**
+ * netplay_savestate_delta_apply
+ *
+ * Rebuild a savestate for the given frame from the delta in
+ * netplay->delta_buffer and the last savestate a peer sent us, which must be
+ * the one at base_frame with CRC base_crc.
+ *
+ * Returns: True with the CRC of the savestate if the delta applied, false
+ * otherwise, after which no delta applies until a full savestate is loaded.
+ */
+bool netplay_savestate_delta_apply(netplay_t *netplay, void *state,
+      size_t delta_size, uint32_t frame, uint32_t base_frame,
+      uint32_t base_crc, uint32_t *crc);
+
+/**
+ * netplay_savestate_delta_loaded
+ *
+ * Remember a full savestate loaded from a peer as the base for its next
+ * delta.
+ *
+ * Returns: True with the CRC of the savestate to acknowledge it with, false
+ * if we can't hold it.
+ */
+bool netplay_savestate_delta_loaded(netplay_t *netplay, const void *state,
+      uint32_t frame, uint32_t *crc);
+
+/**
+ * netplay_savestate_delta_free
+ *
+ * Free the savestate delta buffers.
+ */
+void netplay_savestate_delta_free(netplay_t *netplay);
+
 /**
  * netplay_input_state_for
  *
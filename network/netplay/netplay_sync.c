@@ -505,9 +505,20 @@ bool netplay_resolve_input(netplay_t *netplay, size_t sim_ptr, bool resim)
    return ret;
 }
 
+/* Not every core writes the whole buffer, and the CRC covers all of it */
+static bool netplay_sync_serialize(retro_ctx_serialize_info_t *serial_info)
+{
+   memset(serial_info->data, 0, serial_info->size);
+   return core_serialize(serial_info);
+}
+
 static void netplay_handle_frame_hash(netplay_t *netplay,
       struct delta_frame *delta)
 {
+   /* Nothing to check */
+   if (!delta->have_state)
+      return;
+
    if (netplay->is_server)
    {
       if (netplay->check_frames &&
@@ -523,6 +534,8 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
       uint32_t local_crc = netplay_delta_frame_crc(netplay, delta);
       if (local_crc != delta->crc)
       {
+         netplay->crc_mismatches++;
+
          /* If the very first check frame is wrong,
           * they probably just don't work */
          if (!netplay->crc_validity_checked)
@@ -544,6 +557,46 @@ static void netplay_handle_frame_hash(netplay_t *netplay,
    }
 }
 
+/**
+ * netplay_sync_needs_state
+ * @netplay              : pointer to netplay object
+ * @delta                : frame about to be run or replayed
+ *
+ * Whether we need the savestate for a frame about to run. We don't if all
+ * input for it has been read, as then it can't be mispredicted and we never
+ * rewind to it, unless it's to be sent or its CRC checked.
+ */
+static bool netplay_sync_needs_state(netplay_t *netplay,
+      struct delta_frame *delta)
+{
+#ifdef DEBUG_NONDETERMINISTIC_CORES
+   return true;
+#else
+   if (delta->frame >= netplay->unread_frame_count)
+      return true;
+
+   if (netplay->force_send_savestate)
+      return true;
+
+   /* The server already sent its CRC for this frame */
+   if (delta->crc)
+      return true;
+
+   /* CRCed on the server, and checked against those CRCs on the client */
+   if (netplay->is_server)
+   {
+      if (netplay->check_frames &&
+            delta->frame % abs(netplay->check_frames) == 0)
+         return true;
+   }
+   else if (netplay->server_check_frames &&
+         delta->frame % netplay->server_check_frames == 0)
+      return true;
+
+   return false;
+#endif
+}
+
 /**
  * netplay_sync_pre_frame
  * @netplay              : pointer to netplay object
@@ -561,15 +614,24 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
       serial_info.data       = netplay->buffer[netplay->run_ptr].state;
       serial_info.size       = netplay->state_size;
 
-      memset(serial_info.data, 0, serial_info.size);
       if ((netplay->quirks & NETPLAY_QUIRK_INITIALIZATION)
             || netplay->run_frame_count == 0)
       {
          /* Don't serialize until it's safe */
       }
       else if (!(netplay->quirks & NETPLAY_QUIRK_NO_SAVESTATES)
-            && core_serialize(&serial_info))
+            && !netplay_sync_needs_state(netplay,
+                  &netplay->buffer[netplay->run_ptr]))
       {
+         /* Nothing will ever load it */
+         netplay->unserialized_frames++;
+      }
+      else if (!(netplay->quirks & NETPLAY_QUIRK_NO_SAVESTATES)
+            && netplay_sync_serialize(&serial_info))
+      {
+         netplay->buffer[netplay->run_ptr].have_state = true;
+         netplay->serialized_frames++;
+
          if (netplay->force_send_savestate && !netplay->stall
                && !netplay->remote_paused)
          {
@@ -580,6 +642,7 @@ bool netplay_sync_pre_frame(netplay_t *netplay)
                memcpy(netplay->buffer[netplay->self_ptr].state,
                   netplay->buffer[netplay->run_ptr].state,
                   netplay->state_size);
+               netplay->buffer[netplay->self_ptr].have_state = true;
                netplay->run_ptr         = netplay->self_ptr;
                netplay->run_frame_count = netplay->self_frame_count;
             }
@@ -789,6 +852,26 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
       netplay->force_reset = false;
    }
 
+   /* Frames that ran with all their input confirmed have no savestate (see
+    * netplay_sync_pre_frame), but what forces a rewind never changes their
+    * input, so it can start from the first frame after them */
+   if (netplay->force_rewind &&
+       !(netplay->quirks & NETPLAY_QUIRK_NO_SAVESTATES) &&
+       !netplay->buffer[netplay->other_ptr].have_state &&
+       netplay->other_frame_count < netplay->run_frame_count)
+   {
+      do
+      {
+         netplay->other_ptr = NEXT_PTR(netplay->other_ptr);
+         netplay->other_frame_count++;
+      } while (!netplay->buffer[netplay->other_ptr].have_state &&
+            netplay->other_frame_count < netplay->run_frame_count);
+
+      /* Nothing that ran needs replaying */
+      if (netplay->other_frame_count == netplay->run_frame_count)
+         netplay->force_rewind = false;
+   }
+
    netplay->replay_ptr = netplay->other_ptr;
    netplay->replay_frame_count = netplay->other_frame_count;
 
@@ -836,10 +919,21 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
        netplay->replay_frame_count < netplay->run_frame_count)
    {
       retro_ctx_serialize_info_t serial_info;
-
-      /* Replay frames. */
+      retro_time_t rollback_start = cpu_features_get_time_usec();
+      uint32_t rollback_frames    = netplay->run_frame_count -
+         netplay->replay_frame_count;
+      size_t first_ptr            = netplay->replay_ptr;
+
+      /* Replay frames. Video and audio are dropped while replaying (see
+       * netplay_should_skip), and the core is told so it can skip rendering
+       * them. */
       netplay->is_replay = true;
 
+#ifdef HAVE_THREADS
+      /* Hold it for the whole replay rather than frame by frame */
+      autosave_lock();
+#endif
+
       /* If we have a keyboard device, we replay the previous frame's input
        * just to assert that the keydown/keyup events work if the core
        * translates them in that way */
@@ -847,13 +941,7 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
       {
          netplay->replay_ptr = PREV_PTR(netplay->replay_ptr);
          netplay->replay_frame_count--;
-#ifdef HAVE_THREADS
-         autosave_lock();
-#endif
          core_run();
-#ifdef HAVE_THREADS
-         autosave_unlock();
-#endif
          netplay->replay_ptr = NEXT_PTR(netplay->replay_ptr);
          netplay->replay_frame_count++;
       }
@@ -882,22 +970,29 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
 
          start                   = cpu_features_get_time_usec();
 
-         /* Remember the current state */
-         memset(serial_info.data, 0, serial_info.size);
-         core_serialize(&serial_info);
+         /* Remember the current state, unless we just loaded it or won't
+          * rewind here again */
+         if (netplay->replay_ptr == first_ptr && ptr->have_state)
+         {
+            /* Already there */
+         }
+         else if (netplay_sync_needs_state(netplay, ptr))
+         {
+            ptr->have_state = netplay_sync_serialize(&serial_info);
+            netplay->serialized_frames++;
+         }
+         else
+         {
+            ptr->have_state = false;
+            netplay->unserialized_frames++;
+         }
          if (netplay->replay_frame_count < netplay->unread_frame_count)
             netplay_handle_frame_hash(netplay, ptr);
 
          /* Re-simulate this frame's input */
          netplay_resolve_input(netplay, netplay->replay_ptr, true);
 
-#ifdef HAVE_THREADS
-         autosave_lock();
-#endif
          core_run();
-#ifdef HAVE_THREADS
-         autosave_unlock();
-#endif
          netplay->replay_ptr = NEXT_PTR(netplay->replay_ptr);
          netplay->replay_frame_count++;
 
@@ -927,9 +1022,23 @@ void netplay_sync_post_frame(netplay_t *netplay, bool stalled)
             netplay->frame_run_time_ptr = 0;
       }
 
+#ifdef HAVE_THREADS
+      autosave_unlock();
+#endif
+
       /* Average our time */
       netplay->frame_run_time_avg   = netplay->frame_run_time_sum / NETPLAY_FRAME_RUN_TIME_WINDOW;
 
+      /* And keep track of how costly rolling back is */
+      netplay->rollbacks++;
+      netplay->rollback_frames      += rollback_frames;
+      netplay->rollback_last_frames  = rollback_frames;
+      netplay->rollback_last_time    =
+         cpu_features_get_time_usec() - rollback_start;
+      netplay->rollback_time        += netplay->rollback_last_time;
+      if (rollback_frames > netplay->rollback_max_frames)
+         netplay->rollback_max_frames = rollback_frames;
+
       if (netplay->unread_frame_count < netplay->run_frame_count)
       {
          netplay->other_ptr         = netplay->unread_ptr;
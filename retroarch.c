@@ -1673,6 +1673,7 @@ typedef struct input_remote_state
 typedef struct input_list_element_t
 {
    int16_t *state;
+   uint8_t *state_read;
    unsigned port;
    unsigned device;
    unsigned index;
@@ -2225,6 +2226,8 @@ struct rarch_state
 
 #ifdef HAVE_RUNAHEAD
    size_t runahead_save_state_size;
+   size_t runahead_ring_frames;
+   size_t runahead_ring_head;
 #endif
 
    jmp_buf error_sjlj_context;              /* 4-byte alignment,
@@ -2297,6 +2300,10 @@ struct rarch_state
 
    unsigned audio_driver_free_samples_buf[
       AUDIO_BUFFER_FREE_SAMPLES_COUNT];
+#ifdef HAVE_AUDIO_THREAD_RING
+   /* Threaded ring underruns as of the last flush */
+   unsigned audio_driver_ring_underruns;
+#endif
    unsigned perf_ptr_rarch;
    unsigned perf_ptr_libretro;
 
@@ -2582,6 +2589,7 @@ struct rarch_state
    bool runahead_available;
    bool runahead_secondary_core_available;
    bool runahead_force_input_dirty;
+   bool runahead_ring_valid;
 #endif
 
 #ifdef HAVE_AUDIOMIXER
@@ -10272,30 +10280,54 @@ static void netplay_force_future(netplay_t *netplay)
 }
 
 /**
- * netplay_send_savestate
+ * netplay_send_savestate_to
  * @netplay              : pointer to netplay object
- * @serial_info          : the savestate being loaded
+ * @cmd                  : NETPLAY_CMD_LOAD_SAVESTATE or
+ *                         NETPLAY_CMD_LOAD_SAVESTATE_DELTA
+ * @data                 : the savestate or delta to send
+ * @size                 : its size
+ * @state_size           : size of the savestate itself
  * @cx                   : compression type
  * @z                    : compression backend to use
+ * @delta_sent           : whether the peers which can take a delta get one
  *
- * Send a loaded savestate to those connected peers using the given compression
- * scheme.
+ * Compress a savestate or delta and send it to the connected peers using the
+ * given compression scheme which should get it.
  */
-void netplay_send_savestate(netplay_t *netplay,
-   retro_ctx_serialize_info_t *serial_info, uint32_t cx,
-   struct compression_transcoder *z)
+static void netplay_send_savestate_to(netplay_t *netplay, uint32_t cmd,
+   const void *data, size_t size, size_t state_size, uint32_t cx,
+   struct compression_transcoder *z, bool delta_sent)
 {
-   uint32_t header[4];
+   uint32_t header[6];
    uint32_t rd, wn;
    size_t i;
+   enum trans_stream_error error;
+   struct netplay_shared_block *block = NULL;
+   size_t header_size = (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+      ? sizeof(header) : 4*sizeof(uint32_t);
+
+   for (i = 0; i < netplay->connections_size; i++)
+   {
+      struct netplay_connection *connection = &netplay->connections[i];
+      if (!connection->active ||
+          connection->mode < NETPLAY_CONNECTION_CONNECTED ||
+          connection->compression_supported != cx) continue;
+      if ((cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA) == (delta_sent &&
+            netplay_savestate_delta_can_send(netplay, connection)))
+         break;
+   }
+
+   /* Nobody to send it to */
+   if (i == netplay->connections_size)
+      return;
 
    /* Compress it */
    z->compression_backend->set_in(z->compression_stream,
-      (const uint8_t*)serial_info->data_const, (uint32_t)serial_info->size);
+      (const uint8_t*)data, (uint32_t)size);
    z->compression_backend->set_out(z->compression_stream,
       netplay->zbuffer, (uint32_t)netplay->zbuffer_size);
    if (!z->compression_backend->trans(z->compression_stream, true, &rd,
-         &wn, NULL))
+         &wn, &error))
    {
       /* Catastrophe! */
       for (i = 0; i < netplay->connections_size; i++)
@@ -10304,10 +10336,19 @@ void netplay_send_savestate(netplay_t *netplay,
    }
 
    /* Send it to relevant peers */
-   header[0] = htonl(NETPLAY_CMD_LOAD_SAVESTATE);
-   header[1] = htonl(wn + 2*sizeof(uint32_t));
+   header[0] = htonl(cmd);
+   header[1] = htonl(wn + header_size - 2*sizeof(uint32_t));
    header[2] = htonl(netplay->run_frame_count);
-   header[3] = htonl(serial_info->size);
+   header[3] = htonl(state_size);
+   header[4] = htonl(netplay->delta_send_frame);
+   header[5] = htonl(netplay->delta_send_crc);
+
+   /* One copy for every peer to send from */
+   if ((block = netplay_shared_block_new(header_size + wn)))
+   {
+      memcpy(block->data, header, header_size);
+      memcpy(block->data + header_size, netplay->zbuffer, wn);
+   }
 
    for (i = 0; i < netplay->connections_size; i++)
    {
@@ -10315,13 +10356,57 @@ void netplay_send_savestate(netplay_t *netplay,
       if (!connection->active ||
           connection->mode < NETPLAY_CONNECTION_CONNECTED ||
           connection->compression_supported != cx) continue;
+      if ((cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA) != (delta_sent &&
+            netplay_savestate_delta_can_send(netplay, connection)))
+         continue;
 
-      if (!netplay_send(&connection->send_packet_buffer, connection->fd, header,
-            sizeof(header)) ||
-          !netplay_send(&connection->send_packet_buffer, connection->fd,
-            netplay->zbuffer, wn))
+      if (block
+            ? !netplay_send_shared(&connection->send_packet_buffer,
+               connection->fd, block)
+            : (!netplay_send(&connection->send_packet_buffer, connection->fd,
+               header, header_size) ||
+               !netplay_send(&connection->send_packet_buffer, connection->fd,
+               netplay->zbuffer, wn)))
+      {
          netplay_hangup(netplay, connection);
+         continue;
+      }
+
+      netplay->savestates_sent++;
+      if (cmd == NETPLAY_CMD_LOAD_SAVESTATE_DELTA)
+         netplay->savestate_deltas_sent++;
+      netplay->savestate_bytes += header_size + wn;
    }
+
+   netplay_shared_block_release(block);
+}
+
+/**
+ * netplay_send_savestate
+ * @netplay              : pointer to netplay object
+ * @serial_info          : the savestate being loaded
+ * @delta                : the savestate as a delta against the last one sent,
+ *                         or NULL
+ * @delta_size           : size of the delta
+ * @cx                   : compression type
+ * @z                    : compression backend to use
+ *
+ * Send a loaded savestate to those connected peers using the given compression
+ * scheme. Peers holding the last savestate we sent get only the delta.
+ */
+void netplay_send_savestate(netplay_t *netplay,
+   retro_ctx_serialize_info_t *serial_info,
+   const void *delta, size_t delta_size, uint32_t cx,
+   struct compression_transcoder *z)
+{
+   if (delta)
+      netplay_send_savestate_to(netplay, NETPLAY_CMD_LOAD_SAVESTATE_DELTA,
+            delta, delta_size, serial_info->size, cx, z, true);
+   /* Everyone else gets it whole, even those which could have taken a
+    * delta if it wasn't worth encoding */
+   netplay_send_savestate_to(netplay, NETPLAY_CMD_LOAD_SAVESTATE,
+         serial_info->data_const, serial_info->size, serial_info->size,
+         cx, z, delta != NULL);
 }
 
 /**
@@ -10338,6 +10423,8 @@ void netplay_load_savestate(netplay_t *netplay,
       retro_ctx_serialize_info_t *serial_info, bool save)
 {
    retro_ctx_serialize_info_t tmp_serial_info;
+   size_t delta_size  = 0;
+   const void *delta  = netplay->delta_buffer;
 
    netplay_force_future(netplay);
 
@@ -10355,12 +10442,16 @@ void netplay_load_savestate(netplay_t *netplay,
                return;
             tmp_serial_info.data_const = tmp_serial_info.data;
             serial_info = &tmp_serial_info;
+            netplay->buffer[netplay->run_ptr].have_state = true;
          }
          else
          {
             if (serial_info->size <= netplay->state_size)
+            {
                memcpy(netplay->buffer[netplay->run_ptr].state,
                      serial_info->data_const, serial_info->size);
+               netplay->buffer[netplay->run_ptr].have_state = true;
+            }
          }
       }
       /* FIXME: This is a critical failure! */
@@ -10379,11 +10470,19 @@ void netplay_load_savestate(netplay_t *netplay,
       return;
 
    /* Send this to every peer */
+   if (!netplay_savestate_delta_encode(netplay, serial_info->data_const,
+            serial_info->size, &delta_size))
+      delta = NULL;
    if (netplay->compress_nil.compression_backend)
-      netplay_send_savestate(netplay, serial_info, 0, &netplay->compress_nil);
+      netplay_send_savestate(netplay, serial_info, delta, delta_size,
+            0, &netplay->compress_nil);
    if (netplay->compress_zlib.compression_backend)
-      netplay_send_savestate(netplay, serial_info, NETPLAY_COMPRESSION_ZLIB,
-         &netplay->compress_zlib);
+      netplay_send_savestate(netplay, serial_info, delta, delta_size,
+            NETPLAY_COMPRESSION_ZLIB, &netplay->compress_zlib);
+
+   /* Which the next one can be a delta against */
+   netplay_savestate_delta_sent(netplay, serial_info->data_const,
+         serial_info->size, netplay->run_frame_count);
 }
 
 /**
@@ -12894,6 +12993,57 @@ static bool command_get_config_param(const char* arg)
    return true;
 }
 
+#ifdef HAVE_NETWORKING
+static bool command_get_netplay_stats(const char* arg)
+{
+   size_t i;
+   char reply[768]             = {0};
+   unsigned connections        = 0;
+   struct rarch_state *p_rarch = &rarch_st;
+   netplay_t          *netplay = p_rarch->netplay_data;
+
+   if (!netplay)
+      snprintf(reply, sizeof(reply), "GET_NETPLAY_STATS INACTIVE\n");
+   else
+   {
+      for (i = 0; i < netplay->connections_size; i++)
+         if (     netplay->connections[i].active
+               && netplay->connections[i].mode >= NETPLAY_CONNECTION_CONNECTED)
+            connections++;
+
+      snprintf(reply, sizeof(reply), "GET_NETPLAY_STATS "
+            "connections=%u,frames=%u,"
+            "rollbacks=%u,rollback_frames=%u,rollback_max_frames=%u,"
+            "rollback_usec=%lld,last_rollback_frames=%u,"
+            "last_rollback_usec=%lld,frame_usec=%lld,"
+            "input_latency_frames=%d,saved_frames=%u,skipped_frames=%u,"
+            "savestates_sent=%u,savestate_deltas_sent=%u,"
+            "savestate_bytes=%llu,savestate_requests=%u,"
+            "crc_mismatches=%u\n",
+            connections,
+            netplay->self_frame_count,
+            netplay->rollbacks,
+            netplay->rollback_frames,
+            netplay->rollback_max_frames,
+            (long long)netplay->rollback_time,
+            netplay->rollback_last_frames,
+            (long long)netplay->rollback_last_time,
+            (long long)netplay->frame_run_time_avg,
+            netplay->input_latency_frames,
+            netplay->serialized_frames,
+            netplay->unserialized_frames,
+            netplay->savestates_sent,
+            netplay->savestate_deltas_sent,
+            (unsigned long long)netplay->savestate_bytes,
+            netplay->savestate_requests,
+            netplay->crc_mismatches);
+   }
+
+   command_reply(p_rarch, reply, strlen(reply));
+   return true;
+}
+#endif
+
 #if defined(HAVE_CHEEVOS)
 static bool command_read_ram(const char *arg);
 static bool command_write_ram(const char *arg);
@@ -12905,6 +13055,9 @@ static const struct cmd_action_map action_map[] = {
    { "GET_STATUS",       command_get_status,       "No argument" },
    { "GET_CONFIG_PARAM", command_get_config_param, "<param name>" },
    { "SHOW_MSG",         command_show_osd_msg,     "No argument" },
+#ifdef HAVE_NETWORKING
+   { "GET_NETPLAY_STATS", command_get_netplay_stats, "No argument" },
+#endif
 #if defined(HAVE_CHEEVOS)
    { "READ_CORE_RAM",   command_read_ram,    "<address> <number of bytes>" },
    { "WRITE_CORE_RAM",  command_write_ram,   "<address> <byte1> <byte2> ..." },
@@ -15975,6 +16128,9 @@ static void runahead_clear_variables(struct rarch_state *p_rarch)
    p_rarch->runahead_secondary_core_available = true;
    p_rarch->runahead_force_input_dirty        = true;
    p_rarch->runahead_last_frame_count         = 0;
+   p_rarch->runahead_ring_frames              = 0;
+   p_rarch->runahead_ring_head                = 0;
+   p_rarch->runahead_ring_valid               = false;
 }
 #endif
 
@@ -16426,6 +16582,10 @@ bool command_event(enum event_command cmd, void *data)
          {
             bool rewind_enable        = settings->bools.rewind_enable;
             unsigned rewind_buf_size  = settings->sizes.rewind_buffer_size;
+            bool rewind_block_delta   = settings->bools.rewind_block_delta;
+            bool rewind_threaded      = settings->bools.rewind_threaded;
+            size_t rewind_spill_size  = (size_t)
+               settings->uints.rewind_spill_size << 20;
 #ifdef HAVE_CHEEVOS
             if (rcheevos_hardcore_active())
                return false;
@@ -16439,7 +16599,16 @@ bool command_event(enum event_command cmd, void *data)
                         RARCH_NETPLAY_CTL_IS_ENABLED, NULL))
 #endif
                {
-                  state_manager_event_init((unsigned)rewind_buf_size);
+                  const char *spill_dir =
+                     settings->paths.directory_cache;
+
+                  /* Fall back to the savestate directory */
+                  if (string_is_empty(spill_dir))
+                     spill_dir = p_rarch->current_savestate_dir;
+
+                  state_manager_event_init((unsigned)rewind_buf_size,
+                        rewind_block_delta, rewind_threaded,
+                        rewind_spill_size, spill_dir);
                }
             }
          }
@@ -16671,11 +16840,27 @@ bool command_event(enum event_command cmd, void *data)
       case CMD_EVENT_CORE_INFO_INIT:
          {
             char ext_name[255];
+            char cache_dir[PATH_MAX_LENGTH];
             const char *dir_libretro       = settings->paths.directory_libretro;
             const char *path_libretro_info = settings->paths.path_libretro_info;
+            const char *dir_cache          = settings->paths.directory_cache;
             bool show_hidden_files         = settings->bools.show_hidden_files;
+            bool core_info_cache_enable    = settings->bools.core_info_cache_enable;
 
             ext_name[0]                    = '\0';
+            cache_dir[0]                   = '\0';
+
+            /* The info directory is often read-only, so the
+             * cache goes with the other caches, or next to
+             * the config file if there is no cache directory */
+            if (core_info_cache_enable)
+            {
+               if (!string_is_empty(dir_cache))
+                  strlcpy(cache_dir, dir_cache, sizeof(cache_dir));
+               else if (!path_is_empty(RARCH_PATH_CONFIG))
+                  fill_pathname_basedir(cache_dir,
+                        path_get(RARCH_PATH_CONFIG), sizeof(cache_dir));
+            }
 
             command_event(CMD_EVENT_CORE_INFO_DEINIT, NULL);
 
@@ -16686,7 +16871,8 @@ bool command_event(enum event_command cmd, void *data)
                core_info_init_list(path_libretro_info,
                      dir_libretro,
                      ext_name,
-                     show_hidden_files
+                     show_hidden_files,
+                     cache_dir
                      );
          }
          break;
@@ -30102,7 +30288,11 @@ static bool audio_driver_init_internal(
    }
 
 #ifdef HAVE_THREADS
+#ifdef HAVE_AUDIO_THREAD_RING
+   if (audio_cb_inited || settings->bools.audio_thread_ring)
+#else
    if (audio_cb_inited)
+#endif
    {
       RARCH_LOG("[Audio]: Starting threaded audio driver ...\n");
       if (!audio_init_thread(
@@ -30113,7 +30303,8 @@ static bool audio_driver_init_internal(
                settings->uints.audio_out_rate, &new_rate,
                settings->uints.audio_latency,
                settings->uints.audio_block_frames,
-               p_rarch->current_audio))
+               p_rarch->current_audio,
+               !audio_cb_inited))
       {
          RARCH_ERR("Cannot open threaded audio driver ... Exiting ...\n");
          retroarch_fail(1, "audio_driver_init_internal()");
@@ -30239,25 +30430,15 @@ error:
    return audio_driver_deinit(p_rarch);
 }
 
-/**
- * audio_driver_flush:
- * @data                 : pointer to audio buffer.
- * @right                : amount of samples to write.
- *
- * Writes audio samples to audio driver. Will first
- * perform DSP processing (if enabled) and resampling.
- **/
-static void audio_driver_flush(
+/* Runs one block of interleaved samples through every
+ * stage of the pipeline (conversion, DSP, resampler, mixer)
+ * and hands the result to the audio driver. */
+static void audio_driver_flush_samples(
       struct rarch_state *p_rarch,
-      float slowmotion_ratio,
-      bool audio_fastforward_mute,
       const int16_t *data, size_t samples,
-      bool is_slowmotion, bool is_fastmotion)
+      float audio_volume_gain, double ratio)
 {
    struct resampler_data src_data;
-   float audio_volume_gain           = (p_rarch->audio_driver_mute_enable ||
-         (audio_fastforward_mute && is_fastmotion)) ?
-               0.0f : p_rarch->audio_driver_volume_gain;
 
    src_data.data_out                 = NULL;
    src_data.output_frames            = 0;
@@ -30292,22 +30473,115 @@ static void audio_driver_flush(
 #endif
 
    src_data.data_out                 = p_rarch->audio_driver_output_samples_buf;
+   src_data.ratio                    = ratio;
+
+   p_rarch->audio_driver_resampler->process(
+         p_rarch->audio_driver_resampler_data, &src_data);
+
+#ifdef HAVE_AUDIOMIXER
+   if (p_rarch->audio_mixer_active)
+   {
+      bool override                       = true;
+      float mixer_gain                    = 0.0f;
+      bool audio_driver_mixer_mute_enable =
+         p_rarch->audio_driver_mixer_mute_enable;
+
+      if (!audio_driver_mixer_mute_enable)
+      {
+         if (p_rarch->audio_driver_mixer_volume_gain == 1.0f)
+            override                      = false;
+         mixer_gain                       =
+            p_rarch->audio_driver_mixer_volume_gain;
+      }
+      audio_mixer_mix(
+            p_rarch->audio_driver_output_samples_buf,
+            src_data.output_frames, mixer_gain, override);
+   }
+#endif
+
+   {
+      const void *output_data = p_rarch->audio_driver_output_samples_buf;
+      unsigned output_frames  = (unsigned)src_data.output_frames;
+
+      if (p_rarch->audio_driver_use_float)
+         output_frames       *= sizeof(float);
+      else
+      {
+         convert_float_to_s16(p_rarch->audio_driver_output_samples_conv_buf,
+               (const float*)output_data, output_frames * 2);
+
+         output_data          = p_rarch->audio_driver_output_samples_conv_buf;
+         output_frames       *= sizeof(int16_t);
+      }
+
+      if (p_rarch->current_audio->write(
+               p_rarch->audio_driver_context_audio_data,
+               output_data, output_frames * 2) < 0)
+         p_rarch->audio_driver_active = false;
+   }
+}
+
+/**
+ * audio_driver_flush:
+ * @data                 : pointer to audio buffer.
+ * @right                : amount of samples to write.
+ *
+ * Writes audio samples to audio driver. Will first
+ * perform DSP processing (if enabled) and resampling.
+ **/
+static void audio_driver_flush(
+      struct rarch_state *p_rarch,
+      float slowmotion_ratio,
+      bool audio_fastforward_mute,
+      const int16_t *data, size_t samples,
+      bool is_slowmotion, bool is_fastmotion)
+{
+   double ratio;
+   float audio_volume_gain           = (p_rarch->audio_driver_mute_enable ||
+         (audio_fastforward_mute && is_fastmotion)) ?
+               0.0f : p_rarch->audio_driver_volume_gain;
 
    if (p_rarch->audio_driver_control)
    {
       /* Readjust the audio input rate. */
       int      half_size           =
          (int)(p_rarch->audio_driver_buffer_size / 2);
-      int      avail               =
-         (int)p_rarch->current_audio->write_avail(
-               p_rarch->audio_driver_context_audio_data);
-      int      delta_mid           = avail - half_size;
-      double   direction           = (double)delta_mid / half_size;
-      double   adjust              = 1.0 +
-         p_rarch->audio_driver_rate_control_delta * direction;
+      int      avail;
+      int      delta_mid;
+      double   direction;
+      double   adjust;
       unsigned write_idx           =
          p_rarch->audio_driver_free_samples_count++ &
          (AUDIO_BUFFER_FREE_SAMPLES_COUNT - 1);
+#ifdef HAVE_AUDIO_THREAD_RING
+      size_t   fill;
+      unsigned underruns;
+
+      if (audio_thread_get_ring_stats(p_rarch->current_audio,
+               p_rarch->audio_driver_context_audio_data,
+               &fill, &underruns))
+      {
+         avail                     =
+            (int)(p_rarch->audio_driver_buffer_size - fill);
+
+         /* The ring ran dry since the last flush, even if it has
+          * been topped up since; steer as if it still were empty */
+         if (underruns != p_rarch->audio_driver_ring_underruns)
+         {
+            p_rarch->audio_driver_ring_underruns = underruns;
+            avail                  = (int)p_rarch->audio_driver_buffer_size;
+         }
+      }
+      else
+#endif
+         avail                     =
+            (int)p_rarch->current_audio->write_avail(
+                  p_rarch->audio_driver_context_audio_data);
+
+      delta_mid                    = avail - half_size;
+      direction                    = (double)delta_mid / half_size;
+      adjust                       = 1.0 +
+         p_rarch->audio_driver_rate_control_delta * direction;
 
       p_rarch->audio_driver_free_samples_buf
          [write_idx]                        = avail;
@@ -30327,10 +30601,10 @@ static void audio_driver_flush(
 #endif
    }
 
-   src_data.ratio           = p_rarch->audio_source_ratio_current;
+   ratio                    = p_rarch->audio_source_ratio_current;
 
    if (is_slowmotion)
-      src_data.ratio       *= slowmotion_ratio;
+      ratio                *= slowmotion_ratio;
 
    /* Note: Ideally we would divide by the user-configured
     * 'fastforward_ratio' when fast forward is enabled,
@@ -30349,50 +30623,26 @@ static void audio_driver_flush(
     * trying to do anything. Just leave the ratio as-is,
     * and hope for the best... */
 
-   p_rarch->audio_driver_resampler->process(
-         p_rarch->audio_driver_resampler_data, &src_data);
-
-#ifdef HAVE_AUDIOMIXER
-   if (p_rarch->audio_mixer_active)
+   /* In fused mode, push the samples through the whole
+    * pipeline in small chunks so that the intermediate
+    * buffers stay in cache between stages. Every stage
+    * is a stream, so the result is the same. */
+   if (p_rarch->configuration_settings->bools.audio_fused_pipeline)
    {
-      bool override                       = true;
-      float mixer_gain                    = 0.0f;
-      bool audio_driver_mixer_mute_enable =
-         p_rarch->audio_driver_mixer_mute_enable;
-
-      if (!audio_driver_mixer_mute_enable)
+      while (samples && p_rarch->audio_driver_active)
       {
-         if (p_rarch->audio_driver_mixer_volume_gain == 1.0f)
-            override                      = false;
-         mixer_gain                       =
-            p_rarch->audio_driver_mixer_volume_gain;
-      }
-      audio_mixer_mix(
-            p_rarch->audio_driver_output_samples_buf,
-            src_data.output_frames, mixer_gain, override);
-   }
-#endif
+         size_t chunk = MIN(samples, AUDIO_FUSED_CHUNK_FRAMES * 2);
 
-   {
-      const void *output_data = p_rarch->audio_driver_output_samples_buf;
-      unsigned output_frames  = (unsigned)src_data.output_frames;
+         audio_driver_flush_samples(p_rarch, data, chunk,
+               audio_volume_gain, ratio);
 
-      if (p_rarch->audio_driver_use_float)
-         output_frames       *= sizeof(float);
-      else
-      {
-         convert_float_to_s16(p_rarch->audio_driver_output_samples_conv_buf,
-               (const float*)output_data, output_frames * 2);
-
-         output_data          = p_rarch->audio_driver_output_samples_conv_buf;
-         output_frames       *= sizeof(int16_t);
+         data        += chunk;
+         samples     -= chunk;
       }
-
-      if (p_rarch->current_audio->write(
-               p_rarch->audio_driver_context_audio_data,
-               output_data, output_frames * 2) < 0)
-         p_rarch->audio_driver_active = false;
    }
+   else
+      audio_driver_flush_samples(p_rarch, data, samples,
+            audio_volume_gain, ratio);
 }
 
 /**
@@ -35738,6 +35988,7 @@ static void *input_list_element_constructor(void)
    element->device             = 0;
    element->index              = 0;
    element->state              = (int16_t*)calloc(256, sizeof(int16_t));
+   element->state_read         = (uint8_t*)calloc(256, sizeof(uint8_t));
    element->state_size         = 256;
 
    return ptr;
@@ -35751,8 +36002,12 @@ static void input_list_element_realloc(
    {
       element->state = (int16_t*)realloc(element->state,
             new_size * sizeof(int16_t));
+      element->state_read = (uint8_t*)realloc(element->state_read,
+            new_size * sizeof(uint8_t));
       memset(&element->state[element->state_size], 0,
             (new_size - element->state_size) * sizeof(int16_t));
+      memset(&element->state_read[element->state_size], 0,
+            (new_size - element->state_size) * sizeof(uint8_t));
       element->state_size = new_size;
    }
 }
@@ -35775,6 +36030,7 @@ static void input_list_element_destructor(void* element_ptr)
       return;
 
    free(element->state);
+   free(element->state_read);
    free(element_ptr);
 }
 
@@ -35801,7 +36057,8 @@ static void input_state_set_last(unsigned port, unsigned device,
       {
          if (id >= element->state_size)
             input_list_element_expand(element, id);
-         element->state[id] = value;
+         element->state[id]      = value;
+         element->state_read[id] = 1;
          return;
       }
    }
@@ -35813,7 +36070,8 @@ static void input_state_set_last(unsigned port, unsigned device,
    element->index     = index;
    if (id >= element->state_size)
       input_list_element_expand(element, id);
-   element->state[id] = value;
+   element->state[id]      = value;
+   element->state_read[id] = 1;
 }
 
 static int16_t input_state_get_last(unsigned port,
@@ -36055,6 +36313,9 @@ static void runahead_error(struct rarch_state *p_rarch)
    runahead_remove_hooks(p_rarch);
    p_rarch->runahead_save_state_size       = 0;
    p_rarch->runahead_save_state_size_known = true;
+   p_rarch->runahead_ring_frames           = 0;
+   p_rarch->runahead_ring_head             = 0;
+   p_rarch->runahead_ring_valid            = false;
 }
 
 static bool runahead_create(struct rarch_state *p_rarch)
@@ -36083,7 +36344,8 @@ static bool runahead_create(struct rarch_state *p_rarch)
    return true;
 }
 
-static bool runahead_save_state(struct rarch_state *p_rarch)
+static bool runahead_save_state_slot(struct rarch_state *p_rarch,
+      size_t slot)
 {
    retro_ctx_serialize_info_t *serialize_info;
    bool okay                       = false;
@@ -36092,7 +36354,7 @@ static bool runahead_save_state(struct rarch_state *p_rarch)
       return false;
 
    serialize_info                  =
-      (retro_ctx_serialize_info_t*)p_rarch->runahead_save_state_list->data[0];
+      (retro_ctx_serialize_info_t*)p_rarch->runahead_save_state_list->data[slot];
 
    p_rarch->request_fast_savestate = true;
    okay                            = core_serialize(serialize_info);
@@ -36105,11 +36367,17 @@ static bool runahead_save_state(struct rarch_state *p_rarch)
    return false;
 }
 
-static bool runahead_load_state(struct rarch_state *p_rarch)
+static bool runahead_save_state(struct rarch_state *p_rarch)
+{
+   return runahead_save_state_slot(p_rarch, 0);
+}
+
+static bool runahead_load_state_slot(struct rarch_state *p_rarch,
+      size_t slot)
 {
    bool okay                                  = false;
    retro_ctx_serialize_info_t *serialize_info = (retro_ctx_serialize_info_t*)
-      p_rarch->runahead_save_state_list->data[0];
+      p_rarch->runahead_save_state_list->data[slot];
    bool last_dirty                            = p_rarch->input_is_dirty;
 
    p_rarch->request_fast_savestate            = true;
@@ -36128,6 +36396,11 @@ static bool runahead_load_state(struct rarch_state *p_rarch)
    return okay;
 }
 
+static bool runahead_load_state(struct rarch_state *p_rarch)
+{
+   return runahead_load_state_slot(p_rarch, 0);
+}
+
 #if HAVE_DYNAMIC
 static bool runahead_load_state_secondary(struct rarch_state *p_rarch)
 {
@@ -36152,14 +36425,15 @@ static bool runahead_load_state_secondary(struct rarch_state *p_rarch)
 }
 #endif
 
-static bool runahead_core_run_use_last_input(struct rarch_state *p_rarch)
+static bool runahead_core_run_with_input(struct rarch_state *p_rarch,
+      retro_input_state_t state_cb)
 {
    struct retro_callbacks *cbs            = &p_rarch->retro_ctx;
    retro_input_poll_t old_poll_function   = cbs->poll_cb;
    retro_input_state_t old_input_function = cbs->state_cb;
 
    cbs->poll_cb                           = retro_input_poll_null;
-   cbs->state_cb                          = input_state_get_last;
+   cbs->state_cb                          = state_cb;
 
    p_rarch->current_core.retro_set_input_poll(cbs->poll_cb);
    p_rarch->current_core.retro_set_input_state(cbs->state_cb);
@@ -36175,9 +36449,190 @@ static bool runahead_core_run_use_last_input(struct rarch_state *p_rarch)
    return true;
 }
 
+static bool runahead_core_run_use_last_input(struct rarch_state *p_rarch)
+{
+   return runahead_core_run_with_input(p_rarch, input_state_get_last);
+}
+
+/* Savestate ring
+ *
+ * Keeps the states following each of the last 'runahead_count'
+ * emulated frames. The oldest entry ('runahead_ring_head') is
+ * the state after the last frame that was run with confirmed
+ * input, the others are predicted with that same input.
+ *
+ * As long as the input read by the core does not change, the
+ * predicted frames remain valid: the core is left on the
+ * newest predicted frame and only one frame has to be emulated
+ * (and one state saved) per video frame, instead of re-running
+ * and reloading 'runahead_count' frames. When the input changes,
+ * the core is rolled back to the oldest entry. */
+
+/* Input callback for the predicted frames of the ring: they
+ * repeat the logged input. An input the core had not read
+ * before is logged at its current value too, or
+ * runahead_input_probe_dirty() would never notice it change
+ * and the misprediction would stay in the ring */
+static int16_t input_state_predicted(unsigned port,
+      unsigned device, unsigned index, unsigned id)
+{
+   unsigned i;
+   int16_t result;
+   struct rarch_state *p_rarch = &rarch_st;
+
+   if (p_rarch->input_state_list)
+   {
+      for (i = 0; i < (unsigned)p_rarch->input_state_list->size; i++)
+      {
+         input_list_element *element =
+            (input_list_element*)p_rarch->input_state_list->data[i];
+
+         if (  (element->port   == port)   &&
+               (element->device == device) &&
+               (element->index  == index))
+         {
+            if (id < element->state_size && element->state_read[id])
+               return element->state[id];
+            break;
+         }
+      }
+   }
+
+   if (!p_rarch->input_state_callback_original)
+      return 0;
+
+   result = p_rarch->input_state_callback_original(
+         port, device, index, id);
+   /*arbitrary limit of up to 65536 elements in state array*/
+   if (id < 65536)
+      input_state_set_last(port, device, index, id, result);
+   return result;
+}
+
+/* Returns true if any input value previously read by the
+ * core differs from its last logged value */
+static bool runahead_input_probe_dirty(struct rarch_state *p_rarch)
+{
+   unsigned i, id;
+   retro_input_state_t state_cb = p_rarch->input_state_callback_original;
+
+   if (!p_rarch->input_state_list || !state_cb)
+      return true;
+
+   for (i = 0; i < (unsigned)p_rarch->input_state_list->size; i++)
+   {
+      input_list_element *element =
+         (input_list_element*)p_rarch->input_state_list->data[i];
+
+      for (id = 0; id < element->state_size; id++)
+      {
+         if (!element->state_read[id])
+            continue;
+         if (state_cb(element->port, element->device,
+                  element->index, id) != element->state[id])
+            return true;
+      }
+   }
+
+   return false;
+}
+
+static bool runahead_ring_run(struct rarch_state *p_rarch,
+      int runahead_count)
+{
+   size_t i;
+   size_t ring_frames   = (size_t)runahead_count;
+   bool force_rollback  = p_rarch->runahead_force_input_dirty;
+
+   /* Poll once for the whole video frame, the core itself
+    * is run with a null poll callback */
+   input_driver_poll();
+   p_rarch->current_core.input_polled = true;
+
+   if (p_rarch->runahead_ring_frames != ring_frames)
+   {
+      mylist_resize(p_rarch->runahead_save_state_list,
+            (int)ring_frames, true);
+      p_rarch->runahead_ring_frames = ring_frames;
+      p_rarch->runahead_ring_head   = 0;
+      p_rarch->runahead_ring_valid  = false;
+   }
+
+   /* Between two calls, input can only be flagged dirty by
+    * the reset/unserialize hooks - the current core state is
+    * then authoritative and the ring has to be rebuilt */
+   if (p_rarch->input_is_dirty)
+      p_rarch->runahead_ring_valid = false;
+
+   if (     p_rarch->runahead_ring_valid
+         && !force_rollback
+         && !runahead_input_probe_dirty(p_rarch))
+   {
+      /* The current (predicted) state becomes the newest entry,
+       * replacing the oldest one */
+      if (!runahead_save_state_slot(p_rarch, p_rarch->runahead_ring_head))
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         return false;
+      }
+      p_rarch->runahead_ring_head = (p_rarch->runahead_ring_head + 1)
+         % ring_frames;
+
+      runahead_core_run_with_input(p_rarch, input_state_with_logging);
+
+      /* The core read an input it had never read before
+       * with a different value than predicted - roll back
+       * on the next frame */
+      p_rarch->runahead_force_input_dirty = p_rarch->input_is_dirty;
+      p_rarch->input_is_dirty             = false;
+      return true;
+   }
+
+   if (p_rarch->runahead_ring_valid)
+   {
+      if (!runahead_load_state_slot(p_rarch, p_rarch->runahead_ring_head))
+      {
+         runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_LOAD_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+         return false;
+      }
+   }
+
+   for (i = 0; i <= ring_frames; i++)
+   {
+      bool last_frame = (i == ring_frames);
+
+      if (!last_frame)
+      {
+         p_rarch->audio_suspended     = true;
+         p_rarch->video_driver_active = false;
+      }
+
+      runahead_core_run_with_input(p_rarch,
+            (i == 0) ? input_state_with_logging : input_state_predicted);
+
+      if (!last_frame)
+      {
+         RUNAHEAD_RESUME_VIDEO();
+         p_rarch->audio_suspended     = false;
+
+         if (!runahead_save_state_slot(p_rarch,
+                  (p_rarch->runahead_ring_head + i) % ring_frames))
+         {
+            runloop_msg_queue_push(msg_hash_to_str(MSG_RUNAHEAD_FAILED_TO_SAVE_STATE), 0, 3 * 60, true, NULL, MESSAGE_QUEUE_ICON_DEFAULT, MESSAGE_QUEUE_CATEGORY_INFO);
+            return false;
+         }
+      }
+   }
+
+   p_rarch->runahead_ring_valid        = true;
+   p_rarch->runahead_force_input_dirty = false;
+   p_rarch->input_is_dirty             = false;
+   return true;
+}
+
 static void do_runahead(
       struct rarch_state *p_rarch,
-      int runahead_count, bool use_secondary)
+      int runahead_count, bool use_secondary, bool use_ring)
 {
    int frame_number        = 0;
    bool last_frame         = false;
@@ -36216,8 +36671,14 @@ static void do_runahead(
          || !have_dynamic
          || !p_rarch->runahead_secondary_core_available)
    {
-      /* TODO: multiple savestates for higher performance
-       * when not using secondary core */
+      if (use_ring)
+      {
+         runahead_ring_run(p_rarch, runahead_count);
+         return;
+      }
+
+      p_rarch->runahead_ring_valid = false;
+
       for (frame_number = 0; frame_number <= runahead_count; frame_number++)
       {
          last_frame      = frame_number == runahead_count;
@@ -36262,6 +36723,8 @@ static void do_runahead(
    else
    {
 #if HAVE_DYNAMIC
+      p_rarch->runahead_ring_valid = false;
+
       if (!secondary_core_ensure_exists(p_rarch))
       {
          secondary_core_destroy(p_rarch);
@@ -38066,6 +38529,8 @@ void retroarch_init_task_queue(void)
    struct rarch_state *p_rarch = &rarch_st;
    settings_t *settings        = p_rarch->configuration_settings;
    bool threaded_enable        = settings->bools.threaded_data_runloop_enable;
+
+   task_queue_set_workers(settings->uints.threaded_data_runloop_workers);
 #else
    bool threaded_enable        = false;
 #endif
@@ -40424,7 +40889,8 @@ int runloop_iterate(void)
          do_runahead(
                p_rarch,
                run_ahead_num_frames,
-               settings->bools.run_ahead_secondary_instance);
+               settings->bools.run_ahead_secondary_instance,
+               settings->bools.run_ahead_state_ring);
       else
 #endif
          core_run();
@@ -0,0 +1,340 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Compiles every slang preset under a directory the way
+ * the D3D and Metal drivers do (glslang, then SPIRV-Cross
+ * reflection and cross-compilation, to GLSL here since no
+ * GPU is involved) and reports how long that takes:
+ *
+ * - serial:   pass by pass with slang_process(), no cache
+ * - parallel: all passes at once with slang_batch_new()
+ *             on one thread per CPU core, no cache
+ * - cached:   the same from a warm shader cache
+ *
+ * Every run must produce the same output as the serial one.
+ *
+ * Usage: slang_bench [shader dir] [cache dir]
+ *
+ * The cache directory must not hold a shader cache yet,
+ * or the run filling it isn't checked against the others. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <file/file_path.h>
+#include <lists/dir_list.h>
+#include <string/stdstring.h>
+#include <features/features_cpu.h>
+
+#include "../../../configuration.h"
+#include "../../../retroarch.h"
+#include "../../../frontend/frontend_driver.h"
+#include "../../../gfx/video_shader_parse.h"
+#include "../../../gfx/drivers_shader/slang_process.h"
+
+static settings_t bench_settings;
+
+settings_t *config_get_ptr(void)
+{
+   return &bench_settings;
+}
+
+/* No video driver or console here, and shader file
+ * watching is off */
+bool video_context_driver_get_flags(gfx_ctx_flags_t *flags)
+{
+   return false;
+}
+
+void frontend_driver_attach_console(void)
+{
+}
+
+void frontend_driver_detach_console(void)
+{
+}
+
+void frontend_driver_watch_path_for_changes(struct string_list *list,
+      int flags, path_change_data_t **change_data)
+{
+}
+
+bool frontend_driver_check_for_path_changes(
+      path_change_data_t *change_data)
+{
+   return false;
+}
+
+/* Everything slang_process() produced for one pass,
+ * to check the cached run against the cold one */
+typedef struct
+{
+   char *vertex;
+   char *fragment;
+   pass_semantics_t semantics;
+} bench_pass_t;
+
+static void bench_pass_free(bench_pass_t *pass)
+{
+   unsigned i;
+
+   free(pass->vertex);
+   free(pass->fragment);
+   free(pass->semantics.textures);
+   for (i = 0; i < SLANG_CBUFFER_MAX; i++)
+      free(pass->semantics.cbuffers[i].uniforms);
+}
+
+static bool bench_pass_equal(const bench_pass_t *a, const bench_pass_t *b)
+{
+   unsigned i;
+
+   if (     !string_is_equal(a->vertex, b->vertex)
+         || !string_is_equal(a->fragment, b->fragment)
+         || a->semantics.format        != b->semantics.format
+         || a->semantics.texture_count != b->semantics.texture_count)
+      return false;
+
+   for (i = 0; i < (unsigned)a->semantics.texture_count; i++)
+   {
+      const texture_sem_t *ta = &a->semantics.textures[i];
+      const texture_sem_t *tb = &b->semantics.textures[i];
+
+      if (     ta->stage_mask != tb->stage_mask
+            || ta->binding    != tb->binding
+            || !string_is_equal(ta->id, tb->id))
+         return false;
+   }
+
+   for (i = 0; i < SLANG_CBUFFER_MAX; i++)
+   {
+      int j;
+      const cbuffer_sem_t *ca = &a->semantics.cbuffers[i];
+      const cbuffer_sem_t *cb = &b->semantics.cbuffers[i];
+
+      if (     ca->stage_mask    != cb->stage_mask
+            || ca->binding       != cb->binding
+            || ca->size          != cb->size
+            || ca->uniform_count != cb->uniform_count)
+         return false;
+
+      for (j = 0; j < ca->uniform_count; j++)
+      {
+         const uniform_sem_t *ua = &ca->uniforms[j];
+         const uniform_sem_t *ub = &cb->uniforms[j];
+
+         if (     ua->size   != ub->size
+               || ua->offset != ub->offset
+               || !string_is_equal(ua->id, ub->id))
+            return false;
+      }
+   }
+
+   return true;
+}
+
+/* Returns the number of passes compiled, or -1 */
+static int bench_preset(const char *path, bench_pass_t *passes,
+      bool batched)
+{
+   unsigned i;
+   char cache_dir[PATH_MAX_LENGTH];
+   semantics_map_t semantics_map;
+   struct video_shader *shader = NULL;
+   slang_batch_t *batch        = NULL;
+   config_file_t *conf         = video_shader_read_preset(path);
+   int ret                     = -1;
+
+   /* No real textures or uniforms to point at */
+   memset(&semantics_map, 0, sizeof(semantics_map));
+
+   if (!conf)
+      return -1;
+
+   if (!(shader = (struct video_shader*)calloc(1, sizeof(*shader))))
+      goto end;
+
+   if (!video_shader_read_conf_preset(conf, shader))
+      goto end;
+
+   if (batched)
+   {
+      video_shader_get_cache_dir(cache_dir, sizeof(cache_dir));
+      batch = slang_batch_new(shader, RARCH_SHADER_GLSL, 330, cache_dir,
+            video_shader_get_compile_threads());
+   }
+
+   for (i = 0; i < shader->passes; i++)
+   {
+      bool ok;
+
+      memset(&passes[i], 0, sizeof(passes[i]));
+
+      if (batched)
+         ok = slang_batch_process(batch, i,
+               &semantics_map, &passes[i].semantics);
+      else
+         ok = slang_process(shader, i, RARCH_SHADER_GLSL, 330,
+               &semantics_map, &passes[i].semantics);
+
+      if (!ok)
+      {
+         while (i--)
+            bench_pass_free(&passes[i]);
+         goto end;
+      }
+
+      passes[i].vertex   = shader->pass[i].source.string.vertex;
+      passes[i].fragment = shader->pass[i].source.string.fragment;
+   }
+
+   ret = (int)shader->passes;
+
+end:
+   slang_batch_free(batch);
+   free(shader);
+   config_file_free(conf);
+   return ret;
+}
+
+enum bench_mode
+{
+   BENCH_SERIAL = 0,
+   BENCH_PARALLEL,
+   BENCH_FILL_CACHE,
+   BENCH_CACHED,
+   BENCH_MODES
+};
+
+/* Runs a preset in one mode, checking the result against
+ * the serial run, which is kept in reference */
+static retro_time_t bench_run(const char *path, enum bench_mode mode,
+      bench_pass_t *reference, int *reference_passes, unsigned *mismatched)
+{
+   static bench_pass_t passes[GFX_MAX_SHADERS];
+   int i, count;
+   retro_time_t start;
+   retro_time_t time;
+
+   bench_settings.bools.video_shader_cache_enable =
+         mode == BENCH_FILL_CACHE || mode == BENCH_CACHED;
+   bench_settings.uints.video_shader_compile_threads =
+         mode == BENCH_SERIAL ? 1 : 0;
+
+   start = cpu_features_get_time_usec();
+   count = bench_preset(path, mode == BENCH_SERIAL ? reference : passes,
+         mode != BENCH_SERIAL);
+   time  = cpu_features_get_time_usec() - start;
+
+   if (mode == BENCH_SERIAL)
+   {
+      *reference_passes = count;
+      return count < 0 ? -1 : time;
+   }
+
+   if (count != *reference_passes)
+   {
+      for (i = 0; i < count; i++)
+         bench_pass_free(&passes[i]);
+      (*mismatched)++;
+      return -1;
+   }
+
+   for (i = 0; i < count; i++)
+   {
+      if (!bench_pass_equal(&reference[i], &passes[i]))
+      {
+         fprintf(stderr, "%s: pass %d differs (run %d)\n",
+               path, i, (int)mode);
+         (*mismatched)++;
+      }
+      bench_pass_free(&passes[i]);
+   }
+
+   return time;
+}
+
+int main(int argc, char *argv[])
+{
+   size_t i;
+   const char *shader_dir   = argc > 1 ? argv[1] : "shaders";
+   const char *cache_dir    = argc > 2 ? argv[2] : "slang_bench_cache";
+   struct string_list *list = NULL;
+   retro_time_t total[BENCH_MODES] = {0};
+   unsigned failed          = 0;
+   unsigned mismatched      = 0;
+   unsigned presets         = 0;
+
+   strlcpy(bench_settings.paths.directory_cache, cache_dir,
+         sizeof(bench_settings.paths.directory_cache));
+
+   if (!(list = dir_list_new(shader_dir, "slangp",
+               false, false, false, true)))
+   {
+      fprintf(stderr, "Usage: %s [shader dir] [cache dir]\n", argv[0]);
+      return 1;
+   }
+
+   dir_list_sort(list, true);
+
+   printf("%12s %12s %12s\n", "serial", "parallel", "cached");
+
+   for (i = 0; i < list->size; i++)
+   {
+      static bench_pass_t reference[GFX_MAX_SHADERS];
+      int j;
+      int passes = -1;
+      retro_time_t times[BENCH_MODES];
+      const char *path = list->elems[i].data;
+
+      for (j = 0; j < BENCH_MODES; j++)
+      {
+         times[j] = bench_run(path, (enum bench_mode)j,
+               reference, &passes, &mismatched);
+         if (times[j] < 0)
+            break;
+      }
+
+      for (j = 0; j < passes; j++)
+         bench_pass_free(&reference[j]);
+
+      if (passes < 0 || times[BENCH_MODES - 1] < 0)
+      {
+         fprintf(stderr, "Failed to compile %s\n", path);
+         failed++;
+         continue;
+      }
+
+      printf("%9.1f ms %9.1f ms %9.1f ms %3d passes  %s\n",
+            times[BENCH_SERIAL]   / 1000.0,
+            times[BENCH_PARALLEL] / 1000.0,
+            times[BENCH_CACHED]   / 1000.0,
+            passes, path);
+
+      for (j = 0; j < BENCH_MODES; j++)
+         total[j] += times[j];
+      presets++;
+   }
+
+   printf("%9.1f ms %9.1f ms %9.1f ms  %u presets\n",
+         total[BENCH_SERIAL]   / 1000.0,
+         total[BENCH_PARALLEL] / 1000.0,
+         total[BENCH_CACHED]   / 1000.0,
+         presets);
+
+   string_list_free(list);
+
+   return (failed || mismatched) ? 1 : 0;
+}
@@ -0,0 +1,1098 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Runs a netplay session on loopback with no video, audio or
+ * input drivers: one host and N clients, all playing the
+ * deterministic netplay_test core, and reports how netplay did.
+ *
+ * Netplay state is global to a RetroArch process, so each peer
+ * is a retroarch of its own. Every client talks to the host
+ * through a proxy here, which delays what it forwards by the
+ * given latency plus up to the given jitter and counts bytes.
+ * Each peer gets random, seeded joypad input as remote gamepad
+ * packets, and is polled for GET_NETPLAY_STATS over the network
+ * command interface, which gives the rollbacks, savestates and
+ * CRC mismatches reported at the end, with the CPU time each
+ * peer took per frame over the whole run.
+ *
+ * Fails if a peer quits or never connects, or if any CRC check
+ * fails, as the test core is deterministic. Logs are kept in a
+ * directory under /tmp.
+ *
+ * With -d, client1 runs the core with its netplay_test_desync
+ * option set, so it keeps desyncing and the host has to send it
+ * savestates. Then the run must see both delta and whole
+ * savestates go out, and once the host holds start, which stops
+ * the desyncs, client1 must come back and stay in sync while
+ * every other peer never left it.
+ *
+ * Usage: netplay_loopback [options] [retroarch] [core]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+#include <boolean.h>
+#include <libretro.h>
+#include <features/features_cpu.h>
+
+#define LOOPBACK_MAX_CLIENTS  8
+#define LOOPBACK_CHUNK_SIZE   65536
+#define LOOPBACK_WARMUP_USEC  2000000
+#define LOOPBACK_CONNECT_USEC 20000000
+#define LOOPBACK_STATS_USEC   500000
+#define LOOPBACK_SETTLE_USEC  1500000
+#define LOOPBACK_STEADY_USEC  3000000
+
+/* Must match struct remote_message in retroarch.c */
+struct remote_message
+{
+   int port;
+   int device;
+   int index;
+   int id;
+   uint16_t state;
+};
+
+enum lb_stat
+{
+   LB_CONNECTIONS = 0,
+   LB_FRAMES,
+   LB_ROLLBACKS,
+   LB_ROLLBACK_FRAMES,
+   LB_ROLLBACK_MAX_FRAMES,
+   LB_ROLLBACK_USEC,
+   LB_FRAME_USEC,
+   LB_SAVESTATES_SENT,
+   LB_SAVESTATE_DELTAS_SENT,
+   LB_SAVESTATE_BYTES,
+   LB_SAVESTATE_REQUESTS,
+   LB_CRC_MISMATCHES,
+   LB_STATS
+};
+
+static const char *lb_stat_names[LB_STATS] = {
+   "connections",
+   "frames",
+   "rollbacks",
+   "rollback_frames",
+   "rollback_max_frames",
+   "rollback_usec",
+   "frame_usec",
+   "savestates_sent",
+   "savestate_deltas_sent",
+   "savestate_bytes",
+   "savestate_requests",
+   "crc_mismatches"
+};
+
+typedef struct
+{
+   long long value[LB_STATS];
+   retro_time_t time;
+   bool valid;
+} lb_stats_t;
+
+/* Data waiting to be forwarded until it's due */
+typedef struct lb_chunk
+{
+   struct lb_chunk *next;
+   retro_time_t due;
+   size_t len;
+   size_t pos;
+   uint8_t data[];
+} lb_chunk_t;
+
+/* One direction of a proxied connection */
+typedef struct
+{
+   lb_chunk_t *head;
+   lb_chunk_t *tail;
+   retro_time_t last_due;
+   uint64_t bytes;
+   int in;
+   int out;
+} lb_pipe_t;
+
+typedef struct
+{
+   lb_pipe_t up;   /* client to host */
+   lb_pipe_t down; /* host to client */
+   uint64_t up_start;
+   uint64_t down_start;
+   int listen_fd;
+   bool open;
+} lb_link_t;
+
+typedef struct
+{
+   lb_stats_t stats;
+   lb_stats_t start;
+   lb_stats_t settled;
+   retro_time_t next_input;
+   retro_time_t cpu_usec;
+   pid_t pid;
+   unsigned cmd_port;
+   unsigned remote_port;
+   uint16_t buttons;
+   bool exited;
+} lb_peer_t;
+
+typedef struct
+{
+   const char *retroarch;
+   const char *core;
+   unsigned clients;
+   unsigned spectators;
+   unsigned seconds;
+   unsigned latency_ms;
+   unsigned jitter_ms;
+   unsigned inputs;
+   unsigned state_size;
+   unsigned base_port;
+   unsigned desync;
+   int check_frames;
+   uint32_t seed;
+} lb_options_t;
+
+static lb_peer_t lb_peers[LOOPBACK_MAX_CLIENTS + 1];
+static lb_link_t lb_links[LOOPBACK_MAX_CLIENTS];
+static char lb_dir[64];
+static uint32_t lb_seed;
+
+static uint32_t lb_rand(void)
+{
+   lb_seed ^= lb_seed << 13;
+   lb_seed ^= lb_seed >> 17;
+   lb_seed ^= lb_seed << 5;
+   return lb_seed;
+}
+
+static void lb_peer_name(unsigned i, char *s, size_t len)
+{
+   if (i == 0)
+      snprintf(s, len, "host");
+   else
+      snprintf(s, len, "client%u", i);
+}
+
+static bool lb_write_config(const lb_options_t *opts, unsigned i)
+{
+   char name[16];
+   char path[128];
+   FILE *f;
+
+   lb_peer_name(i, name, sizeof(name));
+   snprintf(path, sizeof(path), "%s/%s.cfg", lb_dir, name);
+
+   if (!(f = fopen(path, "w")))
+      return false;
+
+   /* With no video driver to wait for, vrr_runloop_enable
+    * is what holds the run loop to the core's 60 fps */
+   fprintf(f,
+         "video_driver = \"null\"\n"
+         "audio_driver = \"null\"\n"
+         "input_driver = \"null\"\n"
+         "input_joypad_driver = \"null\"\n"
+         "menu_driver = \"null\"\n"
+         "vrr_runloop_enable = \"true\"\n"
+         "config_save_on_exit = \"false\"\n"
+         "network_cmd_enable = \"true\"\n"
+         "network_cmd_port = \"%u\"\n"
+         "network_remote_enable = \"true\"\n"
+         "network_remote_enable_user_p1 = \"true\"\n"
+         "network_remote_base_port = \"%u\"\n"
+         "netplay_nickname = \"%s\"\n"
+         "netplay_start_as_spectator = \"%s\"\n"
+         "netplay_check_frames = \"%d\"\n"
+         "netplay_nat_traversal = \"false\"\n"
+         "netplay_public_announce = \"false\"\n"
+         "global_core_options = \"true\"\n"
+         "game_specific_options = \"false\"\n"
+         "core_options_path = \"%s/%s.opt\"\n"
+         "rgui_config_directory = \"%s\"\n"
+         "savefile_directory = \"%s\"\n"
+         "savestate_directory = \"%s\"\n"
+         "system_directory = \"%s\"\n"
+         "content_history_path = \"%s/%s.lpl\"\n",
+         lb_peers[i].cmd_port, lb_peers[i].remote_port, name,
+         i > opts->clients - opts->spectators ? "true" : "false",
+         opts->check_frames, lb_dir, name,
+         lb_dir, lb_dir, lb_dir, lb_dir, lb_dir, name);
+
+   fclose(f);
+
+   snprintf(path, sizeof(path), "%s/%s.opt", lb_dir, name);
+
+   if (!(f = fopen(path, "w")))
+      return false;
+
+   if (i == 1 && opts->desync)
+      fprintf(f, "netplay_test_desync = \"%u\"\n", opts->desync);
+   else
+      fprintf(f, "netplay_test_desync = \"disabled\"\n");
+
+   fclose(f);
+   return true;
+}
+
+static pid_t lb_spawn(const lb_options_t *opts, unsigned i, unsigned port)
+{
+   char name[16];
+   char cfg[128];
+   char log[128];
+   char port_str[16];
+   pid_t pid;
+
+   lb_peer_name(i, name, sizeof(name));
+   snprintf(cfg, sizeof(cfg), "%s/%s.cfg", lb_dir, name);
+   snprintf(log, sizeof(log), "%s/%s.log", lb_dir, name);
+   snprintf(port_str, sizeof(port_str), "%u", port);
+
+   if ((pid = fork()) == 0)
+   {
+      int fd = open(log, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+      if (fd >= 0)
+      {
+         dup2(fd, STDOUT_FILENO);
+         dup2(fd, STDERR_FILENO);
+         close(fd);
+      }
+
+      if (i == 0)
+         execl(opts->retroarch, opts->retroarch, "--config", cfg,
+               "-L", opts->core, "--verbose", "--host",
+               "--port", port_str, (char*)NULL);
+      else
+         execl(opts->retroarch, opts->retroarch, "--config", cfg,
+               "-L", opts->core, "--verbose", "--connect", "127.0.0.1",
+               "--port", port_str, (char*)NULL);
+      _exit(127);
+   }
+
+   return pid;
+}
+
+static void lb_set_nonblock(int fd)
+{
+   int one = 1;
+
+   fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+   setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+static void lb_addr(struct sockaddr_in *addr, unsigned port)
+{
+   memset(addr, 0, sizeof(*addr));
+   addr->sin_family      = AF_INET;
+   addr->sin_port        = htons(port);
+   addr->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+}
+
+/* Listens on a free port for a client, returning the port */
+static unsigned lb_link_listen(lb_link_t *link)
+{
+   struct sockaddr_in addr;
+   socklen_t len = sizeof(addr);
+
+   memset(link, 0, sizeof(*link));
+   link->up.in = link->up.out = link->down.in = link->down.out = -1;
+
+   lb_addr(&addr, 0);
+   if (     (link->listen_fd = socket(AF_INET, SOCK_STREAM, 0)) < 0
+         || bind(link->listen_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0
+         || listen(link->listen_fd, 1) < 0
+         || getsockname(link->listen_fd, (struct sockaddr*)&addr, &len) < 0)
+      return 0;
+
+   return ntohs(addr.sin_port);
+}
+
+static bool lb_link_accept(lb_link_t *link, unsigned host_port)
+{
+   struct sockaddr_in addr;
+   int client = accept(link->listen_fd, NULL, NULL);
+   int host   = socket(AF_INET, SOCK_STREAM, 0);
+
+   lb_addr(&addr, host_port);
+   if (     client < 0 || host < 0
+         || connect(host, (struct sockaddr*)&addr, sizeof(addr)) < 0)
+   {
+      if (client >= 0)
+         close(client);
+      if (host >= 0)
+         close(host);
+      return false;
+   }
+
+   lb_set_nonblock(client);
+   lb_set_nonblock(host);
+
+   close(link->listen_fd);
+   link->listen_fd = -1;
+   link->up.in     = link->down.out = client;
+   link->up.out    = link->down.in  = host;
+   link->open      = true;
+   return true;
+}
+
+static void lb_link_close(lb_link_t *link)
+{
+   lb_pipe_t *pipes[2];
+   unsigned i;
+
+   pipes[0] = &link->up;
+   pipes[1] = &link->down;
+
+   for (i = 0; i < 2; i++)
+   {
+      while (pipes[i]->head)
+      {
+         lb_chunk_t *next = pipes[i]->head->next;
+         free(pipes[i]->head);
+         pipes[i]->head = next;
+      }
+      pipes[i]->tail = NULL;
+   }
+
+   if (link->up.in >= 0)
+      close(link->up.in);
+   if (link->up.out >= 0)
+      close(link->up.out);
+   if (link->listen_fd >= 0)
+      close(link->listen_fd);
+   link->up.in = link->up.out = link->down.in = link->down.out = -1;
+   link->listen_fd = -1;
+   link->open      = false;
+}
+
+/* Reads what's there and queues it to go out after the delay.
+ * A chunk is never due before the one ahead of it, as with a
+ * real stream, where one late segment holds up the rest. */
+static bool lb_pipe_read(lb_pipe_t *pipe, const lb_options_t *opts,
+      retro_time_t now)
+{
+   for (;;)
+   {
+      uint8_t buf[LOOPBACK_CHUNK_SIZE];
+      lb_chunk_t *chunk;
+      ssize_t len = read(pipe->in, buf, sizeof(buf));
+
+      if (len == 0)
+         return false;
+      if (len < 0)
+         return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+      if (!(chunk = (lb_chunk_t*)malloc(sizeof(*chunk) + len)))
+         return false;
+
+      memcpy(chunk->data, buf, len);
+      chunk->next = NULL;
+      chunk->len  = len;
+      chunk->pos  = 0;
+      chunk->due  = now + opts->latency_ms * 1000 +
+         (opts->jitter_ms ? lb_rand() % (opts->jitter_ms * 1000 + 1) : 0);
+      if (chunk->due < pipe->last_due)
+         chunk->due = pipe->last_due;
+      pipe->last_due = chunk->due;
+      pipe->bytes   += len;
+
+      if (pipe->tail)
+         pipe->tail->next = chunk;
+      else
+         pipe->head       = chunk;
+      pipe->tail          = chunk;
+   }
+}
+
+static bool lb_pipe_write(lb_pipe_t *pipe, retro_time_t now)
+{
+   while (pipe->head && pipe->head->due <= now)
+   {
+      lb_chunk_t *chunk = pipe->head;
+      ssize_t len       = write(pipe->out, chunk->data + chunk->pos,
+            chunk->len - chunk->pos);
+
+      if (len < 0)
+         return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+      if ((chunk->pos += len) < chunk->len)
+         break;
+
+      if (!(pipe->head = chunk->next))
+         pipe->tail = NULL;
+      free(chunk);
+   }
+
+   return true;
+}
+
+static void lb_send_button(int udp, const lb_peer_t *peer, int id,
+      uint16_t state)
+{
+   struct remote_message msg;
+   struct sockaddr_in addr;
+
+   memset(&msg, 0, sizeof(msg));
+   msg.port   = 0;
+   msg.device = RETRO_DEVICE_JOYPAD;
+   msg.index  = 0;
+   msg.id     = id;
+   msg.state  = state;
+
+   lb_addr(&addr, peer->remote_port);
+   sendto(udp, (const char*)&msg, sizeof(msg), 0,
+         (struct sockaddr*)&addr, sizeof(addr));
+}
+
+static void lb_send_input(int udp, lb_peer_t *peer, const lb_options_t *opts,
+      retro_time_t now)
+{
+   /* Leave out select and start */
+   static const int ids[] = {
+      RETRO_DEVICE_ID_JOYPAD_B,     RETRO_DEVICE_ID_JOYPAD_Y,
+      RETRO_DEVICE_ID_JOYPAD_UP,    RETRO_DEVICE_ID_JOYPAD_DOWN,
+      RETRO_DEVICE_ID_JOYPAD_LEFT,  RETRO_DEVICE_ID_JOYPAD_RIGHT,
+      RETRO_DEVICE_ID_JOYPAD_A,     RETRO_DEVICE_ID_JOYPAD_X
+   };
+   int id = ids[lb_rand() % (sizeof(ids) / sizeof(*ids))];
+
+   peer->buttons ^= 1 << id;
+   lb_send_button(udp, peer, id, (peer->buttons >> id) & 1);
+
+   /* Anywhere up to twice the mean interval */
+   peer->next_input = now + (retro_time_t)(lb_rand() %
+         (2000000 / opts->inputs + 1));
+}
+
+static void lb_request_stats(int udp, unsigned peers)
+{
+   unsigned i;
+
+   for (i = 0; i < peers; i++)
+   {
+      struct sockaddr_in addr;
+      static const char cmd[] = "GET_NETPLAY_STATS";
+
+      lb_addr(&addr, lb_peers[i].cmd_port);
+      sendto(udp, cmd, sizeof(cmd) - 1, 0,
+            (struct sockaddr*)&addr, sizeof(addr));
+   }
+}
+
+static void lb_read_stats(int udp, unsigned peers, retro_time_t now)
+{
+   char reply[1024];
+   struct sockaddr_in addr;
+   socklen_t addr_len = sizeof(addr);
+   ssize_t len;
+
+   while ((len = recvfrom(udp, reply, sizeof(reply) - 1, MSG_DONTWAIT,
+               (struct sockaddr*)&addr, &addr_len)) > 0)
+   {
+      unsigned i;
+      char *tok, *save;
+      lb_peer_t *peer = NULL;
+
+      for (i = 0; i < peers; i++)
+         if (lb_peers[i].cmd_port == ntohs(addr.sin_port))
+            peer = &lb_peers[i];
+
+      reply[len] = '\0';
+      addr_len   = sizeof(addr);
+
+      if (!peer || strncmp(reply, "GET_NETPLAY_STATS ", 18)
+            || !strncmp(reply + 18, "INACTIVE", 8))
+         continue;
+
+      for (tok = strtok_r(reply + 18, ",\n", &save); tok;
+            tok = strtok_r(NULL, ",\n", &save))
+      {
+         char *eq = strchr(tok, '=');
+
+         if (!eq)
+            continue;
+         *eq = '\0';
+
+         for (i = 0; i < LB_STATS; i++)
+            if (!strcmp(tok, lb_stat_names[i]))
+               peer->stats.value[i] = strtoll(eq + 1, NULL, 10);
+      }
+
+      peer->stats.time  = now;
+      peer->stats.valid = true;
+   }
+}
+
+/* Whether every peer has reported since the given time */
+static bool lb_stats_fresh(unsigned peers, retro_time_t since)
+{
+   unsigned i;
+
+   for (i = 0; i < peers; i++)
+      if (lb_peers[i].stats.time <= since)
+         return false;
+
+   return true;
+}
+
+static bool lb_reap(unsigned peers)
+{
+   unsigned i;
+   bool ok = true;
+
+   for (i = 0; i < peers; i++)
+   {
+      int status;
+
+      if (lb_peers[i].exited)
+         ok = false;
+      else if (waitpid(lb_peers[i].pid, &status, WNOHANG) == lb_peers[i].pid)
+      {
+         char name[16];
+
+         lb_peer_name(i, name, sizeof(name));
+         fprintf(stderr, "%s quit (status %d), see %s/%s.log\n",
+               name, status, lb_dir, name);
+         lb_peers[i].exited = true;
+         ok                 = false;
+      }
+   }
+
+   return ok;
+}
+
+static void lb_wait(lb_peer_t *peer, int options)
+{
+   struct rusage usage;
+
+   if (wait4(peer->pid, NULL, options, &usage) != peer->pid)
+      return;
+
+   peer->cpu_usec = (retro_time_t)
+        (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000
+      + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+   peer->exited   = true;
+}
+
+static void lb_shutdown(unsigned peers)
+{
+   unsigned i;
+   retro_time_t deadline = cpu_features_get_time_usec() + 5000000;
+
+   for (i = 0; i < peers; i++)
+      if (!lb_peers[i].exited)
+         kill(lb_peers[i].pid, SIGTERM);
+
+   for (i = 0; i < peers; i++)
+   {
+      while (!lb_peers[i].exited)
+      {
+         lb_wait(&lb_peers[i], WNOHANG);
+
+         if (lb_peers[i].exited)
+            break;
+
+         if (cpu_features_get_time_usec() > deadline)
+         {
+            kill(lb_peers[i].pid, SIGKILL);
+            lb_wait(&lb_peers[i], 0);
+         }
+         else
+            usleep(10000);
+      }
+   }
+}
+
+static void lb_report(const lb_options_t *opts, unsigned peers,
+      retro_time_t elapsed)
+{
+   unsigned i;
+   double secs      = elapsed / 1000000.0;
+   long long frames = lb_peers[0].stats.value[LB_FRAMES]
+      - lb_peers[0].start.value[LB_FRAMES];
+
+   printf("%u client(s) (%u spectating), %.1f s, %u ms latency, "
+         "%u ms jitter, %u byte state, seed %u\n\n",
+         opts->clients, opts->spectators, secs, opts->latency_ms,
+         opts->jitter_ms, opts->state_size, (unsigned)opts->seed);
+
+   printf("%-8s %7s %11s %10s %4s %11s %8s %8s %10s %6s %9s %8s %8s\n",
+         "", "frames", "rollbacks/s", "replayed/s", "max", "rollback ms",
+         "frame us", "cpu us/f", "savestates", "deltas", "state KiB",
+         "requests", "crc fail");
+
+   for (i = 0; i < peers; i++)
+   {
+      char name[16];
+      const long long *v = lb_peers[i].stats.value;
+      const long long *s = lb_peers[i].start.value;
+
+      lb_peer_name(i, name, sizeof(name));
+      printf("%-8s %7lld %11.2f %10.2f %4lld %11.1f %8lld %8.1f %10lld "
+            "%6lld %9.1f %8lld %8lld\n",
+            name,
+            v[LB_FRAMES] - s[LB_FRAMES],
+            (v[LB_ROLLBACKS] - s[LB_ROLLBACKS]) / secs,
+            (v[LB_ROLLBACK_FRAMES] - s[LB_ROLLBACK_FRAMES]) / secs,
+            v[LB_ROLLBACK_MAX_FRAMES],
+            (v[LB_ROLLBACK_USEC] - s[LB_ROLLBACK_USEC]) / 1000.0,
+            v[LB_FRAME_USEC],
+            v[LB_FRAMES] ? (double)lb_peers[i].cpu_usec / v[LB_FRAMES] : 0.0,
+            v[LB_SAVESTATES_SENT] - s[LB_SAVESTATES_SENT],
+            v[LB_SAVESTATE_DELTAS_SENT] - s[LB_SAVESTATE_DELTAS_SENT],
+            (v[LB_SAVESTATE_BYTES] - s[LB_SAVESTATE_BYTES]) / 1024.0,
+            v[LB_SAVESTATE_REQUESTS] - s[LB_SAVESTATE_REQUESTS],
+            v[LB_CRC_MISMATCHES]);
+   }
+
+   /* Per frame the host ran */
+   printf("\n%-8s %12s %12s\n", "", "to host B/f", "to client B/f");
+
+   for (i = 0; i < opts->clients; i++)
+   {
+      char name[16];
+      const lb_link_t *link = &lb_links[i];
+
+      lb_peer_name(i + 1, name, sizeof(name));
+      printf("%-8s %12.1f %12.1f\n", name,
+            frames ? (double)(link->up.bytes - link->up_start) / frames : 0.0,
+            frames ? (double)(link->down.bytes - link->down_start) / frames
+            : 0.0);
+   }
+}
+
+static void lb_usage(const char *name)
+{
+   fprintf(stderr,
+         "Usage: %s [options] [retroarch] [core]\n"
+         "  -c <n>     clients (1-%u, default 2)\n"
+         "  -w <n>     of which spectating (default 0)\n"
+         "  -t <s>     seconds to measure for (default 30)\n"
+         "  -l <ms>    one-way latency (default 30)\n"
+         "  -j <ms>    jitter on top of it (default 10)\n"
+         "  -i <n>     input changes per second per player (default 4)\n"
+         "  -k <bytes> test core state size (default 65536)\n"
+         "  -f <n>     netplay_check_frames (default 30)\n"
+         "  -p <port>  first of the ports to use (default 55400)\n"
+         "  -s <seed>  input and jitter seed (default 1)\n"
+         "  -d <n>     desync client1 every n frames (30, 60, 120, 240 "
+         "or 480)\n",
+         name, LOOPBACK_MAX_CLIENTS);
+}
+
+int main(int argc, char *argv[])
+{
+   int opt;
+   unsigned i;
+   char state_size[16];
+   lb_options_t opts;
+   unsigned peers;
+   int udp;
+   retro_time_t now;
+   retro_time_t next_stats   = 0;
+   retro_time_t spawned_at   = 0;
+   retro_time_t connected_at = 0;
+   retro_time_t started_at   = 0;
+   retro_time_t stopped_at   = 0;
+   retro_time_t settled_at   = 0;
+   retro_time_t ended_at     = 0;
+   retro_time_t run_usec;
+   bool ok                   = true;
+   bool done                 = false;
+
+   memset(&opts, 0, sizeof(opts));
+   opts.retroarch    = "../../../retroarch";
+   opts.core         = "./netplay_test_libretro.so";
+   opts.clients      = 2;
+   opts.seconds      = 30;
+   opts.latency_ms   = 30;
+   opts.jitter_ms    = 10;
+   opts.inputs       = 4;
+   opts.state_size   = 65536;
+   opts.base_port    = 55400;
+   opts.check_frames = 30;
+   opts.seed         = 1;
+
+   while ((opt = getopt(argc, argv, "c:w:t:l:j:i:k:f:p:s:d:h")) != -1)
+   {
+      switch (opt)
+      {
+         case 'c': opts.clients      = atoi(optarg); break;
+         case 'w': opts.spectators   = atoi(optarg); break;
+         case 't': opts.seconds      = atoi(optarg); break;
+         case 'l': opts.latency_ms   = atoi(optarg); break;
+         case 'j': opts.jitter_ms    = atoi(optarg); break;
+         case 'i': opts.inputs       = atoi(optarg); break;
+         case 'k': opts.state_size   = atoi(optarg); break;
+         case 'f': opts.check_frames = atoi(optarg); break;
+         case 'p': opts.base_port    = atoi(optarg); break;
+         case 's': opts.seed         = strtoul(optarg, NULL, 0); break;
+         case 'd': opts.desync       = atoi(optarg); break;
+         default:
+            lb_usage(argv[0]);
+            return 1;
+      }
+   }
+
+   if (optind < argc)
+      opts.retroarch = argv[optind++];
+   if (optind < argc)
+      opts.core = argv[optind++];
+
+   if (     opts.clients < 1 || opts.clients > LOOPBACK_MAX_CLIENTS
+         || opts.spectators > opts.clients
+         || opts.seconds < 1 || opts.inputs < 1
+         || (opts.desync && (opts.spectators >= opts.clients
+            || (opts.desync != 30 && opts.desync != 60
+               && opts.desync != 120 && opts.desync != 240
+               && opts.desync != 480)))
+         || access(opts.retroarch, X_OK) || access(opts.core, R_OK))
+   {
+      lb_usage(argv[0]);
+      return 1;
+   }
+
+   lb_seed  = opts.seed ? opts.seed : 1;
+   peers    = opts.clients + 1;
+   run_usec = (retro_time_t)opts.seconds * 1000000;
+   if (opts.desync)
+      run_usec += LOOPBACK_SETTLE_USEC + LOOPBACK_STEADY_USEC;
+
+   for (i = 0; i < opts.clients; i++)
+   {
+      lb_links[i].listen_fd = -1;
+      lb_links[i].up.in     = lb_links[i].up.out   = -1;
+      lb_links[i].down.in   = lb_links[i].down.out = -1;
+   }
+
+   snprintf(lb_dir, sizeof(lb_dir), "/tmp/netplay_loopback.XXXXXX");
+   if (!mkdtemp(lb_dir))
+   {
+      perror("mkdtemp");
+      return 1;
+   }
+
+   signal(SIGPIPE, SIG_IGN);
+   snprintf(state_size, sizeof(state_size), "%u", opts.state_size);
+   setenv("NETPLAY_TEST_STATE_SIZE", state_size, 1);
+
+   if ((udp = socket(AF_INET, SOCK_DGRAM, 0)) < 0)
+   {
+      perror("socket");
+      return 1;
+   }
+
+   /* The host plays on opts.base_port, the network commands
+    * and remote gamepads of each peer are above it */
+   for (i = 0; i < peers; i++)
+   {
+      lb_peers[i].cmd_port    = opts.base_port + 1 + i;
+      lb_peers[i].remote_port = opts.base_port + 1 + peers + i;
+
+      if (!lb_write_config(&opts, i))
+      {
+         fprintf(stderr, "Can't write configs to %s\n", lb_dir);
+         return 1;
+      }
+   }
+
+   lb_peers[0].pid = lb_spawn(&opts, 0, opts.base_port);
+
+   /* Wait for the host to come up before pointing clients at it */
+   now = cpu_features_get_time_usec();
+   while (!lb_peers[0].stats.valid && ok)
+   {
+      if (cpu_features_get_time_usec() - now > LOOPBACK_CONNECT_USEC)
+         ok = false;
+      lb_request_stats(udp, 1);
+      usleep(100000);
+      lb_read_stats(udp, 1, cpu_features_get_time_usec());
+      ok = ok && lb_reap(1);
+   }
+
+   for (i = 0; i < opts.clients && ok; i++)
+   {
+      unsigned port = lb_link_listen(&lb_links[i]);
+
+      if (!port)
+      {
+         perror("listen");
+         ok = false;
+         break;
+      }
+
+      lb_peers[i + 1].pid = lb_spawn(&opts, i + 1, port);
+   }
+
+   if (ok)
+      printf("Logs are in %s\n", lb_dir);
+   else
+      fprintf(stderr, "The host didn't start, see %s/host.log\n", lb_dir);
+
+   spawned_at = cpu_features_get_time_usec();
+   for (i = 0; i < peers; i++)
+      lb_peers[i].next_input = spawned_at;
+
+   while (ok)
+   {
+      struct pollfd fds[2 * LOOPBACK_MAX_CLIENTS + 1];
+      lb_pipe_t *pipes[2 * LOOPBACK_MAX_CLIENTS];
+      retro_time_t wake;
+      unsigned nfds = 0;
+      bool all_connected;
+
+      now  = cpu_features_get_time_usec();
+      wake = now + 10000;
+
+      if (!(ok = lb_reap(peers)))
+         break;
+
+      /* Stats */
+      if (now >= next_stats)
+      {
+         lb_request_stats(udp, peers);
+         next_stats = now + LOOPBACK_STATS_USEC;
+      }
+      lb_read_stats(udp, peers, now);
+
+      /* The host is connected to every client, each client
+       * to the host */
+      all_connected = true;
+      for (i = 0; i < peers; i++)
+         all_connected = all_connected && lb_peers[i].stats.valid
+            && lb_peers[i].stats.value[LB_CONNECTIONS]
+            >= (i ? 1 : opts.clients);
+
+      if (!connected_at)
+      {
+         if (all_connected)
+            connected_at = now;
+         else if (now - spawned_at > LOOPBACK_CONNECT_USEC)
+         {
+            fprintf(stderr, "Not every client connected\n");
+            ok = false;
+            break;
+         }
+      }
+      else if (!all_connected)
+      {
+         fprintf(stderr, "A client disconnected\n");
+         ok = false;
+         break;
+      }
+
+      if (connected_at && !started_at
+            && now - connected_at >= LOOPBACK_WARMUP_USEC)
+      {
+         /* Stats from before now are stale, wait for fresh ones */
+         if (lb_stats_fresh(peers, connected_at
+                  + LOOPBACK_WARMUP_USEC - LOOPBACK_STATS_USEC))
+         {
+            started_at = now;
+            for (i = 0; i < peers; i++)
+               lb_peers[i].start = lb_peers[i].stats;
+            for (i = 0; i < opts.clients; i++)
+            {
+               lb_links[i].up_start   = lb_links[i].up.bytes;
+               lb_links[i].down_start = lb_links[i].down.bytes;
+            }
+         }
+      }
+
+      /* Holding start stops the desyncs, then client1 gets a while
+       * to come back into sync before it has to stay there */
+      if (opts.desync && started_at && !stopped_at
+            && now - started_at >= (retro_time_t)opts.seconds * 1000000)
+      {
+         lb_send_button(udp, &lb_peers[0], RETRO_DEVICE_ID_JOYPAD_START, 1);
+         stopped_at = now;
+      }
+
+      if (stopped_at && !settled_at
+            && lb_stats_fresh(peers, stopped_at + LOOPBACK_SETTLE_USEC))
+      {
+         settled_at = now;
+         for (i = 0; i < peers; i++)
+            lb_peers[i].settled = lb_peers[i].stats;
+      }
+
+      if (started_at && !ended_at && now - started_at >= run_usec)
+      {
+         ended_at   = now;
+         next_stats = now;
+      }
+
+      if (ended_at && lb_stats_fresh(peers, ended_at))
+      {
+         done = true;
+         break;
+      }
+
+      /* Input */
+      for (i = 0; i < peers; i++)
+      {
+         if (now >= lb_peers[i].next_input)
+            lb_send_input(udp, &lb_peers[i], &opts, now);
+         if (lb_peers[i].next_input < wake)
+            wake = lb_peers[i].next_input;
+      }
+
+      /* Proxies */
+      for (i = 0; i < opts.clients; i++)
+      {
+         lb_link_t *link = &lb_links[i];
+         unsigned j;
+
+         if (!link->open)
+         {
+            if (link->listen_fd >= 0)
+            {
+               fds[nfds].fd      = link->listen_fd;
+               fds[nfds].events  = POLLIN;
+               pipes[nfds++]     = NULL;
+            }
+            continue;
+         }
+
+         for (j = 0; j < 2; j++)
+         {
+            lb_pipe_t *pipe = j ? &link->down : &link->up;
+
+            if (!lb_pipe_write(pipe, now))
+            {
+               ok = false;
+               break;
+            }
+
+            fds[nfds].fd     = pipe->in;
+            fds[nfds].events = POLLIN;
+            pipes[nfds++]    = pipe;
+
+            if (pipe->head && pipe->head->due < wake)
+               wake = pipe->head->due;
+         }
+      }
+
+      if (!ok)
+      {
+         fprintf(stderr, "A proxy connection failed\n");
+         break;
+      }
+
+      fds[nfds].fd     = udp;
+      fds[nfds].events = POLLIN;
+
+      poll(fds, nfds + 1,
+            wake > now ? (int)((wake - now + 999) / 1000) : 0);
+
+      now = cpu_features_get_time_usec();
+
+      for (i = 0; i < nfds; i++)
+      {
+         if (!(fds[i].revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+
+         if (!pipes[i])
+         {
+            unsigned j;
+
+            for (j = 0; j < opts.clients; j++)
+               if (lb_links[j].listen_fd == fds[i].fd
+                     && !lb_link_accept(&lb_links[j], opts.base_port))
+                  ok = false;
+         }
+         else if (!lb_pipe_read(pipes[i], &opts, now))
+         {
+            fprintf(stderr, "A peer hung up\n");
+            ok = false;
+         }
+      }
+   }
+
+   lb_shutdown(peers);
+
+   /* After the peers quit, for their CPU time */
+   if (done)
+      lb_report(&opts, peers, ended_at - started_at);
+
+   for (i = 0; i < opts.clients; i++)
+      lb_link_close(&lb_links[i]);
+   close(udp);
+
+   if (!ok)
+      return 1;
+
+   if (opts.desync)
+   {
+      const long long *v = lb_peers[0].stats.value;
+      const long long *s = lb_peers[0].start.value;
+      long long deltas   = v[LB_SAVESTATE_DELTAS_SENT]
+         - s[LB_SAVESTATE_DELTAS_SENT];
+      long long whole    = v[LB_SAVESTATES_SENT] - s[LB_SAVESTATES_SENT]
+         - deltas;
+
+      if (lb_peers[1].stats.value[LB_CRC_MISMATCHES]
+            == lb_peers[1].start.value[LB_CRC_MISMATCHES])
+      {
+         fprintf(stderr, "client1 never desynced\n");
+         ok = false;
+      }
+
+      if (!deltas || !whole)
+      {
+         fprintf(stderr, "The host sent %lld delta and %lld whole "
+               "savestate(s), it should send both\n", deltas, whole);
+         ok = false;
+      }
+
+      if (     !settled_at
+            || lb_peers[1].stats.value[LB_CRC_MISMATCHES]
+            != lb_peers[1].settled.value[LB_CRC_MISMATCHES])
+      {
+         fprintf(stderr, "client1 didn't come back into sync\n");
+         ok = false;
+      }
+   }
+
+   /* Only client1 may have desynced */
+   for (i = 0; i < peers; i++)
+   {
+      if (     lb_peers[i].stats.value[LB_CRC_MISMATCHES]
+            && !(opts.desync && i == 1))
+      {
+         fprintf(stderr, "CRC mismatches, netplay desynced\n");
+         ok = false;
+         break;
+      }
+   }
+
+   return ok ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+/*  RetroArch - A frontend for libretro.
+ *
+ *  RetroArch is free software: you can redistribute it and/or modify it under the terms
+ *  of the GNU General Public License as published by the Free Software Found-
+ *  ation, either version 3 of the License, or (at your option) any later version.
+ *
+ *  RetroArch is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ *  without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR
+ *  PURPOSE.  See the GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License along with RetroArch.
+ *  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A deterministic core for netplay_loopback. It needs no content
+ * and its state is a block of memory of which every frame rewrites
+ * a few words, mixing in the joypad of every port, so any input
+ * netplay gets wrong shows up as a CRC mismatch.
+ *
+ * NETPLAY_TEST_STATE_SIZE sets the size of the state in bytes,
+ * to see how netplay copes with larger cores.
+ *
+ * The netplay_test_desync core option makes a peer flip a bit
+ * of its state on about one frame in that many, so that only it
+ * desyncs and netplay has to bring it back with savestates. It
+ * holds off for the first TEST_DESYNC_AFTER frames, as netplay
+ * gives up on CRCs for good if the very first check fails, and
+ * stops while player 1 holds start, so a test can check that
+ * the peer comes back into sync. */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libretro.h>
+#include <retro_inline.h>
+
+#define TEST_PORTS       4
+#define TEST_WIDTH       64
+#define TEST_HEIGHT      64
+#define TEST_SAMPLES     (44100 / 60)
+#define TEST_WORDS_FRAME 16
+#define TEST_DESYNC_AFTER 300
+
+static retro_environment_t environ_cb;
+static retro_video_refresh_t video_cb;
+static retro_audio_sample_batch_t audio_batch_cb;
+static retro_input_poll_t input_poll_cb;
+static retro_input_state_t input_state_cb;
+
+static uint32_t *test_state;
+static size_t test_state_words;
+static unsigned test_desync;
+static unsigned test_runs;
+static uint32_t test_frame[TEST_WIDTH * TEST_HEIGHT];
+static int16_t test_audio[TEST_SAMPLES * 2];
+
+static INLINE uint32_t test_mix(uint32_t x)
+{
+   x ^= x >> 16;
+   x *= 0x7feb352d;
+   x ^= x >> 15;
+   x *= 0x846ca68b;
+   x ^= x >> 16;
+   return x;
+}
+
+static void test_check_variables(void)
+{
+   struct retro_variable var;
+
+   var.key     = "netplay_test_desync";
+   var.value   = NULL;
+   test_desync = 0;
+
+   if (environ_cb(RETRO_ENVIRONMENT_GET_VARIABLE, &var) && var.value)
+      test_desync = (unsigned)strtoul(var.value, NULL, 10);
+}
+
+void retro_set_environment(retro_environment_t cb)
+{
+   static const struct retro_variable vars[] = {
+      { "netplay_test_desync",
+         "Desync every N frames; disabled|30|60|120|240|480" },
+      { NULL, NULL },
+   };
+   bool no_content = true;
+
+   environ_cb = cb;
+   cb(RETRO_ENVIRONMENT_SET_SUPPORT_NO_GAME, &no_content);
+   cb(RETRO_ENVIRONMENT_SET_VARIABLES, (void*)vars);
+}
+
+void retro_set_video_refresh(retro_video_refresh_t cb) { video_cb = cb; }
+void retro_set_audio_sample(retro_audio_sample_t cb) { }
+void retro_set_audio_sample_batch(retro_audio_sample_batch_t cb) { audio_batch_cb = cb; }
+void retro_set_input_poll(retro_input_poll_t cb) { input_poll_cb = cb; }
+void retro_set_input_state(retro_input_state_t cb) { input_state_cb = cb; }
+void retro_set_controller_port_device(unsigned port, unsigned device) { }
+
+void retro_init(void)
+{
+   const char *size = getenv("NETPLAY_TEST_STATE_SIZE");
+
+   test_state_words = (size ? (size_t)strtoul(size, NULL, 0) : 65536) / 4;
+   if (test_state_words < TEST_WORDS_FRAME)
+      test_state_words = TEST_WORDS_FRAME;
+   test_state = (uint32_t*)calloc(test_state_words, sizeof(*test_state));
+}
+
+void retro_deinit(void)
+{
+   free(test_state);
+   test_state = NULL;
+}
+
+unsigned retro_api_version(void)
+{
+   return RETRO_API_VERSION;
+}
+
+void retro_get_system_info(struct retro_system_info *info)
+{
+   memset(info, 0, sizeof(*info));
+   info->library_name     = "netplay_test";
+   info->library_version  = "1.0";
+   info->need_fullpath    = false;
+   info->valid_extensions = NULL;
+}
+
+void retro_get_system_av_info(struct retro_system_av_info *info)
+{
+   memset(info, 0, sizeof(*info));
+   info->timing.fps            = 60.0;
+   info->timing.sample_rate    = 44100.0;
+   info->geometry.base_width   = TEST_WIDTH;
+   info->geometry.base_height  = TEST_HEIGHT;
+   info->geometry.max_width    = TEST_WIDTH;
+   info->geometry.max_height   = TEST_HEIGHT;
+   info->geometry.aspect_ratio = 1.0f;
+}
+
+void retro_reset(void)
+{
+   memset(test_state, 0, test_state_words * sizeof(*test_state));
+}
+
+void retro_run(void)
+{
+   unsigned i, port;
+   uint32_t input = 0;
+   uint32_t frame;
+
+   input_poll_cb();
+
+   for (port = 0; port < TEST_PORTS; port++)
+   {
+      uint32_t buttons = 0;
+
+      for (i = 0; i <= RETRO_DEVICE_ID_JOYPAD_R3; i++)
+         if (input_state_cb(port, RETRO_DEVICE_JOYPAD, 0, i))
+            buttons |= 1 << i;
+
+      input |= (buttons & 0xff) << (port * 8);
+   }
+
+   /* Word 0 counts frames; which words change after it
+    * depends on the whole state so far */
+   frame         = ++test_state[0];
+   for (i = 0; i < TEST_WORDS_FRAME; i++)
+   {
+      size_t word = 1 + test_mix(frame * TEST_WORDS_FRAME + i
+            + test_state[1]) % (test_state_words - 1);
+      test_state[word] = test_mix(test_state[word] ^ input ^ i);
+      test_state[1]   ^= test_state[word];
+   }
+
+   /* Which frames go wrong depends only on the frame, so replays
+    * of them go wrong the same way */
+   if (     test_desync && ++test_runs > TEST_DESYNC_AFTER
+         && !(input & (1 << RETRO_DEVICE_ID_JOYPAD_START))
+         && test_mix(frame ^ 0x9e3779b9) % test_desync == 0)
+      test_state[1 + frame % (test_state_words - 1)] ^= 1;
+
+   for (i = 0; i < TEST_WIDTH * TEST_HEIGHT; i++)
+      test_frame[i] = test_state[i % test_state_words];
+
+   video_cb(test_frame, TEST_WIDTH, TEST_HEIGHT,
+         TEST_WIDTH * sizeof(*test_frame));
+   audio_batch_cb(test_audio, TEST_SAMPLES);
+}
+
+size_t retro_serialize_size(void)
+{
+   return test_state_words * sizeof(*test_state);
+}
+
+bool retro_serialize(void *data, size_t size)
+{
+   if (size < retro_serialize_size())
+      return false;
+   memcpy(data, test_state, retro_serialize_size());
+   return true;
+}
+
+bool retro_unserialize(const void *data, size_t size)
+{
+   if (size < retro_serialize_size())
+      return false;
+   memcpy(test_state, data, retro_serialize_size());
+   return true;
+}
+
+bool retro_load_game(const struct retro_game_info *game)
+{
+   enum retro_pixel_format fmt = RETRO_PIXEL_FORMAT_XRGB8888;
+
+   if (!environ_cb(RETRO_ENVIRONMENT_SET_PIXEL_FORMAT, &fmt))
+      return false;
+
+   test_check_variables();
+   test_runs = 0;
+   retro_reset();
+   return true;
+}
+
+bool retro_load_game_special(unsigned type,
+      const struct retro_game_info *info, size_t num)
+{
+   return false;
+}
+
+void retro_unload_game(void)
+{
+}
+
+unsigned retro_get_region(void)
+{
+   return RETRO_REGION_NTSC;
+}
+
+void *retro_get_memory_data(unsigned id)
+{
+   return NULL;
+}
+
+size_t retro_get_memory_size(unsigned id)
+{
+   return 0;
+}
+
+void retro_cheat_reset(void)
+{
+}
+
+void retro_cheat_set(unsigned index, bool enabled, const char *code)
+{
+}
@@ -1111,6 +1111,7 @@ void *task_push_core_updater_download(
    strlcat(task_title, download_handle->display_name, sizeof(task_title));
 
    task->handler          = task_core_updater_download_handler;
+   task->priority         = TASK_PRIORITY_BULK;
    task->state            = download_handle;
    task->mute             = mute;
    task->title            = strdup(task_title);
@@ -1519,6 +1520,7 @@ void task_push_update_installed_cores(
 
    /* Configure task */
    task->handler          = task_update_installed_cores_handler;
+   task->priority         = TASK_PRIORITY_BULK;
    task->state            = update_installed_handle;
    task->title            = strdup(msg_hash_to_str(MSG_FETCHING_CORE_LIST));
    task->alternative_look = true;
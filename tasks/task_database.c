@@ -27,6 +27,11 @@
 #include <streams/file_stream.h>
 #include <streams/chd_stream.h>
 #include <streams/interface_stream.h>
+#include <features/features_cpu.h>
+#ifdef HAVE_THREADS
+#include <rthreads/rthreads.h>
+#include <rthreads/tpool.h>
+#endif
 #include "tasks_internal.h"
 
 #include "../core_info.h"
@@ -46,6 +51,8 @@
 typedef struct database_state_handle
 {
    database_info_list_t *info;
+   database_info_index_t *index;
+   database_info_cache_t *cache; /* Databases kept open for the scan */
    struct string_list *list;
    uint8_t *buf;
    size_t list_index;
@@ -56,18 +63,63 @@ typedef struct database_state_handle
    char serial[4096];
 } database_state_handle_t;
 
+#ifdef HAVE_THREADS
+/* Entries each worker may be hashed ahead of the matching */
+#define DATABASE_SCAN_AHEAD 4
+
+struct database_scan_pipeline;
+
+typedef struct database_scan_job
+{
+   struct database_scan_pipeline *pipeline;
+   char *path;          /* Own copy, entries can be pruned meanwhile */
+   size_t index;        /* Entry of the content list */
+   uint32_t crc;
+   uint32_t archive_crc;
+   enum database_type type;
+   int ret;
+   bool busy;
+   bool done;
+   char serial[4096];
+} database_scan_job_t;
+
+/* Hashing and serial extraction run on a pool of workers,
+ * a bounded number of entries ahead of the task, which
+ * matches the results against the databases and writes
+ * the playlists in list order. */
+typedef struct database_scan_pipeline
+{
+   tpool_t *pool;
+   slock_t *lock;
+   scond_t *cond;
+   database_scan_job_t *jobs; /* Ring, entry i goes to slot i % slots */
+   size_t slots;
+   size_t next;               /* Next entry to hand out */
+   retro_time_t start_time;
+   retro_time_t walk_time;
+   unsigned hashed;           /* Guarded by lock */
+   unsigned matched;
+} database_scan_pipeline_t;
+#endif
+
 typedef struct db_handle
 {
    char *playlist_directory;
    char *content_database_path;
    char *fullpath;
    database_info_handle_t *handle;
+#ifdef HAVE_THREADS
+   database_scan_pipeline_t *pipeline;
+#endif
    database_state_handle_t state;
    playlist_config_t playlist_config; /* size_t alignment */
+   retro_time_t scan_start_time;
    unsigned status;
+   unsigned scan_workers;
    bool is_directory;
    bool scan_started;
    bool scan_without_core_match;
+   bool scan_hash_index;
    bool show_hidden_files;
 } db_handle_t;
 
@@ -111,7 +163,7 @@ static const char *database_info_get_current_element_name(
 
 static int task_database_iterate_start(retro_task_t *task,
       database_info_handle_t *db,
-      const char *name)
+      const char *name, const char *stats)
 {
    char msg[256];
    const char *basename_path = !string_is_empty(name) ?
@@ -120,11 +172,12 @@ static int task_database_iterate_start(retro_task_t *task,
    msg[0] = '\0';
 
    snprintf(msg, sizeof(msg),
-         STRING_REP_USIZE "/" STRING_REP_USIZE ": %s %s...\n",
+         STRING_REP_USIZE "/" STRING_REP_USIZE ": %s %s...%s\n",
          (size_t)db->list_ptr,
          (size_t)db->list->size,
          msg_hash_to_str(MSG_SCANNING),
-         basename_path);
+         basename_path,
+         stats ? stats : "");
 
    if (!string_is_empty(msg))
    {
@@ -557,73 +610,289 @@ static enum msg_file_type extension_to_file_type(const char *ext)
    return FILE_TYPE_NONE;
 }
 
-static int task_database_iterate_playlist(
-      database_state_handle_t *db_state,
-      database_info_handle_t *db, const char *name)
+/* Drops the track files of a CUE/GDI sheet from the content list */
+static void task_database_prune(database_info_handle_t *db,
+      const char *name)
+{
+   switch (extension_to_file_type(path_get_extension(name)))
+   {
+      case FILE_TYPE_CUE:
+         task_database_cue_prune(db, name);
+         break;
+      case FILE_TYPE_GDI:
+         gdi_prune(db, name);
+         break;
+      default:
+         break;
+   }
+}
+
+/* Works out how @name is looked up and reads the CRC or serial
+ * for it. Only touches its arguments, so it can run off the
+ * task thread. */
+static int task_database_get_file_info(const char *name,
+      enum database_type *type, uint32_t *crc, uint32_t *archive_crc,
+      char *serial)
 {
    switch (extension_to_file_type(path_get_extension(name)))
    {
       case FILE_TYPE_COMPRESSED:
 #ifdef HAVE_COMPRESSION
-         db->type = DATABASE_TYPE_CRC_LOOKUP;
+         *type = DATABASE_TYPE_CRC_LOOKUP;
          /* first check crc of archive itself */
          return intfstream_file_get_crc(name,
-               0, SIZE_MAX, &db_state->archive_crc);
+               0, SIZE_MAX, archive_crc);
 #else
          break;
 #endif
       case FILE_TYPE_CUE:
-         task_database_cue_prune(db, name);
-         db_state->serial[0] = '\0';
-         if (task_database_cue_get_serial(name, db_state->serial))
-            db->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         serial[0] = '\0';
+         if (task_database_cue_get_serial(name, serial))
+            *type = DATABASE_TYPE_SERIAL_LOOKUP;
          else
          {
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-            return task_database_cue_get_crc(name, &db_state->crc);
+            *type = DATABASE_TYPE_CRC_LOOKUP;
+            return task_database_cue_get_crc(name, crc);
          }
          break;
       case FILE_TYPE_GDI:
-         gdi_prune(db, name);
-         db_state->serial[0] = '\0';
+         serial[0] = '\0';
          /* There are no serial databases, so don't bother with
             serials at the moment */
-         if (0 && task_database_gdi_get_serial(name, db_state->serial))
-            db->type = DATABASE_TYPE_SERIAL_LOOKUP;
+         if (0 && task_database_gdi_get_serial(name, serial))
+            *type = DATABASE_TYPE_SERIAL_LOOKUP;
          else
          {
-            db->type = DATABASE_TYPE_CRC_LOOKUP;
-            return task_database_gdi_get_crc(name, &db_state->crc);
+            *type = DATABASE_TYPE_CRC_LOOKUP;
+            return task_database_gdi_get_crc(name, crc);
          }
          break;
       /* Consider Wii WBFS files similar to ISO files. */
       case FILE_TYPE_WBFS:
       case FILE_TYPE_ISO:
-         db_state->serial[0] = '\0';
-         intfstream_file_get_serial(name, 0, SIZE_MAX, db_state->serial);
-         db->type            =  DATABASE_TYPE_SERIAL_LOOKUP;
+         serial[0] = '\0';
+         intfstream_file_get_serial(name, 0, SIZE_MAX, serial);
+         *type     =  DATABASE_TYPE_SERIAL_LOOKUP;
          break;
       case FILE_TYPE_CHD:
-         db_state->serial[0] = '\0';
-         if (task_database_chd_get_serial(name, db_state->serial))
-            db->type         = DATABASE_TYPE_SERIAL_LOOKUP;
+         serial[0] = '\0';
+         if (task_database_chd_get_serial(name, serial))
+            *type  = DATABASE_TYPE_SERIAL_LOOKUP;
          else
          {
-            db->type         = DATABASE_TYPE_CRC_LOOKUP;
-            return task_database_chd_get_crc(name, &db_state->crc);
+            *type  = DATABASE_TYPE_CRC_LOOKUP;
+            return task_database_chd_get_crc(name, crc);
          }
          break;
       case FILE_TYPE_LUTRO:
-         db->type            = DATABASE_TYPE_ITERATE_LUTRO;
+         *type     = DATABASE_TYPE_ITERATE_LUTRO;
          break;
       default:
-         db->type            = DATABASE_TYPE_CRC_LOOKUP;
-         return intfstream_file_get_crc(name, 0, SIZE_MAX, &db_state->crc);
+         *type     = DATABASE_TYPE_CRC_LOOKUP;
+         return intfstream_file_get_crc(name, 0, SIZE_MAX, crc);
    }
 
    return 1;
 }
 
+static int task_database_iterate_playlist(
+      database_state_handle_t *db_state,
+      database_info_handle_t *db, const char *name)
+{
+   task_database_prune(db, name);
+   return task_database_get_file_info(name, &db->type,
+         &db_state->crc, &db_state->archive_crc, db_state->serial);
+}
+
+#ifdef HAVE_THREADS
+static void task_database_scan_job(void *data)
+{
+   database_scan_job_t *job           = (database_scan_job_t*)data;
+   database_scan_pipeline_t *pipeline = job->pipeline;
+
+   if (path_contains_compressed_file(job->path))
+   {
+      job->type = DATABASE_TYPE_ITERATE_ARCHIVE;
+      job->crc  = file_archive_get_file_crc32(job->path);
+      job->ret  = 1;
+   }
+   else
+   {
+      job->ret  = task_database_get_file_info(job->path, &job->type,
+            &job->crc, &job->archive_crc, job->serial);
+
+      /* The CRC lookup would read this next, on the task thread */
+      if (     job->ret
+            && job->type == DATABASE_TYPE_CRC_LOOKUP
+            && !job->crc
+            && path_is_compressed_file(job->path))
+         job->crc = file_archive_get_file_crc32(job->path);
+   }
+
+   slock_lock(pipeline->lock);
+   job->done = true;
+   pipeline->hashed++;
+   scond_broadcast(pipeline->cond);
+   slock_unlock(pipeline->lock);
+}
+
+static void task_database_pipeline_free(database_scan_pipeline_t *pipeline)
+{
+   size_t i;
+
+   if (!pipeline)
+      return;
+
+   if (pipeline->pool)
+   {
+      tpool_wait(pipeline->pool);
+      tpool_destroy(pipeline->pool);
+   }
+
+   if (pipeline->jobs)
+      for (i = 0; i < pipeline->slots; i++)
+         free(pipeline->jobs[i].path);
+
+   if (pipeline->cond)
+      scond_free(pipeline->cond);
+   if (pipeline->lock)
+      slock_free(pipeline->lock);
+   free(pipeline->jobs);
+   free(pipeline);
+}
+
+static database_scan_pipeline_t *task_database_pipeline_new(
+      unsigned workers, retro_time_t walk_time)
+{
+   database_scan_pipeline_t *pipeline = (database_scan_pipeline_t*)
+      calloc(1, sizeof(*pipeline));
+
+   if (!pipeline)
+      return NULL;
+
+   pipeline->slots      = workers * DATABASE_SCAN_AHEAD;
+   pipeline->jobs       = (database_scan_job_t*)calloc(pipeline->slots,
+         sizeof(*pipeline->jobs));
+   pipeline->lock       = slock_new();
+   pipeline->cond       = scond_new();
+   pipeline->pool       = tpool_create(workers);
+   pipeline->start_time = cpu_features_get_time_usec();
+   pipeline->walk_time  = walk_time;
+
+   if (     !pipeline->jobs
+         || !pipeline->lock
+         || !pipeline->cond
+         || !pipeline->pool)
+   {
+      task_database_pipeline_free(pipeline);
+      return NULL;
+   }
+
+   return pipeline;
+}
+
+/* Hands the entries from @list_ptr up to the lookahead window to
+ * the workers. A slot is reused once the task has moved past its
+ * entry and its worker is done with it. */
+static void task_database_pipeline_fill(database_scan_pipeline_t *pipeline,
+      database_info_handle_t *dbinfo)
+{
+   if (pipeline->next < dbinfo->list_ptr)
+      pipeline->next = dbinfo->list_ptr;
+
+   while (     pipeline->next < dbinfo->list->size
+         &&    pipeline->next < dbinfo->list_ptr + pipeline->slots)
+   {
+      database_scan_job_t *job = &pipeline->jobs[
+         pipeline->next % pipeline->slots];
+      const char *path         = dbinfo->list->elems[pipeline->next].data;
+      bool busy;
+
+      slock_lock(pipeline->lock);
+      busy = job->busy && !job->done;
+      slock_unlock(pipeline->lock);
+
+      if (busy)
+         break;
+
+      free(job->path);
+      job->pipeline    = pipeline;
+      job->path        = NULL;
+      job->index       = pipeline->next;
+      job->crc         = 0;
+      job->archive_crc = 0;
+      job->type        = DATABASE_TYPE_ITERATE;
+      job->ret         = 0;
+      job->serial[0]   = '\0';
+      job->busy        = true;
+      job->done        = false;
+
+      pipeline->next++;
+
+      /* Pruned entries are skipped by the task anyway */
+      if (!path || !(job->path = strdup(path)))
+      {
+         job->done = true;
+         continue;
+      }
+
+      if (!tpool_add_work(pipeline->pool, task_database_scan_job, job))
+      {
+         /* The task hashes it itself */
+         job->busy = false;
+         job->done = true;
+      }
+   }
+}
+
+/* Returns the finished job of the current entry, NULL if the
+ * task has to hash it itself. Sets @wait if the job is still
+ * running, the task should then come back later. */
+static database_scan_job_t *task_database_pipeline_get(
+      database_scan_pipeline_t *pipeline,
+      database_info_handle_t *dbinfo, bool *wait)
+{
+   database_scan_job_t *job = NULL;
+
+   *wait = false;
+
+   task_database_pipeline_fill(pipeline, dbinfo);
+
+   job   = &pipeline->jobs[dbinfo->list_ptr % pipeline->slots];
+
+   if (!job->busy || job->index != dbinfo->list_ptr || !job->path)
+      return NULL;
+
+   slock_lock(pipeline->lock);
+   if (!job->done)
+      scond_wait_timeout(pipeline->cond, pipeline->lock, 10000);
+   *wait = !job->done;
+   slock_unlock(pipeline->lock);
+
+   return *wait ? NULL : job;
+}
+
+/* Per stage throughput, for the progress message */
+static void task_database_pipeline_stats(
+      database_scan_pipeline_t *pipeline, char *s, size_t len)
+{
+   unsigned hashed;
+   float secs = (cpu_features_get_time_usec()
+         - pipeline->start_time) / 1000000.0f;
+
+   slock_lock(pipeline->lock);
+   hashed = pipeline->hashed;
+   slock_unlock(pipeline->lock);
+
+   if (secs <= 0.0f)
+      secs = 0.001f;
+
+   snprintf(s, len, " (walk %.1fs, hash %.1f/s, match %.1f/s)",
+         pipeline->walk_time / 1000000.0f,
+         hashed / secs, pipeline->matched / secs);
+}
+#endif
+
 static int database_info_list_iterate_end_no_match(
       database_info_handle_t *db,
       database_state_handle_t *db_state,
@@ -697,7 +966,11 @@ static int database_info_list_iterate_new(database_state_handle_t *db_state,
       database_info_list_free(db_state->info);
       free(db_state->info);
    }
-   db_state->info = database_info_list_new(new_database, query);
+   if (db_state->cache)
+      db_state->info = database_info_cache_list_new(db_state->cache,
+            new_database, query);
+   else
+      db_state->info = database_info_list_new(new_database, query);
    return 0;
 }
 
@@ -807,6 +1080,11 @@ static int database_info_list_iterate_found_match(
    playlist_write_file(playlist);
    playlist_free(playlist);
 
+#ifdef HAVE_THREADS
+   if (_db->pipeline)
+      _db->pipeline->matched++;
+#endif
+
    database_info_list_free(db_state->info);
    free(db_state->info);
 
@@ -815,8 +1093,9 @@ static int database_info_list_iterate_found_match(
    db_state->archive_crc = 0;
 
    /* Move database to start since we are likely to match against it
-      again */
-   if (db_state->list_index != 0)
+      again. The hash index refers to databases by position, and
+      doesn't need the hint anyway. */
+   if (db_state->list_index != 0 && !db_state->index)
    {
       struct string_list_elem entry = 
          db_state->list->elems[db_state->list_index];
@@ -845,6 +1124,85 @@ static int database_info_list_iterate_next(
    return 1;
 }
 
+/* Returns true if @name can't be in the database at @list_index,
+ * see task_database_iterate_crc_lookup(). */
+static bool task_database_skip_database(db_handle_t *_db,
+      database_state_handle_t *db_state, size_t list_index,
+      const char *name)
+{
+   const char *db_path = db_state->list->elems[list_index].data;
+
+   if (_db->scan_without_core_match)
+      return false;
+
+   if (!core_info_database_supports_content_path(db_path, name))
+      return true;
+
+   if (!path_contains_compressed_file(name))
+      if (core_info_database_match_archive_member(db_path))
+         return true;
+
+   return false;
+}
+
+/* Same as task_database_iterate_crc_lookup(), but resolves
+ * the file against the hash index in a single step. */
+static int task_database_index_crc_lookup(
+      db_handle_t *_db,
+      database_state_handle_t *db_state,
+      database_info_handle_t *db,
+      const char *name,
+      const char *archive_entry)
+{
+   database_info_index_pos_t pos;
+
+   if (!db_state->crc)
+      db_state->crc = file_archive_get_file_crc32(name);
+
+   pos.db     = 0;
+   pos.offset = 0;
+
+   for (;;)
+   {
+      database_info_index_pos_t pos_crc     = pos;
+      database_info_index_pos_t pos_archive = pos;
+      bool has_crc     = database_info_index_find_crc(
+            db_state->index, db_state->crc, &pos_crc);
+      bool has_archive = database_info_index_find_crc(
+            db_state->index, db_state->archive_crc, &pos_archive);
+      bool is_archive;
+
+      if (!has_crc && !has_archive)
+         break;
+
+      /* Earliest match wins, as with the linear walk */
+      is_archive = has_archive && (!has_crc
+            || pos_archive.db < pos_crc.db
+            || (pos_archive.db == pos_crc.db
+               && pos_archive.offset <= pos_crc.offset));
+      pos        = is_archive ? pos_archive : pos_crc;
+
+      if (task_database_skip_database(_db, db_state, pos.db, name))
+      {
+         /* Move on to the next database */
+         pos.offset = (uint64_t)-1;
+         continue;
+      }
+
+      if (!(db_state->info = database_info_index_read(
+                  db_state->index, &pos)))
+         continue;
+
+      db_state->list_index  = pos.db;
+      db_state->entry_index = 0;
+
+      return database_info_list_iterate_found_match(_db, db_state, db,
+            is_archive ? NULL : archive_entry);
+   }
+
+   return database_info_list_iterate_end_no_match(db, db_state, name);
+}
+
 static int task_database_iterate_crc_lookup(
       db_handle_t *_db,
       database_state_handle_t *db_state,
@@ -856,6 +1214,10 @@ static int task_database_iterate_crc_lookup(
          (unsigned)db_state->list_index == (unsigned)db_state->list->size)
       return database_info_list_iterate_end_no_match(db, db_state, name);
 
+   if (db_state->index)
+      return task_database_index_crc_lookup(_db, db_state, db,
+            name, archive_entry);
+
    /* Archive did not contain a CRC for this entry, 
     * or the file is empty. */
    if (!db_state->crc)
@@ -872,24 +1234,14 @@ static int task_database_iterate_crc_lookup(
 
       query[0] = '\0';
 
-      if (!_db->scan_without_core_match)
-      {
-         /* don't scan files that can't be in this database.
-          *
-          * Could be because of:
-          * - A matching core missing
-          * - Incompatible file extension */
-         if (!core_info_database_supports_content_path(
-               db_state->list->elems[db_state->list_index].data, name))
-            return database_info_list_iterate_next(db_state);
-
-         if (!path_contains_compressed_file(name))
-         {
-            if (core_info_database_match_archive_member(
-                  db_state->list->elems[db_state->list_index].data))
-               return database_info_list_iterate_next(db_state);
-         }
-      }
+      /* don't scan files that can't be in this database.
+       *
+       * Could be because of:
+       * - A matching core missing
+       * - Incompatible file extension */
+      if (task_database_skip_database(_db, db_state,
+               db_state->list_index, name))
+         return database_info_list_iterate_next(db_state);
 
       snprintf(query, sizeof(query),
             "{crc:or(b\"%08X\",b\"%08X\")}",
@@ -1011,6 +1363,37 @@ static int task_database_iterate_serial_lookup(
       )
       return database_info_list_iterate_end_no_match(db, db_state, name);
 
+   if (db_state->index)
+   {
+      database_info_index_pos_t pos;
+
+      pos.db     = 0;
+      pos.offset = 0;
+
+      /* Serials are hashed, so check the entry itself */
+      while (database_info_index_find_serial(db_state->index,
+               db_state->serial, &pos))
+      {
+         if (!(db_state->info = database_info_index_read(
+                     db_state->index, &pos)))
+            continue;
+
+         if (string_is_equal(db_state->serial, db_state->info->list[0].serial))
+         {
+            db_state->list_index  = pos.db;
+            db_state->entry_index = 0;
+            return database_info_list_iterate_found_match(_db,
+                  db_state, db, NULL);
+         }
+
+         database_info_list_free(db_state->info);
+         free(db_state->info);
+         db_state->info = NULL;
+      }
+
+      return database_info_list_iterate_end_no_match(db, db_state, name);
+   }
+
    if (db_state->entry_index == 0)
    {
       char query[50];
@@ -1124,7 +1507,8 @@ static void task_database_handler(retro_task_t *task)
 
    if (!db->scan_started)
    {
-      db->scan_started = true;
+      db->scan_started    = true;
+      db->scan_start_time = cpu_features_get_time_usec();
 
       if (!string_is_empty(db->fullpath))
       {
@@ -1200,6 +1584,47 @@ static void task_database_handler(retro_task_t *task)
                }
             }
          }
+         /* Only worth it when there's more than one file to look up */
+         if (     dbstate->list
+               && !dbstate->index
+               && db->scan_hash_index
+               && db->is_directory)
+            dbstate->index = database_info_index_new(dbstate->list);
+         /* Keep the databases open so the indexes they build
+          * for the first lookup serve the rest of the scan */
+         if (dbstate->list && !dbstate->cache && db->is_directory)
+            dbstate->cache = database_info_cache_new();
+         /* Index one database per run so the task stays responsive */
+         if (dbstate->index)
+         {
+            int ret = database_info_index_iterate(dbstate->index);
+
+            if (ret > 0)
+               break;
+            if (ret < 0)
+            {
+               /* Fall back to walking the databases */
+               database_info_index_free(dbstate->index);
+               dbstate->index      = NULL;
+               db->scan_hash_index = false;
+            }
+         }
+#ifdef HAVE_THREADS
+         if (     !db->pipeline
+               && db->scan_workers > 0
+               && dbinfo->list->size > 1)
+         {
+            db->pipeline = task_database_pipeline_new(db->scan_workers,
+                  cpu_features_get_time_usec() - db->scan_start_time);
+#ifdef RARCH_INTERNAL
+            if (db->pipeline)
+               RARCH_LOG("[Scanner] Found %u entries in %.3fs, hashing on %u worker(s).\n",
+                     (unsigned)dbinfo->list->size,
+                     db->pipeline->walk_time / 1000000.0f,
+                     db->scan_workers);
+#endif
+         }
+#endif
          dbinfo->status = DATABASE_STATUS_ITERATE_START;
          break;
       case DATABASE_STATUS_ITERATE_START:
@@ -1207,7 +1632,39 @@ static void task_database_handler(retro_task_t *task)
          task_database_cleanup_state(dbstate);
          dbstate->list_index  = 0;
          dbstate->entry_index = 0;
-         task_database_iterate_start(task, dbinfo, name);
+#ifdef HAVE_THREADS
+         if (db->pipeline && name)
+         {
+            char stats[64];
+            bool wait                = false;
+            database_scan_job_t *job = task_database_pipeline_get(
+                  db->pipeline, dbinfo, &wait);
+
+            /* Still hashing, try again on the next run */
+            if (wait)
+               break;
+
+            task_database_pipeline_stats(db->pipeline, stats, sizeof(stats));
+            task_database_iterate_start(task, dbinfo, name, stats);
+
+            if (job)
+            {
+               task_database_prune(dbinfo, name);
+               dbinfo->type         = job->type;
+               dbstate->crc         = job->crc;
+               dbstate->archive_crc = job->archive_crc;
+               strlcpy(dbstate->serial, job->serial, sizeof(dbstate->serial));
+
+               if (job->ret == 0)
+               {
+                  dbinfo->status    = DATABASE_STATUS_ITERATE_NEXT;
+                  dbinfo->type      = DATABASE_TYPE_ITERATE;
+               }
+            }
+            break;
+         }
+#endif
+         task_database_iterate_start(task, dbinfo, name, NULL);
          break;
       case DATABASE_STATUS_ITERATE:
          {
@@ -1264,10 +1721,21 @@ task_finished:
    if (task)
       task_set_finished(task, true);
 
+#ifdef HAVE_THREADS
+   if (db && db->pipeline)
+   {
+      task_database_pipeline_free(db->pipeline);
+      db->pipeline = NULL;
+   }
+#endif
+
    if (dbstate)
    {
       if (dbstate->list)
          dir_list_free(dbstate->list);
+      if (dbstate->index)
+         database_info_index_free(dbstate->index);
+      database_info_cache_free(dbstate->cache);
    }
 
    if (db)
@@ -1317,6 +1785,7 @@ bool task_push_dbscan(
       goto error;
 
    t->handler                              = task_database_handler;
+   t->priority                             = TASK_PRIORITY_BULK;
    t->state                                = db;
    t->callback                             = cb;
    t->title                                = strdup(msg_hash_to_str(
@@ -1326,6 +1795,8 @@ bool task_push_dbscan(
 #ifdef RARCH_INTERNAL
    t->progress_cb                          = task_database_progress_cb;
    db->scan_without_core_match             = settings->bools.scan_without_core_match;
+   db->scan_hash_index                     = settings->bools.scan_hash_index;
+   db->scan_workers                        = settings->uints.scan_workers;
    db->playlist_config.capacity            = COLLECTION_SIZE;
    db->playlist_config.old_format          = settings->bools.playlist_use_old_format;
    db->playlist_config.compress            = settings->bools.playlist_compression;
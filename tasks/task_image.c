@@ -20,6 +20,9 @@
 
 #include <file/nbio.h>
 #include <formats/image.h>
+#ifdef HAVE_RPNG
+#include <formats/rpng.h>
+#endif
 #include <compat/strl.h>
 #include <string/stdstring.h>
 #include <retro_miscellaneous.h>
@@ -202,6 +205,17 @@ static int cb_nbio_image_thumbnail(void *data, size_t len)
    image->handle                   = handle;
    image->cb                       = &cb_image_thumbnail;
 
+#ifdef HAVE_RPNG
+   /* On a task thread there is no frame to keep responsive,
+    * so decode PNGs in one go instead of scanline by scanline,
+    * converting large ones on the task queue's thread pool */
+   if (image->type == IMAGE_TYPE_PNG && task_queue_is_threaded())
+   {
+      rpng_set_fast_path((rpng_t*)handle, true);
+      rpng_set_thread_pool((rpng_t*)handle, task_queue_get_thread_pool());
+   }
+#endif
+
    ptr                             = nbio_get_ptr(nbio->handle, &len);
 
    image_transfer_set_buffer_ptr(image->handle, image->type, ptr, len);
@@ -461,6 +475,7 @@ bool task_push_image_load(const char *fullpath,
 
    t->state           = nbio;
    t->handler         = task_file_load_handler;
+   t->priority        = TASK_PRIORITY_INTERACTIVE;
    t->cleanup         = task_image_load_free;
    t->callback        = cb;
    t->user_data       = user_data;
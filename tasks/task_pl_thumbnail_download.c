@@ -538,6 +538,7 @@ bool task_push_pl_thumbnail_download(
 
    /* Configure task */
    task->handler                 = task_pl_thumbnail_download_handler;
+   task->priority                = TASK_PRIORITY_BULK;
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->alternative_look        = true;
@@ -874,6 +875,7 @@ bool task_push_pl_entry_thumbnail_download(
 
    /* Configure task */
    task->handler                 = task_pl_entry_thumbnail_download_handler;
+   task->priority                = TASK_PRIORITY_INTERACTIVE;
    task->state                   = pl_thumb;
    task->title                   = strdup(system);
    task->alternative_look        = true;